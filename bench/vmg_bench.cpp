@@ -0,0 +1,461 @@
+/**
+ * @file vmg_bench.cpp
+ * @brief Hot-path microbenchmarks (Google Benchmark)
+ *
+ * Usage: vmg_bench [--benchmark_filter=<regex>] [--benchmark_format=json]
+ *
+ * Covers package parsing / verification, SHA256 and partition hashing,
+ * CRC32 kernels, DoIP framing and MQTT JSON payload construction. Each
+ * benchmark reports throughput (bytes_per_second) and allocs/op, counted by
+ * the global operator new below.
+ *
+ * Test data is generated once per run in a temp directory: a Vehicle
+ * Package built by vmg-pack (4 zones x 4 ECUs x 1MB, fixed seed), one of its
+ * Zone Packages and a 16MB firmware / partition image. Set
+ * VMG_BENCH_PACKAGE=<file> to benchmark an existing package instead.
+ */
+
+#include "vehicle_package.hpp"
+#include "zone_package.hpp"
+#include "package_verifier.hpp"
+#include "crc32.hpp"
+#include "ota_manager.hpp"
+#include "partition_manager.hpp"
+#include "doip_client.hpp"
+#include "mqtt_client.hpp"
+#include <benchmark/benchmark.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#ifndef VMG_PACK_PATH
+#define VMG_PACK_PATH "vmg-pack"
+#endif
+
+#define BENCH_FIRMWARE_SIZE     (16 * 1024 * 1024)      // SHA256 / partition image
+
+// ==================== Allocation Counting ====================
+
+// Counts every scalar/array operator new in the process (aligned new is not counted)
+static std::atomic<uint64_t> g_allocations(0);
+
+// Out of line, so the compiler never pairs an inlined free() with a new expression
+__attribute__((noinline)) static void* countedAllocate(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) static void countedRelease(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete(void* ptr) noexcept { countedRelease(ptr); }
+void operator delete[](void* ptr) noexcept { countedRelease(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { countedRelease(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { countedRelease(ptr); }
+
+/**
+ * @brief Reports allocs/op for the benchmark loop it encloses
+ */
+class AllocationCounter {
+public:
+    explicit AllocationCounter(benchmark::State& state)
+        : state_(state), start_(g_allocations.load(std::memory_order_relaxed)) {}
+    
+    ~AllocationCounter() {
+        uint64_t count = g_allocations.load(std::memory_order_relaxed) - start_;
+        state_.counters["allocs/op"] = benchmark::Counter(static_cast<double>(count),
+                                                          benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& state_;
+    uint64_t start_;
+};
+
+/**
+ * @brief Silences std::cout / std::cerr (parsers log every call)
+ */
+class QuietOutput {
+public:
+    QuietOutput() : out_(std::cout.rdbuf(nullptr)), err_(std::cerr.rdbuf(nullptr)) {}
+    ~QuietOutput() {
+        std::cout.rdbuf(out_);
+        std::cerr.rdbuf(err_);
+    }
+
+private:
+    std::streambuf* out_;
+    std::streambuf* err_;
+};
+
+// ==================== Test Data ====================
+
+static const std::string& benchDir() {
+    static std::string dir = [] {
+        char path[] = "/tmp/vmg_bench.XXXXXX";
+        return std::string(mkdtemp(path) ? path : "");
+    }();
+    return dir;
+}
+
+static const std::string& benchPackage() {
+    static std::string path = [] {
+        if (const char* existing = std::getenv("VMG_BENCH_PACKAGE")) {
+            return std::string(existing);
+        }
+        std::string output = benchDir() + "/vehicle.bin";
+        std::string command = std::string(VMG_PACK_PATH) + " -o " + output +
+                              " --zones 4 --ecus-per-zone 4 --firmware-kb 1024 --seed 1 > /dev/null";
+        return std::system(command.c_str()) == 0 ? output : std::string();
+    }();
+    return path;
+}
+
+static const std::string& benchZonePackage() {
+    static std::string path = [] {
+        QuietOutput quiet;
+        VehiclePackageParser parser(benchPackage());
+        std::string output = benchDir() + "/zone.bin";
+        if (!parser.parse() || parser.getZonePackages().empty() ||
+            !parser.extractZonePackage(parser.getZonePackages()[0].zone_number, output)) {
+            return std::string();
+        }
+        return output;
+    }();
+    return path;
+}
+
+static std::vector<uint8_t> randomBytes(size_t size) {
+    std::vector<uint8_t> data(size);
+    std::mt19937 rng(12345);
+    for (auto& b : data) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+static const std::string& benchFirmware() {
+    static std::string path = [] {
+        std::string output = benchDir() + "/firmware.bin";
+        std::vector<uint8_t> data = randomBytes(BENCH_FIRMWARE_SIZE);
+        std::ofstream file(output, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        return file.good() ? output : std::string();
+    }();
+    return path;
+}
+
+/**
+ * @brief Partition A image: metadata (with firmware SHA256) + firmware
+ */
+static PartitionManager* benchPartitionManager() {
+    static PartitionManager* manager = []() -> PartitionManager* {
+        QuietOutput quiet;
+        uint8_t hash[32];
+        if (benchFirmware().empty() || !OTAManager::calculateSHA256(benchFirmware(), hash)) {
+            return nullptr;
+        }
+        
+        std::string dir = benchDir();
+        PartitionMetadata metadata;
+        std::memset(&metadata, 0, sizeof(metadata));
+        metadata.magic_number = PARTITION_MAGIC_NUMBER;
+        metadata.total_size = BENCH_FIRMWARE_SIZE;
+        std::memcpy(metadata.sha256_hash, hash, sizeof(hash));
+        metadata.state = PartitionState::STATE_READY;
+        
+        // A: SHA256 only, B: same image with a hash tree
+        for (const char* name : {"/partition_a", "/partition_b"}) {
+            std::ofstream image(dir + name, std::ios::binary);
+            std::ifstream firmware(benchFirmware(), std::ios::binary);
+            image.write(reinterpret_cast<const char*>(&metadata), sizeof(metadata));
+            image << firmware.rdbuf();
+            if (!image.good()) {
+                return nullptr;
+            }
+        }
+        
+        auto* manager = new PartitionManager(dir + "/partition_a", dir + "/partition_b", dir, dir,
+                                             dir + "/boot_status.dat", true);
+        PartitionHashTree tree;
+        if (!tree.build(benchFirmware(), 0, BENCH_FIRMWARE_SIZE) ||
+            !manager->writeHashTree(PartitionId::PARTITION_B, tree, metadata) ||
+            !manager->writeMetadata(PartitionId::PARTITION_B, metadata)) {
+            delete manager;
+            return nullptr;
+        }
+        return manager;
+    }();
+    return manager;
+}
+
+static MqttClient& benchMqttClient() {
+    static MqttClient client("localhost", 1883, "vmg-bench", "KMHXX00XXXX000001");
+    return client;
+}
+
+static std::string sampleVciJson(int ecu_count) {
+    std::string zones = "[";
+    for (int i = 0; i < ecu_count; i++) {
+        zones += std::string(i ? "," : "") +
+                 "{\"ecu_id\":\"ECU_" + std::to_string(100 + i) + "\",\"sw_version\":\"1.0.0\","
+                 "\"hw_version\":\"1.0.0\",\"serial_num\":\"" + std::to_string(91000000 + i) + "\"}";
+    }
+    zones += "]";
+    return "{\"vmg\":{\"sw_version\":\"2.0.0\"},\"zgw\":{\"ecu_id\":\"ECU_091\"},\"zones\":" + zones + "}";
+}
+
+// ==================== Package Parsing / Verification ====================
+
+static void BM_VehiclePackageParse(benchmark::State& state) {
+    if (benchPackage().empty()) {
+        state.SkipWithError("vmg-pack failed");
+        return;
+    }
+    
+    QuietOutput quiet;
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        VehiclePackageParser parser(benchPackage());
+        benchmark::DoNotOptimize(parser.parse());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VehiclePackageParse);
+
+static void BM_VehiclePackageVerify(benchmark::State& state) {
+    QuietOutput quiet;
+    VehiclePackageParser parser(benchPackage());
+    if (benchPackage().empty() || !parser.parse()) {
+        state.SkipWithError("Package not available");
+        return;
+    }
+    parser.setVerifyThreads(static_cast<unsigned>(state.range(0)));
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        if (!parser.verify()) {
+            state.SkipWithError("verify() failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(parser.getMetadata().total_size));
+}
+BENCHMARK(BM_VehiclePackageVerify)->Arg(1)->Arg(0)->UseRealTime();
+
+static void BM_ZonePackageVerify(benchmark::State& state) {
+    QuietOutput quiet;
+    ZonePackageParser parser(benchZonePackage());
+    if (benchZonePackage().empty() || !parser.parse()) {
+        state.SkipWithError("Zone Package not available");
+        return;
+    }
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        if (!parser.verify()) {
+            state.SkipWithError("verify() failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(parser.getTotalSize()));
+}
+BENCHMARK(BM_ZonePackageVerify)->UseRealTime();
+
+static void BM_PackageIntegrityVerifier(benchmark::State& state) {
+    if (benchPackage().empty()) {
+        state.SkipWithError("vmg-pack failed");
+        return;
+    }
+    
+    QuietOutput quiet;
+    PackageIntegrityVerifier verifier(benchPackage());
+    verifier.setThreadCount(static_cast<unsigned>(state.range(0)));
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        if (!verifier.verify()) {
+            state.SkipWithError("verify() failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(verifier.getReport().bytes_read));
+}
+BENCHMARK(BM_PackageIntegrityVerifier)->Arg(1)->Arg(0)->UseRealTime();
+
+// ==================== Hashing ====================
+
+static void BM_CalculateSHA256(benchmark::State& state) {
+    if (benchFirmware().empty()) {
+        state.SkipWithError("Firmware image not available");
+        return;
+    }
+    
+    uint8_t hash[32];
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(OTAManager::calculateSHA256(benchFirmware(), hash));
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(BENCH_FIRMWARE_SIZE));
+}
+BENCHMARK(BM_CalculateSHA256)->UseRealTime();
+
+static void BM_VerifyPartition(benchmark::State& state, PartitionId partition) {
+    PartitionManager* manager = benchPartitionManager();
+    if (!manager) {
+        state.SkipWithError("Partition image not available");
+        return;
+    }
+    
+    QuietOutput quiet;
+    manager->setVerifyThreads(static_cast<unsigned>(state.range(0)));
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        if (!manager->verifyPartition(partition)) {
+            state.SkipWithError("verifyPartition() failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(BENCH_FIRMWARE_SIZE));
+}
+BENCHMARK_CAPTURE(BM_VerifyPartition, sha256, PartitionId::PARTITION_A)->Arg(1)->UseRealTime();
+BENCHMARK_CAPTURE(BM_VerifyPartition, hash_tree, PartitionId::PARTITION_B)->Arg(1)->Arg(0)->UseRealTime();
+
+static void BM_CheckPartitionRoot(benchmark::State& state) {
+    PartitionManager* manager = benchPartitionManager();
+    if (!manager) {
+        state.SkipWithError("Partition image not available");
+        return;
+    }
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        if (!manager->checkPartitionRoot(PartitionId::PARTITION_B)) {
+            state.SkipWithError("checkPartitionRoot() failed");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_CheckPartitionRoot)->UseRealTime();
+
+static void BM_CRC32(benchmark::State& state, CRC32Kernel kernel) {
+    if (!crc32KernelSupported(kernel)) {
+        state.SkipWithError("Kernel not supported on this CPU");
+        return;
+    }
+    
+    std::vector<uint8_t> data = randomBytes(static_cast<size_t>(state.range(0)));
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crc32UpdateWith(kernel, 0, data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_CRC32, portable, CRC32Kernel::PORTABLE)->Arg(4096)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_CRC32, x86_pclmul, CRC32Kernel::X86_PCLMUL)->Arg(4096)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_CRC32, armv8_crc, CRC32Kernel::ARMV8_CRC)->Arg(4096)->Arg(1 << 20);
+
+// ==================== DoIP Framing ====================
+
+static void BM_DoIPBuildMessage(benchmark::State& state) {
+    std::vector<uint8_t> payload = randomBytes(static_cast<size_t>(state.range(0)));
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        auto message = DoIPClient::buildDoIPMessage(DoIPPayloadType::DIAGNOSTIC_MESSAGE, payload);
+        benchmark::DoNotOptimize(message.data());
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(DOIP_HEADER_SIZE + payload.size()));
+}
+BENCHMARK(BM_DoIPBuildMessage)->Arg(8)->Arg(1024)->Arg(4096);
+
+static void BM_DoIPParseMessage(benchmark::State& state) {
+    std::vector<uint8_t> message = DoIPClient::buildDoIPMessage(
+        DoIPPayloadType::DIAGNOSTIC_MESSAGE, randomBytes(static_cast<size_t>(state.range(0))));
+    DoIPPayloadType type;
+    std::vector<uint8_t> payload;
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(DoIPClient::parseDoIPMessage(message, type, payload));
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(message.size()));
+}
+BENCHMARK(BM_DoIPParseMessage)->Arg(8)->Arg(1024)->Arg(4096);
+
+// ==================== MQTT Payloads ====================
+
+static void BM_MqttHeartbeatPayload(benchmark::State& state) {
+    MqttClient& client = benchMqttClient();
+    size_t bytes = 0;
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        std::string payload = client.buildHeartbeatPayload("PARKED", 3600);
+        bytes += payload.size();
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.SetBytesProcessed(int64_t(bytes));
+}
+BENCHMARK(BM_MqttHeartbeatPayload);
+
+static void BM_MqttDownloadProgressPayload(benchmark::State& state) {
+    MqttClient& client = benchMqttClient();
+    size_t bytes = 0;
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        std::string payload = client.buildDownloadProgressPayload("CAMPAIGN-001", 42, 44040192, 104857600);
+        bytes += payload.size();
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.SetBytesProcessed(int64_t(bytes));
+}
+BENCHMARK(BM_MqttDownloadProgressPayload);
+
+static void BM_MqttVciReportPayload(benchmark::State& state) {
+    MqttClient& client = benchMqttClient();
+    std::string vci_json = sampleVciJson(static_cast<int>(state.range(0)));
+    size_t bytes = 0;
+    
+    AllocationCounter allocs(state);
+    for (auto _ : state) {
+        std::string payload = client.buildVciReportPayload(vci_json);
+        bytes += payload.size();
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.SetBytesProcessed(int64_t(bytes));
+}
+BENCHMARK(BM_MqttVciReportPayload)->Arg(5)->Arg(64);
+
+// ==================== Main ====================
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    
+    if (!benchDir().empty()) {
+        std::error_code ec;
+        std::filesystem::remove_all(benchDir(), ec);
+    }
+    return 0;
+}
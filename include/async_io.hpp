@@ -0,0 +1,220 @@
+/**
+ * @file async_io.hpp
+ * @brief Queued file I/O for the OTA data path (io_uring or thread pool)
+ *
+ * AsyncIO keeps up to queue_depth preads in flight:
+ *   - io_uring (raw syscalls, no liburing) when built with VMG_HAVE_IO_URING
+ *     and the kernel allows io_uring_setup()
+ *   - otherwise a small thread pool running pread()
+ *
+ * AsyncFileReader builds on it: a file range is read in large blocks with
+ * several reads queued ahead, and delivered in order to a consumer, so
+ * hashing / writing the current block overlaps reading the next ones.
+ * Download verification, install copies and partition verification all
+ * read through it. Writes stay synchronous pwrite(): the O_DIRECT fallback
+ * and skip-unchanged compare need each result before the next block.
+ */
+
+#ifndef ASYNC_IO_HPP
+#define ASYNC_IO_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// ==================== Constants ====================
+
+#define ASYNC_IO_QUEUE_DEPTH        4                   // Requests in flight
+#define ASYNC_IO_BLOCK_SIZE         (1024 * 1024)       // AsyncFileReader block size
+#define ASYNC_IO_ALIGNMENT          4096                // Buffer alignment (O_DIRECT capable)
+#define ASYNC_IO_POOL_THREADS       2                   // Thread pool fallback workers
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief Backend executing the requests
+ */
+enum class AsyncIOBackend : uint8_t {
+    IO_URING = 0,
+    THREAD_POOL = 1
+};
+
+/**
+ * @brief Completed request
+ */
+struct AsyncIOCompletion {
+    uint64_t tag;                   // Caller's tag from submitRead()
+    int64_t result;                 // Bytes transferred, or -errno
+};
+
+/**
+ * @brief Aligned I/O buffer (posix_memalign)
+ */
+using AsyncIOBuffer = std::unique_ptr<uint8_t, void (*)(void*)>;
+
+// ==================== Functions ====================
+
+/**
+ * @brief Backend name for logging
+ */
+const char* asyncIOBackendName(AsyncIOBackend backend);
+
+/**
+ * @brief Allocate an ASYNC_IO_ALIGNMENT aligned buffer (empty on failure)
+ */
+AsyncIOBuffer allocateAsyncIOBuffer(size_t size);
+
+// ==================== Async I/O ====================
+
+/**
+ * @brief Async I/O Queue Class
+ *
+ * Not thread-safe: one thread submits and waits.
+ *
+ * Usage:
+ *   AsyncIO io;
+ *   io.submitRead(fd, buffer, size, offset, tag);
+ *   AsyncIOCompletion completion;
+ *   io.wait(completion);
+ */
+class AsyncIO {
+public:
+    /**
+     * @brief Constructor
+     * @param queue_depth Maximum requests in flight
+     */
+    explicit AsyncIO(unsigned queue_depth = ASYNC_IO_QUEUE_DEPTH);
+    ~AsyncIO();
+    
+    AsyncIO(const AsyncIO&) = delete;
+    AsyncIO& operator=(const AsyncIO&) = delete;
+    
+    /**
+     * @brief Queue a pread
+     * @return false if the queue is full
+     */
+    bool submitRead(int fd, void* buffer, size_t size, uint64_t offset, uint64_t tag);
+    
+    /**
+     * @brief Wait for the next completion (any order)
+     * @return false if nothing is in flight or the wait failed
+     */
+    bool wait(AsyncIOCompletion& completion);
+    
+    AsyncIOBackend backend() const { return backend_; }
+    unsigned inFlight() const { return in_flight_; }
+    unsigned queueDepth() const { return queue_depth_; }
+
+private:
+    struct Request {
+        int fd;
+        void* buffer;
+        size_t size;
+        uint64_t offset;
+        uint64_t tag;
+    };
+    
+    AsyncIOBackend backend_;
+    unsigned queue_depth_;
+    unsigned in_flight_;
+    
+    // io_uring
+    int ring_fd_;
+    void* sq_ring_;
+    void* cq_ring_;
+    void* sqes_;
+    size_t sq_ring_size_;
+    size_t cq_ring_size_;
+    size_t sqes_size_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    void* cqes_;
+    
+    // Thread pool
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable request_cv_;
+    std::condition_variable completion_cv_;
+    std::deque<Request> requests_;
+    std::deque<AsyncIOCompletion> completions_;
+    bool stopping_;
+    
+    bool submit(const Request& request);
+    
+    /**
+     * @brief Set up the ring
+     * @return false if io_uring is unavailable (thread pool is used)
+     */
+    bool setupRing();
+    void closeRing();
+    bool submitRing(const Request& request);
+    bool waitRing(AsyncIOCompletion& completion);
+    
+    void startPool();
+    void stopPool();
+    void workerLoop();
+};
+
+// ==================== Async File Reader ====================
+
+/**
+ * @brief Consumer of in-order blocks
+ * @return false to stop reading
+ */
+using AsyncReadConsumer = std::function<bool(const uint8_t* data, size_t size)>;
+
+/**
+ * @brief Async File Reader Class
+ *
+ * Usage:
+ *   AsyncFileReader reader;
+ *   reader.read(path, 0, size, [&](const uint8_t* data, size_t n) { return hash(data, n); });
+ */
+class AsyncFileReader {
+public:
+    /**
+     * @brief Constructor
+     * @param block_size Bytes per read (rounded up to ASYNC_IO_ALIGNMENT)
+     * @param queue_depth Reads in flight
+     */
+    explicit AsyncFileReader(size_t block_size = ASYNC_IO_BLOCK_SIZE, unsigned queue_depth = ASYNC_IO_QUEUE_DEPTH);
+    
+    /**
+     * @brief Read [offset, offset + length) of an open file in order
+     * @return true if every byte was read and accepted by the consumer
+     */
+    bool read(int fd, uint64_t offset, uint64_t length, const AsyncReadConsumer& consumer);
+    
+    /**
+     * @brief Read [offset, offset + length) of a file in order
+     */
+    bool read(const std::string& path, uint64_t offset, uint64_t length, const AsyncReadConsumer& consumer);
+    
+    /**
+     * @brief Read a whole file in order
+     */
+    bool readFile(const std::string& path, const AsyncReadConsumer& consumer);
+    
+    AsyncIOBackend backend() const { return io_.backend(); }
+    const std::string& getError() const { return error_; }
+
+private:
+    AsyncIO io_;
+    size_t block_size_;
+    std::vector<AsyncIOBuffer> buffers_;
+    std::string error_;
+};
+
+#endif // ASYNC_IO_HPP
@@ -0,0 +1,27 @@
+/**
+ * @file atomic_file.hpp
+ * @brief Crash-safe whole-file replacement
+ *
+ * The content goes to "<path>.tmp", which is fsync()ed and renamed over
+ * path; the parent directory is fsync()ed so the rename survives a power
+ * loss. Readers see either the old or the new file, never a partial one.
+ * Used for the package index, campaign queue and UDS checkpoints.
+ */
+
+#ifndef ATOMIC_FILE_HPP
+#define ATOMIC_FILE_HPP
+
+#include <string>
+
+// ==================== Functions ====================
+
+/**
+ * @brief Replace a file with new content atomically and durably
+ * @param path File to replace (created if missing)
+ * @param content New file content
+ * @param error Set on failure
+ * @return true if the new content is on disk under path
+ */
+bool writeFileAtomic(const std::string& path, const std::string& content, std::string& error);
+
+#endif // ATOMIC_FILE_HPP
@@ -0,0 +1,182 @@
+/**
+ * @file campaign_scheduler.hpp
+ * @brief Persistent OTA campaign queue run by vehicle state
+ *
+ * Campaigns wait in a queue on the data partition instead of being
+ * rejected while another OTA runs. Each campaign names the vehicle states
+ * its download and install phases may run in; tick() starts the best
+ * waiting campaign once its download phase is allowed and, while it runs,
+ * maps the current state onto OTAManager::setAllowedPhases(). A job whose
+ * phase is not allowed pauses at its next chunk / block and continues when
+ * the vehicle is back in an allowed state, so the bulk download can use
+ * driving time while flashing waits for a parked window.
+ *
+ * The queue is a small JSON file replaced atomically (temp file, fsync,
+ * rename) on every change. A campaign interrupted by a restart runs again
+ * from the start (the verified package index still skips a finished
+ * download).
+ */
+
+#ifndef CAMPAIGN_SCHEDULER_HPP
+#define CAMPAIGN_SCHEDULER_HPP
+
+#include "ota_manager.hpp"
+#include "config_manager.hpp"
+#include "vehicle_state.hpp"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+// ==================== Constants ====================
+
+#define OTA_CAMPAIGN_QUEUE_FILENAME     "campaign_queue.json"
+#define OTA_CAMPAIGN_QUEUE_VERSION      1
+#define OTA_CAMPAIGN_MAX_QUEUED         16
+#define OTA_CAMPAIGN_MAX_ATTEMPTS       3       // Failed runs before a campaign is dropped (configurable)
+#define OTA_CAMPAIGN_RETRY_DELAY_SEC    60      // Wait after a failed run (times the attempt count)
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief Queued OTA campaign
+ */
+struct OTACampaign {
+    OTAPackageInfo package;
+    OTAJobType type;
+    int32_t priority;               // Higher runs first
+    int64_t deadline;               // Unix time; dropped if not started by then (0 = none)
+    uint32_t download_states;       // vehicleStateBit() mask for the download phase
+    uint32_t install_states;        // vehicleStateBit() mask for the install phase
+    int64_t queued_at;              // Unix time
+    int64_t not_before;             // Unix time; retry delay after a failed run
+    uint32_t attempts;              // Runs started so far
+};
+
+// ==================== Campaign Scheduler ====================
+
+/**
+ * @brief Campaign Scheduler Class
+ *
+ * Usage:
+ *   CampaignScheduler scheduler(config, ota_manager);
+ *   scheduler.initialize();                                 // loads the queue
+ *   scheduler.enqueue(start_ota_command);                   // any thread (MQTT)
+ *   scheduler.tick(vehicle_state.getCurrentState(), now);   // main loop
+ *
+ * Order: priority (high first), then deadline (earliest first, none last),
+ * then queue time. One campaign runs at a time and is not preempted; the
+ * scheduler must be the only caller of OTAManager::submitOTA().
+ */
+class CampaignScheduler {
+public:
+    /**
+     * @brief Constructor
+     * @param config Configuration manager
+     * @param ota_manager Runs the jobs
+     */
+    CampaignScheduler(ConfigManager& config, OTAManager& ota_manager);
+    
+    /**
+     * @brief Read settings and load the queue from disk
+     * @return false if a configured vehicle state name is unknown
+     *
+     * An unreadable queue file is logged and the queue starts empty.
+     */
+    bool initialize();
+    
+    /**
+     * @brief Add a campaign, or update a waiting one with the same campaign_id
+     * @return false if the campaign is running or the queue is full
+     */
+    bool enqueue(const OTACampaign& campaign);
+    
+    /**
+     * @brief Add a campaign from a start_ota command
+     * @param command Campaign JSON (see parseCampaign()); missing states use the configured defaults
+     * @return false if the command is invalid or enqueue() refused it
+     */
+    bool enqueue(const nlohmann::json& command);
+    
+    /**
+     * @brief Remove a waiting campaign or cancel the running one
+     * @param campaign_id Campaign ID (empty = the running campaign)
+     * @return false if no such campaign
+     *
+     * A running campaign stops at its next chunk / block and is dropped by
+     * tick() once the worker reports OTA_CANCELLED.
+     */
+    bool cancel(const std::string& campaign_id);
+    
+    /**
+     * @brief Advance the queue for the current vehicle state
+     * @param state Current vehicle state
+     * @param now Unix time
+     *
+     * Updates the phase gate of the running job, retires a finished one
+     * (COMPLETED / CANCELLED dropped, ERROR retried up to max attempts),
+     * drops expired campaigns and starts the next runnable one.
+     */
+    void tick(VehicleState state, int64_t now);
+    
+    size_t size() const;
+    std::string getRunningCampaign() const;
+    
+    /**
+     * @brief Build a campaign from JSON (start_ota command or queue entry)
+     * @param j campaign_id, package_url (required); package_size, firmware_version,
+     *          sha256_hash, target_partition, package_type ("single" / "vehicle"),
+     *          priority, deadline, download_states, install_states (state names)
+     * @param download_states Default download mask if j has none
+     * @param install_states Default install mask if j has none
+     * @param campaign Output
+     * @param error Reason on failure
+     * @return false if a required field is missing, a state name is unknown or a phase has no state
+     */
+    static bool parseCampaign(const nlohmann::json& j, uint32_t download_states, uint32_t install_states,
+                              OTACampaign& campaign, std::string& error);
+    
+    static nlohmann::json campaignToJson(const OTACampaign& campaign);
+
+private:
+    ConfigManager& config_;
+    OTAManager& ota_manager_;
+    std::string queue_path_;
+    uint32_t max_attempts_;
+    uint32_t default_download_states_;
+    uint32_t default_install_states_;
+    
+    mutable std::mutex mutex_;
+    std::vector<OTACampaign> campaigns_;    // Waiting and running
+    std::string running_id_;                // Submitted to ota_manager_ (empty = none)
+    
+    /**
+     * @brief Retire the running campaign once the OTA worker is idle
+     */
+    void finishRunning(int64_t now);
+    
+    /**
+     * @brief Index of the best campaign startable in a state (-1 = none)
+     */
+    int pickNext(uint32_t state_bit, int64_t now) const;
+    
+    /**
+     * @brief OTA_PHASE_* mask a campaign allows in a state
+     */
+    static uint8_t allowedPhases(const OTACampaign& campaign, uint32_t state_bit);
+    
+    std::vector<OTACampaign>::iterator find(const std::string& campaign_id);
+    
+    /**
+     * @brief Load queue from disk
+     */
+    bool load();
+    
+    /**
+     * @brief Write queue atomically (temp file + fsync + rename)
+     */
+    bool save() const;
+};
+
+#endif // CAMPAIGN_SCHEDULER_HPP
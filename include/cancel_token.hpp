@@ -0,0 +1,77 @@
+/**
+ * @file cancel_token.hpp
+ * @brief Cooperative cancellation / pause flag for long-running OTA work
+ *
+ * One thread calls cancel() or pause(); the worker checks the token between
+ * chunks and blocks. A cancelled worker unwinds through its normal error
+ * path, a paused one waits at the check until resume() or cancel().
+ */
+
+#ifndef CANCEL_TOKEN_HPP
+#define CANCEL_TOKEN_HPP
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @brief Cancel Token Class
+ *
+ * Usage:
+ *   CancelToken cancel;
+ *   writer.setCancelToken(&cancel);
+ *   cancel.cancel();                        // any thread
+ *   if (cancel.isCancelled()) { ... }       // worker, between blocks
+ *   if (!cancel.waitWhilePaused()) { ... }  // worker checkpoint: honours pause()
+ */
+class CancelToken {
+public:
+    CancelToken() : cancelled_(false), paused_(false) {}
+    
+    CancelToken(const CancelToken&) = delete;
+    CancelToken& operator=(const CancelToken&) = delete;
+    
+    void cancel() { set(cancelled_, true); }
+    void pause() { set(paused_, true); }
+    void resume() { set(paused_, false); }
+    
+    void reset() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_.store(false, std::memory_order_release);
+            paused_.store(false, std::memory_order_release);
+        }
+        cv_.notify_all();
+    }
+    
+    bool isCancelled() const { return cancelled_.load(std::memory_order_acquire); }
+    bool isPaused() const { return paused_.load(std::memory_order_acquire); }
+    
+    /**
+     * @brief Checkpoint: block while paused
+     * @return false if cancelled (before or while paused)
+     */
+    bool waitWhilePaused() const {
+        if (isPaused() && !isCancelled()) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return !isPaused() || isCancelled(); });
+        }
+        return !isCancelled();
+    }
+
+private:
+    std::atomic<bool> cancelled_;
+    std::atomic<bool> paused_;
+    mutable std::mutex mutex_;                  // Only taken to wait / wake paused workers
+    mutable std::condition_variable cv_;
+    
+    void set(std::atomic<bool>& flag, bool value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flag.store(value, std::memory_order_release);
+        }
+        cv_.notify_all();
+    }
+};
+
+#endif // CANCEL_TOKEN_HPP
@@ -9,6 +9,7 @@
 #define CONFIG_MANAGER_HPP
 
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 /**
@@ -140,12 +141,33 @@ public:
     std::string getOtaInstallPath() const;
     std::string getOtaBackupPath() const;
     int getMaxPackageSizeMb() const;
-    
-    // Dual Partition paths (simulation mode)
+    int getVerifyThreads() const;           // 0 = one per CPU core
+    int getZgwMaxConcurrent() const;        // Zone transfers per ZGW (0 = unlimited)
+    int getZstdWindowLogMax() const;        // Largest zstd decoder window (log2 bytes)
+    bool isStreamInstallEnabled() const;    // Download A/B images straight into the standby partition
+    bool isSkipUnchangedBlocksEnabled() const;  // Compare with the standby partition, write only changes
+    int getPipelineBuffers() const;         // Download pipeline buffers (peak memory = buffers x chunk)
+    bool isOverlapZoneFlashEnabled() const; // Send Vehicle OTA zones to ZGWs while later zones download
+    bool isUdsFileTransferEnabled() const;  // Try 0x38 ReplaceFile / ResumeFile before 0x34 RequestDownload
+    int getUdsMaxBlockBytes() const;        // 0x36 payload cap (0 = ZGW maxNumberOfBlockLength)
+    int getProgressReportIntervalMs() const;    // MQTT progress sampling period
+    int getProgressLogIntervalMs() const;       // Progress log line period (0 = off)
+    int getCampaignMaxAttempts() const;         // Failed runs before a queued campaign is dropped
+    std::vector<std::string> getCampaignDownloadStates() const;  // Default vehicle states for the download phase
+    std::vector<std::string> getCampaignInstallStates() const;   // Default vehicle states for the install phase
+    
+    // Dual Partition paths
     std::string getPartitionAPath() const;
     std::string getPartitionBPath() const;
+    std::string getDataPartitionPath() const;
+    std::string getDataMountPoint() const;
     std::string getBootStatusPath() const;
     
+    // Simulation partitions (sparse image files instead of block devices)
+    bool isPartitionSimulation() const;
+    std::string getSimulationImageDir() const;
+    int getSimulationImageSizeMb() const;
+    
     // ========================================
     // Logging Configuration
     // ========================================
@@ -0,0 +1,71 @@
+/**
+ * @file crc32.hpp
+ * @brief CRC32 (IEEE 802.3, zlib-compatible) with hardware acceleration
+ *
+ * Kernels (selected once at runtime):
+ *   - x86-64:  PCLMULQDQ carry-less multiply folding (CPUID: pclmul + sse4.1)
+ *   - AArch64: ARMv8 CRC32 instructions (HWCAP_CRC32)
+ *   - Portable: zlib crc32() (table-driven)
+ *
+ * All kernels produce the same value as zlib crc32().
+ */
+
+#ifndef CRC32_HPP
+#define CRC32_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief CRC32 implementation
+ */
+enum class CRC32Kernel : uint8_t {
+    PORTABLE = 0,       /* zlib table-driven */
+    X86_PCLMUL = 1,     /* x86-64 PCLMULQDQ folding */
+    ARMV8_CRC = 2       /* AArch64 CRC32 instructions */
+};
+
+// ==================== Functions ====================
+
+/**
+ * @brief Update a running CRC32 with a buffer (uses the selected kernel)
+ * @param crc Running CRC (0 for a new computation)
+ * @param data Input data
+ * @param size Input size in bytes
+ * @return Updated CRC
+ */
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size);
+
+/**
+ * @brief Update a running CRC32 with a specific kernel (benchmarks / tests)
+ * @note Falls back to PORTABLE if the kernel is not supported on this CPU
+ */
+uint32_t crc32UpdateWith(CRC32Kernel kernel, uint32_t crc, const uint8_t* data, size_t size);
+
+/**
+ * @brief Combine CRC(A) and CRC(B) into CRC(A || B)
+ * @param crc1 CRC32 of first block
+ * @param crc2 CRC32 of second block
+ * @param length2 Length of second block in bytes
+ * @return CRC32 of the concatenation
+ */
+uint32_t crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t length2);
+
+/**
+ * @brief Kernel chosen for this CPU (detected once)
+ */
+CRC32Kernel crc32SelectedKernel();
+
+/**
+ * @brief Check if a kernel can run on this CPU
+ */
+bool crc32KernelSupported(CRC32Kernel kernel);
+
+/**
+ * @brief Kernel name for logging
+ */
+const char* crc32KernelName(CRC32Kernel kernel);
+
+#endif // CRC32_HPP
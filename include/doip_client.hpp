@@ -66,11 +66,27 @@ enum class UDSService : uint8_t {
     REQUEST_DOWNLOAD = 0x34,
     TRANSFER_DATA = 0x36,
     REQUEST_TRANSFER_EXIT = 0x37,
+    REQUEST_FILE_TRANSFER = 0x38,
     
     // Positive response offset
     POSITIVE_RESPONSE = 0x40
 };
 
+// UDS negative response (0x7F, SID, NRC)
+constexpr uint8_t UDS_NEGATIVE_RESPONSE = 0x7F;
+constexpr uint8_t UDS_NRC_SERVICE_NOT_SUPPORTED = 0x11;
+constexpr uint8_t UDS_NRC_SUB_FUNCTION_NOT_SUPPORTED = 0x12;
+constexpr uint8_t UDS_NRC_REQUEST_OUT_OF_RANGE = 0x31;
+constexpr uint8_t UDS_NRC_SERVICE_NOT_SUPPORTED_IN_SESSION = 0x7F;
+
+// RequestFileTransfer (0x38) modeOfOperation
+constexpr uint8_t UDS_MOOP_REPLACE_FILE = 0x03;
+constexpr uint8_t UDS_MOOP_RESUME_FILE = 0x06;     // Continue a partial file at the position the server reports
+
+// RequestDownload (0x34) dataFormatIdentifier: compressionMethod (high nibble) | encryptingMethod (low nibble)
+constexpr uint8_t UDS_DFI_UNCOMPRESSED = 0x00;
+constexpr uint8_t UDS_DFI_ZSTD = 0x10;      // zstd ECU payloads (ZoneECUEntry::compression), ZGW decompresses
+
 /*******************************************************************************
  * UDS Routine Control IDs (parallel with ZGW vmg_server.py)
  ******************************************************************************/
@@ -178,6 +194,9 @@ public:
      */
     DoIPClientState getState() const;
     
+    const std::string& getZgwIp() const { return zgw_ip_; }
+    uint16_t getZgwPort() const { return zgw_port_; }
+    
     /***************************************************************************
      * UDS Routine Control Commands (parallel with vmg_server.py)
      **************************************************************************/
@@ -226,6 +245,30 @@ public:
      */
     bool sendFirmware(const std::string& ecu_id, 
                       const std::vector<uint8_t>& firmware_data);
+    
+    /***************************************************************************
+     * DoIP Message Framing (stateless)
+     **************************************************************************/
+    
+    /**
+     * @brief Build DoIP message (header + payload)
+     * @param payload_type DoIP payload type
+     * @param payload Payload data
+     * @return Complete DoIP message
+     */
+    static std::vector<uint8_t> buildDoIPMessage(DoIPPayloadType payload_type,
+                                                  const std::vector<uint8_t>& payload);
+    
+    /**
+     * @brief Parse DoIP header and extract payload
+     * @param response Raw DoIP message
+     * @param payload_type Output: payload type
+     * @param payload Output: payload data
+     * @return true if valid DoIP message
+     */
+    static bool parseDoIPMessage(const std::vector<uint8_t>& response,
+                                 DoIPPayloadType& payload_type,
+                                 std::vector<uint8_t>& payload);
 
 private:
     /***************************************************************************
@@ -247,26 +290,6 @@ private:
      */
     bool activateRouting();
     
-    /**
-     * @brief Build DoIP message (header + payload)
-     * @param payload_type DoIP payload type
-     * @param payload Payload data
-     * @return Complete DoIP message
-     */
-    std::vector<uint8_t> buildDoIPMessage(DoIPPayloadType payload_type,
-                                           const std::vector<uint8_t>& payload);
-    
-    /**
-     * @brief Parse DoIP header and extract payload
-     * @param response Raw DoIP message
-     * @param payload_type Output: payload type
-     * @param payload Output: payload data
-     * @return true if valid DoIP message
-     */
-    bool parseDoIPMessage(const std::vector<uint8_t>& response,
-                          DoIPPayloadType& payload_type,
-                          std::vector<uint8_t>& payload);
-    
     /***************************************************************************
      * UDS Low-Level Functions
      **************************************************************************/
@@ -0,0 +1,156 @@
+/**
+ * @file ecu_compression.hpp
+ * @brief zstd-compressed ECU firmware payloads
+ *
+ * An ECU Package may store its firmware as one zstd frame
+ * (ZoneECUEntry::compression = ECU_COMPRESSION_ZSTD). The table entry then
+ * describes the stored bytes (firmware_size, crc32) and uncompressed_size the
+ * image; ECUMetadata keeps describing the image the ECU flashes.
+ *
+ * Compressed Zone Packages go to a ZGW as-is if it accepts the zstd
+ * dataFormatIdentifier in RequestDownload (0x34). Otherwise the VMG expands
+ * the Zone Package with a streaming decoder whose window is capped at
+ * 1 << window_log_max bytes, so memory stays bounded for any firmware size.
+ *
+ * Requires libzstd (VMG_HAVE_ZSTD); without it compressed packages are
+ * parsed and verified, but cannot be expanded or built.
+ */
+
+#ifndef ECU_COMPRESSION_HPP
+#define ECU_COMPRESSION_HPP
+
+#include "zone_package.hpp"
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// ==================== Constants ====================
+
+#define ECU_ZSTD_WINDOW_LOG_MIN         10      // 1KB (zstd minimum)
+#define ECU_ZSTD_WINDOW_LOG_DEFAULT     23      // 8MB: builder window and VMG decoder cap
+#define ECU_ZSTD_WINDOW_LOG_MAX         27      // 128MB
+#define ECU_ZSTD_LEVEL_DEFAULT          19
+
+// ==================== Functions ====================
+
+/**
+ * @brief Check if this build can decode / encode a compression method
+ */
+bool ecuCompressionAvailable(uint8_t compression);
+
+/**
+ * @brief Compression method name for logging
+ */
+const char* ecuCompressionName(uint8_t compression);
+
+/**
+ * @brief Check if any ECU Package in a zone stores compressed firmware
+ */
+bool zoneHasCompressedECUs(const ZonePackageView& zone);
+
+/**
+ * @brief Write a copy of a Zone Package with all firmware decompressed
+ *
+ * ECU Packages are written back to back in offset order; offsets, sizes,
+ * ECU CRCs and zone_crc32 are recomputed. Every decoded image is checked
+ * against ECUMetadata::firmware_size / firmware_crc32.
+ *
+ * @param zone Zone Package (ECU table validated by ZonePackageView::open)
+ * @param output_path Output Zone Package file
+ * @param window_log_max Largest decoder window accepted (log2 bytes)
+ * @return true if written and all images verified
+ */
+bool expandZonePackage(const ZonePackageView& zone, const std::string& output_path,
+                       unsigned window_log_max = ECU_ZSTD_WINDOW_LOG_DEFAULT);
+
+// ==================== Streaming Codec ====================
+
+/**
+ * @brief Receives decoded / encoded bytes; return false to abort
+ */
+using ZstdSink = std::function<bool(const uint8_t* data, size_t size)>;
+
+/**
+ * @brief Streaming zstd decoder with a bounded window
+ *
+ * Usage:
+ *   ZstdStreamDecoder decoder(23);
+ *   decoder.decompress(frame, frame_size, image_size, [&](const uint8_t* p, size_t n) {
+ *       return write(p, n);
+ *   });
+ */
+class ZstdStreamDecoder {
+public:
+    explicit ZstdStreamDecoder(unsigned window_log_max = ECU_ZSTD_WINDOW_LOG_DEFAULT);
+    ~ZstdStreamDecoder();
+    
+    ZstdStreamDecoder(const ZstdStreamDecoder&) = delete;
+    ZstdStreamDecoder& operator=(const ZstdStreamDecoder&) = delete;
+    
+    /**
+     * @brief Decode one frame
+     * @param data zstd frame
+     * @param size Frame size
+     * @param expected_size Decoded size (ZoneECUEntry::uncompressed_size)
+     * @param sink Output, in chunks of up to ZSTD_DStreamOutSize()
+     * @return true if the frame decoded to exactly expected_size bytes
+     */
+    bool decompress(const uint8_t* data, size_t size, uint64_t expected_size, const ZstdSink& sink);
+    
+    const std::string& getError() const { return error_; }
+
+private:
+    void* dctx_;
+    std::vector<uint8_t> buffer_;
+    std::string error_;
+};
+
+/**
+ * @brief Streaming zstd encoder (package builder)
+ *
+ * Frames carry the content size and a checksum. The window is the smallest
+ * power of two covering the content, capped at window_log.
+ */
+class ZstdStreamEncoder {
+public:
+    ZstdStreamEncoder(int level = ECU_ZSTD_LEVEL_DEFAULT, unsigned window_log = ECU_ZSTD_WINDOW_LOG_DEFAULT);
+    ~ZstdStreamEncoder();
+    
+    ZstdStreamEncoder(const ZstdStreamEncoder&) = delete;
+    ZstdStreamEncoder& operator=(const ZstdStreamEncoder&) = delete;
+    
+    /**
+     * @brief Start a frame
+     * @param content_size Total bytes that will be passed to compress()
+     */
+    bool begin(uint64_t content_size);
+    
+    /**
+     * @brief Feed input; last = true ends the frame
+     */
+    bool compress(const uint8_t* data, size_t size, bool last, const ZstdSink& sink);
+    
+    /**
+     * @brief Window used for the current frame (ZoneECUEntry::window_log)
+     */
+    uint8_t windowLog() const { return frame_window_log_; }
+    
+    const std::string& getError() const { return error_; }
+    
+    /**
+     * @brief Worst-case frame size for size input bytes
+     */
+    static uint64_t compressBound(uint64_t size);
+
+private:
+    void* cctx_;
+    int level_;
+    unsigned window_log_;
+    uint8_t frame_window_log_;
+    std::vector<uint8_t> buffer_;
+    std::string error_;
+};
+
+#endif // ECU_COMPRESSION_HPP
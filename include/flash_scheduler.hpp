@@ -0,0 +1,149 @@
+/**
+ * @file flash_scheduler.hpp
+ * @brief ECU dependency-graph flash scheduler
+ *
+ * Builds the cross-zone ECU dependency DAG from ECUMetadata::dependencies,
+ * orders it topologically (ZoneECUEntry::priority breaks ties) and
+ * dispatches Zone Packages to their ZGWs concurrently.
+ *
+ * VMG transfers whole Zone Packages; the ZGW flashes the ECUs inside a zone
+ * in priority order. Scheduling is therefore done per zone: a zone is
+ * dispatched once every zone holding one of its ECUs' dependencies has
+ * finished. Ready zones are started longest critical path first, limited
+ * per ZGW.
+ *
+ * With an UpdatePlan, ECUs already at the target version are left out of the
+ * graph and zones without an ECU to update are skipped (not read, not sent).
+ */
+
+#ifndef FLASH_SCHEDULER_HPP
+#define FLASH_SCHEDULER_HPP
+
+#include "vehicle_package.hpp"
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+struct UpdatePlan;
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief ECU node in the dependency graph
+ */
+struct FlashECU {
+    std::string ecu_id;
+    size_t zone;                        // Index into zone list
+    uint8_t priority;                   // 0 = highest
+    uint32_t version;                   // Version in this package
+    std::vector<size_t> depends_on;     // ECUs that must be flashed first
+};
+
+/**
+ * @brief Zone Package transfer job
+ */
+struct ZoneFlashJob {
+    size_t zone;                        // Index into zone list
+    uint8_t zone_number;
+    std::string zgw;                    // "ip:port" of target ZGW
+    uint8_t priority;                   // Highest ECU priority in the zone
+    uint64_t size;                      // Zone Package size (bytes)
+    bool skipped;                       // No ECU to update: not transferred
+    uint64_t critical_path;             // Bytes on the longest chain starting here
+    std::vector<size_t> depends_on;     // Jobs that must finish first
+    std::vector<size_t> dependents;     // Jobs waiting for this one
+};
+
+// ==================== Flash Scheduler ====================
+
+/**
+ * @brief Flash Scheduler Class
+ *
+ * Usage:
+ *   FlashScheduler scheduler;
+ *   scheduler.build(parser.getView(), parser.getZonePackages());
+ *   scheduler.run(1, [&](size_t zone) { return sendZone(zones[zone]); });
+ */
+class FlashScheduler {
+public:
+    FlashScheduler();
+    
+    /**
+     * @brief Build ECU and zone dependency graphs
+     * @param package Parsed Vehicle Package
+     * @param zones Zone list (same order as package zone_refs)
+     * @param plan Selective update plan (nullptr = update every ECU)
+     * @return false on invalid zone, duplicate ECU, unsatisfiable
+     *         min_version or dependency cycle
+     */
+    bool build(const VehiclePackageView& package, const std::vector<ZonePackageInfo>& zones,
+               const UpdatePlan* plan = nullptr);
+    
+    /**
+     * @brief Dispatch zones in dependency order
+     * @param per_zgw_limit Max concurrent transfers per ZGW (0 = unlimited)
+     * @param flash Transfer function, called from worker threads with the zone index
+     * @return true if every zone was transferred (skipped zones count as done);
+     *         no new zone starts after a failure
+     */
+    bool run(unsigned per_zgw_limit, const std::function<bool(size_t zone)>& flash);
+    
+    /**
+     * @brief Get the order run() starts zones in with one transfer at a time
+     *
+     * Zones to download for an overlapped download / flash: fetching them in
+     * this order lets the first transfer start as early as possible.
+     *
+     * @return Zone indices (skipped zones left out)
+     */
+    std::vector<size_t> getTransferOrder() const;
+    
+    /**
+     * @brief Get ECU nodes
+     */
+    const std::vector<FlashECU>& getECUs() const { return ecus_; }
+    
+    /**
+     * @brief Get ECUs in topological order (priority tie-break)
+     */
+    const std::vector<size_t>& getECUOrder() const { return ecu_order_; }
+    
+    /**
+     * @brief Get zone transfer jobs (same order as zone list)
+     */
+    const std::vector<ZoneFlashJob>& getJobs() const { return jobs_; }
+    
+    /**
+     * @brief Print flash order and zone dependencies
+     */
+    void printPlan() const;
+
+private:
+    std::vector<FlashECU> ecus_;
+    std::vector<size_t> ecu_order_;
+    std::vector<ZoneFlashJob> jobs_;
+    
+    /**
+     * @brief Read ECU nodes and dependencies from the package
+     */
+    bool collectECUs(const VehiclePackageView& package, const std::vector<ZonePackageInfo>& zones,
+                     const UpdatePlan* plan);
+    
+    /**
+     * @brief Kahn topological sort of ECUs, lowest priority value first
+     */
+    bool orderECUs();
+    
+    /**
+     * @brief Derive zone jobs, check for zone-level cycles, compute critical paths
+     */
+    bool buildJobs(const std::vector<ZonePackageInfo>& zones, const UpdatePlan* plan);
+    
+    /**
+     * @brief Dispatch order of two ready jobs: longest critical path, then priority
+     */
+    bool startsBefore(size_t a, size_t b) const;
+};
+
+#endif // FLASH_SCHEDULER_HPP
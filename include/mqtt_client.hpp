@@ -105,6 +105,17 @@ public:
      * @brief Send heartbeat (status update)
      */
     bool sendHeartbeat(const std::string& vehicle_state, int uptime_sec);
+    
+    // ========================================
+    // Payload Builders (JSON, used by send*)
+    // ========================================
+    
+    std::string buildWakeUpPayload(const std::string& vmg_sw_version, const std::string& vehicle_state) const;
+    std::string buildVciReportPayload(const std::string& vci_json) const;
+    std::string buildReadinessResponsePayload(const std::string& readiness_json) const;
+    std::string buildDownloadProgressPayload(const std::string& campaign_id, int percentage,
+                                             int bytes_downloaded, int total_bytes) const;
+    std::string buildHeartbeatPayload(const std::string& vehicle_state, int uptime_sec) const;
 
 private:
     std::string host_;
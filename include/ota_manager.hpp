@@ -19,6 +19,12 @@
 #include <functional>
 #include <memory>
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <type_traits>
+#include <nlohmann/json.hpp>
 #include "partition_manager.hpp"
 #include "http_client.hpp"
 #include "mqtt_client.hpp"
@@ -26,17 +32,39 @@
 #include "vehicle_package.hpp"
 #include "zone_package.hpp"
 #include "doip_client.hpp"
+#include "cancel_token.hpp"
+#include "progress_publisher.hpp"
+
+struct UpdatePlan;
+struct PipelineBlock;
+class OTAPipeline;
+class UdsCheckpointStore;
 
 // ==================== Constants ====================
 
 #define OTA_DOWNLOAD_CHUNK_SIZE     (64 * 1024)     // 64KB chunks (configurable)
 #define OTA_MAX_RETRY_ATTEMPTS      3               // Maximum download retry
-#define OTA_PROGRESS_REPORT_INTERVAL 5              // Report every 5% progress
+#define OTA_PROGRESS_REPORT_INTERVAL_MS 1000        // MQTT progress sampling period (configurable)
+#define OTA_PROGRESS_STEP_MAX       96              // current_step buffer (bytes, incl. NUL)
+#define OTA_PROGRESS_ERROR_MAX      192             // error_message buffer (bytes, incl. NUL)
+
+// Job phases gated by vehicle state (setAllowedPhases() mask)
+#define OTA_PHASE_DOWNLOAD          0x01            // DOWNLOADING / VERIFYING: network, VMG storage
+#define OTA_PHASE_INSTALL           0x02            // INSTALLING / READY: partition writes, ECU flashing
+#define OTA_PHASE_ALL               (OTA_PHASE_DOWNLOAD | OTA_PHASE_INSTALL)
 
 // ==================== Type Definitions ====================
 
 /**
  * @brief OTA Update State (parallel to ZGW update flow)
+ *
+ * Transitions (anything else is rejected by updateState()):
+ *   IDLE / COMPLETED / ERROR / CANCELLED → DOWNLOADING, VERIFYING
+ *   DOWNLOADING → VERIFYING, COMPLETED
+ *   VERIFYING   → INSTALLING, COMPLETED
+ *   INSTALLING  → READY, COMPLETED
+ *   READY       → COMPLETED
+ *   any active state → ERROR, CANCELLED
  */
 enum class OTAState : uint8_t {
     OTA_IDLE = 0,              /* No OTA in progress */
@@ -45,21 +73,38 @@ enum class OTAState : uint8_t {
     OTA_INSTALLING = 3,        /* Installing to standby partition */
     OTA_READY = 4,             /* Ready to reboot */
     OTA_ERROR = 5,             /* Error occurred */
-    OTA_COMPLETED = 6          /* OTA completed successfully */
+    OTA_COMPLETED = 6,         /* OTA completed successfully */
+    OTA_CANCELLED = 7          /* Stopped by cancelOTA() */
+};
+
+/**
+ * @brief Package layout of an OTA job
+ */
+enum class OTAJobType : uint8_t {
+    SINGLE_PACKAGE = 0,        /* VMG A/B image (startOTA) */
+    VEHICLE_PACKAGE = 1        /* 3-layer Vehicle Package (startVehicleOTA) */
 };
 
 /**
  * @brief OTA Progress Information
+ *
+ * Plain data: published as a whole through a seqlock (ProgressPublisher).
+ * Text fields are NUL-terminated and truncated to fit.
  */
 struct OTAProgress {
     OTAState state;                 /* Current OTA state */
     uint32_t total_bytes;           /* Total package size */
     uint32_t downloaded_bytes;      /* Downloaded bytes */
     uint8_t  percentage;            /* Progress percentage (0-100) */
-    std::string current_step;       /* Current step description */
-    std::string error_message;      /* Error message (if any) */
+    uint32_t throughput_kbps;       /* Measured install write throughput (0 = not installing) */
+    uint32_t blocks_written;        /* Partition blocks written (skip-unchanged install) */
+    uint32_t blocks_skipped;        /* Partition blocks already up to date */
+    char     current_step[OTA_PROGRESS_STEP_MAX];      /* Current step description */
+    char     error_message[OTA_PROGRESS_ERROR_MAX];    /* Error message (empty if none) */
 };
 
+static_assert(std::is_trivially_copyable<OTAProgress>::value, "OTAProgress is published through a seqlock");
+
 /**
  * @brief OTA Package Metadata (from server)
  */
@@ -98,16 +143,52 @@ public:
         std::vector<std::shared_ptr<DoIPClient>> doip_clients = {}
     );
     
+    /**
+     * @brief Destructor (cancels a running job, joins the worker and progress subscribers)
+     */
+    ~OTAManager();
+    
+    OTAManager(const OTAManager&) = delete;
+    OTAManager& operator=(const OTAManager&) = delete;
+    
     /**
      * @brief Initialize OTA manager
      * @return true if successful
      */
     bool initialize();
     
+    /**
+     * @brief Run an OTA job on the worker thread
+     * @param package_info OTA package information
+     * @param type Package layout
+     * @return false if a job is already queued or running
+     *
+     * Returns immediately; follow the job with getState() / getProgress().
+     */
+    bool submitOTA(const OTAPackageInfo& package_info, OTAJobType type);
+    
+    /**
+     * @brief Check if the worker has a job queued or running
+     */
+    bool isBusy() const;
+    
+    /**
+     * @brief Wait until the worker is idle
+     * @param timeout_ms Maximum wait (0 = forever)
+     * @return true if idle
+     */
+    bool waitIdle(uint32_t timeout_ms = 0);
+    
+    /**
+     * @brief Cancel the running job, stop the worker thread and the progress subscribers
+     */
+    void stopWorker();
+    
     /**
      * @brief Start OTA update process (Legacy: single package)
      * @param package_info OTA package information
      * @return true if OTA started successfully
+     * @note Blocks the caller; submitOTA() runs it on the worker thread
      */
     bool startOTA(const OTAPackageInfo& package_info);
     
@@ -117,46 +198,109 @@ public:
      * @return true if OTA started successfully
      * 
      * Flow:
-     *   1. Download Vehicle Package from Server (HTTPS)
-     *   2. Parse Vehicle Package metadata
-     *   3. Verify VIN, Model, Year
-     *   4. Extract Zone Packages
-     *   5. Send each Zone Package to target ZGW (DoIP/UDS)
+     *   1. Fetch the 12KB metadata (HTTP Range) and compare its ECU
+     *      references with the latest VCI snapshot (UpdatePlanner)
+     *   2. Download only the zones holding an ECU to update (whole package
+     *      if every zone is needed or the plan is not selective)
+     *   3. Verify vehicle / zone / ECU CRCs (single pass; downloaded zones
+     *      only for a partial package) and VIN, Model, Year
+     *   4. Extract Zone Packages, dropping ECUs already at the target version
+     *   5. Send Zone Packages to target ZGWs (DoIP/UDS) in ECU dependency
+     *      order; independent zones are sent concurrently (FlashScheduler)
+     *
+     * With ota.overlap_zone_flash, steps 2-5 run per zone: zones download in
+     * flash order and each is sent as soon as it is verified, while the next
+     * zone downloads (flashZonesWhileDownloading()). That flow counts as the
+     * install phase, so it is only chosen while OTA_PHASE_INSTALL is allowed.
      */
     bool startVehicleOTA(const OTAPackageInfo& package_info);
     
+    /**
+     * @brief Set the VCI snapshot used to skip up-to-date ECUs
+     * @param vci VCI report (VCICollector::getVciData())
+     */
+    void setVciSnapshot(const nlohmann::json& vci);
+    
     /**
      * @brief Get current OTA state
      */
     OTAState getState() const { return current_state_; }
     
     /**
-     * @brief Get current progress
+     * @brief Get current progress (consistent snapshot, any thread, lock-free)
      */
-    OTAProgress getProgress() const { return progress_; }
+    OTAProgress getProgress() const { return progress_publisher_.snapshot(); }
     
     /**
      * @brief Check if OTA is in progress
      */
     bool isOTAInProgress() const {
-        return current_state_ != OTAState::OTA_IDLE &&
-               current_state_ != OTAState::OTA_COMPLETED &&
-               current_state_ != OTAState::OTA_ERROR;
+        OTAState state = current_state_;
+        return state != OTAState::OTA_IDLE &&
+               state != OTAState::OTA_COMPLETED &&
+               state != OTAState::OTA_ERROR &&
+               state != OTAState::OTA_CANCELLED;
     }
     
     /**
      * @brief Cancel ongoing OTA
-     * @return true if cancelled successfully
+     * @return true if a job was running or queued
+     *
+     * The worker stops at the next chunk / block boundary and ends in
+     * OTA_CANCELLED; the standby partition is left marked STATE_ERROR.
      */
     bool cancelOTA();
     
+    /**
+     * @brief Set the job phases the current vehicle state allows
+     * @param phases OTA_PHASE_* mask (default OTA_PHASE_ALL)
+     *
+     * A job in a phase outside the mask pauses at its next chunk / block
+     * checkpoint and continues from there once the phase is allowed again.
+     * Kept across jobs; cancelOTA() also ends a paused job.
+     */
+    void setAllowedPhases(uint8_t phases);
+    
+    uint8_t getAllowedPhases() const { return allowed_phases_; }
+    
+    /**
+     * @brief Check if the running job is held by the phase gate
+     */
+    bool isPaused() const { return cancel_.isPaused(); }
+    
+    /**
+     * @brief Subscribe to progress snapshots
+     * @param name Subscriber name (MQTT, IPC, log, ...)
+     * @param interval_ms Sampling period
+     * @param callback Runs on the subscriber's own thread, only when progress changed
+     * @return Subscription id
+     *
+     * The OTA job never waits on a subscriber; a slow callback only delays
+     * its own next sample.
+     */
+    unsigned subscribeProgress(const std::string& name, uint32_t interval_ms,
+                               std::function<void(const OTAProgress&)> callback);
+    
+    /**
+     * @brief Stop a progress subscriber (after one last sample)
+     * @return false if the id is unknown
+     */
+    bool unsubscribeProgress(unsigned id);
+    
     /**
      * @brief Set progress callback (for real-time updates)
-     * @param callback Progress callback function
+     * @param callback Progress callback function (replaces the previous one; empty = none)
+     * @note Sampled every OTA_PROGRESS_REPORT_INTERVAL_MS on its own thread
      */
-    void setProgressCallback(std::function<void(const OTAProgress&)> callback) {
-        progress_callback_ = callback;
-    }
+    void setProgressCallback(std::function<void(const OTAProgress&)> callback);
+    
+    /**
+     * @brief Calculate SHA256 hash of file
+     * @param file_path File path
+     * @param hash Output hash (32 bytes)
+     * @return true if successful
+     */
+    static bool calculateSHA256(const std::string& file_path, uint8_t* hash);
 
 private:
     // Dependencies
@@ -164,23 +308,66 @@ private:
     HttpClient* http_client_;
     MqttClient* mqtt_client_;
     std::shared_ptr<PartitionManager> partition_mgr_;
-    std::vector<std::shared_ptr<DoIPClient>> doip_clients_;
+    std::vector<std::shared_ptr<DoIPClient>> doip_clients_;   // Idle ZGW clients (guarded by zone_mutex_)
     
     // State
-    OTAState current_state_;
-    OTAProgress progress_;
+    std::atomic<OTAState> current_state_;
+    OTAProgress progress_;                // Writer copy; readers use progress_publisher_
+    std::mutex progress_mutex_;           // Serializes progress_ writers (never held by readers)
+    ProgressPublisher<OTAProgress> progress_publisher_;
+    std::atomic<unsigned> progress_callback_id_;  // setProgressCallback() subscription (0 = none)
     OTAPackageInfo package_info_;
-    std::function<void(const OTAProgress&)> progress_callback_;
     
     // Configuration
     std::string download_path_;
     std::string install_path_;
     uint32_t chunk_size_;
     uint32_t max_retries_;
+    unsigned verify_threads_;      // CRC worker threads (0 = one per core)
+    unsigned zgw_max_concurrent_;  // Zone transfers per ZGW (0 = unlimited)
+    unsigned zstd_window_log_max_; // Decoder window cap for compressed ECU payloads
+    bool stream_install_;          // A/B images go straight to the standby partition
+    bool skip_unchanged_;          // Only write partition blocks that differ
+    unsigned pipeline_buffers_;    // Download pipeline pool size (buffers of chunk_size_)
+    bool overlap_zone_flash_;      // Vehicle OTA: send zones while later zones download
+    bool uds_file_transfer_;       // Zone transfers try 0x38 (resumable) before 0x34
+    size_t uds_max_block_bytes_;   // 0x36 payload cap (0 = ZGW limit)
+    std::unique_ptr<UdsCheckpointStore> uds_checkpoints_;  // Offsets of interrupted zone transfers
+    
+    // SHA256 computed while downloading (verifyPackage() skips the re-read)
+    uint8_t download_sha256_[32];
+    bool download_hashed_;
     
     // Vehicle Package processing
     std::unique_ptr<VehiclePackageParser> vehicle_parser_;
     std::vector<ZonePackageInfo> zone_packages_;
+    std::mutex zone_mutex_;        // Guards doip_clients_ / zone counters during zone transfers
+    nlohmann::json vci_snapshot_;  // Latest VCI (installed ECU versions)
+    std::mutex vci_mutex_;
+    
+    // Worker thread (one job at a time)
+    std::thread worker_;
+    mutable std::mutex worker_mutex_;
+    std::condition_variable worker_cv_;
+    bool worker_stop_;
+    bool job_pending_;             // Submitted and not finished
+    bool job_running_;
+    OTAPackageInfo job_info_;
+    OTAJobType job_type_;
+    CancelToken cancel_;
+    std::atomic<uint8_t> allowed_phases_;  // OTA_PHASE_* the vehicle state allows
+    std::atomic<bool> install_in_download_; // Streamed install / overlapped zone flash: DOWNLOADING also installs
+    std::mutex phase_mutex_;               // Serializes applyPhaseGate()
+    
+    /**
+     * @brief Pause or resume cancel_ for the phase of current_state_
+     */
+    void applyPhaseGate();
+    
+    /**
+     * @brief Worker thread body: run submitted jobs until stopWorker()
+     */
+    void workerLoop();
     
     /**
      * @brief Download OTA package (with chunked download)
@@ -188,6 +375,15 @@ private:
      */
     bool downloadPackage();
     
+    /**
+     * @brief Pipeline receive stage: download the next chunk of [next, end)
+     * @param block Pool buffer; size 0 once next reaches end
+     * @param capacity Buffer size (largest chunk)
+     * @param next Next byte to request (advanced)
+     * @return true if successful
+     */
+    bool receiveChunk(PipelineBlock& block, size_t capacity, uint64_t& next, uint64_t end);
+    
     /**
      * @brief Download a single chunk with retry
      * @param url Download URL
@@ -198,6 +394,13 @@ private:
      */
     bool downloadChunk(const std::string& url, size_t start, size_t end, std::ofstream& output_file);
     
+    /**
+     * @brief Download a single chunk with retry into memory
+     * @param body Output chunk (exactly end - start + 1 bytes)
+     * @return true if successful
+     */
+    bool downloadChunk(const std::string& url, size_t start, size_t end, std::string& body);
+    
     /**
      * @brief Verify downloaded package integrity
      * @return true if valid
@@ -211,12 +414,23 @@ private:
     bool installPackage();
     
     /**
-     * @brief Calculate SHA256 hash of file
-     * @param file_path File path
-     * @param hash Output hash (32 bytes)
+     * @brief Download the package straight into the standby partition
+     *
+     * No download file: chunks are hashed and written at their final
+     * partition offsets. The partition stays STATE_UPDATING until the
+     * SHA256 of the received image matches.
+     *
+     * @return true if installed and verified
+     */
+    bool streamInstallPackage();
+    
+    /**
+     * @brief Write hash tree and metadata, verify the partition and switch boot target
+     * @param standby Partition holding the new image
+     * @param tree Hash tree of the image (built from the source bytes)
      * @return true if successful
      */
-    bool calculateSHA256(const std::string& file_path, uint8_t* hash);
+    bool completeInstall(PartitionId standby, const PartitionHashTree& tree);
     
     /**
      * @brief Convert hex string to binary
@@ -228,10 +442,16 @@ private:
     
     /**
      * @brief Update OTA state and report progress
-     * @param state New state
+     * @param state New state (must be a valid transition, see OTAState)
      * @param step_description Step description
+     * @return false if the transition is not allowed (state unchanged)
+     */
+    bool updateState(OTAState state, const std::string& step_description);
+    
+    /**
+     * @brief Check the OTAState transition table
      */
-    void updateState(OTAState state, const std::string& step_description);
+    static bool isValidTransition(OTAState from, OTAState to);
     
     /**
      * @brief Update progress and report via MQTT
@@ -240,6 +460,27 @@ private:
      */
     void updateProgress(uint32_t downloaded, uint32_t total);
     
+    /**
+     * @brief Clear progress for a new job
+     */
+    void resetProgress(uint32_t total_bytes);
+    
+    /**
+     * @brief Set the percentage only (zone transfers)
+     */
+    void setProgressPercentage(uint8_t percentage);
+    
+    /**
+     * @brief Set the downloaded bytes only (percentage tracks zone transfers)
+     */
+    void setDownloadedBytes(uint32_t downloaded);
+    
+    /**
+     * @brief Set install write statistics
+     * @param throughput_kbps Current write throughput (0 = not installing)
+     */
+    void setInstallStats(uint32_t throughput_kbps, uint64_t blocks_written, uint64_t blocks_skipped);
+    
     /**
      * @brief Report error
      * @param error_message Error message
@@ -247,9 +488,19 @@ private:
     void reportError(const std::string& error_message);
     
     /**
-     * @brief Send progress report to server via MQTT
+     * @brief Publish progress_ to readers and subscribers (progress_mutex_ held)
      */
-    void sendProgressReport();
+    void publishProgress();
+    
+    /**
+     * @brief Send progress report to server via MQTT (MQTT subscriber thread)
+     */
+    void sendProgressReport(const OTAProgress& progress);
+    
+    /**
+     * @brief Log a progress line (log subscriber thread)
+     */
+    static void logProgress(const OTAProgress& progress);
     
     // ==================== Vehicle Package Processing ====================
     
@@ -259,17 +510,88 @@ private:
      */
     bool downloadVehiclePackage();
     
+    /**
+     * @brief Download only the 12KB Vehicle Package metadata (HTTP Range)
+     * @return true if the package file now starts with the metadata
+     */
+    bool downloadVehicleMetadata();
+    
+    /**
+     * @brief Download the zones selected by a plan into the package file
+     * @param metadata Vehicle Package metadata (already at offset 0)
+     * @param plan Selective update plan
+     * @return true if every selected zone was written at its package offset
+     * @note Other zones are left as holes; the file has the full package size
+     */
+    bool downloadVehiclePackageZones(const VehiclePackageMetadata& metadata, const UpdatePlan& plan);
+    
+    /**
+     * @brief Download the selected zones and send each to its ZGW as soon as it is ready
+     *
+     * Zone headers and ECU metadata are fetched first so the flash order is
+     * known. A download thread then fetches the zones in that order and
+     * verifies and extracts each one; a zone is sent once that is done, while
+     * the next zone downloads. End-to-end time is about max(download, flash).
+     *
+     * @param metadata Vehicle Package metadata (already at offset 0)
+     * @param plan Update plan
+     * @return true if every selected zone was sent (errors are reported)
+     * @note Zone / ECU CRCs are checked per zone; the vehicle CRC32 is not
+     *       (as for a partial package) and the package is not indexed
+     */
+    bool flashZonesWhileDownloading(const VehiclePackageMetadata& metadata, const UpdatePlan& plan);
+    
+    /**
+     * @brief Fetch the zone headers and ECU metadata FlashScheduler reads
+     * @param fd Package file (sized to total_size)
+     * @return true if written at their package offsets
+     */
+    bool downloadZoneHeaders(int fd, const VehiclePackageMetadata& metadata, const UpdatePlan& plan);
+    
+    /**
+     * @brief Download, verify and extract one zone (overlapped flow)
+     * @param fd Package file
+     * @param pipeline Download pipeline (reused across zones)
+     * @param zone Zone index
+     * @param abort Stops the download (a zone transfer failed)
+     * @return true if the zone is ready to send
+     */
+    bool downloadZonePackage(int fd, OTAPipeline& pipeline, size_t zone, const UpdatePlan& plan,
+                             const std::atomic<bool>& abort);
+    
     /**
      * @brief Verify Vehicle Package target (VIN, Model, Year)
+     * @param metadata Vehicle Package metadata (body not needed)
      * @return true if match
      */
-    bool verifyVehiclePackageTarget();
+    bool verifyVehiclePackageTarget(const VehiclePackageMetadata& metadata);
+    
+    /**
+     * @brief Extract the Zone Packages a plan selects
+     * @param plan Update plan; zones with up-to-date ECUs are written as subsets
+     * @return true if successful (zone_packages_ holds the extracted paths)
+     */
+    bool extractZonePackages(const UpdatePlan& plan);
     
     /**
-     * @brief Extract Zone Packages from Vehicle Package
+     * @brief Extract one Zone Package into zone_packages_[zone]
      * @return true if successful
      */
-    bool extractZonePackages();
+    bool extractZonePackage(size_t zone, const UpdatePlan& plan);
+    
+    /**
+     * @brief Send a scheduled zone and report progress (FlashScheduler worker threads)
+     * @param zone Zone index
+     * @param zones_to_send Zones in the plan
+     * @param zones_completed Zones sent so far (guarded by zone_mutex_)
+     * @return true if sent
+     */
+    bool sendScheduledZone(size_t zone, size_t zones_to_send, uint32_t& zones_completed);
+    
+    /**
+     * @brief Mark the Vehicle OTA completed and print the summary
+     */
+    void completeVehicleOTA(const UpdatePlan& plan);
     
     /**
      * @brief Send a Zone Package to target ZGW via DoIP/UDS
@@ -279,21 +601,34 @@ private:
     bool sendZonePackageToZGW(const ZonePackageInfo& zone_info);
     
     /**
-     * @brief Send Zone Package using UDS 0x34/0x36/0x37
+     * @brief Send Zone Package using UDS 0x38 (or 0x34) / 0x36 / 0x37
      * @param doip_client DoIP client connected to ZGW
+     * @param zone_info Target ZGW of the zone (checkpoint key)
      * @param zone_package_path Path to Zone Package file
+     * @param data_format RequestDownload dataFormatIdentifier (UDS_DFI_*)
+     * @param format_rejected Set if the ZGW refused data_format (NRC 0x31)
      * @return true if successful
+     *
+     * A lost link is re-established and the transfer resumed from the ZGW's
+     * position (UdsZoneTransfer), also across VMG restarts.
      */
     bool transferZonePackageViaUDS(DoIPClient* doip_client, 
-                                     const std::string& zone_package_path);
+                                     const ZonePackageInfo& zone_info,
+                                     const std::string& zone_package_path,
+                                     uint8_t data_format = UDS_DFI_UNCOMPRESSED,
+                                     bool* format_rejected = nullptr);
     
     /**
-     * @brief Get or create DoIP client for target ZGW
+     * @brief Take an idle DoIP client for target ZGW, or create one
      * @param zgw_ip ZGW IP address
      * @param zgw_port ZGW DoIP port
-     * @return DoIP client pointer
+     * @return DoIP client, owned by the caller until released
+     *
+     * Zones to the same ZGW may transfer concurrently, so a client serves
+     * one transfer at a time. Dropping the returned pointer puts the client
+     * (still connected) back on the idle list for the next zone.
      */
-    DoIPClient* getDoIPClientForZGW(const std::string& zgw_ip, uint16_t zgw_port);
+    std::shared_ptr<DoIPClient> getDoIPClientForZGW(const std::string& zgw_ip, uint16_t zgw_port);
 };
 
 #endif // OTA_MANAGER_HPP
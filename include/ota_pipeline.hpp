@@ -0,0 +1,196 @@
+/**
+ * @file ota_pipeline.hpp
+ * @brief Threaded receive → hash → write pipeline with a bounded buffer pool
+ *
+ * Each stage runs on its own thread and passes buffers on through a
+ * lock-free single-producer / single-consumer queue:
+ *
+ *   receive ──▶ hash ──▶ write
+ *      ▲                   │
+ *      └──── free list ◀───┘
+ *
+ * Buffers come from a fixed pool of aligned blocks and return to the
+ * receive stage once written, so a stalled stage stops the ones before it
+ * (backpressure) and peak memory is the pool size. Throughput is that of
+ * the slowest stage instead of the sum of all three.
+ */
+
+#ifndef OTA_PIPELINE_HPP
+#define OTA_PIPELINE_HPP
+
+#include "async_io.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// ==================== Constants ====================
+
+#define OTA_PIPELINE_BUFFERS        8               // Pool size (buffers)
+#define OTA_PIPELINE_MAX_BUFFERS    64
+#define OTA_PIPELINE_SPIN_COUNT     256             // Polls before a waiting stage yields / sleeps
+#define OTA_PIPELINE_SLEEP_US       100             // Sleep between polls once idle
+#define OTA_PIPELINE_MAX_SLEEP_US   10000           // Longest sleep (backs off while a stage is paused)
+
+// ==================== SPSC Queue ====================
+
+/**
+ * @brief Bounded lock-free single-producer / single-consumer queue
+ *
+ * push() is only called from one thread and pop() from one other thread.
+ * Capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SPSCQueue {
+public:
+    explicit SPSCQueue(size_t capacity) : head_(0), tail_(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+    
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+    
+    /**
+     * @brief Append an item (producer)
+     * @return false if the queue is full
+     */
+    bool push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    /**
+     * @brief Take the oldest item (consumer)
+     * @return false if the queue is empty
+     */
+    bool pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;      // Next slot to pop (consumer)
+    alignas(64) std::atomic<size_t> tail_;      // Next slot to push (producer)
+};
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief Data block travelling through the pipeline
+ */
+struct PipelineBlock {
+    uint8_t* data;                  // Pool buffer
+    size_t size;                    // Valid bytes
+    uint64_t offset;                // Destination offset set by the receive stage
+};
+
+/**
+ * @brief Fill a buffer with the next block
+ * @param block data / capacity given; set size (0 = end of input) and offset
+ * @return false on error
+ */
+using PipelineReceive = std::function<bool(PipelineBlock& block, size_t capacity)>;
+
+/**
+ * @brief Hash or write stage
+ * @return false on error
+ */
+using PipelineStage = std::function<bool(const PipelineBlock& block)>;
+
+/**
+ * @brief Per-stage timing of the last run
+ */
+struct PipelineStats {
+    uint64_t bytes;                 // Bytes through the write stage
+    uint64_t blocks;
+    double elapsed_ms;              // Wall time of run()
+    double receive_ms;              // Time each stage spent working (not waiting)
+    double hash_ms;
+    double write_ms;
+    
+    /**
+     * @brief Stage that limited throughput
+     */
+    const char* bottleneck() const {
+        if (receive_ms >= hash_ms && receive_ms >= write_ms) {
+            return "receive";
+        }
+        return hash_ms >= write_ms ? "hash" : "write";
+    }
+};
+
+// ==================== Functions ====================
+
+/**
+ * @brief pwrite a whole block at its offset
+ * @return false on write error (errno set)
+ */
+bool writePipelineBlock(int fd, const PipelineBlock& block);
+
+// ==================== OTA Pipeline ====================
+
+/**
+ * @brief OTA Pipeline Class
+ *
+ * Usage:
+ *   OTAPipeline pipeline(64 * 1024, 8);
+ *   pipeline.run(
+ *       [&](PipelineBlock& block, size_t capacity) { return receive(block, capacity); },
+ *       [&](const PipelineBlock& block) { return hash(block.data, block.size); },
+ *       [&](const PipelineBlock& block) { return write(block.data, block.size, block.offset); });
+ *
+ * The first stage error stops every stage; getError() names it.
+ */
+class OTAPipeline {
+public:
+    /**
+     * @brief Constructor
+     * @param buffer_size Bytes per pool buffer
+     * @param buffer_count Pool size (clamped to 2..OTA_PIPELINE_MAX_BUFFERS)
+     */
+    OTAPipeline(size_t buffer_size, unsigned buffer_count = OTA_PIPELINE_BUFFERS);
+    
+    OTAPipeline(const OTAPipeline&) = delete;
+    OTAPipeline& operator=(const OTAPipeline&) = delete;
+    
+    /**
+     * @brief Run the stages until receive reports end of input or a stage fails
+     * @param hash Hash stage (empty = blocks go straight to write)
+     * @return true if every block was received, hashed and written
+     */
+    bool run(const PipelineReceive& receive, const PipelineStage& hash, const PipelineStage& write);
+    
+    size_t bufferSize() const { return buffer_size_; }
+    size_t poolBytes() const { return buffer_size_ * buffers_.size(); }
+    const PipelineStats& getStats() const { return stats_; }
+    const std::string& getError() const { return error_; }
+
+private:
+    size_t buffer_size_;
+    std::vector<AsyncIOBuffer> buffers_;
+    PipelineStats stats_;
+    std::string error_;
+};
+
+#endif // OTA_PIPELINE_HPP
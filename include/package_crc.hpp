@@ -0,0 +1,52 @@
+/**
+ * @file package_crc.hpp
+ * @brief Streaming CRC32 for Vehicle / Zone Package verification
+ *
+ * Packages can be hundreds of MB (ota.max_package_size_mb), so CRCs are
+ * computed over a fixed-size buffer instead of loading the range into RAM.
+ * Peak memory is PACKAGE_CRC_BUFFER_SIZE per worker regardless of package size.
+ *
+ * Large ranges are split across worker threads; the partial CRCs are merged
+ * with crc32_combine, so the result is identical to a single-pass CRC.
+ */
+
+#ifndef PACKAGE_CRC_HPP
+#define PACKAGE_CRC_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "crc32.hpp"
+
+// ==================== Constants ====================
+
+#define PACKAGE_CRC_BUFFER_SIZE         (256 * 1024)        // 256KB read buffer
+#define PACKAGE_CRC_PARALLEL_MIN_SIZE   (8 * 1024 * 1024)   // Min bytes per worker thread
+
+// ==================== Functions ====================
+
+/**
+ * @brief Resolve configured CRC thread count
+ * @param requested Configured count (0 = one per CPU core)
+ * @return Thread count (>= 1)
+ */
+unsigned resolveCRCThreadCount(unsigned requested);
+
+/**
+ * @brief Calculate CRC32 of a byte range of a file (streaming)
+ * @param file_path File path
+ * @param offset Start offset in file
+ * @param length Number of bytes to include
+ * @param crc Output CRC32
+ * @param thread_count Worker threads (0 = one per CPU core, 1 = single thread).
+ *                     Ranges smaller than PACKAGE_CRC_PARALLEL_MIN_SIZE per
+ *                     worker use fewer threads.
+ * @return true if the whole range was read
+ */
+bool calculateFileCRC32(const std::string& file_path,
+                        uint64_t offset,
+                        uint64_t length,
+                        uint32_t& crc,
+                        unsigned thread_count = 1);
+
+#endif // PACKAGE_CRC_HPP
@@ -0,0 +1,134 @@
+/**
+ * @file package_index.hpp
+ * @brief Persistent index of verified Vehicle Packages
+ *
+ * Records the outcome of a successful PackageIntegrityVerifier pass so a
+ * restart (e.g. retry after a DoIP failure) can skip the download and the
+ * full CRC read. Entries are keyed by package path, size, mtime, inode and
+ * the server-supplied hash; any rewrite of the file changes size, mtime or
+ * inode and turns the entry into a miss.
+ *
+ * The index is a small JSON file on the data partition, replaced atomically
+ * (write temp file, fsync, rename) on every update.
+ */
+
+#ifndef PACKAGE_INDEX_HPP
+#define PACKAGE_INDEX_HPP
+
+#include "vehicle_package.hpp"
+#include "package_verifier.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+// ==================== Constants ====================
+
+#define PACKAGE_INDEX_FILENAME      "verified_index.json"
+#define PACKAGE_INDEX_VERSION       1
+#define PACKAGE_INDEX_MAX_ENTRIES   8       // Oldest entries dropped first
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief Identity of a package file on disk
+ */
+struct PackageFileKey {
+    std::string path;
+    uint64_t size;
+    int64_t mtime_ns;
+    uint64_t inode;
+    std::string expected_hash;      // Server-supplied hash (may be empty)
+};
+
+/**
+ * @brief Verified byte range within the package file
+ */
+struct VerifiedRange {
+    std::string id;                 // Zone ID or ECU ID
+    uint64_t offset;                // Absolute file offset
+    uint64_t size;
+    uint32_t crc32;                 // Zone: body after header, ECU: metadata + firmware
+    uint32_t firmware_crc32;        // ECU only
+};
+
+/**
+ * @brief Index entry for one verified package
+ */
+struct VerifiedPackageEntry {
+    PackageFileKey key;
+    uint32_t vehicle_crc32;
+    uint64_t verified_at;           // Unix time (seconds)
+    std::vector<VerifiedRange> zones;
+    std::vector<VerifiedRange> ecus;
+};
+
+// ==================== Verified Package Index ====================
+
+/**
+ * @brief Verified Package Index Class
+ *
+ * Usage:
+ *   VerifiedPackageIndex index(download_path + "/" PACKAGE_INDEX_FILENAME);
+ *   index.load();
+ *   if (!index.lookup(path, hash, view.metadata().vehicle_crc32)) {
+ *       if (verifier.verify()) index.record(path, hash, view, verifier.getReport());
+ *   }
+ */
+class VerifiedPackageIndex {
+public:
+    /**
+     * @brief Constructor
+     * @param index_path Path to index JSON file
+     */
+    explicit VerifiedPackageIndex(const std::string& index_path);
+    
+    /**
+     * @brief Load index from disk
+     * @return false if the file exists but is unreadable (index starts empty)
+     */
+    bool load();
+    
+    /**
+     * @brief Check whether a package file is already verified
+     * @param package_path Package file path
+     * @param expected_hash Server-supplied hash
+     * @param vehicle_crc32 vehicle_crc32 from the package metadata (0 = not checked)
+     * @return Entry if the file is unchanged since verification, nullptr otherwise
+     */
+    const VerifiedPackageEntry* lookup(const std::string& package_path,
+                                       const std::string& expected_hash,
+                                       uint32_t vehicle_crc32 = 0) const;
+    
+    /**
+     * @brief Record a successful verification and save the index
+     * @param package_path Package file path
+     * @param expected_hash Server-supplied hash
+     * @param package View of the verified package (zone / ECU offsets)
+     * @param report Report of the verification pass (must be valid)
+     * @return true if recorded and saved
+     */
+    bool record(const std::string& package_path, const std::string& expected_hash,
+                const VehiclePackageView& package, const PackageIntegrityReport& report);
+    
+    /**
+     * @brief Drop the entry for a package (before rewrite or after a failed check)
+     */
+    void invalidate(const std::string& package_path);
+
+private:
+    std::string index_path_;
+    std::map<std::string, VerifiedPackageEntry> entries_;     // By package path
+    
+    /**
+     * @brief Read size / mtime / inode of a file
+     */
+    static bool statFile(const std::string& path, PackageFileKey& key);
+    
+    /**
+     * @brief Write index atomically (temp file + fsync + rename)
+     */
+    bool save() const;
+};
+
+#endif // PACKAGE_INDEX_HPP
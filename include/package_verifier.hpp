@@ -0,0 +1,190 @@
+/**
+ * @file package_verifier.hpp
+ * @brief Single-pass hierarchical integrity verification (Vehicle → Zone → ECU)
+ *
+ * One sequential read of the Vehicle Package checks every CRC in the hierarchy:
+ *   - VehiclePackageMetadata::vehicle_crc32  (package body after the 12KB metadata)
+ *   - ZonePackageHeader::zone_crc32          (zone body after the 1KB header)
+ *   - ZoneECUEntry::crc32                    (ECU package = metadata + firmware)
+ *   - ECUMetadata::firmware_crc32            (firmware binary)
+ *
+ * Compressed firmware (ZoneECUEntry::compression) is covered by the ECU
+ * package CRC; its image CRC is checked when the frame is decoded
+ * (expandZonePackage on the VMG, or the ZGW).
+ *
+ * Each byte is hashed once, into the innermost range that contains it. The
+ * enclosing CRCs are assembled with crc32Combine as ranges close. Zone headers
+ * and ECU metadata are captured from the stream, so zone_refs and ecu_table
+ * drive the walk without extra seeks.
+ *
+ * A partially downloaded package (selective update, see update_planner.hpp)
+ * is verified zone by zone: only the selected zones are read and
+ * vehicle_crc32 is not checked.
+ */
+
+#ifndef PACKAGE_VERIFIER_HPP
+#define PACKAGE_VERIFIER_HPP
+
+#include "vehicle_package.hpp"
+#include "zone_package.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief Hierarchy level at which verification failed
+ */
+enum class IntegrityLevel : uint8_t {
+    NONE = 0,           // No failure
+    STRUCTURE = 1,      // Layout invalid (metadata, offsets, truncated file)
+    VEHICLE = 2,        // vehicle_crc32 mismatch
+    ZONE = 3,           // Zone header invalid or zone_crc32 mismatch
+    ECU_PACKAGE = 4,    // ECU metadata invalid or ZoneECUEntry::crc32 mismatch
+    FIRMWARE = 5        // ECUMetadata::firmware_crc32 mismatch
+};
+
+/**
+ * @brief Verification result for one ECU Package
+ */
+struct ECUIntegrityResult {
+    std::string ecu_id;
+    uint32_t expected_package_crc;
+    uint32_t calculated_package_crc;
+    uint32_t expected_firmware_crc;     // Firmware image (ECUMetadata::firmware_crc32)
+    uint32_t calculated_firmware_crc;   // Firmware as stored
+    bool metadata_valid;            // ECUM magic, firmware size consistent
+    bool package_valid;
+    bool firmware_valid;
+    bool compressed;                // Stored firmware is a zstd frame (covered by package CRC only)
+};
+
+/**
+ * @brief Verification result for one Zone Package
+ */
+struct ZoneIntegrityResult {
+    std::string zone_id;
+    uint8_t zone_number;
+    uint32_t expected_crc;
+    uint32_t calculated_crc;
+    bool checked;                   // false if not selected (partial verification)
+    bool header_valid;              // ZONE magic, ECU table within bounds
+    bool crc_valid;
+    std::vector<ECUIntegrityResult> ecus;
+};
+
+/**
+ * @brief Verification report for a Vehicle Package
+ */
+struct PackageIntegrityReport {
+    bool valid;
+    bool partial;                   // Only selected zones checked, vehicle_crc32 skipped
+    IntegrityLevel failed_level;    // Most specific level that failed
+    std::string failed_zone_id;     // Set for ZONE / ECU_PACKAGE / FIRMWARE
+    std::string failed_ecu_id;      // Set for ECU_PACKAGE / FIRMWARE
+    std::string message;
+    uint32_t expected_vehicle_crc;
+    uint32_t calculated_vehicle_crc;
+    uint64_t bytes_read;
+    std::vector<ZoneIntegrityResult> zones;     // In zone_refs order
+};
+
+/**
+ * @brief Convert IntegrityLevel to string
+ */
+const char* integrityLevelToString(IntegrityLevel level);
+
+// ==================== Package Integrity Verifier ====================
+
+/**
+ * @brief Package Integrity Verifier Class
+ *
+ * Usage:
+ *   PackageIntegrityVerifier verifier(path);
+ *   if (!verifier.verify()) {
+ *       verifier.printReport();
+ *   }
+ */
+class PackageIntegrityVerifier {
+public:
+    /**
+     * @brief Constructor
+     * @param package_path Path to Vehicle Package file
+     */
+    explicit PackageIntegrityVerifier(const std::string& package_path);
+    
+    /**
+     * @brief Set number of worker threads
+     * @param thread_count Worker threads (0 = one per CPU core, 1 = single thread).
+     *                     Zones are split between workers; each byte is still read once.
+     */
+    void setThreadCount(unsigned thread_count) { thread_count_ = thread_count; }
+    
+    /**
+     * @brief Verify only some zones (partially downloaded package)
+     * @param zones zone_refs order: zone is present and checked
+     */
+    void setZoneSelection(const std::vector<bool>& zones) { zone_selection_ = zones; }
+    
+    /**
+     * @brief Verify vehicle, zone, ECU package and firmware CRCs in one pass
+     * @return true if every level is valid
+     */
+    bool verify();
+    
+    /**
+     * @brief Get report of the last verify() call
+     */
+    const PackageIntegrityReport& getReport() const { return report_; }
+    
+    /**
+     * @brief Print per-zone / per-ECU results
+     */
+    void printReport() const;
+
+private:
+    std::string package_path_;
+    unsigned thread_count_;
+    std::vector<bool> zone_selection_;              // Empty: whole package
+    VehiclePackageMetadata metadata_;
+    std::vector<ZonePackageHeader> zone_headers_;   // Captured during the walk
+    PackageIntegrityReport report_;
+    
+    /**
+     * @brief Validate metadata and zone_refs layout
+     */
+    bool validateMetadata();
+    
+    /**
+     * @brief Hash [start, end) of the package body, descending into zones
+     * @param fd Open package file
+     * @param start Range start (zone boundary or end of metadata)
+     * @param end Range end (zone boundary or total_size)
+     * @param zones Zone indices (report_.zones) inside the range, in file order
+     * @param crc Output CRC32 of the whole range
+     * @param bytes_read Output bytes read
+     * @param error Output I/O error message
+     * @return false on I/O error
+     */
+    bool walkRange(int fd, uint64_t start, uint64_t end,
+                   const std::vector<size_t>& zones,
+                   uint32_t& crc, uint64_t& bytes_read, std::string& error);
+    
+    /**
+     * @brief Check captured zone header, fill expected CRCs
+     */
+    void checkZoneHeader(size_t zone, const std::vector<uint8_t>& captured);
+    
+    /**
+     * @brief Check captured ECU metadata, fill expected firmware CRC
+     */
+    void checkECUMetadata(size_t zone, size_t ecu, const std::vector<uint8_t>& captured);
+    
+    /**
+     * @brief Determine failed level from per-zone / per-ECU results
+     */
+    void summarize();
+};
+
+#endif // PACKAGE_VERIFIER_HPP
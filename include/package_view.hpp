@@ -0,0 +1,87 @@
+/**
+ * @file package_view.hpp
+ * @brief Building blocks for zero-copy package views
+ *
+ * VehiclePackageView (vehicle_package.hpp) and ZonePackageView
+ * (zone_package.hpp) overlay the packed package structs on a MappedFile.
+ * open() checks host endianness and every offset/size once; after that the
+ * accessors are plain pointer arithmetic with no copies and no allocation.
+ * IDs are returned as std::string_view bounded by the field width, so IDs
+ * that fill the whole field (no NUL terminator) are handled correctly.
+ *
+ * Views do not own the bytes; the MappedFile (or buffer) must outlive them.
+ */
+
+#ifndef PACKAGE_VIEW_HPP
+#define PACKAGE_VIEW_HPP
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// ==================== Helpers ====================
+
+/**
+ * @brief View of a fixed-width, optionally NUL-terminated char field
+ */
+inline std::string_view fixedStringView(const char* data, size_t max_length) {
+    return std::string_view(data, strnlen(data, max_length));
+}
+
+/**
+ * @brief Contiguous table of packed entries (range-for support)
+ */
+template <typename T>
+class TableRange {
+public:
+    TableRange(const T* first, size_t count) : first_(first), count_(count) {}
+    
+    const T* begin() const { return first_; }
+    const T* end() const { return first_ + count_; }
+    size_t size() const { return count_; }
+    const T& operator[](size_t index) const { return first_[index]; }
+
+private:
+    const T* first_;
+    size_t count_;
+};
+
+// ==================== Mapped File ====================
+
+/**
+ * @brief Read-only memory-mapped file (RAII)
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    
+    /**
+     * @brief Map a file read-only
+     * @param path File path
+     * @return true if mapped
+     */
+    bool open(const std::string& path);
+    
+    /**
+     * @brief Unmap the file
+     */
+    void close();
+    
+    bool isOpen() const { return data_ != nullptr; }
+    const uint8_t* data() const { return data_; }
+    uint64_t size() const { return size_; }
+
+private:
+    const uint8_t* data_;
+    uint64_t size_;
+};
+
+#endif // PACKAGE_VIEW_HPP
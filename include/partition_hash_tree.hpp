@@ -0,0 +1,154 @@
+/**
+ * @file partition_hash_tree.hpp
+ * @brief Block hash tree for partition images (dm-verity style)
+ *
+ * The image is split into HASH_TREE_BLOCK_SIZE blocks; each block's SHA256
+ * is a leaf. Leaves are packed into hash blocks of the same size (128
+ * hashes, zero padded) and hashed again, level by level, until one hash
+ * block remains. Its SHA256 is the root, kept in PartitionMetadata; the
+ * levels are stored in the partition right after the image.
+ *
+ * Unlike a single SHA256 of the image this allows:
+ *   - verifying blocks on several threads
+ *   - verifying only a range of blocks (e.g. the blocks just written)
+ *   - checking the stored tree against the root without reading the image
+ *
+ * Leaves are computed from the image source (download file or received
+ * chunks), so verifying the partition against the tree also catches bad
+ * writes. The final partial block is hashed zero padded. No salt is used.
+ */
+
+#ifndef PARTITION_HASH_TREE_HPP
+#define PARTITION_HASH_TREE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// ==================== Constants ====================
+
+#define HASH_TREE_BLOCK_SIZE        4096                                    // Data and hash block size
+#define HASH_TREE_DIGEST_SIZE       32                                      // SHA256
+#define HASH_TREE_HASHES_PER_BLOCK  (HASH_TREE_BLOCK_SIZE / HASH_TREE_DIGEST_SIZE)
+#define HASH_TREE_READ_BLOCKS       256                                     // 1MB per read while hashing
+
+// ==================== Partition Hash Tree ====================
+
+/**
+ * @brief Partition Hash Tree Class
+ *
+ * Usage:
+ *   PartitionHashTree tree;
+ *   tree.build(image_file, 0, image_size, 0);              // or begin() / update() / finish()
+ *   tree.store(partition_path, tree_offset);
+ *
+ *   tree.load(partition_path, tree_offset, tree_size, image_size);
+ *   tree.matchesRoot(metadata.hash_tree_root);            // tree only
+ *   tree.verifyBlocks(partition_path, data_offset, 0, tree.blockCount(), 0);
+ */
+class PartitionHashTree {
+public:
+    PartitionHashTree();
+    
+    /**
+     * @brief Build from a file range, hashing blocks on several threads
+     * @param path Image file
+     * @param data_offset Start of the image in path
+     * @param data_size Image size
+     * @param thread_count Worker threads (0 = one per CPU core)
+     * @return true if the whole range was read
+     */
+    bool build(const std::string& path, uint64_t data_offset, uint64_t data_size, unsigned thread_count = 0);
+    
+    /**
+     * @brief Start an incremental build (image bytes passed in order to update())
+     */
+    void begin(uint64_t data_size);
+    
+    /**
+     * @brief Hash the next image bytes
+     */
+    void update(const uint8_t* data, size_t size);
+    
+    /**
+     * @brief Complete an incremental build
+     * @return false if update() did not receive exactly data_size bytes
+     */
+    bool finish();
+    
+    /**
+     * @brief Write the tree levels to a partition and fdatasync
+     */
+    bool store(const std::string& path, uint64_t tree_offset) const;
+    
+    /**
+     * @brief Read stored tree levels
+     * @param tree_size Stored size (must match the layout for data_size)
+     */
+    bool load(const std::string& path, uint64_t tree_offset, uint64_t tree_size, uint64_t data_size);
+    
+    /**
+     * @brief Check the levels against each other and a root (no image reads)
+     */
+    bool matchesRoot(const uint8_t* root) const;
+    
+    /**
+     * @brief Hash image blocks and compare them with the leaves
+     * @param path Partition
+     * @param data_offset Start of the image in path
+     * @param first_block First block to check
+     * @param block_count Blocks to check (clipped to blockCount())
+     * @param thread_count Worker threads (0 = one per CPU core)
+     * @return true if every block matched; see badBlock() otherwise
+     */
+    bool verifyBlocks(const std::string& path, uint64_t data_offset, uint64_t first_block,
+                      uint64_t block_count, unsigned thread_count = 0);
+    
+    const uint8_t* root() const { return root_; }
+    uint64_t dataSize() const { return data_size_; }
+    uint64_t blockCount() const { return (data_size_ + HASH_TREE_BLOCK_SIZE - 1) / HASH_TREE_BLOCK_SIZE; }
+    uint64_t treeSize() const { return tree_.size(); }
+    uint64_t badBlock() const { return bad_block_; }            // First mismatching block
+    const std::string& getError() const { return error_; }
+
+private:
+    uint64_t data_size_;
+    std::vector<uint8_t> tree_;                 // Levels, leaves first, each padded to whole hash blocks
+    std::vector<uint64_t> level_offsets_;       // Start of each level in tree_
+    uint8_t root_[HASH_TREE_DIGEST_SIZE];
+    uint64_t bad_block_;
+    std::string error_;
+    
+    // Incremental build
+    std::vector<uint8_t> pending_;
+    uint64_t next_block_;
+    uint64_t received_;
+    
+    /**
+     * @brief Size tree_ and level_offsets_ for an image size
+     */
+    void layout(uint64_t data_size);
+    
+    /**
+     * @brief Recompute levels above the leaves and the root
+     */
+    void computeUpperLevels();
+    
+    /**
+     * @brief Hash blocks [first, first + count) of an image into out (or compare with it)
+     * @param compare Compare with out instead of writing it
+     * @param bad First mismatching block (if compare)
+     * @return false on read error or mismatch
+     */
+    bool hashBlocks(int fd, uint64_t data_offset, uint64_t first, uint64_t count,
+                    uint8_t* out, bool compare, uint64_t& bad, std::string& error) const;
+    
+    /**
+     * @brief Run hashBlocks over a block range split across threads
+     */
+    bool hashBlocksParallel(const std::string& path, uint64_t data_offset, uint64_t first,
+                            uint64_t count, bool compare, unsigned thread_count);
+};
+
+#endif // PARTITION_HASH_TREE_HPP
@@ -18,6 +18,8 @@
 
 #include <string>
 #include <cstdint>
+#include <cstddef>
+#include "partition_hash_tree.hpp"
 
 // ==================== Constants ====================
 
@@ -34,6 +36,7 @@
 #define DEFAULT_SIM_PARTITION_B     "/tmp/vmg_partitions/partition_b"
 #define DEFAULT_SIM_DATA_PARTITION  "/tmp/vmg_partitions/data"
 #define DEFAULT_SIM_BOOT_STATUS     "/tmp/vmg_partitions/data/boot_status.dat"
+#define DEFAULT_SIM_PARTITION_SIZE  (100ULL * 1024 * 1024)  // Sparse, blocks allocated on write
 
 // Magic number for validation (parallel to ZGW: 0x42414E4B "BANK")
 #define PARTITION_MAGIC_NUMBER      0x564D4750  /* "VMGP" */
@@ -77,13 +80,23 @@ struct PartitionMetadata {
     uint32_t total_size;             /* Firmware size in bytes */
     uint8_t  sha256_hash[32];        /* SHA256 hash (instead of CRC32) */
     PartitionState state;            /* Current partition state */
-    uint8_t  reserved[959];          /* Padding to 1KB */
+    uint8_t  hash_tree_root[32];     /* Block hash tree root (see partition_hash_tree.hpp) */
+    uint64_t hash_tree_offset;       /* Tree location in the partition (0 = no tree) */
+    uint32_t hash_tree_size;         /* Stored tree size in bytes */
+    uint32_t hash_block_size;        /* Hash tree block size */
+    uint8_t  reserved[927];          /* Padding to 1KB */
 } __attribute__((packed));
 
+// Image starts right after the metadata; 1KB keeps it sector aligned for O_DIRECT
+static_assert(sizeof(PartitionMetadata) == 1024, "PartitionMetadata must be 1KB");
+
 /**
  * @brief Boot Status (parallel to ZGW FlashBankStatus_t)
  * 
- * Stored in /boot/boot_status.dat (or simulation path)
+ * Stored in /boot/boot_status.dat (or simulation path) as a two-slot
+ * journal: each write goes to the slot not holding the newest record
+ * (sequence & 1), so a torn write never loses the previous status.
+ * Reads take the valid slot (magic + CRC32) with the highest sequence.
  */
 struct BootStatus {
     uint32_t magic_number;           /* 0x564D4750 ("VMGP") */
@@ -92,9 +105,16 @@ struct BootStatus {
     PartitionState state_b;          /* Partition B state */
     uint32_t boot_count;             /* Boot attempt counter (for rollback) */
     uint32_t last_boot_timestamp;    /* Last successful boot time */
-    uint8_t  reserved[236];          /* Padding to 256 bytes */
+    uint32_t sequence;               /* Journal sequence, incremented per write */
+    uint8_t  reserved[233];          /* Padding to 256 bytes */
+    uint32_t crc32;                  /* CRC32 of the bytes above */
 } __attribute__((packed));
 
+static_assert(sizeof(BootStatus) == 256, "BootStatus must be 256 bytes");
+
+#define BOOT_STATUS_SLOTS           2
+#define BOOT_STATUS_FILE_SIZE       (BOOT_STATUS_SLOTS * sizeof(BootStatus))
+
 // ==================== Class Definition ====================
 
 /**
@@ -122,6 +142,43 @@ public:
         const std::string& boot_status_path = DEFAULT_BOOT_STATUS_PATH,
         bool simulation_mode = false
     );
+    ~PartitionManager();
+    
+    PartitionManager(const PartitionManager&) = delete;
+    PartitionManager& operator=(const PartitionManager&) = delete;
+    
+    /**
+     * @brief Groups boot status changes into one journal write
+     * 
+     * While a batch is open, setPartitionState() / switchBootTarget() /
+     * resetBootCount() only update memory; commit() (or the destructor)
+     * writes them with a single pwrite + fdatasync.
+     * 
+     * Usage:
+     *   PartitionManager::BootStatusBatch batch(*partition_mgr);
+     *   partition_mgr->setPartitionState(standby, PartitionState::STATE_READY);
+     *   partition_mgr->switchBootTarget(standby);
+     *   batch.commit();
+     */
+    class BootStatusBatch {
+    public:
+        explicit BootStatusBatch(PartitionManager& manager);
+        ~BootStatusBatch();
+        
+        BootStatusBatch(const BootStatusBatch&) = delete;
+        BootStatusBatch& operator=(const BootStatusBatch&) = delete;
+        
+        /**
+         * @brief Write the grouped changes (once; later calls return the first result)
+         * @return true if durable (or nothing changed)
+         */
+        bool commit();
+    
+    private:
+        PartitionManager& manager_;
+        bool committed_;
+        bool result_;
+    };
     
     /**
      * @brief Initialize partition manager
@@ -170,13 +227,56 @@ public:
      */
     bool writeMetadata(PartitionId partition, const PartitionMetadata& metadata);
     
+    /**
+     * @brief Store a hash tree after the image and record it in metadata
+     * 
+     * The tree is written (and synced) at the first 4KB boundary after the
+     * image; the metadata itself is not written.
+     * 
+     * @param partition Partition ID
+     * @param tree Tree built from the installed image
+     * @param metadata Metadata to fill in (hash_tree_* fields)
+     * @return true if successful
+     */
+    bool writeHashTree(PartitionId partition, const PartitionHashTree& tree, PartitionMetadata& metadata);
+    
     /**
      * @brief Verify partition integrity
+     * 
+     * With a hash tree: tree checked against the root, then all image blocks
+     * hashed on verify threads. Without: SHA256 of total_size image bytes.
+     * 
      * @param partition Partition ID
      * @return true if partition is valid
      */
     bool verifyPartition(PartitionId partition);
     
+    /**
+     * @brief Verify the image blocks covering a byte range (hash tree required)
+     * @param partition Partition ID
+     * @param offset Image offset (excluding metadata)
+     * @param length Bytes
+     * @return true if every block in the range matches the tree
+     */
+    bool verifyPartitionRange(PartitionId partition, uint64_t offset, uint64_t length);
+    
+    /**
+     * @brief Check the stored hash tree against the metadata root (no image reads)
+     * @param partition Partition ID
+     * @return true if the tree is intact
+     */
+    bool checkPartitionRoot(PartitionId partition);
+    
+    /**
+     * @brief Set hash tree verification threads (0 = one per CPU core)
+     */
+    void setVerifyThreads(unsigned thread_count) { verify_threads_ = thread_count; }
+    
+    /**
+     * @brief Set the simulation image size (before initialize())
+     */
+    void setSimulationImageSize(uint64_t bytes) { sim_image_size_ = bytes; }
+    
     /**
      * @brief Switch boot target (parallel to ZGW FlashBank_SwitchBank)
      * @param target Target partition for next boot
@@ -204,6 +304,11 @@ public:
     
     /**
      * @brief Perform rollback to previous partition
+     * 
+     * The previous partition is verified against its hash tree first (if it
+     * has one); a corrupted partition is marked STATE_ERROR and the rollback
+     * is refused.
+     * 
      * @return true if successful
      */
     bool performRollback();
@@ -242,28 +347,65 @@ private:
     std::string boot_status_path_;
     bool simulation_mode_;
     bool data_mounted_;
+    unsigned verify_threads_;
+    uint64_t sim_image_size_;
     
     // Runtime state
     PartitionId active_partition_;
     BootStatus boot_status_;
+    int boot_status_fd_;                // Journal file, kept open
+    unsigned batch_depth_;              // Open BootStatusBatch objects
+    bool boot_status_dirty_;            // Changes deferred by a batch
     
     /**
-     * @brief Read boot status from file
+     * @brief Load the stored hash tree described by metadata
+     * @return true if the tree was read
+     */
+    bool loadHashTree(PartitionId partition, const PartitionMetadata& metadata, PartitionHashTree& tree);
+    
+    /**
+     * @brief Check hash tree roots of bootable partitions (at startup)
+     */
+    void checkBootPartitions();
+    
+    /**
+     * @brief Open (and preallocate) the boot status journal
+     * @return true if boot_status_fd_ is valid
+     */
+    bool openBootStatus();
+    
+    /**
+     * @brief Read the newest valid journal slot
      * @return true if successful
      */
     bool readBootStatus();
     
     /**
-     * @brief Write boot status to file
+     * @brief Write boot status to the next journal slot (deferred inside a batch)
      * @return true if successful
      */
     bool writeBootStatus();
     
     /**
-     * @brief Create simulation directories (if simulation_mode)
+     * @brief CRC32 of a record, excluding the crc32 field
+     */
+    static uint32_t bootStatusCRC32(const BootStatus& status);
+    
+    /**
+     * @brief Create simulation directories and partition images (if simulation_mode)
+     * 
+     * Existing images are reused; missing or short ones are created or
+     * extended as sparse files, so a restart writes no data.
+     * 
      * @return true if successful
      */
     bool createSimulationEnvironment();
+    
+    /**
+     * @brief Create or extend a sparse simulation partition image
+     * @return true if the image exists with at least sim_image_size_ bytes
+     */
+    bool prepareSimulationImage(const std::string& path);
 };
 
 #endif // PARTITION_MANAGER_HPP
@@ -0,0 +1,233 @@
+/**
+ * @file partition_writer.hpp
+ * @brief Large-block partition image writer
+ *
+ * Copies an image from a file into a partition at a fixed offset:
+ *   - Block device: O_DIRECT writes of PARTITION_WRITE_BLOCK_SIZE from
+ *     aligned buffers (no page cache, eMMC sees full sequential blocks);
+ *     source reads are queued ahead through AsyncFileReader
+ *   - Regular file (simulation partitions): copy_file_range(), then
+ *     sendfile(), in-kernel with no user-space copy
+ *   - Anything else, or if the above are refused: buffered pwrite()
+ *
+ * Images received over the network can be streamed in with begin() /
+ * append() / finish() instead of copy(); appended bytes are gathered into
+ * PARTITION_WRITE_BLOCK_SIZE blocks, so no intermediate file is needed.
+ *
+ * With setSkipUnchanged(true) every block is first read back from the
+ * partition and compared in PARTITION_COMPARE_BLOCK_SIZE pieces; only
+ * pieces that differ are written (re-flash / retry of the same image
+ * costs reads only, no eMMC wear). Files are then copied through the
+ * buffer instead of copy_file_range() / sendfile().
+ *
+ * The partition is always fdatasync()ed before copy() / finish() return,
+ * and the measured throughput (including the sync) is reported. copy()
+ * checks an optional CancelToken between blocks.
+ */
+
+#ifndef PARTITION_WRITER_HPP
+#define PARTITION_WRITER_HPP
+
+#include "cancel_token.hpp"
+#include <string>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+// ==================== Constants ====================
+
+#define PARTITION_WRITE_BLOCK_SIZE      (1024 * 1024)   // 1MB per write (multiple of eMMC erase unit)
+#define PARTITION_WRITE_ALIGNMENT       4096            // O_DIRECT buffer alignment
+#define PARTITION_COMPARE_BLOCK_SIZE    (64 * 1024)     // Skip-unchanged granularity
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief How the image was written
+ */
+enum class PartitionWriteMethod : uint8_t {
+    COPY_FILE_RANGE = 0,
+    SENDFILE = 1,
+    DIRECT_IO = 2,
+    BUFFERED = 3
+};
+
+/**
+ * @brief Result of a copy() call
+ */
+struct PartitionWriteStats {
+    PartitionWriteMethod method;    // Method that wrote the last block
+    uint64_t bytes;                 // Bytes written
+    double seconds;                 // Wall time including fdatasync
+    uint64_t blocks_written;        // Compare blocks written (skip-unchanged mode)
+    uint64_t blocks_skipped;        // Compare blocks already holding the image
+    
+    double throughputMBps() const { return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0; }
+};
+
+/**
+ * @brief Progress callback (after every block)
+ * @param written Bytes written so far
+ * @param total Bytes to write
+ * @param throughput_kbps Average throughput so far (KB/s)
+ */
+using PartitionWriteProgress = std::function<void(uint64_t written, uint64_t total, uint32_t throughput_kbps)>;
+
+/**
+ * @brief Aligned block buffer (posix_memalign)
+ */
+using PartitionWriteBuffer = std::unique_ptr<uint8_t, void (*)(void*)>;
+
+// ==================== Functions ====================
+
+/**
+ * @brief Method name for logging
+ */
+const char* partitionWriteMethodName(PartitionWriteMethod method);
+
+// ==================== Partition Writer ====================
+
+/**
+ * @brief Partition Writer Class
+ *
+ * Usage:
+ *   PartitionWriter writer("/dev/mmcblk0p3");
+ *   writer.copy(download_file, 0, image_size, sizeof(PartitionMetadata), progress);
+ *   writer.getStats().throughputMBps();
+ *
+ *   // or, streaming
+ *   writer.begin(sizeof(PartitionMetadata));
+ *   while (receive(chunk)) writer.append(chunk.data(), chunk.size());
+ *   writer.finish();
+ */
+class PartitionWriter {
+public:
+    /**
+     * @brief Constructor
+     * @param target_path Partition (block device or image file, must exist)
+     * @param block_size Bytes per write (rounded up to PARTITION_WRITE_ALIGNMENT)
+     */
+    explicit PartitionWriter(const std::string& target_path,
+                             size_t block_size = PARTITION_WRITE_BLOCK_SIZE);
+    ~PartitionWriter();
+    
+    PartitionWriter(const PartitionWriter&) = delete;
+    PartitionWriter& operator=(const PartitionWriter&) = delete;
+    
+    /**
+     * @brief Copy a file range into the partition and fdatasync it
+     * @param source_path Image file
+     * @param source_offset Start of the image in source_path
+     * @param length Image size
+     * @param target_offset Partition offset the image is written to
+     * @param progress Optional progress callback
+     * @return true if all bytes were written and synced
+     */
+    bool copy(const std::string& source_path, uint64_t source_offset, uint64_t length,
+              uint64_t target_offset, const PartitionWriteProgress& progress = nullptr);
+    
+    /**
+     * @brief Start a streamed write
+     * @param target_offset Partition offset of the first appended byte
+     * @return true if the partition is open
+     */
+    bool begin(uint64_t target_offset);
+    
+    /**
+     * @brief Append bytes at the current stream position
+     * @return true if buffered or written
+     */
+    bool append(const uint8_t* data, size_t size);
+    
+    /**
+     * @brief Write buffered bytes, fdatasync and close the partition
+     * @return true if everything appended is on the device
+     */
+    bool finish();
+    
+    /**
+     * @brief Average throughput since copy() / begin() (KB/s)
+     */
+    uint32_t throughputKBps() const;
+    
+    /**
+     * @brief Only write blocks that differ from the partition (before copy() / begin())
+     */
+    void setSkipUnchanged(bool skip) { skip_unchanged_ = skip; }
+    
+    /**
+     * @brief Stop copy() / append() between blocks once the token is cancelled, wait while paused (nullptr = never)
+     */
+    void setCancelToken(const CancelToken* cancel) { cancel_ = cancel; }
+    
+    const PartitionWriteStats& getStats() const { return stats_; }
+    const std::string& getError() const { return error_; }
+
+private:
+    std::string target_path_;
+    size_t block_size_;
+    PartitionWriteStats stats_;
+    std::string error_;
+    
+    int target_fd_;
+    int direct_fd_;                         // O_DIRECT descriptor (block devices)
+    PartitionWriteBuffer buffer_;
+    PartitionWriteBuffer compare_buffer_;   // Current partition contents (skip-unchanged mode)
+    bool skip_unchanged_;
+    const CancelToken* cancel_;
+    size_t buffered_;                       // Streamed bytes waiting in buffer_
+    uint64_t stream_offset_;                // Partition offset of buffer_[0]
+    std::chrono::steady_clock::time_point start_;
+    
+    /**
+     * @brief Check the cancel token, waiting while it is paused (sets error_ if cancelled)
+     */
+    bool cancelled();
+    
+    /**
+     * @brief Open the partition and pick the write method
+     * @param from_file Source is a file (in-kernel copy possible)
+     */
+    bool openTarget(uint64_t target_offset, bool from_file);
+    
+    /**
+     * @brief fdatasync (if ok) and close the partition
+     * @return ok, false if the sync or close failed
+     */
+    bool closeTarget(bool ok);
+    
+    /**
+     * @brief Copy one block in the kernel (copy_file_range / sendfile)
+     * 
+     * May downgrade stats_.method if the kernel refuses the file pair.
+     * 
+     * @return Bytes written (> 0), or 0 on error (error_ set) or once
+     *         stats_.method fell back to BUFFERED (error_ empty)
+     */
+    size_t copyBlock(int source_fd, uint64_t source_offset, uint64_t target_offset, size_t size);
+    
+    /**
+     * @brief Write user-space bytes, skipping unchanged blocks if enabled
+     */
+    bool writeBuffer(const uint8_t* data, size_t size, uint64_t target_offset);
+    
+    /**
+     * @brief Write user-space bytes (O_DIRECT for whole aligned blocks, buffered otherwise)
+     */
+    bool writeRange(const uint8_t* data, size_t size, uint64_t target_offset);
+    
+    /**
+     * @brief Read current partition contents into compare_buffer_
+     * @return Bytes read (short at the end of the partition)
+     */
+    size_t readTarget(size_t size, uint64_t target_offset);
+    
+    /**
+     * @brief Logical block size of the target (O_DIRECT offset/size granularity)
+     */
+    static size_t logicalBlockSize(int fd);
+};
+
+#endif // PARTITION_WRITER_HPP
@@ -0,0 +1,261 @@
+/**
+ * @file progress_publisher.hpp
+ * @brief Seqlock-published progress snapshots with rate-limited subscribers
+ *
+ * The writer stores a plain-data snapshot through a seqlock and never waits
+ * on a reader. Each subscriber (MQTT, logs, local IPC) has its own thread
+ * that samples the latest snapshot at its own interval and runs its
+ * callback only if the snapshot changed, so a slow consumer delays nobody
+ * but itself:
+ *
+ *   writer ──store──▶ SeqLock ◀──load── subscriber thread ──▶ callback
+ *                               ◀──load── subscriber thread ──▶ callback
+ */
+
+#ifndef PROGRESS_PUBLISHER_HPP
+#define PROGRESS_PUBLISHER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+
+// ==================== SeqLock ====================
+
+/**
+ * @brief Single-writer sequence lock for a trivially copyable value
+ *
+ * store() makes the sequence odd, copies the value and makes it even again.
+ * load() copies the value and retries if the sequence was odd or moved
+ * meanwhile. Data is kept in relaxed atomic words, so a torn copy is
+ * discarded instead of being a data race.
+ *
+ * Writers must be serialized by the caller.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+public:
+    SeqLock() : sequence_(0) {
+        for (auto& word : words_) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+    
+    /**
+     * @brief Publish a new value (writer, never blocks)
+     */
+    void store(const T& value) {
+        uint64_t words[WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+        
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+    
+    /**
+     * @brief Copy the latest value (any thread)
+     * @return Sequence of the copy (0 = nothing stored yet)
+     */
+    uint64_t load(T& value) const {
+        uint64_t words[WORDS];
+        while (true) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();      // Writer is mid-copy
+                continue;
+            }
+            
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                std::memcpy(&value, words, sizeof(T));
+                return before;
+            }
+        }
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    
+    std::atomic<uint64_t> sequence_;
+    std::atomic<uint64_t> words_[WORDS];
+};
+
+// ==================== Progress Publisher ====================
+
+/**
+ * @brief Progress Publisher Class
+ *
+ * Usage:
+ *   ProgressPublisher<OTAProgress> publisher;
+ *   unsigned id = publisher.subscribe("mqtt", 1000, [&](const OTAProgress& p) { publish(p); });
+ *   publisher.publish(progress);        // writer: seqlock store only
+ *   publisher.snapshot();               // any thread, lock-free
+ *   publisher.unsubscribe(id);
+ *
+ * A subscriber sees the latest snapshot at each tick; intermediate
+ * snapshots between two ticks are skipped. On unsubscribe() / stop() it
+ * gets one last sample so a final state is not lost.
+ */
+template <typename T>
+class ProgressPublisher {
+public:
+    using Callback = std::function<void(const T& snapshot)>;
+    
+    ProgressPublisher() : next_id_(1) {}
+    ~ProgressPublisher() { stop(); }
+    
+    ProgressPublisher(const ProgressPublisher&) = delete;
+    ProgressPublisher& operator=(const ProgressPublisher&) = delete;
+    
+    /**
+     * @brief Publish a snapshot (writers serialized by the caller)
+     */
+    void publish(const T& snapshot) { snapshot_.store(snapshot); }
+    
+    /**
+     * @brief Latest snapshot (value-initialized before the first publish)
+     */
+    T snapshot() const {
+        T value{};
+        snapshot_.load(value);
+        return value;
+    }
+    
+    /**
+     * @brief Start a subscriber thread
+     * @param name Subscriber name
+     * @param interval_ms Sampling period (clamped to at least 1 ms)
+     * @param callback Called on the subscriber thread when the snapshot changed
+     * @return Subscription id
+     */
+    unsigned subscribe(const std::string& name, uint32_t interval_ms, Callback callback) {
+        auto subscriber = std::make_unique<Subscriber>();
+        subscriber->name = name;
+        subscriber->interval_ms = interval_ms ? interval_ms : 1;
+        subscriber->callback = std::move(callback);
+        subscriber->stop = false;
+        
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        subscriber->id = next_id_++;
+        Subscriber* raw = subscriber.get();
+        raw->thread = std::thread([this, raw]() { runSubscriber(*raw); });
+        subscribers_.push_back(std::move(subscriber));
+        return raw->id;
+    }
+    
+    /**
+     * @brief Stop a subscriber after one last sample
+     * @return false if the id is unknown
+     */
+    bool unsubscribe(unsigned id) {
+        std::unique_ptr<Subscriber> subscriber;
+        {
+            std::lock_guard<std::mutex> lock(subscribers_mutex_);
+            for (auto it = subscribers_.begin(); it != subscribers_.end(); ++it) {
+                if ((*it)->id == id) {
+                    subscriber = std::move(*it);
+                    subscribers_.erase(it);
+                    break;
+                }
+            }
+        }
+        if (!subscriber) {
+            return false;
+        }
+        stopSubscriber(*subscriber);
+        return true;
+    }
+    
+    /**
+     * @brief Stop every subscriber after one last sample
+     */
+    void stop() {
+        std::vector<std::unique_ptr<Subscriber>> subscribers;
+        {
+            std::lock_guard<std::mutex> lock(subscribers_mutex_);
+            subscribers.swap(subscribers_);
+        }
+        for (auto& subscriber : subscribers) {
+            stopSubscriber(*subscriber);
+        }
+    }
+    
+    size_t subscriberCount() const {
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        return subscribers_.size();
+    }
+
+private:
+    struct Subscriber {
+        unsigned id;
+        std::string name;
+        uint32_t interval_ms;
+        Callback callback;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stop;
+    };
+    
+    SeqLock<T> snapshot_;
+    mutable std::mutex subscribers_mutex_;
+    std::vector<std::unique_ptr<Subscriber>> subscribers_;
+    unsigned next_id_;
+    
+    void runSubscriber(Subscriber& subscriber) {
+        uint64_t delivered = 0;         // Sequence 0: nothing published yet
+        std::unique_lock<std::mutex> lock(subscriber.mutex);
+        while (true) {
+            bool stopping = subscriber.cv.wait_for(lock, std::chrono::milliseconds(subscriber.interval_ms),
+                                                   [&]() { return subscriber.stop; });
+            lock.unlock();
+            
+            T value;
+            uint64_t sequence = snapshot_.load(value);
+            if (sequence != delivered) {
+                delivered = sequence;
+                subscriber.callback(value);
+            }
+            
+            if (stopping) {
+                return;
+            }
+            lock.lock();
+        }
+    }
+    
+    static void stopSubscriber(Subscriber& subscriber) {
+        {
+            std::lock_guard<std::mutex> lock(subscriber.mutex);
+            subscriber.stop = true;
+        }
+        subscriber.cv.notify_one();
+        if (subscriber.thread.joinable()) {
+            subscriber.thread.join();
+        }
+    }
+};
+
+#endif // PROGRESS_PUBLISHER_HPP
@@ -20,6 +20,7 @@
 #include "doip_client.hpp"
 #include "partition_manager.hpp"
 #include "ota_manager.hpp"
+#include "campaign_scheduler.hpp"
 
 /**
  * @brief System Manager Class
@@ -95,11 +96,11 @@ private:
     // OTA components (parallel with ZGW FlashBankManager)
     std::shared_ptr<PartitionManager> partition_mgr_;
     std::unique_ptr<OTAManager> ota_manager_;
+    std::unique_ptr<CampaignScheduler> campaign_scheduler_;  // Only submitter of OTA jobs
     
     // Event triggers (set by MQTT callback)
     std::atomic<bool> trigger_vci_collection_;
     std::atomic<bool> trigger_readiness_check_;
-    std::atomic<bool> trigger_ota_start_;  // New: OTA trigger
     
     // Timers
     uint32_t heartbeat_timer_;
@@ -0,0 +1,289 @@
+/**
+ * @file uds_transfer.hpp
+ * @brief Resumable Zone Package transfer over UDS with persisted checkpoints
+ *
+ * A Zone Package goes to its ZGW as one UDS transfer:
+ *
+ *   0x38 ReplaceFile (or 0x34 RequestDownload) → 0x36 blocks → 0x37
+ *
+ * Blocks are read from the file as they are sent. A block without a
+ * response is resent with the same blockSequenceCounter; if that keeps
+ * failing, the DoIP link is re-established with backoff and a 0x38 ZGW is
+ * asked to ResumeFile at the position it reports, so a short Ethernet
+ * outage costs a few blocks instead of the whole zone. A ZGW without file
+ * transfer support gets a clean restart from RequestDownload.
+ *
+ * The 0x36 block size starts at the ZGW's maxNumberOfBlockLength, halves
+ * after a lost block and grows back after a run of good blocks.
+ *
+ * Progress of 0x38 transfers (zone, ECU, acknowledged offset and block
+ * counter) is written to a small JSON file on the data partition, so a
+ * transfer cut off by a VMG restart resumes on the next attempt too.
+ */
+
+#ifndef UDS_TRANSFER_HPP
+#define UDS_TRANSFER_HPP
+
+#include "doip_client.hpp"
+#include "cancel_token.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// ==================== Constants ====================
+
+#define UDS_TRANSFER_DEFAULT_BLOCK      1024            // 0x36 payload if the ZGW reports no limit
+#define UDS_TRANSFER_MIN_BLOCK          256             // Smallest payload after repeated losses
+#define UDS_TRANSFER_MAX_BLOCK          (64 * 1024)
+#define UDS_TRANSFER_GROW_AFTER         32              // Good blocks before the block size doubles
+#define UDS_TRANSFER_BLOCK_RETRIES      2               // Resends of a block before reconnecting
+#define UDS_TRANSFER_RECONNECT_ATTEMPTS 5
+#define UDS_TRANSFER_RECONNECT_DELAY_MS 250             // Doubles per attempt (~7.75 s in total)
+
+#define UDS_CHECKPOINT_FILENAME         "uds_checkpoints.json"
+#define UDS_CHECKPOINT_VERSION          1
+#define UDS_CHECKPOINT_MAX_ENTRIES      32              // Oldest entries dropped first
+#define UDS_CHECKPOINT_INTERVAL_BYTES   (1024 * 1024)   // Persist at most once per MB sent
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief Progress of one interrupted Zone Package transfer
+ */
+struct UdsTransferCheckpoint {
+    std::string zgw;                // "ip:port"
+    std::string zone_id;
+    std::string ecu_id;             // ECU the offset falls in (empty = zone header)
+    uint64_t file_size;             // Identity of the transferred file:
+    uint32_t zone_crc32;            //   size, header CRC and dataFormatIdentifier
+    uint8_t data_format;
+    uint64_t offset;                // Bytes acknowledged by the ZGW
+    uint8_t block_sequence;         // Last acknowledged blockSequenceCounter
+    uint64_t updated_at;            // Unix time (seconds)
+};
+
+/**
+ * @brief Transfer statistics of the last run
+ */
+struct UdsTransferStats {
+    uint64_t bytes;                 // Bytes acknowledged in this run
+    uint64_t resumed_from;          // Offset the first 0x36 started at (0 = beginning)
+    uint32_t blocks;
+    uint32_t block_retries;         // Blocks resent with the same counter
+    uint32_t reconnects;
+    uint32_t resumes;               // 0x38 ResumeFile accepted
+    uint32_t restarts;              // Transfers started again from byte 0
+    size_t block_size;              // Final 0x36 payload size
+    size_t block_limit;             // Payload limit from the ZGW (and configuration)
+    bool file_transfer;             // 0x38 used (false = 0x34 RequestDownload)
+    double elapsed_ms;
+};
+
+// ==================== UDS Checkpoint Store ====================
+
+/**
+ * @brief UDS Checkpoint Store Class
+ *
+ * Usage:
+ *   UdsCheckpointStore store(download_path + "/" UDS_CHECKPOINT_FILENAME);
+ *   store.load();
+ *   transfer.setCheckpointStore(&store);
+ *
+ * Entries are keyed by ZGW and zone; a lookup with a different file size,
+ * CRC or format is a miss. Thread-safe (zones transfer concurrently).
+ */
+class UdsCheckpointStore {
+public:
+    /**
+     * @brief Constructor
+     * @param path Path to checkpoint JSON file
+     */
+    explicit UdsCheckpointStore(const std::string& path);
+    
+    /**
+     * @brief Load checkpoints from disk
+     * @return false if the file exists but is unreadable (store starts empty)
+     */
+    bool load();
+    
+    /**
+     * @brief Find the checkpoint of a transfer
+     * @return false if none matches zgw / zone and the file identity
+     */
+    bool lookup(const std::string& zgw, const std::string& zone_id, uint64_t file_size,
+                uint32_t zone_crc32, uint8_t data_format, UdsTransferCheckpoint& checkpoint) const;
+    
+    /**
+     * @brief Record progress and save
+     */
+    bool record(const UdsTransferCheckpoint& checkpoint);
+    
+    /**
+     * @brief Drop the checkpoint of a finished transfer and save
+     */
+    void clear(const std::string& zgw, const std::string& zone_id);
+    
+    size_t size() const;
+
+private:
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::map<std::string, UdsTransferCheckpoint> entries_;     // By zgw + "/" + zone_id
+    
+    /**
+     * @brief Write checkpoints atomically (temp file + fsync + rename)
+     */
+    bool save() const;
+};
+
+// ==================== UDS Zone Transfer ====================
+
+/**
+ * @brief UDS Zone Transfer Class
+ *
+ * Usage:
+ *   UdsZoneTransfer transfer(doip_client, "192.168.1.10:13400");
+ *   transfer.setCheckpointStore(&store);
+ *   transfer.setCancelToken(&cancel);
+ *   if (!transfer.run(zone_package_path)) {
+ *       if (transfer.formatRejected()) { ... send uncompressed ... }
+ *   }
+ */
+class UdsZoneTransfer {
+public:
+    /**
+     * @brief Constructor
+     * @param client DoIP client of the target ZGW (reconnected on link loss)
+     * @param zgw ZGW address "ip:port" (checkpoint key)
+     */
+    UdsZoneTransfer(DoIPClient& client, const std::string& zgw);
+    
+    UdsZoneTransfer(const UdsZoneTransfer&) = delete;
+    UdsZoneTransfer& operator=(const UdsZoneTransfer&) = delete;
+    
+    /**
+     * @brief dataFormatIdentifier of the transfer (UDS_DFI_*)
+     */
+    void setDataFormat(uint8_t data_format) { data_format_ = data_format; }
+    
+    /**
+     * @brief Try 0x38 ReplaceFile / ResumeFile before 0x34 RequestDownload
+     */
+    void setFileTransfer(bool enabled) { file_transfer_ = enabled; }
+    
+    /**
+     * @brief Cap the 0x36 payload below the ZGW limit (0 = ZGW limit)
+     */
+    void setMaxBlockSize(size_t bytes) { max_block_size_ = bytes; }
+    
+    /**
+     * @brief Persist / resume 0x38 transfers through a checkpoint store (nullptr = none)
+     */
+    void setCheckpointStore(UdsCheckpointStore* store) { checkpoints_ = store; }
+    
+    /**
+     * @brief Stop between blocks once cancelled, wait while paused (nullptr = never)
+     */
+    void setCancelToken(const CancelToken* cancel) { cancel_ = cancel; }
+    
+    /**
+     * @brief Transfer a Zone Package file
+     * @return true once the ZGW accepted RequestTransferExit
+     */
+    bool run(const std::string& path);
+    
+    /**
+     * @brief The ZGW refused the dataFormatIdentifier (NRC 0x31 on RequestDownload)
+     */
+    bool formatRejected() const { return format_rejected_; }
+    
+    const UdsTransferStats& getStats() const { return stats_; }
+    const std::string& getError() const { return error_; }
+
+private:
+    /**
+     * @brief Outcome of a 0x38 / 0x34 request
+     */
+    enum class RequestResult {
+        ACCEPTED,
+        REJECTED,           // Negative response
+        UNSUPPORTED,        // Service / mode not supported: fall back to 0x34
+        NO_RESPONSE         // Link lost
+    };
+    
+    struct EcuRange {
+        std::string ecu_id;
+        uint64_t offset;                // Within the Zone Package
+        uint64_t size;
+    };
+    
+    DoIPClient& client_;
+    std::string zgw_;
+    uint8_t data_format_;
+    bool file_transfer_;
+    size_t max_block_size_;
+    UdsCheckpointStore* checkpoints_;
+    const CancelToken* cancel_;
+    
+    // Current run
+    int fd_;
+    uint64_t file_size_;
+    std::string zone_id_;
+    uint32_t zone_crc32_;
+    std::vector<EcuRange> ecu_ranges_;
+    bool using_file_transfer_;
+    uint64_t offset_;                   // Bytes acknowledged
+    uint8_t sequence_;                  // Next blockSequenceCounter
+    size_t block_size_;
+    size_t block_limit_;
+    uint64_t persisted_offset_;
+    bool file_transfer_unsupported_;    // ZGW refused 0x38 in this run
+    bool format_rejected_;
+    UdsTransferStats stats_;
+    std::string error_;
+    
+    /**
+     * @brief Read zone ID, CRC and ECU table from the Zone Package header
+     */
+    void readHeader();
+    
+    /**
+     * @brief Open the transfer: ResumeFile at a checkpoint, else ReplaceFile, else RequestDownload
+     * @param resume Ask the ZGW to continue a partial file
+     * @return ACCEPTED (offset_ / sequence_ set), REJECTED or NO_RESPONSE
+     */
+    RequestResult start(bool resume);
+    
+    RequestResult requestFileTransfer(uint8_t mode);
+    RequestResult requestDownload();
+    
+    /**
+     * @brief Send 0x36 blocks from offset_ to the end of the file
+     */
+    bool sendBlocks();
+    
+    /**
+     * @brief Re-establish the link and continue (resume or clean restart)
+     */
+    bool recover();
+    
+    bool exitTransfer();
+    
+    /**
+     * @brief Record offset_ in the checkpoint store (0x38 transfers only)
+     */
+    void saveCheckpoint();
+    
+    /**
+     * @brief Set the block size limit from a maxNumberOfBlockLength field
+     */
+    void setBlockLimit(const std::vector<uint8_t>& response, size_t index, size_t length);
+    
+    const std::string& ecuAt(uint64_t offset) const;
+    bool cancelled();
+};
+
+#endif // UDS_TRANSFER_HPP
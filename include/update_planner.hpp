@@ -0,0 +1,125 @@
+/**
+ * @file update_planner.hpp
+ * @brief VCI-driven selective Vehicle OTA planning
+ *
+ * Compares the ECU Quick Reference table (ECUReference::firmware_version) in
+ * the 12KB Vehicle Package metadata with the latest VCI snapshot before the
+ * package body is downloaded:
+ *   - ECUs already running the target version are skipped
+ *   - Zones with no ECU to update are neither downloaded nor sent
+ *   - Zones with some up-to-date ECUs are sent as a subset Zone Package
+ *
+ * The plan falls back to updating everything if the VCI snapshot or the
+ * ECU references are missing. An ECU absent from the VCI is always updated.
+ */
+
+#ifndef UPDATE_PLANNER_HPP
+#define UPDATE_PLANNER_HPP
+
+#include "vehicle_package.hpp"
+#include "zone_package.hpp"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// ==================== Type Definitions ====================
+
+/**
+ * @brief Update decision for one ECU of the package
+ */
+struct ECUUpdateDecision {
+    std::string ecu_id;
+    uint8_t zone_number;
+    uint32_t target_version;            // ECUReference::firmware_version
+    uint32_t installed_version;         // VCI sw_version (valid if installed_known)
+    bool installed_known;
+    bool update;                        // Installed version differs or is unknown
+};
+
+/**
+ * @brief Selective update plan
+ */
+struct UpdatePlan {
+    bool selective;                     // false: update every zone and ECU
+    std::string reason;                 // Why the plan is not selective
+    std::vector<bool> zones;            // zone_refs order: zone is downloaded and sent
+    std::vector<ECUUpdateDecision> ecus;    // ecu_refs order
+    uint64_t package_bytes;             // Full Vehicle Package
+    uint64_t download_bytes;            // Metadata + selected zones
+    
+    bool zoneSelected(size_t zone) const { return !selective || (zone < zones.size() && zones[zone]); }
+    const ECUUpdateDecision* findECU(std::string_view ecu_id) const;
+    bool ecuSkipped(std::string_view ecu_id) const;
+    size_t selectedZoneCount() const;
+    size_t updatedECUCount() const;
+};
+
+// ==================== Functions ====================
+
+/**
+ * @brief Parse a version string ("1.2.3", "v1.2.3-20241117") into 0x00MMmmpp
+ */
+bool parseVersionString(const std::string& text, uint32_t& version);
+
+/**
+ * @brief Write a Zone Package holding only the ECUs the plan updates
+ *
+ * ECU Packages are copied as stored (compressed payloads stay compressed);
+ * the ECU table is compacted and total_size / zone_crc32 are recomputed from
+ * the verified ECU CRCs.
+ *
+ * @param zone Verified Zone Package
+ * @param plan Plan whose skipped ECUs are dropped
+ * @param output_path Output Zone Package file
+ * @return true if written
+ */
+bool writeZonePackageSubset(const ZonePackageView& zone, const UpdatePlan& plan,
+                            const std::string& output_path);
+
+// ==================== Update Planner ====================
+
+/**
+ * @brief Update Planner Class
+ *
+ * Usage:
+ *   UpdatePlanner planner;
+ *   planner.build(metadata, vci_snapshot);
+ *   planner.printPlan();
+ *   download(planner.getPlan().zones);
+ */
+class UpdatePlanner {
+public:
+    UpdatePlanner();
+    
+    /**
+     * @brief Compare package ECU references with a VCI snapshot
+     * @param metadata Vehicle Package metadata (body not needed)
+     * @param vci VCI report ({"ecus": [{"ecu_id", "sw_version"}, ...]})
+     * @return false if the metadata is invalid; a missing VCI is not an error
+     */
+    bool build(const VehiclePackageMetadata& metadata, const nlohmann::json& vci);
+    
+    /**
+     * @brief Get the plan of the last build() call
+     */
+    const UpdatePlan& getPlan() const { return plan_; }
+    
+    /**
+     * @brief Print per-zone / per-ECU decisions and the download size
+     */
+    void printPlan() const;
+
+private:
+    UpdatePlan plan_;
+    std::vector<std::string> zone_ids_;
+    std::vector<uint8_t> zone_numbers_;
+    
+    /**
+     * @brief Select every zone (non-selective plan)
+     */
+    void selectAll(const VehiclePackageMetadata& metadata, const std::string& reason);
+};
+
+#endif // UPDATE_PLANNER_HPP
@@ -17,6 +17,10 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include "package_view.hpp"
+#include "zone_package.hpp"
 
 // ==================== Constants ====================
 
@@ -67,32 +71,41 @@ struct VehiclePackageMetadata {
     uint8_t  region;                // Region code
     uint8_t  reserved1[12];
     
-    // Master SW Version (48 bytes)
+    // Master SW Version (52 bytes)
     uint32_t master_sw_version;     // 0xAABBCCDD (vAA.BB.CC.DD)
     char     master_sw_string[32];  // "v2.0.0"
-    uint8_t  reserved2[12];
+    uint8_t  reserved2[16];
     
-    // Package Counts (16 bytes)
+    // Package Counts (16 bytes, offset 128)
     uint8_t  zone_count;            // Number of Zone Packages (1~16)
     uint8_t  total_ecu_count;       // Total ECUs across all zones (1~256)
     uint8_t  reserved3[14];
     
-    // CRC (16 bytes)
-    uint32_t vehicle_crc32;         // CRC32 of entire Vehicle Package (excluding this field)
-    uint32_t metadata_crc32;        // CRC32 of this metadata structure
-    uint8_t  reserved4[8];
+    // CRC (48 bytes, offset 144)
+    uint32_t vehicle_crc32;         // CRC32 of Vehicle Package body (everything after this metadata)
+    uint32_t metadata_crc32;        // CRC32 of this metadata structure (this field as 0; 0 = not sealed)
+    uint8_t  reserved4[40];
     
-    // Zone References (512 bytes = 32 bytes × 16)
+    // Zone References (512 bytes = 32 bytes × 16, offset 192)
     ZoneReference zone_refs[MAX_ZONES_IN_VEHICLE];
     
-    // ECU Quick Reference Table (8192 bytes = 32 bytes × 256)
+    // ECU Quick Reference Table (8192 bytes = 32 bytes × 256, offset 704)
     ECUReference ecu_refs[MAX_ECUS_IN_VEHICLE];
     
-    // Reserved (3072 bytes)
-    uint8_t  reserved5[3072];
+    // Reserved (3392 bytes)
+    uint8_t  reserved5[3392];
     
 } __attribute__((packed));  // Total: 12KB (0x3000 bytes)
 
+static_assert(sizeof(ZoneReference) == 32, "ZoneReference must be 32 bytes");
+static_assert(sizeof(ECUReference) == 32, "ECUReference must be 32 bytes");
+static_assert(sizeof(VehiclePackageMetadata) == 12288, "VehiclePackageMetadata must be 12KB");
+static_assert(offsetof(VehiclePackageMetadata, zone_count) == 128, "zone_count offset");
+static_assert(offsetof(VehiclePackageMetadata, vehicle_crc32) == 144, "vehicle_crc32 offset");
+static_assert(offsetof(VehiclePackageMetadata, metadata_crc32) == 148, "metadata_crc32 offset");
+static_assert(offsetof(VehiclePackageMetadata, zone_refs) == 192, "zone_refs offset");
+static_assert(offsetof(VehiclePackageMetadata, ecu_refs) == 704, "ecu_refs offset");
+
 // ==================== Zone Package Info ====================
 
 /**
@@ -109,6 +122,81 @@ struct ZonePackageInfo {
     std::string extracted_path;     // Path to extracted Zone Package file
 };
 
+// ==================== Functions ====================
+
+/**
+ * @brief CRC32 of the 12KB metadata with metadata_crc32 taken as 0
+ */
+uint32_t calculateMetadataCRC32(const VehiclePackageMetadata& metadata);
+
+// ==================== Vehicle Package View ====================
+
+/**
+ * @brief Read-only view of a Vehicle Package
+ */
+class VehiclePackageView {
+public:
+    VehiclePackageView();
+    
+    /**
+     * @brief Overlay the view on a Vehicle Package and validate it
+     * @param data Start of the Vehicle Package
+     * @param size Bytes available from data
+     * @return true if metadata and zone references are within bounds
+     * @note Zone headers are validated lazily by zonePackage()
+     */
+    bool open(const uint8_t* data, uint64_t size);
+    
+    /**
+     * @brief Validate metadata without the package body
+     *
+     * Checks magic, metadata_crc32 (if sealed), zone count and that zone
+     * references lie inside total_size without overlapping. Used on the
+     * first 12KB of a download before any zone is fetched.
+     *
+     * @return nullptr if valid, otherwise the error
+     */
+    static const char* checkMetadata(const VehiclePackageMetadata& metadata);
+    
+    bool isValid() const { return metadata_ != nullptr; }
+    const char* getError() const { return error_; }
+    
+    /**
+     * @brief Metadata (all-zero metadata if not valid)
+     */
+    const VehiclePackageMetadata& metadata() const;
+    
+    const uint8_t* data() const { return data_; }
+    std::string_view vin() const { return fixedStringView(metadata().vin, sizeof(metadata().vin)); }
+    std::string_view model() const { return fixedStringView(metadata().model, sizeof(metadata().model)); }
+    std::string_view masterSWString() const {
+        return fixedStringView(metadata().master_sw_string, sizeof(metadata().master_sw_string));
+    }
+    
+    size_t zoneCount() const { return isValid() ? metadata_->zone_count : 0; }
+    TableRange<ZoneReference> zones() const { return TableRange<ZoneReference>(metadata().zone_refs, zoneCount()); }
+    std::string_view zoneId(size_t index) const {
+        const ZoneReference& ref = metadata().zone_refs[index];
+        return fixedStringView(ref.zone_id, sizeof(ref.zone_id));
+    }
+    
+    /**
+     * @brief Find zone reference by zone number
+     * @return nullptr if not found
+     */
+    const ZoneReference* findZone(uint8_t zone_number) const;
+    
+    /**
+     * @brief Zone Package view for a zone reference (validated on demand)
+     */
+    ZonePackageView zonePackage(const ZoneReference& ref) const;
+
+private:
+    const uint8_t* data_;
+    const VehiclePackageMetadata* metadata_;
+    const char* error_;
+};
+
 // ==================== Vehicle Package Parser ====================
 
 /**
@@ -140,6 +228,12 @@ public:
      */
     bool verify();
     
+    /**
+     * @brief Set number of CRC worker threads used by verify()
+     * @param thread_count Worker threads (0 = one per CPU core, 1 = single thread)
+     */
+    void setVerifyThreads(unsigned thread_count) { verify_threads_ = thread_count; }
+    
     /**
      * @brief Check if this package is for the correct vehicle
      * @param vin Expected VIN
@@ -152,9 +246,22 @@ public:
                              uint16_t model_year);
     
     /**
-     * @brief Get parsed metadata
+     * @brief Check vehicle target from metadata alone (before the body is downloaded)
+     */
+    static bool verifyVehicleTarget(const VehiclePackageMetadata& metadata,
+                                    const std::string& vin,
+                                    const std::string& model,
+                                    uint16_t model_year);
+    
+    /**
+     * @brief Get parsed metadata (points into the mapped package)
      */
-    const VehiclePackageMetadata& getMetadata() const { return metadata_; }
+    const VehiclePackageMetadata& getMetadata() const { return view_.metadata(); }
+    
+    /**
+     * @brief Get zero-copy view of the package
+     */
+    const VehiclePackageView& getView() const { return view_; }
     
     /**
      * @brief Get list of Zone Packages
@@ -192,14 +299,11 @@ public:
 
 private:
     std::string package_path_;
-    VehiclePackageMetadata metadata_;
+    MappedFile file_;
+    VehiclePackageView view_;
     std::vector<ZonePackageInfo> zone_packages_;
     bool parsed_;
-    
-    /**
-     * @brief Calculate CRC32 of data
-     */
-    uint32_t calculateCRC32(const uint8_t* data, size_t size) const;
+    unsigned verify_threads_;
     
     /**
      * @brief Determine target ZGW for a zone
@@ -9,6 +9,7 @@
 #define VEHICLE_STATE_HPP
 
 #include <string>
+#include <cstdint>
 
 /**
  * @brief Vehicle operational states
@@ -22,6 +23,24 @@ enum class VehicleState {
     UNKNOWN               // 알 수 없음
 };
 
+/**
+ * @brief State name ("DRIVING", "PARKED_IGNITION_OFF", ...)
+ */
+const char* vehicleStateName(VehicleState state);
+
+/**
+ * @brief Parse a state name (as returned by vehicleStateName())
+ * @return false if the name is unknown
+ */
+bool parseVehicleState(const std::string& name, VehicleState& state);
+
+/**
+ * @brief Bit of a state in a state mask
+ */
+inline uint32_t vehicleStateBit(VehicleState state) {
+    return 1u << static_cast<unsigned>(state);
+}
+
 /**
  * @brief Vehicle State Manager
  */
@@ -15,11 +15,19 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include "package_view.hpp"
 
 // ==================== Constants ====================
 
 #define ZONE_PACKAGE_MAGIC  0x5A4F4E45  // "ZONE"
-#define MAX_ECUS_IN_ZONE    16
+#define MAX_ECUS_IN_ZONE    12          // ECU table entries that fit in the 1KB header
+#define ECU_METADATA_MAGIC  0x4543554D  // "ECUM"
+
+// Firmware encoding in an ECU Package (ZoneECUEntry::compression)
+#define ECU_COMPRESSION_NONE    0x00    // Firmware stored raw
+#define ECU_COMPRESSION_ZSTD    0x01    // Firmware stored as one zstd frame (see ecu_compression.hpp)
 
 // ==================== Zone Package Metadata ====================
 
@@ -31,13 +39,24 @@ struct ZoneECUEntry {
     uint32_t offset;                // Offset in Zone Package
     uint32_t size;                  // Total ECU Package size (metadata + firmware)
     uint32_t metadata_size;         // ECU Metadata size (256 bytes)
-    uint32_t firmware_size;         // Firmware binary size
+    uint32_t firmware_size;         // Firmware bytes stored in the package (compressed size if compressed)
     uint32_t firmware_version;      // 0x00010203 (v1.2.3)
-    uint32_t crc32;                 // ECU Package CRC32
+    uint32_t crc32;                 // ECU Package CRC32 (as stored)
     uint8_t  priority;              // Update priority (0 = highest)
-    uint8_t  reserved[23];
+    uint8_t  compression;           // ECU_COMPRESSION_NONE / ECU_COMPRESSION_ZSTD
+    uint8_t  window_log;            // zstd: decoder window is 1 << window_log bytes (0 if raw)
+    uint8_t  reserved1;
+    uint32_t uncompressed_size;     // Firmware image size after decompression (0 if raw)
+    uint8_t  reserved[16];
 } __attribute__((packed));  // 64 bytes
 
+/**
+ * @brief Size of the firmware image the ECU flashes (ECUMetadata::firmware_size)
+ */
+inline uint32_t ecuImageSize(const ZoneECUEntry& entry) {
+    return entry.compression == ECU_COMPRESSION_NONE ? entry.firmware_size : entry.uncompressed_size;
+}
+
 /**
  * @brief Zone Package Header
  * 
@@ -52,20 +71,25 @@ struct ZonePackageHeader {
     
     char     zone_id[16];           // "Zone_Front_Left"
     uint8_t  zone_number;           // Zone number (1~16)
-    uint8_t  package_count;         // Number of ECUs (1~16)
+    uint8_t  package_count;         // Number of ECUs (1~12)
     uint8_t  reserved1[2];
     
     uint32_t zone_crc32;            // CRC32 of Zone Package (excluding this header)
     uint32_t timestamp;             // Package creation timestamp
     
     char     zone_name[32];         // Human-readable name
-    uint8_t  reserved2[188];
+    uint8_t  reserved2[184];
     
-    // ECU Table (768 bytes = 64 bytes × 12 entries, padded to 16)
+    // ECU Table (768 bytes = 64 bytes × 12 entries, offset 256)
     ZoneECUEntry ecu_table[MAX_ECUS_IN_ZONE];
     
 } __attribute__((packed));  // Total: 1024 bytes (1KB)
 
+static_assert(sizeof(ZoneECUEntry) == 64, "ZoneECUEntry must be 64 bytes");
+static_assert(offsetof(ZoneECUEntry, uncompressed_size) == 44, "uncompressed_size offset");
+static_assert(sizeof(ZonePackageHeader) == 1024, "ZonePackageHeader must be 1KB");
+static_assert(offsetof(ZonePackageHeader, ecu_table) == 256, "ecu_table offset");
+
 // ==================== ECU Package Metadata ====================
 
 /**
@@ -74,8 +98,7 @@ struct ZonePackageHeader {
 struct ECUDependency {
     char     ecu_id[16];            // Required ECU ID
     uint32_t min_version;           // Minimum required version
-    uint8_t  reserved[12];
-} __attribute__((packed));  // 32 bytes
+} __attribute__((packed));  // 20 bytes
 
 /**
  * @brief ECU Package Metadata
@@ -84,14 +107,14 @@ struct ECUDependency {
  * Location: Start of each ECU Package within Zone Package
  */
 struct ECUMetadata {
-    // Basic Info (112 bytes)
+    // Basic Info (76 bytes)
     uint32_t magic_number;          // 0x4543554D ("ECUM")
     
     char     ecu_id[16];            // "ECU_091"
     uint32_t sw_version;            // 0x00010203 (v1.2.3)
     uint32_t hw_version;            // 0x00010000 (HW v1.0.0)
-    uint32_t firmware_size;         // Firmware binary size
-    uint32_t firmware_crc32;        // Firmware CRC32
+    uint32_t firmware_size;         // Firmware image size (uncompressed)
+    uint32_t firmware_crc32;        // Firmware image CRC32 (uncompressed)
     uint32_t build_timestamp;       // Build time
     
     char     version_string[32];    // "v1.2.3-20241117"
@@ -99,14 +122,83 @@ struct ECUMetadata {
     uint8_t  dependency_count;      // Number of dependencies (0~8)
     uint8_t  reserved1[3];
     
-    // Dependency Info (256 bytes = 32 bytes × 8)
+    // Dependency Info (160 bytes = 20 bytes × 8, offset 76)
     ECUDependency dependencies[8];
     
-    // Reserved (144 bytes)
-    uint8_t  reserved2[144];
+    // Reserved (20 bytes)
+    uint8_t  reserved2[20];
     
 } __attribute__((packed));  // Total: 256 bytes
 
+static_assert(sizeof(ECUDependency) == 20, "ECUDependency must be 20 bytes");
+static_assert(sizeof(ECUMetadata) == 256, "ECUMetadata must be 256 bytes");
+static_assert(offsetof(ECUMetadata, dependency_count) == 72, "dependency_count offset");
+
+// ==================== ECU Package View ====================
+
+/**
+ * @brief ECU Package inside a Zone Package (metadata + firmware)
+ */
+struct ECUPackageView {
+    const ZoneECUEntry* entry;      // Entry in the zone ECU table
+    const ECUMetadata* metadata;    // ECU metadata (start of ECU Package)
+    const uint8_t* firmware;        // Firmware as stored (zstd frame if compressed)
+    uint32_t firmware_size;         // Stored bytes
+    
+    std::string_view ecuId() const { return fixedStringView(entry->ecu_id, sizeof(entry->ecu_id)); }
+    std::string_view versionString() const {
+        return fixedStringView(metadata->version_string, sizeof(metadata->version_string));
+    }
+};
+
+// ==================== Zone Package View ====================
+
+/**
+ * @brief Read-only view of a Zone Package
+ */
+class ZonePackageView {
+public:
+    ZonePackageView();
+    
+    /**
+     * @brief Overlay the view on a Zone Package and validate it
+     * @param data Start of the Zone Package
+     * @param size Bytes available from data
+     * @return true if header and ECU table are within bounds
+     */
+    bool open(const uint8_t* data, uint64_t size);
+    
+    bool isValid() const { return header_ != nullptr; }
+    const char* getError() const { return error_; }
+    
+    /**
+     * @brief Zone header (all-zero header if not valid)
+     */
+    const ZonePackageHeader& header() const;
+    
+    const uint8_t* data() const { return data_; }
+    uint32_t totalSize() const { return header().total_size; }
+    std::string_view zoneId() const { return fixedStringView(header().zone_id, sizeof(header().zone_id)); }
+    std::string_view zoneName() const { return fixedStringView(header().zone_name, sizeof(header().zone_name)); }
+    
+    size_t ecuCount() const { return isValid() ? header_->package_count : 0; }
+    TableRange<ZoneECUEntry> ecus() const { return TableRange<ZoneECUEntry>(header().ecu_table, ecuCount()); }
+    std::string_view ecuId(size_t index) const {
+        const ZoneECUEntry& entry = header().ecu_table[index];
+        return fixedStringView(entry.ecu_id, sizeof(entry.ecu_id));
+    }
+    
+    /**
+     * @brief ECU Package at ECU table index (bounds checked by open())
+     */
+    ECUPackageView ecuPackage(size_t index) const;
+
+private:
+    const uint8_t* data_;
+    const ZonePackageHeader* header_;
+    const char* error_;
+};
+
 // ==================== Zone Package Parser ====================
 
 /**
@@ -135,19 +227,30 @@ public:
     bool verify();
     
     /**
-     * @brief Get parsed header
+     * @brief Set number of CRC worker threads used by verify()
+     * @param thread_count Worker threads (0 = one per CPU core, 1 = single thread)
+     */
+    void setVerifyThreads(unsigned thread_count) { verify_threads_ = thread_count; }
+    
+    /**
+     * @brief Get parsed header (points into the mapped package)
+     */
+    const ZonePackageHeader& getHeader() const { return view_.header(); }
+    
+    /**
+     * @brief Get zero-copy view of the package
      */
-    const ZonePackageHeader& getHeader() const { return header_; }
+    const ZonePackageView& getView() const { return view_; }
     
     /**
      * @brief Get ECU count
      */
-    uint8_t getECUCount() const { return header_.package_count; }
+    uint8_t getECUCount() const { return static_cast<uint8_t>(view_.ecuCount()); }
     
     /**
      * @brief Get total package size
      */
-    uint32_t getTotalSize() const { return header_.total_size; }
+    uint32_t getTotalSize() const { return view_.totalSize(); }
     
     /**
      * @brief Print Zone Package summary
@@ -161,13 +264,10 @@ public:
 
 private:
     std::string package_path_;
-    ZonePackageHeader header_;
+    MappedFile file_;
+    ZonePackageView view_;
     bool parsed_;
-    
-    /**
-     * @brief Calculate CRC32
-     */
-    uint32_t calculateCRC32(const uint8_t* data, size_t size) const;
+    unsigned verify_threads_;
 };
 
 #endif // ZONE_PACKAGE_HPP
@@ -293,18 +293,97 @@ int ConfigManager::getMaxPackageSizeMb() const {
     return config_["ota"]["max_package_size_mb"];
 }
 
+int ConfigManager::getVerifyThreads() const {
+    return config_["ota"].value("verify_threads", 0);
+}
+
+int ConfigManager::getZgwMaxConcurrent() const {
+    return config_["ota"].value("zgw_max_concurrent", 1);
+}
+
+int ConfigManager::getZstdWindowLogMax() const {
+    return config_["ota"].value("zstd_window_log_max", 23);
+}
+
+bool ConfigManager::isStreamInstallEnabled() const {
+    return config_["ota"].value("stream_install", true);
+}
+
+bool ConfigManager::isSkipUnchangedBlocksEnabled() const {
+    return config_["ota"].value("skip_unchanged_blocks", true);
+}
+
+int ConfigManager::getPipelineBuffers() const {
+    return config_["ota"].value("pipeline_buffers", 8);
+}
+
+bool ConfigManager::isOverlapZoneFlashEnabled() const {
+    return config_["ota"].value("overlap_zone_flash", true);
+}
+
+bool ConfigManager::isUdsFileTransferEnabled() const {
+    return config_["ota"].value("uds_file_transfer", true);
+}
+
+int ConfigManager::getUdsMaxBlockBytes() const {
+    return config_["ota"].value("uds_max_block_bytes", 0);
+}
+
+int ConfigManager::getProgressReportIntervalMs() const {
+    return config_["ota"].value("progress_report_interval_ms", 1000);
+}
+
+int ConfigManager::getProgressLogIntervalMs() const {
+    return config_["ota"].value("progress_log_interval_ms", 5000);
+}
+
+int ConfigManager::getCampaignMaxAttempts() const {
+    return config_["ota"].value("campaign_max_attempts", 3);
+}
+
+std::vector<std::string> ConfigManager::getCampaignDownloadStates() const {
+    return config_["ota"].value("campaign_download_states", std::vector<std::string>{
+        "DRIVING", "PARKED_IGNITION_ON", "PARKED_IGNITION_OFF", "CHARGING"});
+}
+
+std::vector<std::string> ConfigManager::getCampaignInstallStates() const {
+    return config_["ota"].value("campaign_install_states", std::vector<std::string>{
+        "PARKED_IGNITION_OFF", "CHARGING"});
+}
+
 std::string ConfigManager::getPartitionAPath() const {
-    return config_["ota"]["dual_partition"]["partition_a_path"];
+    return config_["ota"]["dual_partition"]["partition_a"];
 }
 
 std::string ConfigManager::getPartitionBPath() const {
-    return config_["ota"]["dual_partition"]["partition_b_path"];
+    return config_["ota"]["dual_partition"]["partition_b"];
+}
+
+std::string ConfigManager::getDataPartitionPath() const {
+    return config_["ota"]["dual_partition"]["data_partition"];
+}
+
+std::string ConfigManager::getDataMountPoint() const {
+    return config_["ota"]["dual_partition"]["data_mount_point"];
 }
 
 std::string ConfigManager::getBootStatusPath() const {
     return config_["ota"]["dual_partition"]["boot_flag_path"];
 }
 
+bool ConfigManager::isPartitionSimulation() const {
+    const auto& dual_partition = config_["ota"]["dual_partition"];
+    return dual_partition.contains("simulation") && dual_partition["simulation"].value("enabled", false);
+}
+
+std::string ConfigManager::getSimulationImageDir() const {
+    return config_["ota"]["dual_partition"]["simulation"].value("image_dir", "/tmp/vmg_partitions");
+}
+
+int ConfigManager::getSimulationImageSizeMb() const {
+    return config_["ota"]["dual_partition"]["simulation"].value("image_size_mb", 100);
+}
+
 // ========================================
 // Logging Configuration
 // ========================================
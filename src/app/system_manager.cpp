@@ -14,7 +14,6 @@ SystemManager::SystemManager(ConfigManager& config)
       running_(false),
       trigger_vci_collection_(false),
       trigger_readiness_check_(false),
-      trigger_ota_start_(false),
       heartbeat_timer_(0),
       last_heartbeat_time_(0) {
 }
@@ -105,15 +104,29 @@ bool SystemManager::initialize() {
     // 8. Initialize OTA components (parallel with ZGW FlashBankManager)
     std::cout << "[INIT] Setting up OTA components...\n";
     
-    // Partition Manager (simulation mode for development)
-    partition_mgr_ = std::make_shared<PartitionManager>(
-        config_.getPartitionAPath(),
-        config_.getPartitionBPath(),
-        "/dev/mmcblk0p4",  // data_partition_path
-        "/data",           // data_mount_point
-        config_.getBootStatusPath(),
-        true  // simulation_mode = true
-    );
+    // Partition Manager (image files instead of block devices in simulation mode)
+    if (config_.isPartitionSimulation()) {
+        std::string image_dir = config_.getSimulationImageDir();
+        partition_mgr_ = std::make_shared<PartitionManager>(
+            image_dir + "/partition_a",
+            image_dir + "/partition_b",
+            image_dir + "/data",
+            image_dir + "/data",
+            image_dir + "/data/boot_status.dat",
+            true
+        );
+        partition_mgr_->setSimulationImageSize(
+            static_cast<uint64_t>(std::max(1, config_.getSimulationImageSizeMb())) * 1024 * 1024);
+    } else {
+        partition_mgr_ = std::make_shared<PartitionManager>(
+            config_.getPartitionAPath(),
+            config_.getPartitionBPath(),
+            config_.getDataPartitionPath(),
+            config_.getDataMountPoint(),
+            config_.getBootStatusPath(),
+            false
+        );
+    }
     
     if (!partition_mgr_->initialize()) {
         std::cerr << "[ERROR] Failed to initialize Partition Manager\n";
@@ -136,6 +149,14 @@ bool SystemManager::initialize() {
     }
     std::cout << "[INIT] ✓ OTA Manager initialized\n";
     
+    // Campaign queue (persistent; starts OTA jobs as the vehicle state allows)
+    campaign_scheduler_ = std::make_unique<CampaignScheduler>(config_, *ota_manager_);
+    if (!campaign_scheduler_->initialize()) {
+        std::cerr << "[ERROR] Failed to initialize Campaign Scheduler\n";
+        return false;
+    }
+    std::cout << "[INIT] ✓ Campaign Scheduler initialized\n";
+    
     std::cout << "[INIT] ✓ All subsystems initialized\n";
     
     running_ = true;
@@ -157,7 +178,11 @@ bool SystemManager::performPowerOnVci() {
     
     // 2. Collect and upload VCI
     std::cout << "[BOOT] Collecting VCI...\n";
-    return vci_collector_->collectAndUpload("power_on");
+    bool collected = vci_collector_->collectAndUpload("power_on");
+    
+    // OTA skips ECUs whose installed version already matches the package
+    ota_manager_->setVciSnapshot(vci_collector_->getVciData());
+    return collected;
 }
 
 void SystemManager::setupMqttCallback() {
@@ -185,10 +210,22 @@ void SystemManager::handleMqttCommand(const std::string& topic, const std::strin
             std::string campaign_id = cmd.value("campaign_id", "unknown");
             std::cout << "       Campaign ID: " << campaign_id << "\n";
             
-            // Set OTA trigger flag
-            trigger_ota_start_ = true;
+            // The queue is persistent: never store a campaign without a real package
+            if (!cmd.contains("package_url")) {
+                std::cerr << "       ✗ start_ota without package_url rejected\n";
+                return;
+            }
             
-            // TODO: Store OTA package info for processEvents() to pick up
+            // Queued; processEvents() starts it when the vehicle state allows
+            if (!campaign_scheduler_->enqueue(cmd)) {
+                std::cerr << "       Campaign not queued\n";
+            }
+            
+        } else if (command == "cancel_ota") {
+            // Safe from the MQTT callback: only flags the OTA worker / edits the queue
+            if (!campaign_scheduler_->cancel(cmd.value("campaign_id", ""))) {
+                std::cout << "       No such OTA campaign\n";
+            }
             
         } else if (command == "shutdown") {
             std::cout << "       Initiating graceful shutdown...\n";
@@ -210,7 +247,10 @@ void SystemManager::processEvents() {
     if (trigger_vci_collection_.exchange(false)) {
         std::cout << "\n[VCI] External VCI collection requested\n";
         
-        if (vci_collector_->collectAndUpload("external_request")) {
+        bool collected = vci_collector_->collectAndUpload("external_request");
+        ota_manager_->setVciSnapshot(vci_collector_->getVciData());
+        
+        if (collected) {
             // Send ACK via MQTT
             std::string status_topic = config_.getStatusTopic(config_.getDeviceId());
             nlohmann::json ack = {
@@ -228,26 +268,8 @@ void SystemManager::processEvents() {
         readiness_manager_->checkAndPublish("external_request");
     }
     
-    // Handle OTA start trigger
-    if (trigger_ota_start_.exchange(false)) {
-        std::cout << "\n[OTA] OTA update requested\n";
-        
-        // TODO: Parse OTA package info from MQTT message
-        // For now, use mock data for testing
-        OTAPackageInfo package_info;
-        package_info.campaign_id = "campaign_test_001";
-        package_info.package_url = "http://localhost:5000/packages/campaign_test_001/full_package.bin";
-        package_info.package_size = 10485760;  // 10MB for testing
-        package_info.firmware_version = 0x01020003;  // v1.2.3
-        package_info.sha256_hash = "0000000000000000000000000000000000000000000000000000000000000000";  // Mock
-        
-        // Start OTA update (non-blocking, runs in background)
-        if (ota_manager_->startOTA(package_info)) {
-            std::cout << "[OTA] ✓ OTA update started\n";
-        } else {
-            std::cerr << "[OTA] ✗ Failed to start OTA update\n";
-        }
-    }
+    // Run queued OTA campaigns (start / pause / resume) as the vehicle state allows
+    campaign_scheduler_->tick(vehicle_state_->getCurrentState(), std::time(nullptr));
 }
 
 void SystemManager::processHeartbeat() {
@@ -297,6 +319,15 @@ int SystemManager::getAdaptiveHeartbeatInterval() {
 void SystemManager::shutdown() {
     std::cout << "\n[SHUTDOWN] Cleaning up VMG System...\n";
     
+    // Running OTA stops at its next block (standby partition left unbootable)
+    if (ota_manager_) {
+        if (ota_manager_->isBusy()) {
+            ota_manager_->cancelOTA();
+        }
+        ota_manager_->stopWorker();
+        std::cout << "[SHUTDOWN] ✓ OTA worker stopped\n";
+    }
+    
     // Disconnect MQTT (will send LWT if configured)
     mqtt_client_->disconnect();
     std::cout << "[SHUTDOWN] ✓ MQTT disconnected\n";
@@ -23,8 +23,8 @@ void VehicleStateManager::updateState(VehicleState new_state) {
     }
 }
 
-std::string VehicleStateManager::getStateString() const {
-    switch (current_state_) {
+const char* vehicleStateName(VehicleState state) {
+    switch (state) {
         case VehicleState::DRIVING:
             return "DRIVING";
         case VehicleState::PARKED_IGNITION_ON:
@@ -40,6 +40,22 @@ std::string VehicleStateManager::getStateString() const {
     }
 }
 
+bool parseVehicleState(const std::string& name, VehicleState& state) {
+    for (VehicleState candidate : {VehicleState::DRIVING, VehicleState::PARKED_IGNITION_ON,
+                                   VehicleState::PARKED_IGNITION_OFF, VehicleState::CHARGING,
+                                   VehicleState::OTA_ACTIVE, VehicleState::UNKNOWN}) {
+        if (name == vehicleStateName(candidate)) {
+            state = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string VehicleStateManager::getStateString() const {
+    return vehicleStateName(current_state_);
+}
+
 bool VehicleStateManager::hasStateChanged() {
     if (state_changed_) {
         state_changed_ = false;
@@ -167,6 +167,33 @@ std::string MqttClient::getTopic(const std::string& suffix) const {
 // ============================================================================
 
 bool MqttClient::sendWakeUp(const std::string& vmg_sw_version, const std::string& vehicle_state) {
+    return publish(getTopic("wake_up"), buildWakeUpPayload(vmg_sw_version, vehicle_state), 1);
+}
+
+bool MqttClient::sendVciReport(const std::string& vci_json) {
+    return publish(getTopic("vci"), buildVciReportPayload(vci_json), 1);
+}
+
+bool MqttClient::sendReadinessResponse(const std::string& readiness_json) {
+    return publish(getTopic("response"), buildReadinessResponsePayload(readiness_json), 1);
+}
+
+bool MqttClient::sendDownloadProgress(const std::string& campaign_id, int percentage,
+                                      int bytes_downloaded, int total_bytes) {
+    return publish(getTopic("ota/status"),
+                   buildDownloadProgressPayload(campaign_id, percentage, bytes_downloaded, total_bytes), 0);
+}
+
+bool MqttClient::sendHeartbeat(const std::string& vehicle_state, int uptime_sec) {
+    return publish(getTopic("telemetry"), buildHeartbeatPayload(vehicle_state, uptime_sec), 0);
+}
+
+// ============================================================================
+// Payload Builders
+// ============================================================================
+
+std::string MqttClient::buildWakeUpPayload(const std::string& vmg_sw_version,
+                                           const std::string& vehicle_state) const {
     json payload = {
         {"msg_type", "vehicle_wake_up"},
         {"timestamp", std::time(nullptr)},
@@ -181,10 +208,10 @@ bool MqttClient::sendWakeUp(const std::string& vmg_sw_version, const std::string
         }}
     };
     
-    return publish(getTopic("wake_up"), payload.dump(), 1);
+    return payload.dump();
 }
 
-bool MqttClient::sendVciReport(const std::string& vci_json) {
+std::string MqttClient::buildVciReportPayload(const std::string& vci_json) const {
     json vci_data = json::parse(vci_json);
     
     json payload = {
@@ -196,10 +223,10 @@ bool MqttClient::sendVciReport(const std::string& vci_json) {
         {"zones", vci_data.value("zones", json::array())}
     };
     
-    return publish(getTopic("vci"), payload.dump(), 1);
+    return payload.dump();
 }
 
-bool MqttClient::sendReadinessResponse(const std::string& readiness_json) {
+std::string MqttClient::buildReadinessResponsePayload(const std::string& readiness_json) const {
     json readiness_data = json::parse(readiness_json);
     
     json payload = {
@@ -210,11 +237,11 @@ bool MqttClient::sendReadinessResponse(const std::string& readiness_json) {
         {"ecu_readiness", readiness_data.value("ecu_readiness", json::array())}
     };
     
-    return publish(getTopic("response"), payload.dump(), 1);
+    return payload.dump();
 }
 
-bool MqttClient::sendDownloadProgress(const std::string& campaign_id, int percentage,
-                                      int bytes_downloaded, int total_bytes) {
+std::string MqttClient::buildDownloadProgressPayload(const std::string& campaign_id, int percentage,
+                                                     int bytes_downloaded, int total_bytes) const {
     json payload = {
         {"msg_type", "ota_download_progress"},
         {"timestamp", std::time(nullptr)},
@@ -227,10 +254,10 @@ bool MqttClient::sendDownloadProgress(const std::string& campaign_id, int percen
         }}
     };
     
-    return publish(getTopic("ota/status"), payload.dump(), 0);
+    return payload.dump();
 }
 
-bool MqttClient::sendHeartbeat(const std::string& vehicle_state, int uptime_sec) {
+std::string MqttClient::buildHeartbeatPayload(const std::string& vehicle_state, int uptime_sec) const {
     json payload = {
         {"msg_type", "telemetry"},
         {"timestamp", std::time(nullptr)},
@@ -239,5 +266,5 @@ bool MqttClient::sendHeartbeat(const std::string& vehicle_state, int uptime_sec)
         {"uptime_sec", uptime_sec}
     };
     
-    return publish(getTopic("telemetry"), payload.dump(), 0);
+    return payload.dump();
 }
@@ -0,0 +1,438 @@
+/**
+ * @file async_io.cpp
+ * @brief Queued File I/O Implementation
+ */
+
+#include "async_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef VMG_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+// ==================== Helpers ====================
+
+const char* asyncIOBackendName(AsyncIOBackend backend) {
+    switch (backend) {
+        case AsyncIOBackend::IO_URING:    return "io_uring";
+        case AsyncIOBackend::THREAD_POOL: return "thread pool";
+        default:                          return "UNKNOWN";
+    }
+}
+
+AsyncIOBuffer allocateAsyncIOBuffer(size_t size) {
+    void* raw = nullptr;
+    if (posix_memalign(&raw, ASYNC_IO_ALIGNMENT, std::max<size_t>(size, 1)) != 0) {
+        raw = nullptr;
+    }
+    return AsyncIOBuffer(static_cast<uint8_t*>(raw), &std::free);
+}
+
+// ==================== Constructor ====================
+
+AsyncIO::AsyncIO(unsigned queue_depth)
+    : backend_(AsyncIOBackend::THREAD_POOL),
+      queue_depth_(std::max(1u, queue_depth)),
+      in_flight_(0),
+      ring_fd_(-1),
+      sq_ring_(nullptr),
+      cq_ring_(nullptr),
+      sqes_(nullptr),
+      sq_ring_size_(0),
+      cq_ring_size_(0),
+      sqes_size_(0),
+      sq_head_(nullptr),
+      sq_tail_(nullptr),
+      sq_mask_(nullptr),
+      sq_array_(nullptr),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cq_mask_(nullptr),
+      cqes_(nullptr),
+      stopping_(false)
+{
+    if (setupRing()) {
+        backend_ = AsyncIOBackend::IO_URING;
+    } else {
+        startPool();
+    }
+}
+
+AsyncIO::~AsyncIO() {
+    // Buffers belong to the caller: nothing may still be writing into them
+    AsyncIOCompletion completion;
+    while (in_flight_ > 0 && wait(completion)) {
+    }
+    
+    if (backend_ == AsyncIOBackend::IO_URING) {
+        closeRing();
+    } else {
+        stopPool();
+    }
+}
+
+// ==================== Requests ====================
+
+bool AsyncIO::submitRead(int fd, void* buffer, size_t size, uint64_t offset, uint64_t tag) {
+    return submit(Request{fd, buffer, size, offset, tag});
+}
+
+bool AsyncIO::submit(const Request& request) {
+    if (in_flight_ >= queue_depth_) {
+        return false;
+    }
+    
+    if (backend_ == AsyncIOBackend::IO_URING) {
+        if (!submitRing(request)) {
+            return false;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push_back(request);
+        request_cv_.notify_one();
+    }
+    
+    in_flight_++;
+    return true;
+}
+
+bool AsyncIO::wait(AsyncIOCompletion& completion) {
+    if (in_flight_ == 0) {
+        return false;
+    }
+    
+    if (backend_ == AsyncIOBackend::IO_URING) {
+        if (!waitRing(completion)) {
+            return false;
+        }
+    } else {
+        std::unique_lock<std::mutex> lock(mutex_);
+        completion_cv_.wait(lock, [this]() { return !completions_.empty(); });
+        completion = completions_.front();
+        completions_.pop_front();
+    }
+    
+    in_flight_--;
+    return true;
+}
+
+// ==================== io_uring ====================
+
+#ifdef VMG_HAVE_IO_URING
+
+bool AsyncIO::setupRing() {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth_, &params));
+    if (fd < 0) {
+        return false;       // ENOSYS, or blocked by seccomp / io_uring_disabled
+    }
+    
+    // IORING_OP_READ arrived with IORING_FEAT_RW_CUR_POS (5.6)
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        ::close(fd);
+        return false;
+    }
+    ring_fd_ = fd;
+    
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        closeRing();
+        return false;
+    }
+    
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                  IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+        cq_ring_ = nullptr;
+        closeRing();
+        return false;
+    }
+    
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        sqes_ = nullptr;
+        closeRing();
+        return false;
+    }
+    
+    uint8_t* sq = static_cast<uint8_t*>(sq_ring_);
+    uint8_t* cq = static_cast<uint8_t*>(cq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+    
+    // The ring may round entries up; never queue more than it holds
+    queue_depth_ = std::min(queue_depth_, params.sq_entries);
+    return true;
+}
+
+void AsyncIO::closeRing() {
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_) {
+        munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+        ::close(ring_fd_);
+    }
+    sqes_ = cq_ring_ = sq_ring_ = nullptr;
+    ring_fd_ = -1;
+}
+
+bool AsyncIO::submitRing(const Request& request) {
+    // Single submitter: only this thread moves the SQ tail
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes_) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = request.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(request.buffer);
+    sqe->len = static_cast<uint32_t>(std::min<size_t>(request.size, UINT_MAX));
+    sqe->off = request.offset;
+    sqe->user_data = request.tag;
+    
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    
+    for (;;) {
+        long submitted = syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0);
+        if (submitted >= 0) {
+            return true;
+        }
+        if (errno != EINTR && errno != EAGAIN) {
+            return false;
+        }
+    }
+}
+
+bool AsyncIO::waitRing(AsyncIOCompletion& completion) {
+    for (;;) {
+        unsigned head = *cq_head_;
+        if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+            const struct io_uring_cqe* cqe = static_cast<const struct io_uring_cqe*>(cqes_) + (head & *cq_mask_);
+            completion = AsyncIOCompletion{cqe->user_data, cqe->res};
+            __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+        
+        long result = syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (result < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+#else
+
+bool AsyncIO::setupRing() { return false; }
+void AsyncIO::closeRing() {}
+bool AsyncIO::submitRing(const Request&) { return false; }
+bool AsyncIO::waitRing(AsyncIOCompletion&) { return false; }
+
+#endif // VMG_HAVE_IO_URING
+
+// ==================== Thread Pool ====================
+
+void AsyncIO::startPool() {
+    unsigned count = std::min<unsigned>(ASYNC_IO_POOL_THREADS, queue_depth_);
+    for (unsigned i = 0; i < count; i++) {
+        workers_.emplace_back(&AsyncIO::workerLoop, this);
+    }
+}
+
+void AsyncIO::stopPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    request_cv_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void AsyncIO::workerLoop() {
+    for (;;) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            request_cv_.wait(lock, [this]() { return stopping_ || !requests_.empty(); });
+            if (requests_.empty()) {
+                return;
+            }
+            request = requests_.front();
+            requests_.pop_front();
+        }
+        
+        ssize_t n;
+        do {
+            n = ::pread(request.fd, request.buffer, request.size, static_cast<off_t>(request.offset));
+        } while (n < 0 && errno == EINTR);
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completions_.push_back(AsyncIOCompletion{request.tag, n < 0 ? -static_cast<int64_t>(errno) : n});
+        }
+        completion_cv_.notify_one();
+    }
+}
+
+// ==================== Async File Reader ====================
+
+AsyncFileReader::AsyncFileReader(size_t block_size, unsigned queue_depth)
+    : io_(queue_depth),
+      block_size_((std::max<size_t>(block_size, 1) + ASYNC_IO_ALIGNMENT - 1) / ASYNC_IO_ALIGNMENT * ASYNC_IO_ALIGNMENT)
+{
+}
+
+bool AsyncFileReader::read(int fd, uint64_t offset, uint64_t length, const AsyncReadConsumer& consumer) {
+    error_.clear();
+    
+    unsigned depth = io_.queueDepth();
+    while (buffers_.size() < depth) {
+        buffers_.push_back(allocateAsyncIOBuffer(block_size_));
+        if (!buffers_.back()) {
+            buffers_.pop_back();
+            error_ = "Failed to allocate read buffers";
+            return false;
+        }
+    }
+    
+    // Block b always uses buffer b % depth; at most depth consecutive blocks are in flight
+    uint64_t blocks = (length + block_size_ - 1) / block_size_;
+    std::vector<bool> done(depth, false);
+    std::vector<int64_t> results(depth, 0);
+    uint64_t next_submit = 0;
+    bool ok = true;
+    
+    auto blockSize = [&](uint64_t block) {
+        return static_cast<size_t>(std::min<uint64_t>(block_size_, length - block * block_size_));
+    };
+    auto submitNext = [&]() {
+        uint64_t block = next_submit++;
+        if (!io_.submitRead(fd, buffers_[block % depth].get(), blockSize(block), offset + block * block_size_, block)) {
+            error_ = "Failed to queue read at offset " + std::to_string(offset + block * block_size_);
+            return false;
+        }
+        return true;
+    };
+    
+    while (ok && next_submit < blocks && next_submit < depth) {
+        ok = submitNext();
+    }
+    
+    for (uint64_t block = 0; ok && block < blocks; block++) {
+        unsigned slot = static_cast<unsigned>(block % depth);
+        while (!done[slot]) {
+            AsyncIOCompletion completion;
+            if (!io_.wait(completion)) {
+                error_ = "Failed to wait for read completion";
+                ok = false;
+                break;
+            }
+            done[completion.tag % depth] = true;
+            results[completion.tag % depth] = completion.result;
+        }
+        if (!ok) {
+            break;
+        }
+        done[slot] = false;
+        
+        uint8_t* data = buffers_[slot].get();
+        size_t size = blockSize(block);
+        uint64_t position = offset + block * block_size_;
+        if (results[slot] < 0) {
+            error_ = "Read failed at offset " + std::to_string(position) + ": " + strerror(static_cast<int>(-results[slot]));
+            ok = false;
+            break;
+        }
+        
+        // Short read: finish the block synchronously
+        size_t filled = static_cast<size_t>(results[slot]);
+        while (filled < size) {
+            ssize_t n = ::pread(fd, data + filled, size - filled, static_cast<off_t>(position + filled));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                error_ = "Unexpected end of file at offset " + std::to_string(position + filled);
+                ok = false;
+                break;
+            }
+            filled += static_cast<size_t>(n);
+        }
+        
+        if (ok && !consumer(data, size)) {
+            error_ = "Read stopped at offset " + std::to_string(position);
+            ok = false;
+        }
+        
+        // Buffer is free again: queue the block depth ahead
+        if (ok && next_submit < blocks) {
+            ok = submitNext();
+        }
+    }
+    
+    // Never leave reads landing in buffers after returning
+    AsyncIOCompletion completion;
+    while (io_.inFlight() > 0 && io_.wait(completion)) {
+    }
+    return ok;
+}
+
+bool AsyncFileReader::read(const std::string& path, uint64_t offset, uint64_t length,
+                           const AsyncReadConsumer& consumer) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_ = "Failed to open " + path + ": " + strerror(errno);
+        return false;
+    }
+    posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_SEQUENTIAL);
+    
+    bool ok = read(fd, offset, length, consumer);
+    ::close(fd);
+    return ok;
+}
+
+bool AsyncFileReader::readFile(const std::string& path, const AsyncReadConsumer& consumer) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        error_ = "Failed to stat " + path + ": " + strerror(errno);
+        return false;
+    }
+    return read(path, 0, static_cast<uint64_t>(st.st_size), consumer);
+}
@@ -0,0 +1,456 @@
+/**
+ * @file campaign_scheduler.cpp
+ * @brief Campaign Scheduler Implementation
+ */
+
+#include "campaign_scheduler.hpp"
+#include "atomic_file.hpp"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <ctime>
+#include <cctype>
+
+// ==================== JSON Helpers ====================
+
+static bool statesFromJson(const nlohmann::json& names, uint32_t& mask, std::string& error) {
+    mask = 0;
+    for (const auto& name : names) {
+        VehicleState state;
+        if (!name.is_string() || !parseVehicleState(name.get<std::string>(), state)) {
+            error = "Unknown vehicle state " + name.dump();
+            return false;
+        }
+        mask |= vehicleStateBit(state);
+    }
+    return true;
+}
+
+// The campaign id names the download file, so it must not carry path separators
+static bool isValidCampaignId(const std::string& id) {
+    if (id.empty() || id == "." || id == "..") {
+        return false;
+    }
+    return std::all_of(id.begin(), id.end(), [](unsigned char c) {
+        return std::isalnum(c) || c == '.' || c == '_' || c == '-';
+    });
+}
+
+static bool isSha256Hex(const std::string& hex) {
+    return hex.size() == 64 && std::all_of(hex.begin(), hex.end(), [](unsigned char c) { return std::isxdigit(c); });
+}
+
+static nlohmann::json statesToJson(uint32_t mask) {
+    nlohmann::json names = nlohmann::json::array();
+    for (VehicleState state : {VehicleState::DRIVING, VehicleState::PARKED_IGNITION_ON,
+                               VehicleState::PARKED_IGNITION_OFF, VehicleState::CHARGING,
+                               VehicleState::OTA_ACTIVE, VehicleState::UNKNOWN}) {
+        if (mask & vehicleStateBit(state)) {
+            names.push_back(vehicleStateName(state));
+        }
+    }
+    return names;
+}
+
+bool CampaignScheduler::parseCampaign(const nlohmann::json& j, uint32_t download_states, uint32_t install_states,
+                                      OTACampaign& campaign, std::string& error) {
+    campaign = OTACampaign();
+    try {
+        campaign.package.campaign_id = j.at("campaign_id").get<std::string>();
+        campaign.package.package_url = j.at("package_url").get<std::string>();
+        campaign.package.package_size = j.value("package_size", 0u);
+        campaign.package.firmware_version = j.value("firmware_version", 0u);
+        campaign.package.sha256_hash = j.value("sha256_hash", std::string());
+        campaign.package.target_partition = j.value("target_partition", std::string());
+        
+        std::string type = j.value("package_type", std::string("single"));
+        if (type == "vehicle") {
+            campaign.type = OTAJobType::VEHICLE_PACKAGE;
+        } else if (type == "single") {
+            campaign.type = OTAJobType::SINGLE_PACKAGE;
+        } else {
+            error = "Unknown package_type " + type;
+            return false;
+        }
+        
+        campaign.priority = j.value("priority", 0);
+        campaign.deadline = j.value("deadline", int64_t(0));
+        campaign.queued_at = j.value("queued_at", int64_t(0));
+        campaign.not_before = j.value("not_before", int64_t(0));
+        campaign.attempts = j.value("attempts", 0u);
+        
+        campaign.download_states = download_states;
+        campaign.install_states = install_states;
+        if (j.contains("download_states") && !statesFromJson(j.at("download_states"), campaign.download_states, error)) {
+            return false;
+        }
+        if (j.contains("install_states") && !statesFromJson(j.at("install_states"), campaign.install_states, error)) {
+            return false;
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    
+    if (!isValidCampaignId(campaign.package.campaign_id)) {
+        error = "Invalid campaign_id '" + campaign.package.campaign_id + "' (allowed: A-Z a-z 0-9 . _ -)";
+        return false;
+    }
+    if (!isSha256Hex(campaign.package.sha256_hash)) {
+        error = "sha256_hash must be 64 hex digits";
+        return false;
+    }
+    if (campaign.package.package_size == 0) {
+        error = "package_size must be greater than 0";
+        return false;
+    }
+    // A phase no state allows would hold the OTA worker forever
+    if (campaign.download_states == 0 || campaign.install_states == 0) {
+        error = "No vehicle state allows the " + std::string(campaign.download_states == 0 ? "download" : "install")
+              + " phase";
+        return false;
+    }
+    return true;
+}
+
+nlohmann::json CampaignScheduler::campaignToJson(const OTACampaign& campaign) {
+    return {
+        {"campaign_id", campaign.package.campaign_id},
+        {"package_url", campaign.package.package_url},
+        {"package_size", campaign.package.package_size},
+        {"firmware_version", campaign.package.firmware_version},
+        {"sha256_hash", campaign.package.sha256_hash},
+        {"target_partition", campaign.package.target_partition},
+        {"package_type", campaign.type == OTAJobType::VEHICLE_PACKAGE ? "vehicle" : "single"},
+        {"priority", campaign.priority},
+        {"deadline", campaign.deadline},
+        {"download_states", statesToJson(campaign.download_states)},
+        {"install_states", statesToJson(campaign.install_states)},
+        {"queued_at", campaign.queued_at},
+        {"not_before", campaign.not_before},
+        {"attempts", campaign.attempts}
+    };
+}
+
+// ==================== Constructor ====================
+
+CampaignScheduler::CampaignScheduler(ConfigManager& config, OTAManager& ota_manager)
+    : config_(config),
+      ota_manager_(ota_manager),
+      max_attempts_(OTA_CAMPAIGN_MAX_ATTEMPTS),
+      default_download_states_(0),
+      default_install_states_(0) {
+}
+
+// ==================== Initialization ====================
+
+bool CampaignScheduler::initialize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    queue_path_ = config_.getOtaDownloadPath() + "/" OTA_CAMPAIGN_QUEUE_FILENAME;
+    max_attempts_ = static_cast<uint32_t>(std::max(1, config_.getCampaignMaxAttempts()));
+    
+    std::string error;
+    if (!statesFromJson(config_.getCampaignDownloadStates(), default_download_states_, error) ||
+        !statesFromJson(config_.getCampaignInstallStates(), default_install_states_, error)) {
+        std::cerr << "[Campaign] ✗ Invalid campaign state configuration: " << error << "\n";
+        return false;
+    }
+    
+    load();
+    
+    std::cout << "[Campaign] ✓ Queue: " << queue_path_ << " (" << campaigns_.size() << " waiting)\n";
+    std::cout << "[Campaign] ✓ Default states: download " << statesToJson(default_download_states_).dump()
+              << ", install " << statesToJson(default_install_states_).dump() << "\n";
+    return true;
+}
+
+bool CampaignScheduler::load() {
+    campaigns_.clear();
+    
+    std::ifstream file(queue_path_);
+    if (!file.is_open()) {
+        return true;    // No queue yet
+    }
+    
+    try {
+        nlohmann::json queue;
+        file >> queue;
+        
+        if (queue.value("version", 0) != OTA_CAMPAIGN_QUEUE_VERSION) {
+            std::cout << "[Campaign] ⚠ Queue version mismatch, starting empty\n";
+            return true;
+        }
+        
+        for (const auto& j : queue.at("campaigns")) {
+            OTACampaign campaign;
+            std::string error;
+            if (!parseCampaign(j, 0, 0, campaign, error)) {
+                std::cerr << "[Campaign] ⚠ Skipping queue entry: " << error << "\n";
+                continue;
+            }
+            campaigns_.push_back(campaign);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[Campaign] ✗ Failed to read " << queue_path_ << ": " << e.what() << "\n";
+        campaigns_.clear();
+        return false;
+    }
+    
+    return true;
+}
+
+// ==================== Queue ====================
+
+bool CampaignScheduler::enqueue(const OTACampaign& campaign) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string& campaign_id = campaign.package.campaign_id;
+    
+    if (campaign_id == running_id_) {
+        std::cerr << "[Campaign] ✗ Campaign " << campaign_id << " is already running\n";
+        return false;
+    }
+    
+    auto it = find(campaign_id);
+    if (it != campaigns_.end()) {
+        // Same campaign re-sent: take the new settings, keep its place and history
+        OTACampaign updated = campaign;
+        updated.queued_at = it->queued_at;
+        updated.not_before = it->not_before;
+        updated.attempts = it->attempts;
+        *it = updated;
+        std::cout << "[Campaign] ✓ Campaign " << campaign_id << " updated\n";
+    } else {
+        if (campaigns_.size() >= OTA_CAMPAIGN_MAX_QUEUED) {
+            std::cerr << "[Campaign] ✗ Queue full (" << campaigns_.size() << "), campaign " << campaign_id
+                      << " rejected\n";
+            return false;
+        }
+        
+        campaigns_.push_back(campaign);
+        if (campaigns_.back().queued_at == 0) {
+            campaigns_.back().queued_at = std::time(nullptr);
+        }
+        std::cout << "[Campaign] ✓ Campaign " << campaign_id << " queued (priority " << campaign.priority
+                  << ", " << campaigns_.size() << " waiting)\n";
+    }
+    
+    save();     // Still runs from memory if the queue could not be written
+    return true;
+}
+
+bool CampaignScheduler::enqueue(const nlohmann::json& command) {
+    OTACampaign campaign;
+    std::string error;
+    uint32_t download_states;
+    uint32_t install_states;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        download_states = default_download_states_;
+        install_states = default_install_states_;
+    }
+    
+    if (!parseCampaign(command, download_states, install_states, campaign, error)) {
+        std::cerr << "[Campaign] ✗ Invalid campaign: " << error << "\n";
+        return false;
+    }
+    campaign.queued_at = 0;     // Set by enqueue(); not taken from the server
+    campaign.not_before = 0;
+    campaign.attempts = 0;
+    return enqueue(campaign);
+}
+
+bool CampaignScheduler::cancel(const std::string& campaign_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string target = campaign_id.empty() ? running_id_ : campaign_id;
+    if (target.empty()) {
+        return false;
+    }
+    
+    if (target == running_id_) {
+        // Dropped by tick() once the worker reports OTA_CANCELLED
+        std::cout << "[Campaign] ⚠️  Cancelling running campaign " << target << "\n";
+        return ota_manager_.cancelOTA();
+    }
+    
+    auto it = find(target);
+    if (it == campaigns_.end()) {
+        return false;
+    }
+    campaigns_.erase(it);
+    save();
+    std::cout << "[Campaign] ✓ Campaign " << target << " removed from queue\n";
+    return true;
+}
+
+size_t CampaignScheduler::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return campaigns_.size();
+}
+
+std::string CampaignScheduler::getRunningCampaign() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_id_;
+}
+
+// ==================== Scheduling ====================
+
+void CampaignScheduler::tick(VehicleState state, int64_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t state_bit = vehicleStateBit(state);
+    
+    if (!running_id_.empty()) {
+        if (ota_manager_.isBusy()) {
+            // Pause / resume the running job for the current state
+            auto it = find(running_id_);
+            if (it != campaigns_.end()) {
+                ota_manager_.setAllowedPhases(allowedPhases(*it, state_bit));
+            }
+            return;
+        }
+        finishRunning(now);
+    }
+    
+    // A campaign that could not start before its deadline is dropped
+    bool changed = false;
+    for (auto it = campaigns_.begin(); it != campaigns_.end();) {
+        if (it->deadline != 0 && now > it->deadline) {
+            std::cerr << "[Campaign] ✗ Campaign " << it->package.campaign_id << " expired before it could start\n";
+            it = campaigns_.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+    
+    int next = pickNext(state_bit, now);
+    if (next < 0) {
+        if (changed) {
+            save();
+        }
+        return;
+    }
+    
+    // Count the attempt before starting, so a restart mid-run still counts
+    OTACampaign& campaign = campaigns_[next];
+    campaign.attempts++;
+    save();
+    
+    ota_manager_.setAllowedPhases(allowedPhases(campaign, state_bit));
+    if (!ota_manager_.submitOTA(campaign.package, campaign.type)) {
+        campaign.attempts--;    // Worker not available; try again next tick
+        save();
+        return;
+    }
+    
+    running_id_ = campaign.package.campaign_id;
+    std::cout << "[Campaign] ✓ Started campaign " << running_id_ << " (attempt " << campaign.attempts << "/"
+              << max_attempts_ << ", vehicle " << vehicleStateName(state) << ")\n";
+}
+
+void CampaignScheduler::finishRunning(int64_t now) {
+    OTAState result = ota_manager_.getState();
+    std::string campaign_id = running_id_;
+    running_id_.clear();
+    
+    auto it = find(campaign_id);
+    if (it == campaigns_.end()) {
+        return;
+    }
+    
+    if (result == OTAState::OTA_COMPLETED) {
+        std::cout << "[Campaign] ✓ Campaign " << campaign_id << " completed\n";
+        campaigns_.erase(it);
+    } else if (result == OTAState::OTA_CANCELLED) {
+        std::cout << "[Campaign] ⚠️  Campaign " << campaign_id << " cancelled, removed from queue\n";
+        campaigns_.erase(it);
+    } else if (it->attempts >= max_attempts_) {
+        std::cerr << "[Campaign] ✗ Campaign " << campaign_id << " failed " << it->attempts
+                  << " times, removed from queue\n";
+        campaigns_.erase(it);
+    } else {
+        it->not_before = now + int64_t(OTA_CAMPAIGN_RETRY_DELAY_SEC) * it->attempts;
+        std::cerr << "[Campaign] ⚠️  Campaign " << campaign_id << " failed (attempt " << it->attempts << "/"
+                  << max_attempts_ << "), retry in " << (it->not_before - now) << " s\n";
+    }
+    
+    save();
+}
+
+int CampaignScheduler::pickNext(uint32_t state_bit, int64_t now) const {
+    int best = -1;
+    for (size_t i = 0; i < campaigns_.size(); i++) {
+        const OTACampaign& campaign = campaigns_[i];
+        if ((campaign.download_states & state_bit) == 0 || now < campaign.not_before) {
+            continue;
+        }
+        if (best < 0) {
+            best = static_cast<int>(i);
+            continue;
+        }
+        
+        const OTACampaign& current = campaigns_[best];
+        if (campaign.priority != current.priority) {
+            if (campaign.priority > current.priority) {
+                best = static_cast<int>(i);
+            }
+            continue;
+        }
+        
+        // Earlier deadline first; no deadline sorts last
+        int64_t deadline = campaign.deadline ? campaign.deadline : INT64_MAX;
+        int64_t current_deadline = current.deadline ? current.deadline : INT64_MAX;
+        if (deadline != current_deadline) {
+            if (deadline < current_deadline) {
+                best = static_cast<int>(i);
+            }
+            continue;
+        }
+        
+        if (campaign.queued_at < current.queued_at) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+uint8_t CampaignScheduler::allowedPhases(const OTACampaign& campaign, uint32_t state_bit) {
+    uint8_t phases = 0;
+    if (campaign.download_states & state_bit) {
+        phases |= OTA_PHASE_DOWNLOAD;
+    }
+    if (campaign.install_states & state_bit) {
+        phases |= OTA_PHASE_INSTALL;
+    }
+    return phases;
+}
+
+std::vector<OTACampaign>::iterator CampaignScheduler::find(const std::string& campaign_id) {
+    for (auto it = campaigns_.begin(); it != campaigns_.end(); ++it) {
+        if (it->package.campaign_id == campaign_id) {
+            return it;
+        }
+    }
+    return campaigns_.end();
+}
+
+// ==================== Persistence ====================
+
+bool CampaignScheduler::save() const {
+    nlohmann::json campaigns = nlohmann::json::array();
+    for (const auto& campaign : campaigns_) {
+        campaigns.push_back(campaignToJson(campaign));
+    }
+    
+    nlohmann::json queue;
+    queue["version"] = OTA_CAMPAIGN_QUEUE_VERSION;
+    queue["campaigns"] = campaigns;
+    std::string content = queue.dump(2);
+    
+    std::string error;
+    if (!writeFileAtomic(queue_path_, content, error)) {
+        std::cerr << "[Campaign] ✗ " << error << "\n";
+        return false;
+    }
+    return true;
+}
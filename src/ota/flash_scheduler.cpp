@@ -0,0 +1,443 @@
+/**
+ * @file flash_scheduler.cpp
+ * @brief ECU Dependency-Graph Flash Scheduler Implementation
+ */
+
+#include "flash_scheduler.hpp"
+#include "update_planner.hpp"
+#include <iostream>
+#include <map>
+#include <set>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+// ==================== Helpers ====================
+
+static std::string versionToString(uint32_t version) {
+    return "v" + std::to_string((version >> 16) & 0xFF) + "." +
+           std::to_string((version >> 8) & 0xFF) + "." +
+           std::to_string(version & 0xFF);
+}
+
+// ==================== Constructor ====================
+
+FlashScheduler::FlashScheduler() {
+}
+
+// ==================== Graph Construction ====================
+
+bool FlashScheduler::build(const VehiclePackageView& package, const std::vector<ZonePackageInfo>& zones,
+                           const UpdatePlan* plan) {
+    ecus_.clear();
+    ecu_order_.clear();
+    jobs_.clear();
+    
+    if (!package.isValid() || zones.size() != package.zoneCount()) {
+        std::cerr << "[Scheduler] ✗ Package not parsed\n";
+        return false;
+    }
+    
+    return collectECUs(package, zones, plan) && orderECUs() && buildJobs(zones, plan);
+}
+
+bool FlashScheduler::collectECUs(const VehiclePackageView& package, const std::vector<ZonePackageInfo>& zones,
+                                 const UpdatePlan* plan) {
+    std::map<std::string_view, size_t> index;
+    
+    // Skipped zones may not have been downloaded; skipped ECUs are not flashed
+    auto zoneIncluded = [&](size_t z) { return !plan || plan->zoneSelected(z); };
+    auto ecuIncluded = [&](std::string_view ecu_id) { return !plan || !plan->ecuSkipped(ecu_id); };
+    
+    // Pass 1: ECU nodes
+    for (size_t z = 0; z < zones.size(); z++) {
+        if (!zoneIncluded(z)) {
+            continue;
+        }
+        
+        ZonePackageView zone = package.zonePackage(package.zones()[z]);
+        if (!zone.isValid()) {
+            std::cerr << "[Scheduler] ✗ Zone " << zones[z].zone_id << ": " << zone.getError() << "\n";
+            return false;
+        }
+        
+        for (size_t i = 0; i < zone.ecuCount(); i++) {
+            const ZoneECUEntry& entry = zone.ecus()[i];
+            std::string_view ecu_id = zone.ecuId(i);
+            if (!ecuIncluded(ecu_id)) {
+                continue;
+            }
+            
+            if (index.count(ecu_id)) {
+                std::cerr << "[Scheduler] ✗ Duplicate ECU in package: " << ecu_id << "\n";
+                return false;
+            }
+            
+            index[ecu_id] = ecus_.size();
+            ecus_.push_back({std::string(ecu_id), z, entry.priority, entry.firmware_version, {}});
+        }
+    }
+    
+    // Pass 2: dependency edges from ECU metadata
+    size_t node = 0;
+    for (size_t z = 0; z < zones.size(); z++) {
+        if (!zoneIncluded(z)) {
+            continue;
+        }
+        
+        ZonePackageView zone = package.zonePackage(package.zones()[z]);
+        
+        for (size_t i = 0; i < zone.ecuCount(); i++) {
+            if (!ecuIncluded(zone.ecuId(i))) {
+                continue;
+            }
+            
+            const ECUMetadata& metadata = *zone.ecuPackage(i).metadata;
+            size_t current = node++;
+            FlashECU& ecu = ecus_[current];
+            
+            if (metadata.dependency_count > 8) {
+                std::cerr << "[Scheduler] ✗ " << ecu.ecu_id << ": invalid dependency count "
+                          << (int)metadata.dependency_count << "\n";
+                return false;
+            }
+            
+            for (uint8_t d = 0; d < metadata.dependency_count; d++) {
+                const ECUDependency& dep = metadata.dependencies[d];
+                std::string_view dep_id = fixedStringView(dep.ecu_id, sizeof(dep.ecu_id));
+                
+                auto it = index.find(dep_id);
+                const ECUUpdateDecision* installed = plan ? plan->findECU(dep_id) : nullptr;
+                if (it == index.end() && installed && !installed->update) {
+                    // Already at the package version; no flash to wait for
+                    if (installed->target_version < dep.min_version) {
+                        std::cerr << "[Scheduler] ✗ " << ecu.ecu_id << " requires " << dep_id << " >= "
+                                  << versionToString(dep.min_version) << ", installed "
+                                  << versionToString(installed->target_version) << "\n";
+                        return false;
+                    }
+                    continue;
+                }
+                
+                if (it == index.end()) {
+                    // Not updated by this package; the installed version is the server's responsibility
+                    std::cout << "[Scheduler]   " << ecu.ecu_id << " requires " << dep_id << " >= "
+                              << versionToString(dep.min_version) << " (not in package)\n";
+                    continue;
+                }
+                
+                if (it->second == current) {
+                    continue;
+                }
+                
+                const FlashECU& required = ecus_[it->second];
+                if (required.version < dep.min_version) {
+                    std::cerr << "[Scheduler] ✗ " << ecu.ecu_id << " requires " << dep_id << " >= "
+                              << versionToString(dep.min_version) << ", package has "
+                              << versionToString(required.version) << "\n";
+                    return false;
+                }
+                
+                ecu.depends_on.push_back(it->second);
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool FlashScheduler::orderECUs() {
+    size_t count = ecus_.size();
+    std::vector<size_t> indegree(count, 0);
+    std::vector<std::vector<size_t>> dependents(count);
+    
+    for (size_t i = 0; i < count; i++) {
+        for (size_t dep : ecus_[i].depends_on) {
+            dependents[dep].push_back(i);
+            indegree[i]++;
+        }
+    }
+    
+    // Min-heap on (priority, package order)
+    using Key = std::pair<uint8_t, size_t>;
+    std::priority_queue<Key, std::vector<Key>, std::greater<Key>> ready;
+    for (size_t i = 0; i < count; i++) {
+        if (indegree[i] == 0) {
+            ready.push({ecus_[i].priority, i});
+        }
+    }
+    
+    while (!ready.empty()) {
+        size_t current = ready.top().second;
+        ready.pop();
+        ecu_order_.push_back(current);
+        
+        for (size_t next : dependents[current]) {
+            if (--indegree[next] == 0) {
+                ready.push({ecus_[next].priority, next});
+            }
+        }
+    }
+    
+    if (ecu_order_.size() != count) {
+        std::cerr << "[Scheduler] ✗ ECU dependency cycle:";
+        for (size_t i = 0; i < count; i++) {
+            if (indegree[i] > 0) {
+                std::cerr << " " << ecus_[i].ecu_id;
+            }
+        }
+        std::cerr << "\n";
+        return false;
+    }
+    
+    return true;
+}
+
+bool FlashScheduler::buildJobs(const std::vector<ZonePackageInfo>& zones, const UpdatePlan* plan) {
+    size_t count = zones.size();
+    jobs_.resize(count);
+    
+    for (size_t z = 0; z < count; z++) {
+        ZoneFlashJob& job = jobs_[z];
+        job.zone = z;
+        job.zone_number = zones[z].zone_number;
+        job.zgw = zones[z].target_zgw_ip + ":" + std::to_string(zones[z].target_zgw_port);
+        job.priority = 0xFF;
+        job.skipped = plan && !plan->zoneSelected(z);
+        job.size = job.skipped ? 0 : zones[z].size;
+        job.critical_path = 0;
+    }
+    
+    // Collapse ECU edges onto zones
+    std::vector<std::set<size_t>> depends_on(count);
+    for (const FlashECU& ecu : ecus_) {
+        jobs_[ecu.zone].priority = std::min(jobs_[ecu.zone].priority, ecu.priority);
+        
+        for (size_t dep : ecu.depends_on) {
+            size_t dep_zone = ecus_[dep].zone;
+            if (dep_zone != ecu.zone) {
+                depends_on[ecu.zone].insert(dep_zone);
+            } else if (ecus_[dep].priority > ecu.priority) {
+                // ZGW flashes a zone in priority order; warn if that contradicts the DAG
+                std::cout << "[Scheduler] ⚠ " << ecu.ecu_id << " depends on " << ecus_[dep].ecu_id
+                          << " but has higher priority within " << zones[ecu.zone].zone_id << "\n";
+            }
+        }
+    }
+    
+    std::vector<size_t> indegree(count, 0);
+    for (size_t z = 0; z < count; z++) {
+        jobs_[z].depends_on.assign(depends_on[z].begin(), depends_on[z].end());
+        indegree[z] = jobs_[z].depends_on.size();
+        for (size_t dep : jobs_[z].depends_on) {
+            jobs_[dep].dependents.push_back(z);
+        }
+    }
+    
+    // ECU DAG can still form a cycle between zones (A1 -> B1, B2 -> A2)
+    std::vector<size_t> order;
+    std::vector<size_t> queue;
+    for (size_t z = 0; z < count; z++) {
+        if (indegree[z] == 0) {
+            queue.push_back(z);
+        }
+    }
+    while (!queue.empty()) {
+        size_t current = queue.back();
+        queue.pop_back();
+        order.push_back(current);
+        for (size_t next : jobs_[current].dependents) {
+            if (--indegree[next] == 0) {
+                queue.push_back(next);
+            }
+        }
+    }
+    
+    if (order.size() != count) {
+        std::cerr << "[Scheduler] ✗ Zone dependency cycle (zones must be sent as a whole):";
+        for (size_t z = 0; z < count; z++) {
+            if (indegree[z] > 0) {
+                std::cerr << " " << zones[z].zone_id;
+            }
+        }
+        std::cerr << "\n";
+        return false;
+    }
+    
+    // Critical path: this zone plus the longest chain of zones waiting on it
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        ZoneFlashJob& job = jobs_[*it];
+        uint64_t longest = 0;
+        for (size_t next : job.dependents) {
+            longest = std::max(longest, jobs_[next].critical_path);
+        }
+        job.critical_path = job.size + longest;
+    }
+    
+    return true;
+}
+
+// ==================== Dispatch ====================
+
+bool FlashScheduler::run(unsigned per_zgw_limit, const std::function<bool(size_t zone)>& flash) {
+    size_t count = jobs_.size();
+    std::vector<size_t> pending(count);
+    std::vector<char> started(count, 0);
+    for (size_t j = 0; j < count; j++) {
+        pending[j] = jobs_[j].depends_on.size();
+    }
+    
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<std::string, unsigned> active;     // Running transfers per ZGW
+    std::vector<std::thread> threads;
+    size_t running = 0;
+    size_t finished = 0;
+    bool failed = false;
+    
+    // Skipped zones hold no ECU nodes, so nothing depends on them
+    for (size_t j = 0; j < count; j++) {
+        if (jobs_[j].skipped) {
+            started[j] = 1;
+            finished++;
+        }
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (!failed) {
+            // Ready jobs, longest critical path first, then priority
+            std::vector<size_t> ready;
+            for (size_t j = 0; j < count; j++) {
+                if (!started[j] && pending[j] == 0) {
+                    ready.push_back(j);
+                }
+            }
+            std::sort(ready.begin(), ready.end(), [&](size_t a, size_t b) { return startsBefore(a, b); });
+            
+            for (size_t j : ready) {
+                unsigned& zgw_active = active[jobs_[j].zgw];
+                if (per_zgw_limit > 0 && zgw_active >= per_zgw_limit) {
+                    continue;
+                }
+                
+                started[j] = 1;
+                zgw_active++;
+                running++;
+                
+                threads.emplace_back([&, j]() {
+                    bool ok = flash(jobs_[j].zone);
+                    
+                    std::lock_guard<std::mutex> guard(mutex);
+                    active[jobs_[j].zgw]--;
+                    running--;
+                    if (ok) {
+                        finished++;
+                        for (size_t next : jobs_[j].dependents) {
+                            pending[next]--;
+                        }
+                    } else {
+                        failed = true;
+                    }
+                    cv.notify_all();
+                });
+            }
+        }
+        
+        if (running == 0) {
+            break;
+        }
+        cv.wait(lock);
+    }
+    lock.unlock();
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    return !failed && finished == count;
+}
+
+std::vector<size_t> FlashScheduler::getTransferOrder() const {
+    size_t count = jobs_.size();
+    std::vector<size_t> pending(count);
+    std::vector<char> done(count, 0);
+    for (size_t j = 0; j < count; j++) {
+        pending[j] = jobs_[j].depends_on.size();
+        done[j] = jobs_[j].skipped;
+    }
+    
+    // run() with a single slot: the best ready job goes next
+    std::vector<size_t> order;
+    while (true) {
+        size_t best = count;
+        for (size_t j = 0; j < count; j++) {
+            if (!done[j] && pending[j] == 0 && (best == count || startsBefore(j, best))) {
+                best = j;
+            }
+        }
+        if (best == count) {
+            break;
+        }
+        
+        done[best] = 1;
+        order.push_back(best);
+        for (size_t next : jobs_[best].dependents) {
+            pending[next]--;
+        }
+    }
+    return order;
+}
+
+bool FlashScheduler::startsBefore(size_t a, size_t b) const {
+    if (jobs_[a].critical_path != jobs_[b].critical_path) {
+        return jobs_[a].critical_path > jobs_[b].critical_path;
+    }
+    if (jobs_[a].priority != jobs_[b].priority) {
+        return jobs_[a].priority < jobs_[b].priority;
+    }
+    return a < b;
+}
+
+// ==================== Plan ====================
+
+void FlashScheduler::printPlan() const {
+    std::cout << "\n";
+    std::cout << "========================================\n";
+    std::cout << "  Flash Plan\n";
+    std::cout << "========================================\n";
+    std::cout << "ECU order (dependencies first, then priority):\n";
+    
+    for (size_t i = 0; i < ecu_order_.size(); i++) {
+        const FlashECU& ecu = ecus_[ecu_order_[i]];
+        std::cout << "  [" << (i+1) << "] " << ecu.ecu_id << " " << versionToString(ecu.version)
+                  << " (priority=" << (int)ecu.priority << ")";
+        if (!ecu.depends_on.empty()) {
+            std::cout << " after";
+            for (size_t dep : ecu.depends_on) {
+                std::cout << " " << ecus_[dep].ecu_id;
+            }
+        }
+        std::cout << "\n";
+    }
+    
+    std::cout << "\nZone jobs:\n";
+    for (const ZoneFlashJob& job : jobs_) {
+        if (job.skipped) {
+            std::cout << "  Zone " << (int)job.zone_number << " -> skipped (ECUs up to date)\n";
+            continue;
+        }
+        std::cout << "  Zone " << (int)job.zone_number << " -> " << job.zgw
+                  << " (" << job.size << " bytes, critical path " << job.critical_path << " bytes)";
+        if (!job.depends_on.empty()) {
+            std::cout << " after";
+            for (size_t dep : job.depends_on) {
+                std::cout << " Zone " << (int)jobs_[dep].zone_number;
+            }
+        }
+        std::cout << "\n";
+    }
+    std::cout << "========================================\n\n";
+}
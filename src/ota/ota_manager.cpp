@@ -6,16 +6,54 @@
  */
 
 #include "ota_manager.hpp"
+#include "package_crc.hpp"
+#include "ecu_compression.hpp"
+#include "partition_writer.hpp"
+#include "async_io.hpp"
+#include "ota_pipeline.hpp"
+#include "uds_transfer.hpp"
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <cerrno>
+#include <cctype>
 #include <iomanip>
 #include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <openssl/sha.h>
 #include <openssl/evp.h>
 
+// ==================== Helpers ====================
+
+static std::string formatWriteStats(const PartitionWriteStats& stats) {
+    std::ostringstream text;
+    text << stats.bytes << " bytes, " << partitionWriteMethodName(stats.method) << ", "
+         << std::fixed << std::setprecision(1) << stats.throughputMBps() << " MB/s";
+    if (stats.blocks_written + stats.blocks_skipped > 0) {
+        text << ", " << stats.blocks_written << " blocks written, " << stats.blocks_skipped << " unchanged";
+    }
+    return text.str();
+}
+
+static void copyProgressText(char* dest, size_t size, const std::string& text) {
+    size_t length = std::min(text.size(), size - 1);
+    std::memcpy(dest, text.data(), length);
+    dest[length] = '\0';
+}
+
+static std::string formatPipelineStats(const PipelineStats& stats) {
+    std::ostringstream text;
+    text << stats.blocks << " blocks in " << std::fixed << std::setprecision(0) << stats.elapsed_ms
+         << " ms, busy receive " << stats.receive_ms << " / hash " << stats.hash_ms
+         << " / write " << stats.write_ms << " ms, limited by " << stats.bottleneck();
+    return text.str();
+}
+
 // ==================== Constructor ====================
 
 OTAManager::OTAManager(
@@ -30,11 +68,31 @@ OTAManager::OTAManager(
     partition_mgr_(partition_mgr),
     doip_clients_(doip_clients),
     current_state_(OTAState::OTA_IDLE),
+    progress_callback_id_(0),
     chunk_size_(OTA_DOWNLOAD_CHUNK_SIZE),
-    max_retries_(OTA_MAX_RETRY_ATTEMPTS)
+    max_retries_(OTA_MAX_RETRY_ATTEMPTS),
+    verify_threads_(0),
+    zgw_max_concurrent_(1),
+    zstd_window_log_max_(ECU_ZSTD_WINDOW_LOG_DEFAULT),
+    stream_install_(false),
+    skip_unchanged_(true),
+    pipeline_buffers_(OTA_PIPELINE_BUFFERS),
+    overlap_zone_flash_(true),
+    uds_file_transfer_(true),
+    uds_max_block_bytes_(0),
+    download_hashed_(false),
+    worker_stop_(false),
+    job_pending_(false),
+    job_running_(false),
+    job_type_(OTAJobType::SINGLE_PACKAGE),
+    allowed_phases_(OTA_PHASE_ALL),
+    install_in_download_(false)
 {
-    std::memset(&progress_, 0, sizeof(OTAProgress));
-    progress_.state = OTAState::OTA_IDLE;
+    resetProgress(0);
+}
+
+OTAManager::~OTAManager() {
+    stopWorker();
 }
 
 // ==================== Initialization ====================
@@ -45,18 +103,170 @@ bool OTAManager::initialize() {
     // Get paths from config
     download_path_ = config_.getOtaDownloadPath();
     install_path_ = config_.getOtaInstallPath();
+    verify_threads_ = static_cast<unsigned>(std::max(0, config_.getVerifyThreads()));
+    zgw_max_concurrent_ = static_cast<unsigned>(std::max(0, config_.getZgwMaxConcurrent()));
+    zstd_window_log_max_ = static_cast<unsigned>(std::clamp(config_.getZstdWindowLogMax(),
+                                                            ECU_ZSTD_WINDOW_LOG_MIN, ECU_ZSTD_WINDOW_LOG_MAX));
+    stream_install_ = config_.isStreamInstallEnabled();
+    skip_unchanged_ = config_.isSkipUnchangedBlocksEnabled();
+    pipeline_buffers_ = static_cast<unsigned>(std::clamp(config_.getPipelineBuffers(), 2, OTA_PIPELINE_MAX_BUFFERS));
+    overlap_zone_flash_ = config_.isOverlapZoneFlashEnabled();
+    uds_file_transfer_ = config_.isUdsFileTransferEnabled();
+    uds_max_block_bytes_ = static_cast<size_t>(std::max(0, config_.getUdsMaxBlockBytes()));
+    partition_mgr_->setVerifyThreads(verify_threads_);
     
     // Create directories if they don't exist
-    system(("mkdir -p " + download_path_).c_str());
-    system(("mkdir -p " + install_path_).c_str());
+    for (const std::string& dir : {download_path_, install_path_}) {
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            std::cerr << "[OTA] ⚠ Failed to create " << dir << ": " << ec.message() << "\n";
+        }
+    }
+    
+    // Offsets of zone transfers cut off by a restart
+    uds_checkpoints_ = std::make_unique<UdsCheckpointStore>(download_path_ + "/" UDS_CHECKPOINT_FILENAME);
+    uds_checkpoints_->load();
     
     std::cout << "[OTA] ✓ Download path: " << download_path_ << "\n";
     std::cout << "[OTA] ✓ Install path: " << install_path_ << "\n";
+    std::cout << "[OTA] ✓ Verify threads: " << resolveCRCThreadCount(verify_threads_) << "\n";
+    std::cout << "[OTA] ✓ Zone transfers per ZGW: "
+              << (zgw_max_concurrent_ ? std::to_string(zgw_max_concurrent_) : "unlimited") << "\n";
+    std::cout << "[OTA] ✓ CRC32 kernel: " << crc32KernelName(crc32SelectedKernel()) << "\n";
+    std::cout << "[OTA] ✓ zstd payloads: "
+              << (ecuCompressionAvailable(ECU_COMPRESSION_ZSTD)
+                  ? "window up to 2^" + std::to_string(zstd_window_log_max_) + " bytes"
+                  : std::string("not supported (ZGW must decompress)")) << "\n";
+    std::cout << "[OTA] ✓ A/B install: "
+              << (stream_install_ ? "streamed to standby partition" : "via download file")
+              << (skip_unchanged_ ? ", unchanged blocks skipped" : "") << "\n";
+    std::cout << "[OTA] ✓ Download pipeline: " << pipeline_buffers_ << " x " << chunk_size_ / 1024
+              << " KB buffers (receive / hash / write threads)\n";
+    std::cout << "[OTA] ✓ Vehicle OTA: "
+              << (overlap_zone_flash_ ? "zones sent while later zones download" : "zones sent after full download")
+              << "\n";
+    std::cout << "[OTA] ✓ Zone transfer: "
+              << (uds_file_transfer_ ? "0x38 resumable, 0x34 fallback" : "0x34 RequestDownload")
+              << ", block "
+              << (uds_max_block_bytes_ ? "up to " + std::to_string(uds_max_block_bytes_) + " bytes"
+                                       : std::string("ZGW limit")) << "\n";
+    
+    // Progress consumers sample the published snapshot on their own threads
+    uint32_t report_ms = static_cast<uint32_t>(std::max(1, config_.getProgressReportIntervalMs()));
+    int log_ms = config_.getProgressLogIntervalMs();
+    if (mqtt_client_) {
+        progress_publisher_.subscribe("mqtt", report_ms, [this](const OTAProgress& progress) {
+            sendProgressReport(progress);
+        });
+    }
+    if (log_ms > 0) {
+        progress_publisher_.subscribe("log", static_cast<uint32_t>(log_ms), &OTAManager::logProgress);
+    }
+    std::cout << "[OTA] ✓ Progress: MQTT every " << report_ms << " ms"
+              << (log_ms > 0 ? ", log every " + std::to_string(log_ms) + " ms" : std::string()) << "\n";
     std::cout << "[OTA] ✓ OTA Manager initialized\n";
     
     return true;
 }
 
+// ==================== Worker ====================
+
+bool OTAManager::submitOTA(const OTAPackageInfo& package_info, OTAJobType type) {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    if (worker_stop_) {
+        std::cerr << "[OTA] ✗ OTA worker stopped\n";
+        return false;
+    }
+    if (job_pending_ || isOTAInProgress()) {
+        std::cerr << "[OTA] ✗ OTA already in progress\n";
+        return false;
+    }
+    
+    if (!worker_.joinable()) {
+        worker_ = std::thread(&OTAManager::workerLoop, this);
+    }
+    
+    job_info_ = package_info;
+    job_type_ = type;
+    job_pending_ = true;
+    cancel_.reset();
+    resetProgress(package_info.package_size);
+    worker_cv_.notify_all();
+    
+    std::cout << "[OTA] ✓ Campaign " << package_info.campaign_id << " queued on OTA worker\n";
+    return true;
+}
+
+bool OTAManager::isBusy() const {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    return job_pending_;
+}
+
+bool OTAManager::waitIdle(uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    auto idle = [this]() { return !job_pending_; };
+    if (timeout_ms == 0) {
+        worker_cv_.wait(lock, idle);
+        return true;
+    }
+    return worker_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), idle);
+}
+
+void OTAManager::stopWorker() {
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        worker_stop_ = true;
+        if (job_pending_) {
+            cancel_.cancel();
+        }
+    }
+    worker_cv_.notify_all();
+    
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    
+    // Subscribers get the final state, then join
+    progress_publisher_.stop();
+}
+
+void OTAManager::workerLoop() {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    
+    while (true) {
+        worker_cv_.wait(lock, [this]() { return worker_stop_ || job_pending_; });
+        if (worker_stop_) {
+            job_pending_ = false;       // A queued job is dropped
+            worker_cv_.notify_all();
+            return;
+        }
+        
+        OTAPackageInfo package_info = job_info_;
+        OTAJobType type = job_type_;
+        job_running_ = true;
+        lock.unlock();
+        
+        // An escaping exception would terminate the process; fail the job instead
+        bool ok = false;
+        try {
+            ok = (type == OTAJobType::VEHICLE_PACKAGE) ? startVehicleOTA(package_info) : startOTA(package_info);
+        } catch (const std::exception& e) {
+            reportError(std::string("Unexpected exception: ") + e.what());
+        } catch (...) {
+            reportError("Unexpected unknown exception");
+        }
+        std::cout << "[OTA] Worker: campaign " << package_info.campaign_id
+                  << (ok ? " finished" : cancel_.isCancelled() ? " cancelled" : " failed") << "\n";
+        
+        lock.lock();
+        job_running_ = false;
+        job_pending_ = false;
+        cancel_.reset();
+        worker_cv_.notify_all();
+    }
+}
+
 // ==================== OTA Process ====================
 
 bool OTAManager::startOTA(const OTAPackageInfo& package_info) {
@@ -78,28 +288,47 @@ bool OTAManager::startOTA(const OTAPackageInfo& package_info) {
     package_info_ = package_info;
     
     // Reset progress
-    std::memset(&progress_, 0, sizeof(OTAProgress));
-    progress_.total_bytes = package_info.package_size;
-    
-    // Step 1: Download package
-    updateState(OTAState::OTA_DOWNLOADING, "Downloading OTA package");
-    if (!downloadPackage()) {
-        reportError("Download failed");
-        return false;
+    resetProgress(package_info.package_size);
+    download_hashed_ = false;
+    
+    // Streaming writes the standby partition while downloading, so it is
+    // only chosen while installing is allowed (otherwise download to file first)
+    bool stream = stream_install_ && (allowed_phases_ & OTA_PHASE_INSTALL);
+    if (stream_install_ && !stream) {
+        std::cout << "[OTA] Install not allowed in current vehicle state, downloading to file first\n";
     }
     
-    // Step 2: Verify package
-    updateState(OTAState::OTA_VERIFYING, "Verifying package integrity");
-    if (!verifyPackage()) {
-        reportError("Verification failed");
-        return false;
-    }
-    
-    // Step 3: Install to standby partition
-    updateState(OTAState::OTA_INSTALLING, "Installing to standby partition");
-    if (!installPackage()) {
-        reportError("Installation failed");
-        return false;
+    if (stream) {
+        // Steps 1-3 in one pass: download into the standby partition, verify at the end
+        install_in_download_ = true;
+        updateState(OTAState::OTA_DOWNLOADING, "Streaming OTA package to standby partition");
+        bool streamed = streamInstallPackage();
+        install_in_download_ = false;
+        if (!streamed) {
+            reportError("Streaming installation failed");
+            return false;
+        }
+    } else {
+        // Step 1: Download package
+        updateState(OTAState::OTA_DOWNLOADING, "Downloading OTA package");
+        if (!downloadPackage()) {
+            reportError("Download failed");
+            return false;
+        }
+        
+        // Step 2: Verify package
+        updateState(OTAState::OTA_VERIFYING, "Verifying package integrity");
+        if (!cancel_.waitWhilePaused() || !verifyPackage()) {
+            reportError("Verification failed");
+            return false;
+        }
+        
+        // Step 3: Install to standby partition
+        updateState(OTAState::OTA_INSTALLING, "Installing to standby partition");
+        if (!cancel_.waitWhilePaused() || !installPackage()) {
+            reportError("Installation failed");
+            return false;
+        }
     }
     
     // Step 4: Ready to reboot
@@ -109,7 +338,7 @@ bool OTAManager::startOTA(const OTAPackageInfo& package_info) {
     std::cout << "[OTA] ⚠️  Reboot required to apply changes\n";
     std::cout << "[OTA] ========================================\n\n";
     
-    current_state_ = OTAState::OTA_COMPLETED;
+    updateState(OTAState::OTA_COMPLETED, "OTA completed, reboot required");
     return true;
 }
 
@@ -120,50 +349,103 @@ bool OTAManager::downloadPackage() {
     
     // Prepare download path
     std::string download_file = download_path_ + "/" + package_info_.campaign_id + ".bin";
+    download_hashed_ = false;
     
     // Open output file
-    std::ofstream output_file(download_file, std::ios::binary);
-    if (!output_file.is_open()) {
+    int fd = ::open(download_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
         std::cerr << "[OTA] ✗ Failed to create download file: " << download_file << "\n";
         return false;
     }
     
-    // Download in chunks (with Range Request support)
-    size_t total_size = package_info_.package_size;
-    size_t downloaded = 0;
-    uint8_t last_reported_percentage = 0;
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mdctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    if (!mdctx || EVP_DigestInit_ex(mdctx.get(), EVP_sha256(), nullptr) != 1) {
+        std::cerr << "[OTA] ✗ Failed to initialize SHA256\n";
+        ::close(fd);
+        return false;
+    }
     
-    while (downloaded < total_size) {
-        size_t chunk_start = downloaded;
-        size_t chunk_end = std::min(downloaded + chunk_size_ - 1, total_size - 1);
-        
-        // Download chunk with retry
-        if (!downloadChunk(package_info_.package_url, chunk_start, chunk_end, output_file)) {
-            std::cerr << "[OTA] ✗ Failed to download chunk: " << chunk_start << "-" << chunk_end << "\n";
-            output_file.close();
-            return false;
-        }
-        
-        downloaded = chunk_end + 1;
-        
-        // Update progress
-        updateProgress(downloaded, total_size);
-        
-        // Report progress every 5%
-        uint8_t current_percentage = (downloaded * 100) / total_size;
-        if (current_percentage >= last_reported_percentage + OTA_PROGRESS_REPORT_INTERVAL) {
-            sendProgressReport();
-            last_reported_percentage = current_percentage;
-        }
+    // Download in chunks (with Range Request support); receiving, hashing
+    // and writing run on separate threads
+    uint64_t total_size = package_info_.package_size;
+    uint64_t requested = 0;
+    uint64_t downloaded = 0;
+    OTAPipeline pipeline(chunk_size_, pipeline_buffers_);
+    
+    bool completed = pipeline.run(
+        [&](PipelineBlock& block, size_t capacity) {
+            return receiveChunk(block, capacity, requested, total_size);
+        },
+        [&](const PipelineBlock& block) {
+            return EVP_DigestUpdate(mdctx.get(), block.data, block.size) == 1;
+        },
+        [&](const PipelineBlock& block) {
+            if (!writePipelineBlock(fd, block)) {
+                std::cerr << "[OTA] ✗ Failed to write chunk to file: " << std::strerror(errno) << "\n";
+                return false;
+            }
+            
+            downloaded += block.size;
+            
+            updateProgress(downloaded, total_size);
+            return true;
+        });
+    
+    if (::close(fd) != 0) {
+        completed = false;
+    }
+    if (!completed) {
+        std::cerr << "[OTA] ✗ Download failed: " << pipeline.getError() << "\n";
+        return false;
     }
     
-    output_file.close();
+    unsigned int hash_len = 0;
+    download_hashed_ = EVP_DigestFinal_ex(mdctx.get(), download_sha256_, &hash_len) == 1;
     
     std::cout << "[OTA] ✓ Download completed: " << download_file << "\n";
+    std::cout << "[OTA]   Pipeline: " << formatPipelineStats(pipeline.getStats()) << "\n";
+    return true;
+}
+
+bool OTAManager::receiveChunk(PipelineBlock& block, size_t capacity, uint64_t& next, uint64_t end) {
+    if (!cancel_.waitWhilePaused()) {
+        std::cerr << "[OTA] ⚠️  Download cancelled at byte " << next << "\n";
+        return false;
+    }
+    if (next >= end) {
+        return true;  // size 0: end of input
+    }
+    
+    uint64_t chunk_end = std::min<uint64_t>(next + capacity, end) - 1;
+    std::string body;
+    if (!downloadChunk(package_info_.package_url, next, chunk_end, body)) {
+        std::cerr << "[OTA] ✗ Failed to download chunk: " << next << "-" << chunk_end << "\n";
+        return false;
+    }
+    
+    std::memcpy(block.data, body.data(), body.size());
+    block.size = body.size();
+    block.offset = next;
+    next = chunk_end + 1;
     return true;
 }
 
 bool OTAManager::downloadChunk(const std::string& url, size_t start, size_t end, std::ofstream& output_file) {
+    std::string body;
+    if (!downloadChunk(url, start, end, body)) {
+        return false;
+    }
+    
+    // Write to file
+    output_file.write(body.data(), body.size());
+    if (!output_file.good()) {
+        std::cerr << "[OTA] ✗ Failed to write chunk to file\n";
+        return false;
+    }
+    return true;
+}
+
+bool OTAManager::downloadChunk(const std::string& url, size_t start, size_t end, std::string& body) {
     for (uint32_t attempt = 0; attempt < max_retries_; attempt++) {
         // Prepare Range header
         std::map<std::string, std::string> headers;
@@ -176,16 +458,21 @@ bool OTAManager::downloadChunk(const std::string& url, size_t start, size_t end,
         HttpResponse response = http_client_->get(url);
         
         if (response.success && (response.status_code == 206 || response.status_code == 200)) {
-            // Write to file
-            output_file.write(response.body.c_str(), response.body.size());
-            if (!output_file.good()) {
-                std::cerr << "[OTA] ✗ Failed to write chunk to file\n";
+            // A server that ignores Range answers 200 with the whole file
+            if (response.body.size() != end - start + 1) {
+                std::cerr << "[OTA] ✗ Range " << start << "-" << end << " returned "
+                          << response.body.size() << " bytes\n";
                 return false;
             }
+            
+            body = std::move(response.body);
             return true;
         }
         
         std::cerr << "[OTA] ⚠️  Chunk download failed (attempt " << (attempt + 1) << "/" << max_retries_ << ")\n";
+        if (cancel_.isCancelled()) {
+            return false;
+        }
         usleep(1000000);  // Wait 1 second before retry
     }
     
@@ -199,9 +486,11 @@ bool OTAManager::verifyPackage() {
     
     std::string download_file = download_path_ + "/" + package_info_.campaign_id + ".bin";
     
-    // Calculate SHA256
+    // Calculate SHA256 (already done by the download pipeline unless the file came from elsewhere)
     uint8_t calculated_hash[32];
-    if (!calculateSHA256(download_file, calculated_hash)) {
+    if (download_hashed_) {
+        std::memcpy(calculated_hash, download_sha256_, sizeof(calculated_hash));
+    } else if (!calculateSHA256(download_file, calculated_hash)) {
         std::cerr << "[OTA] ✗ Failed to calculate SHA256\n";
         return false;
     }
@@ -236,43 +525,27 @@ bool OTAManager::verifyPackage() {
 }
 
 bool OTAManager::calculateSHA256(const std::string& file_path, uint8_t* hash) {
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "[OTA] ✗ Failed to open file for hashing: " << file_path << "\n";
-        return false;
-    }
-    
     // Use EVP API (recommended in OpenSSL 3.0)
     EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
     if (mdctx == nullptr) {
-        file.close();
         return false;
     }
     
     if (EVP_DigestInit_ex(mdctx, EVP_sha256(), nullptr) != 1) {
         EVP_MD_CTX_free(mdctx);
-        file.close();
         return false;
     }
     
-    const size_t buffer_size = 8192;
-    char buffer[buffer_size];
-    
-    while (file.good()) {
-        file.read(buffer, buffer_size);
-        size_t bytes_read = file.gcount();
-        
-        if (bytes_read > 0) {
-            if (EVP_DigestUpdate(mdctx, buffer, bytes_read) != 1) {
-                EVP_MD_CTX_free(mdctx);
-                file.close();
-                return false;
-            }
-        }
+    // Large reads queued ahead of the digest
+    AsyncFileReader reader;
+    if (!reader.readFile(file_path, [&](const uint8_t* data, size_t size) {
+        return EVP_DigestUpdate(mdctx, data, size) == 1;
+    })) {
+        std::cerr << "[OTA] ✗ Failed to hash " << file_path << ": " << reader.getError() << "\n";
+        EVP_MD_CTX_free(mdctx);
+        return false;
     }
     
-    file.close();
-    
     unsigned int hash_len;
     if (EVP_DigestFinal_ex(mdctx, hash, &hash_len) != 1) {
         EVP_MD_CTX_free(mdctx);
@@ -288,6 +561,11 @@ bool OTAManager::hexToBinary(const std::string& hex_string, uint8_t* binary) {
         return false;
     }
     
+    // stoi alone would accept a sign or "0x" prefix and throw on other junk
+    if (!std::all_of(hex_string.begin(), hex_string.end(), [](unsigned char c) { return std::isxdigit(c); })) {
+        return false;
+    }
+    
     for (size_t i = 0; i < 32; i++) {
         std::string byte_str = hex_string.substr(i * 2, 2);
         binary[i] = static_cast<uint8_t>(std::stoi(byte_str, nullptr, 16));
@@ -311,59 +589,164 @@ bool OTAManager::installPackage() {
     // Set partition state to UPDATING
     partition_mgr_->setPartitionState(standby, PartitionState::STATE_UPDATING);
     
-    // Prepare metadata
-    PartitionMetadata metadata;
-    std::memset(&metadata, 0, sizeof(PartitionMetadata));
-    metadata.magic_number = PARTITION_MAGIC_NUMBER;
-    metadata.firmware_version = package_info_.firmware_version;
-    metadata.build_timestamp = static_cast<uint32_t>(time(nullptr));
-    metadata.total_size = package_info_.package_size;
-    metadata.state = PartitionState::STATE_READY;
+    // Copy package data after the metadata area in large blocks, then fdatasync
+    std::string download_file = download_path_ + "/" + package_info_.campaign_id + ".bin";
+    PartitionWriter writer(standby_path);
+    writer.setSkipUnchanged(skip_unchanged_);
+    writer.setCancelToken(&cancel_);
+    
+    bool copied = writer.copy(download_file, 0, package_info_.package_size, sizeof(PartitionMetadata),
+                              [&](uint64_t written, uint64_t total, uint32_t throughput_kbps) {
+        updateProgress(static_cast<uint32_t>(written), static_cast<uint32_t>(total));
+        setInstallStats(throughput_kbps, 0, 0);
+    });
+    
+    const PartitionWriteStats& stats = writer.getStats();
+    setInstallStats(0, 0, 0);
+    if (!copied) {
+        std::cerr << "[OTA] ✗ Failed to write partition: " << writer.getError() << "\n";
+        partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
+        return false;
+    }
     
-    // Convert hash from hex to binary
-    hexToBinary(package_info_.sha256_hash, metadata.sha256_hash);
+    setInstallStats(0, stats.blocks_written, stats.blocks_skipped);
+    std::cout << "[OTA] ✓ Package installed (" << formatWriteStats(stats) << ")\n";
     
-    // Write metadata to partition (first 1KB)
-    std::ofstream partition_file(standby_path, std::ios::binary | std::ios::in | std::ios::out);
-    if (!partition_file.is_open()) {
-        std::cerr << "[OTA] ✗ Failed to open partition for writing\n";
+    // Leaves from the verified download, so the readback below also catches bad writes
+    PartitionHashTree tree;
+    if (!tree.build(download_file, 0, package_info_.package_size, verify_threads_)) {
+        std::cerr << "[OTA] ✗ Failed to build hash tree: " << tree.getError() << "\n";
         partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
         return false;
     }
     
-    partition_file.write(reinterpret_cast<const char*>(&metadata), sizeof(PartitionMetadata));
+    return completeInstall(standby, tree);
+}
+
+bool OTAManager::streamInstallPackage() {
+    std::cout << "[OTA] Streaming package to standby partition: " << package_info_.package_url << "\n";
     
-    // Copy package data (skip metadata in source, write after metadata in partition)
-    std::string download_file = download_path_ + "/" + package_info_.campaign_id + ".bin";
-    std::ifstream source_file(download_file, std::ios::binary);
-    if (!source_file.is_open()) {
-        std::cerr << "[OTA] ✗ Failed to open downloaded package\n";
-        partition_file.close();
+    PartitionId standby = partition_mgr_->getStandbyPartition();
+    std::string standby_path = partition_mgr_->getPartitionPath(standby);
+    
+    std::cout << "[OTA] Target partition: " << (standby == PartitionId::PARTITION_A ? "A" : "B") << "\n";
+    std::cout << "[OTA] Target path: " << standby_path << "\n";
+    
+    uint8_t expected_hash[32];
+    if (!hexToBinary(package_info_.sha256_hash, expected_hash)) {
+        std::cerr << "[OTA] ✗ Invalid SHA256 format\n";
+        return false;
+    }
+    
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mdctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    if (!mdctx || EVP_DigestInit_ex(mdctx.get(), EVP_sha256(), nullptr) != 1) {
+        std::cerr << "[OTA] ✗ Failed to initialize SHA256\n";
+        return false;
+    }
+    
+    // Not bootable until the hash of the whole image has been checked
+    partition_mgr_->setPartitionState(standby, PartitionState::STATE_UPDATING);
+    
+    PartitionWriter writer(standby_path);
+    writer.setSkipUnchanged(skip_unchanged_);
+    writer.setCancelToken(&cancel_);
+    if (!writer.begin(sizeof(PartitionMetadata))) {
+        std::cerr << "[OTA] ✗ Failed to open partition: " << writer.getError() << "\n";
         partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
         return false;
     }
     
-    // Copy data
-    const size_t buffer_size = 8192;
-    char buffer[buffer_size];
-    size_t total_copied = 0;
+    uint64_t total_size = package_info_.package_size;
+    uint64_t requested = 0;
+    uint64_t downloaded = 0;
+    PartitionHashTree tree;
+    tree.begin(total_size);
+    
+    // Receive, hash (SHA256 + tree leaves) and partition writes overlap
+    OTAPipeline pipeline(chunk_size_, pipeline_buffers_);
+    bool streamed = pipeline.run(
+        [&](PipelineBlock& block, size_t capacity) {
+            return receiveChunk(block, capacity, requested, total_size);
+        },
+        [&](const PipelineBlock& block) {
+            tree.update(block.data, block.size);
+            return EVP_DigestUpdate(mdctx.get(), block.data, block.size) == 1;
+        },
+        [&](const PipelineBlock& block) {
+            if (!writer.append(block.data, block.size)) {
+                std::cerr << "[OTA] ✗ Failed to write partition: " << writer.getError() << "\n";
+                return false;
+            }
+            
+            downloaded += block.size;
+            updateProgress(downloaded, total_size);
+            setInstallStats(writer.throughputKBps(), 0, 0);
+            return true;
+        });
     
-    while (source_file.good() && total_copied < package_info_.package_size) {
-        source_file.read(buffer, buffer_size);
-        size_t bytes_read = source_file.gcount();
-        
-        if (bytes_read > 0) {
-            partition_file.write(buffer, bytes_read);
-            total_copied += bytes_read;
-        }
+    setInstallStats(0, 0, 0);
+    if (!streamed) {
+        std::cerr << "[OTA] ✗ Streaming failed: " << pipeline.getError() << "\n";
+        partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
+        return false;
+    }
+    if (!writer.finish()) {
+        std::cerr << "[OTA] ✗ Failed to write partition: " << writer.getError() << "\n";
+        partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
+        return false;
     }
     
-    source_file.close();
-    partition_file.close();
+    const PartitionWriteStats& stats = writer.getStats();
+    setInstallStats(0, stats.blocks_written, stats.blocks_skipped);
+    std::cout << "[OTA] ✓ Package streamed (" << formatWriteStats(stats) << ")\n";
+    std::cout << "[OTA]   Pipeline: " << formatPipelineStats(pipeline.getStats()) << "\n";
+    
+    // Step 2 equivalent: hash of everything written
+    updateState(OTAState::OTA_VERIFYING, "Verifying streamed image");
+    uint8_t calculated_hash[32];
+    unsigned int hash_len = 0;
+    if (EVP_DigestFinal_ex(mdctx.get(), calculated_hash, &hash_len) != 1 ||
+        std::memcmp(calculated_hash, expected_hash, sizeof(expected_hash)) != 0) {
+        std::cerr << "[OTA] ✗ SHA256 mismatch! Streamed image corrupted\n";
+        partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
+        return false;
+    }
+    std::cout << "[OTA] ✓ Streamed image SHA256 verified\n";
+    
+    if (!tree.finish()) {
+        std::cerr << "[OTA] ✗ Failed to build hash tree: " << tree.getError() << "\n";
+        partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
+        return false;
+    }
+    
+    updateState(OTAState::OTA_INSTALLING, "Finalizing standby partition");
+    if (!cancel_.waitWhilePaused()) {
+        partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
+        return false;
+    }
+    return completeInstall(standby, tree);
+}
+
+bool OTAManager::completeInstall(PartitionId standby, const PartitionHashTree& tree) {
+    PartitionMetadata metadata;
+    std::memset(&metadata, 0, sizeof(PartitionMetadata));
+    metadata.magic_number = PARTITION_MAGIC_NUMBER;
+    metadata.firmware_version = package_info_.firmware_version;
+    metadata.build_timestamp = static_cast<uint32_t>(time(nullptr));
+    metadata.total_size = package_info_.package_size;
+    metadata.state = PartitionState::STATE_READY;
     
-    std::cout << "[OTA] ✓ Package installed (" << total_copied << " bytes)\n";
+    // Convert hash from hex to binary
+    hexToBinary(package_info_.sha256_hash, metadata.sha256_hash);
     
-    // Verify partition
+    // Metadata last: an interrupted copy leaves no valid metadata behind
+    if (!partition_mgr_->writeHashTree(standby, tree, metadata) ||
+        !partition_mgr_->writeMetadata(standby, metadata)) {
+        partition_mgr_->setPartitionState(standby, PartitionState::STATE_ERROR);
+        return false;
+    }
+    
+    // Read back every block against the tree
     std::cout << "[OTA] Verifying installed partition...\n";
     if (!partition_mgr_->verifyPartition(standby)) {
         std::cerr << "[OTA] ✗ Partition verification failed\n";
@@ -371,12 +754,14 @@ bool OTAManager::installPackage() {
         return false;
     }
     
-    // Set partition state to READY
+    // READY and the new boot target land in one boot status write
+    PartitionManager::BootStatusBatch batch(*partition_mgr_);
     partition_mgr_->setPartitionState(standby, PartitionState::STATE_READY);
     
     // Switch boot target
     std::cout << "[OTA] Switching boot target...\n";
-    if (!partition_mgr_->switchBootTarget(standby)) {
+    partition_mgr_->switchBootTarget(standby);
+    if (!batch.commit()) {
         std::cerr << "[OTA] ✗ Failed to switch boot target\n";
         return false;
     }
@@ -387,47 +772,170 @@ bool OTAManager::installPackage() {
 
 // ==================== Progress Reporting ====================
 
-void OTAManager::updateState(OTAState state, const std::string& step_description) {
+bool OTAManager::isValidTransition(OTAState from, OTAState to) {
+    if (from == to) {
+        return from != OTAState::OTA_IDLE;      // New step within the same state
+    }
+    
+    switch (to) {
+        case OTAState::OTA_ERROR:
+        case OTAState::OTA_CANCELLED:
+            return from == OTAState::OTA_DOWNLOADING || from == OTAState::OTA_VERIFYING ||
+                   from == OTAState::OTA_INSTALLING || from == OTAState::OTA_READY;
+        default:
+            break;
+    }
+    
+    switch (from) {
+        case OTAState::OTA_IDLE:
+        case OTAState::OTA_COMPLETED:
+        case OTAState::OTA_ERROR:
+        case OTAState::OTA_CANCELLED:
+            return to == OTAState::OTA_DOWNLOADING || to == OTAState::OTA_VERIFYING;
+        case OTAState::OTA_DOWNLOADING:
+            return to == OTAState::OTA_VERIFYING || to == OTAState::OTA_COMPLETED;
+        case OTAState::OTA_VERIFYING:
+            return to == OTAState::OTA_INSTALLING || to == OTAState::OTA_COMPLETED;
+        case OTAState::OTA_INSTALLING:
+            return to == OTAState::OTA_READY || to == OTAState::OTA_COMPLETED;
+        case OTAState::OTA_READY:
+            return to == OTAState::OTA_COMPLETED;
+    }
+    return false;
+}
+
+bool OTAManager::updateState(OTAState state, const std::string& step_description) {
+    OTAState current = current_state_;
+    if (!isValidTransition(current, state)) {
+        std::cerr << "[OTA] ✗ Invalid state transition " << static_cast<int>(current) << " -> "
+                  << static_cast<int>(state) << " (" << step_description << ")\n";
+        return false;
+    }
+    
     current_state_ = state;
-    progress_.state = state;
-    progress_.current_step = step_description;
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        progress_.state = state;
+        copyProgressText(progress_.current_step, sizeof(progress_.current_step), step_description);
+        publishProgress();
+    }
     
     std::cout << "[OTA] " << step_description << "...\n";
-    
-    sendProgressReport();
+    applyPhaseGate();
+    return true;
 }
 
 void OTAManager::updateProgress(uint32_t downloaded, uint32_t total) {
+    std::lock_guard<std::mutex> lock(progress_mutex_);
     progress_.downloaded_bytes = downloaded;
     progress_.total_bytes = total;
-    progress_.percentage = (downloaded * 100) / total;
+    progress_.percentage = static_cast<uint8_t>((uint64_t(downloaded) * 100) / total);
+    publishProgress();
 }
 
-void OTAManager::reportError(const std::string& error_message) {
-    current_state_ = OTAState::OTA_ERROR;
-    progress_.state = OTAState::OTA_ERROR;
-    progress_.error_message = error_message;
-    
-    std::cerr << "[OTA] ✗ ERROR: " << error_message << "\n";
+void OTAManager::resetProgress(uint32_t total_bytes) {
+    std::lock_guard<std::mutex> lock(progress_mutex_);
+    progress_ = OTAProgress();
+    progress_.state = current_state_;
+    progress_.total_bytes = total_bytes;
+    publishProgress();
+}
+
+void OTAManager::setProgressPercentage(uint8_t percentage) {
+    std::lock_guard<std::mutex> lock(progress_mutex_);
+    progress_.percentage = percentage;
+    publishProgress();
+}
+
+void OTAManager::setDownloadedBytes(uint32_t downloaded) {
+    std::lock_guard<std::mutex> lock(progress_mutex_);
+    progress_.downloaded_bytes = downloaded;
+    publishProgress();
+}
+
+void OTAManager::setInstallStats(uint32_t throughput_kbps, uint64_t blocks_written, uint64_t blocks_skipped) {
+    std::lock_guard<std::mutex> lock(progress_mutex_);
+    progress_.throughput_kbps = throughput_kbps;
+    progress_.blocks_written = static_cast<uint32_t>(blocks_written);
+    progress_.blocks_skipped = static_cast<uint32_t>(blocks_skipped);
+    publishProgress();
+}
+
+void OTAManager::publishProgress() {
+    progress_publisher_.publish(progress_);
+}
+
+unsigned OTAManager::subscribeProgress(const std::string& name, uint32_t interval_ms,
+                                       std::function<void(const OTAProgress&)> callback) {
+    return progress_publisher_.subscribe(name, interval_ms, std::move(callback));
+}
+
+bool OTAManager::unsubscribeProgress(unsigned id) {
+    return progress_publisher_.unsubscribe(id);
+}
+
+void OTAManager::setProgressCallback(std::function<void(const OTAProgress&)> callback) {
+    unsigned id = 0;
+    if (callback) {
+        id = progress_publisher_.subscribe("callback", OTA_PROGRESS_REPORT_INTERVAL_MS, std::move(callback));
+    }
     
-    sendProgressReport();
+    // Swap in one step: concurrent callers each drop the subscription they replaced
+    unsigned previous = progress_callback_id_.exchange(id);
+    if (previous != 0) {
+        progress_publisher_.unsubscribe(previous);
+    }
 }
 
-void OTAManager::sendProgressReport() {
-    if (!mqtt_client_) {
-        return;
+void OTAManager::reportError(const std::string& error_message) {
+    // A cancelled job fails at the next check; report it as cancelled
+    OTAState state = cancel_.isCancelled() ? OTAState::OTA_CANCELLED : OTAState::OTA_ERROR;
+    current_state_ = state;
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        progress_.state = state;
+        copyProgressText(progress_.error_message, sizeof(progress_.error_message),
+                         (state == OTAState::OTA_CANCELLED) ? "OTA cancelled by user" : error_message);
+        publishProgress();
     }
     
-    // Create progress JSON
+    if (state == OTAState::OTA_CANCELLED) {
+        std::cerr << "[OTA] ⚠️  CANCELLED during: " << error_message << "\n";
+    } else {
+        std::cerr << "[OTA] ✗ ERROR: " << error_message << "\n";
+    }
+}
+
+void OTAManager::logProgress(const OTAProgress& progress) {
+    std::cout << "[OTA] Progress: state " << static_cast<int>(progress.state) << ", "
+              << (int)progress.percentage << "% (" << progress.downloaded_bytes << "/" << progress.total_bytes
+              << " bytes) " << progress.current_step;
+    if (progress.error_message[0] != '\0') {
+        std::cout << " - " << progress.error_message;
+    }
+    std::cout << "\n";
+}
+
+void OTAManager::sendProgressReport(const OTAProgress& progress) {
+    // Create progress JSON (subscriber thread; the OTA job does not wait for this)
     nlohmann::json progress_json;
-    progress_json["state"] = static_cast<int>(progress_.state);
-    progress_json["percentage"] = progress_.percentage;
-    progress_json["downloaded_bytes"] = progress_.downloaded_bytes;
-    progress_json["total_bytes"] = progress_.total_bytes;
-    progress_json["current_step"] = progress_.current_step;
+    progress_json["state"] = static_cast<int>(progress.state);
+    progress_json["percentage"] = progress.percentage;
+    progress_json["downloaded_bytes"] = progress.downloaded_bytes;
+    progress_json["total_bytes"] = progress.total_bytes;
+    progress_json["current_step"] = std::string(progress.current_step);
+    
+    if (progress.throughput_kbps != 0) {
+        progress_json["throughput_kbps"] = progress.throughput_kbps;
+    }
     
-    if (!progress_.error_message.empty()) {
-        progress_json["error"] = progress_.error_message;
+    if (progress.blocks_written + progress.blocks_skipped != 0) {
+        progress_json["blocks_written"] = progress.blocks_written;
+        progress_json["blocks_skipped"] = progress.blocks_skipped;
+    }
+    
+    if (progress.error_message[0] != '\0') {
+        progress_json["error"] = std::string(progress.error_message);
     }
     
     // Send via MQTT (publish to ota/progress topic)
@@ -438,15 +946,58 @@ void OTAManager::sendProgressReport() {
 // ==================== Cancel ====================
 
 bool OTAManager::cancelOTA() {
-    if (!isOTAInProgress()) {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    if (!job_pending_ && !isOTAInProgress()) {
         return false;
     }
     
+    // The worker notices at the next chunk / block and reports OTA_CANCELLED
     std::cout << "[OTA] ⚠️  Cancelling OTA update...\n";
-    
-    reportError("OTA cancelled by user");
-    current_state_ = OTAState::OTA_IDLE;
+    cancel_.cancel();
     
     return true;
 }
 
+// ==================== Phase Gate ====================
+
+void OTAManager::setAllowedPhases(uint8_t phases) {
+    allowed_phases_ = phases;
+    applyPhaseGate();
+}
+
+void OTAManager::applyPhaseGate() {
+    std::lock_guard<std::mutex> lock(phase_mutex_);
+    
+    uint8_t phase = 0;
+    switch (current_state_.load()) {
+        case OTAState::OTA_DOWNLOADING:
+        case OTAState::OTA_VERIFYING:
+            phase = OTA_PHASE_DOWNLOAD;
+            if (install_in_download_) {
+                phase |= OTA_PHASE_INSTALL;     // Partition writes / zone flashing run alongside
+            }
+            break;
+        case OTAState::OTA_INSTALLING:
+        case OTAState::OTA_READY:
+            phase = OTA_PHASE_INSTALL;
+            break;
+        default:
+            break;              // No job: nothing to hold
+    }
+    
+    bool hold = phase != 0 && (allowed_phases_ & phase) != phase;
+    if (hold == cancel_.isPaused()) {
+        return;
+    }
+    
+    // The worker waits at its next checkpoint; nothing in flight is interrupted
+    const char* name = (phase & OTA_PHASE_INSTALL) ? "install" : "download";
+    if (hold) {
+        cancel_.pause();
+        std::cout << "[OTA] ⚠️  Paused: " << name << " phase not allowed in current vehicle state\n";
+    } else {
+        cancel_.resume();
+        std::cout << "[OTA] ✓ Resumed " << name << " phase\n";
+    }
+}
+
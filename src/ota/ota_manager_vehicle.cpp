@@ -3,7 +3,9 @@
  * @brief OTA Manager - Vehicle Package Processing Implementation
  * 
  * VMG's role as Package Distributor:
- *   1. Receive Vehicle Package from Server (HTTPS)
+ *   1. Receive Vehicle Package from Server (HTTPS): the 12KB metadata first
+ *      (malformed or mis-targeted packages stop there), then only the zones
+ *      whose ECUs are not already at the target version (VCI snapshot)
  *   2. Parse metadata and extract Zone Packages
  *   3. Route each Zone Package to target ZGW (DoIP/UDS)
  * 
@@ -13,10 +15,39 @@
 
 #include "ota_manager.hpp"
 #include "zone_package.hpp"
+#include "package_verifier.hpp"
+#include "package_index.hpp"
+#include "flash_scheduler.hpp"
+#include "ecu_compression.hpp"
+#include "update_planner.hpp"
+#include "ota_pipeline.hpp"
+#include "uds_transfer.hpp"
 #include <iostream>
 #include <fstream>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ==================== Helpers ====================
+
+/**
+ * @brief Read the 12KB metadata at the start of a Vehicle Package file
+ */
+static bool readVehicleMetadata(const std::string& path, std::vector<uint8_t>& buffer) {
+    buffer.assign(sizeof(VehiclePackageMetadata), 0);
+    std::ifstream file(path, std::ios::binary);
+    file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    return file.gcount() == static_cast<std::streamsize>(buffer.size());
+}
 
 // ==================== Vehicle OTA Flow ====================
 
@@ -40,88 +71,206 @@ bool OTAManager::startVehicleOTA(const OTAPackageInfo& package_info) {
     package_info_ = package_info;
     
     // Reset progress
-    std::memset(&progress_, 0, sizeof(OTAProgress));
-    progress_.total_bytes = package_info.package_size;
+    resetProgress(package_info.package_size);
+    
+    // Package verified by an earlier run (e.g. retry after a DoIP failure)?
+    std::string vehicle_package_path = download_path_ + "/" + package_info_.campaign_id + ".bin";
+    VerifiedPackageIndex package_index(download_path_ + "/" PACKAGE_INDEX_FILENAME);
+    package_index.load();
+    
+    const VerifiedPackageEntry* verified = package_index.lookup(vehicle_package_path, package_info_.sha256_hash);
+    if (verified && verified->key.size != package_info_.package_size) {
+        verified = nullptr;
+    }
+    bool downloaded = false;
+    
+    // Step 1: Fetch metadata (12KB) before any zone
+    if (verified) {
+        std::cout << "[VehicleOTA] ✓ Vehicle Package already downloaded and verified, skipping download\n";
+        updateState(OTAState::OTA_VERIFYING, "Vehicle Package already verified");
+    } else {
+        package_index.invalidate(vehicle_package_path);
+        updateState(OTAState::OTA_DOWNLOADING, "Fetching Vehicle Package metadata");
+        if (!downloadVehicleMetadata()) {
+            std::cout << "[VehicleOTA] ⚠ Metadata range fetch failed, downloading whole package\n";
+            if (!downloadVehiclePackage()) {
+                reportError("Failed to download Vehicle Package");
+                return false;
+            }
+            downloaded = true;
+        }
+    }
+    
+    // VehiclePackageMetadata is 12KB; keep it off the stack
+    std::vector<uint8_t> metadata_buffer;
+    if (!readVehicleMetadata(vehicle_package_path, metadata_buffer)) {
+        package_index.invalidate(vehicle_package_path);
+        reportError("Failed to read Vehicle Package metadata");
+        return false;
+    }
+    const VehiclePackageMetadata& metadata = *reinterpret_cast<const VehiclePackageMetadata*>(metadata_buffer.data());
     
-    // Step 1: Download Vehicle Package from Server
-    updateState(OTAState::OTA_DOWNLOADING, "Downloading Vehicle Package from Server");
-    if (!downloadVehiclePackage()) {
-        reportError("Failed to download Vehicle Package");
+    // Step 2: Reject malformed or mis-targeted packages before the bulk download
+    const char* metadata_error = VehiclePackageView::checkMetadata(metadata);
+    if (metadata_error) {
+        package_index.invalidate(vehicle_package_path);
+        reportError("Invalid Vehicle Package metadata: " + std::string(metadata_error));
         return false;
     }
     
-    // Step 2: Parse Vehicle Package metadata
+    if (package_info_.package_size != 0 && metadata.total_size != package_info_.package_size) {
+        package_index.invalidate(vehicle_package_path);
+        reportError("Vehicle Package size mismatch (metadata " + std::to_string(metadata.total_size) +
+                    ", campaign " + std::to_string(package_info_.package_size) + " bytes)");
+        return false;
+    }
+    
+    if (!verifyVehiclePackageTarget(metadata)) {
+        reportError("Vehicle Package target mismatch");
+        return false;
+    }
+    
+    // Step 3: Plan against the latest VCI snapshot
+    UpdatePlanner planner;
+    {
+        std::lock_guard<std::mutex> lock(vci_mutex_);
+        if (!planner.build(metadata, vci_snapshot_)) {
+            package_index.invalidate(vehicle_package_path);
+            reportError("Invalid Vehicle Package metadata");
+            return false;
+        }
+    }
+    planner.printPlan();
+    const UpdatePlan& plan = planner.getPlan();
+    
+    if (plan.selective && plan.selectedZoneCount() == 0) {
+        updateState(OTAState::OTA_COMPLETED, "All ECUs already at target version");
+        std::cout << "[VehicleOTA] ✓ All " << plan.ecus.size() << " ECUs already at target version, nothing to send\n";
+        return true;
+    }
+    
+    // Steps 4-9 overlapped: each zone is sent while the next one downloads
+    // (only while installing is allowed; otherwise the download runs ahead and waits)
+    if (!verified && !downloaded && overlap_zone_flash_ && (allowed_phases_ & OTA_PHASE_INSTALL)) {
+        install_in_download_ = true;
+        bool flashed = flashZonesWhileDownloading(metadata, plan);
+        install_in_download_ = false;
+        if (!flashed) {
+            return false;
+        }
+        completeVehicleOTA(plan);
+        return true;
+    }
+    
+    // Step 4: Download the zones that hold an ECU to update
+    bool partial = !verified && !downloaded && plan.selective && plan.selectedZoneCount() < plan.zones.size();
+    if (!verified && !downloaded) {
+        updateState(OTAState::OTA_DOWNLOADING, "Downloading Vehicle Package from Server");
+        bool ok = partial ? downloadVehiclePackageZones(metadata, plan) : downloadVehiclePackage();
+        if (!ok) {
+            reportError("Failed to download Vehicle Package");
+            return false;
+        }
+    }
+    
+    // Step 5: Parse Vehicle Package metadata
     updateState(OTAState::OTA_VERIFYING, "Parsing Vehicle Package metadata");
-    std::string vehicle_package_path = download_path_ + "/" + package_info_.campaign_id + ".bin";
     vehicle_parser_ = std::make_unique<VehiclePackageParser>(vehicle_package_path);
     
     if (!vehicle_parser_->parse()) {
+        package_index.invalidate(vehicle_package_path);
         reportError("Failed to parse Vehicle Package");
         return false;
     }
     
-    // Step 3: Verify Vehicle Package integrity
-    if (!vehicle_parser_->verify()) {
-        reportError("Vehicle Package integrity check failed");
+    // Target and plan were checked against the prefetched metadata
+    if (std::memcmp(&vehicle_parser_->getMetadata(), metadata_buffer.data(), sizeof(VehiclePackageMetadata)) != 0) {
+        package_index.invalidate(vehicle_package_path);
+        reportError("Vehicle Package metadata changed during download");
         return false;
     }
     
-    // Step 4: Verify target vehicle (VIN, Model, Year)
-    if (!verifyVehiclePackageTarget()) {
-        reportError("Vehicle Package target mismatch");
-        return false;
+    // Step 6: Verify Vehicle / Zone / ECU / firmware CRCs in one pass
+    if (verified && verified->vehicle_crc32 == vehicle_parser_->getMetadata().vehicle_crc32) {
+        std::cout << "[VehicleOTA] ✓ Integrity already verified (" << verified->zones.size() << " zones, "
+                  << verified->ecus.size() << " ECUs), skipping CRC pass\n";
+    } else {
+        PackageIntegrityVerifier verifier(vehicle_package_path);
+        verifier.setThreadCount(verify_threads_);
+        if (partial) {
+            verifier.setZoneSelection(plan.zones);
+        }
+        if (!verifier.verify()) {
+            verifier.printReport();
+            package_index.invalidate(vehicle_package_path);
+            const PackageIntegrityReport& report = verifier.getReport();
+            reportError("Vehicle Package integrity check failed (" +
+                        std::string(integrityLevelToString(report.failed_level)) + "): " + report.message);
+            return false;
+        }
+        
+        // Not fatal: the next run just verifies again (partial packages are never recorded)
+        if (!partial) {
+            package_index.record(vehicle_package_path, package_info_.sha256_hash,
+                                 vehicle_parser_->getView(), verifier.getReport());
+        }
     }
     
-    // Step 5: Extract Zone Packages
+    // Step 7: Extract Zone Packages (up-to-date ECUs dropped)
     updateState(OTAState::OTA_INSTALLING, "Extracting Zone Packages");
-    if (!extractZonePackages()) {
+    if (!cancel_.waitWhilePaused() || !extractZonePackages(plan)) {
         reportError("Failed to extract Zone Packages");
         return false;
     }
     
-    // Step 6: Send each Zone Package to target ZGW
-    zone_packages_ = vehicle_parser_->getZonePackages();
+    // Step 8: Plan flash order from the ECU dependency graph
+    FlashScheduler scheduler;
+    if (!scheduler.build(vehicle_parser_->getView(), zone_packages_, &plan)) {
+        reportError("Invalid ECU dependency graph");
+        return false;
+    }
+    scheduler.printPlan();
     
+    // Step 9: Send Zone Packages to ZGWs (independent zones concurrently)
     std::cout << "\n[VehicleOTA] Sending Zone Packages to ZGWs...\n";
     std::cout << "════════════════════════════════════════════════════════════\n";
     
-    for (size_t i = 0; i < zone_packages_.size(); i++) {
-        const auto& zone = zone_packages_[i];
-        
-        std::cout << "\n[VehicleOTA] [" << (i+1) << "/" << zone_packages_.size() << "] "
-                  << "Sending Zone " << (int)zone.zone_number << " (" << zone.zone_id << ")...\n";
-        std::cout << "[VehicleOTA]   Target: " << zone.target_zgw_ip << ":" << zone.target_zgw_port << "\n";
-        std::cout << "[VehicleOTA]   ECUs: " << (int)zone.ecu_count << "\n";
-        std::cout << "[VehicleOTA]   Size: " << zone.size << " bytes\n";
-        
-        if (!sendZonePackageToZGW(zone)) {
-            std::cerr << "[VehicleOTA] ✗ Failed to send Zone " << (int)zone.zone_number << "\n";
-            reportError("Failed to send Zone Package to ZGW");
-            return false;
+    size_t zones_to_send = plan.selective ? plan.selectedZoneCount() : zone_packages_.size();
+    uint32_t zones_completed = 0;
+    bool sent = scheduler.run(zgw_max_concurrent_, [&](size_t i) {
+        if (!cancel_.waitWhilePaused()) {
+            return false;               // Zones not yet started are not sent
         }
-        
-        std::cout << "[VehicleOTA] ✓ Zone " << (int)zone.zone_number << " sent successfully\n";
-        
-        // Report progress
-        uint32_t zones_completed = i + 1;
-        uint8_t percentage = (zones_completed * 100) / zone_packages_.size();
-        progress_.percentage = percentage;
-        sendProgressReport();
+        return sendScheduledZone(i, zones_to_send, zones_completed);
+    });
+    
+    if (!sent) {
+        reportError("Failed to send Zone Package to ZGW");
+        return false;
     }
     
-    // Step 7: OTA Completed
+    // Step 10: OTA Completed
+    completeVehicleOTA(plan);
+    return true;
+}
+
+void OTAManager::completeVehicleOTA(const UpdatePlan& plan) {
     updateState(OTAState::OTA_COMPLETED, "All Zone Packages sent to ZGWs");
     
     std::cout << "\n";
     std::cout << "╔════════════════════════════════════════════════════════════╗\n";
     std::cout << "║        ✓ Vehicle OTA Completed Successfully!              ║\n";
     std::cout << "╚════════════════════════════════════════════════════════════╝\n";
-    std::cout << "[VehicleOTA] Zone Packages sent: " << zone_packages_.size() << "\n";
-    std::cout << "[VehicleOTA] Total ECUs updated: " << (int)vehicle_parser_->getMetadata().total_ecu_count << "\n";
+    std::cout << "[VehicleOTA] Zone Packages sent: "
+              << (plan.selective ? plan.selectedZoneCount() : zone_packages_.size()) << "\n";
+    std::cout << "[VehicleOTA] Total ECUs updated: "
+              << (plan.selective ? plan.updatedECUCount() : (size_t)vehicle_parser_->getMetadata().total_ecu_count) << "\n";
     std::cout << "════════════════════════════════════════════════════════════\n\n";
-    
-    current_state_ = OTAState::OTA_COMPLETED;
-    return true;
+}
+
+void OTAManager::setVciSnapshot(const nlohmann::json& vci) {
+    std::lock_guard<std::mutex> lock(vci_mutex_);
+    vci_snapshot_ = vci;
 }
 
 // ==================== Download Vehicle Package ====================
@@ -135,9 +284,320 @@ bool OTAManager::downloadVehiclePackage() {
     return downloadPackage();
 }
 
+bool OTAManager::downloadVehicleMetadata() {
+    std::cout << "[VehicleOTA] Fetching Vehicle Package metadata (" << sizeof(VehiclePackageMetadata)
+              << " bytes)...\n";
+    
+    std::string download_file = download_path_ + "/" + package_info_.campaign_id + ".bin";
+    std::ofstream output_file(download_file, std::ios::binary);
+    if (!output_file.is_open()) {
+        std::cerr << "[VehicleOTA] ✗ Failed to create download file: " << download_file << "\n";
+        return false;
+    }
+    
+    if (!downloadChunk(package_info_.package_url, 0, sizeof(VehiclePackageMetadata) - 1, output_file)) {
+        return false;
+    }
+    
+    output_file.close();
+    return output_file.good();
+}
+
+bool OTAManager::downloadVehiclePackageZones(const VehiclePackageMetadata& metadata, const UpdatePlan& plan) {
+    std::cout << "[VehicleOTA] Downloading " << plan.selectedZoneCount() << " of " << plan.zones.size()
+              << " Zone Packages (" << plan.download_bytes << " of " << plan.package_bytes << " bytes)...\n";
+    
+    // Metadata is already at offset 0; zones go to their package offsets
+    std::string download_file = download_path_ + "/" + package_info_.campaign_id + ".bin";
+    int fd = ::open(download_file.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[VehicleOTA] ✗ Failed to open download file: " << download_file << "\n";
+        return false;
+    }
+    
+    uint64_t downloaded = sizeof(VehiclePackageMetadata);
+    uint8_t zone = 0;
+    uint64_t next = 0;
+    uint64_t zone_end = 0;
+    
+    // Receive walks the selected zones; writes land at the chunk offsets.
+    // CRCs are checked afterwards in one pass, so there is no hash stage.
+    OTAPipeline pipeline(chunk_size_, pipeline_buffers_);
+    bool completed = pipeline.run(
+        [&](PipelineBlock& block, size_t capacity) {
+            while (next >= zone_end && zone < metadata.zone_count) {
+                if (plan.zoneSelected(zone)) {
+                    next = metadata.zone_refs[zone].offset;
+                    zone_end = next + metadata.zone_refs[zone].size;
+                }
+                zone++;
+            }
+            return receiveChunk(block, capacity, next, zone_end);
+        },
+        PipelineStage(),
+        [&](const PipelineBlock& block) {
+            if (!writePipelineBlock(fd, block)) {
+                std::cerr << "[VehicleOTA] ✗ Failed to write " << download_file << ": " << std::strerror(errno) << "\n";
+                return false;
+            }
+            
+            downloaded += block.size;
+            updateProgress(downloaded, plan.download_bytes);
+            return true;
+        });
+    
+    if (::close(fd) != 0) {
+        completed = false;
+    }
+    if (!completed) {
+        std::cerr << "[VehicleOTA] ✗ Zone download failed: " << pipeline.getError() << "\n";
+        return false;
+    }
+    
+    // Skipped zones stay holes, so every zone reference resolves in the file
+    if (::truncate(download_file.c_str(), metadata.total_size) != 0) {
+        std::cerr << "[VehicleOTA] ✗ Failed to size " << download_file << "\n";
+        return false;
+    }
+    
+    std::cout << "[VehicleOTA] ✓ Zone download completed: " << downloaded << " bytes\n";
+    return true;
+}
+
+// ==================== Overlapped Download / Flash ====================
+
+bool OTAManager::flashZonesWhileDownloading(const VehiclePackageMetadata& metadata, const UpdatePlan& plan) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    std::string download_file = download_path_ + "/" + package_info_.campaign_id + ".bin";
+    
+    // Step 4a: Zone headers and ECU metadata first, the flash order depends on them
+    updateState(OTAState::OTA_DOWNLOADING, "Fetching Zone Package headers");
+    if (::truncate(download_file.c_str(), metadata.total_size) != 0) {
+        reportError("Failed to size Vehicle Package file");
+        return false;
+    }
+    
+    int fd = ::open(download_file.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        reportError("Failed to open Vehicle Package file");
+        return false;
+    }
+    
+    if (!downloadZoneHeaders(fd, metadata, plan)) {
+        ::close(fd);
+        reportError("Failed to download Zone Package headers");
+        return false;
+    }
+    
+    // Step 5: Parse Vehicle Package metadata (zone bodies are still holes)
+    updateState(OTAState::OTA_VERIFYING, "Parsing Vehicle Package metadata");
+    vehicle_parser_ = std::make_unique<VehiclePackageParser>(download_file);
+    if (!vehicle_parser_->parse()) {
+        ::close(fd);
+        reportError("Failed to parse Vehicle Package");
+        return false;
+    }
+    
+    if (std::memcmp(&vehicle_parser_->getMetadata(), &metadata, sizeof(VehiclePackageMetadata)) != 0) {
+        ::close(fd);
+        reportError("Vehicle Package metadata changed during download");
+        return false;
+    }
+    zone_packages_ = vehicle_parser_->getZonePackages();
+    
+    // Step 8: Plan flash order; zones are downloaded in the order they are sent
+    FlashScheduler scheduler;
+    if (!scheduler.build(vehicle_parser_->getView(), zone_packages_, &plan)) {
+        ::close(fd);
+        reportError("Invalid ECU dependency graph");
+        return false;
+    }
+    scheduler.printPlan();
+    std::vector<size_t> order = scheduler.getTransferOrder();
+    
+    // Steps 4 / 6 / 7 per zone on the download thread, step 9 as zones become ready
+    updateState(OTAState::OTA_INSTALLING, "Downloading and sending Zone Packages");
+    std::cout << "\n[VehicleOTA] Downloading " << order.size() << " Zone Packages while sending them to ZGWs...\n";
+    std::cout << "════════════════════════════════════════════════════════════\n";
+    
+    std::mutex ready_mutex;
+    std::condition_variable ready_cv;
+    std::vector<char> ready(zone_packages_.size(), 0);
+    bool download_finished = false;
+    bool download_ok = false;
+    double download_ms = 0;
+    std::atomic<bool> send_failed(false);
+    
+    std::thread downloader([&]() {
+        OTAPipeline pipeline(chunk_size_, pipeline_buffers_);
+        uint64_t downloaded = sizeof(VehiclePackageMetadata);
+        bool ok = true;
+        
+        for (size_t z : order) {
+            if (!downloadZonePackage(fd, pipeline, z, plan, send_failed)) {
+                ok = false;
+                break;
+            }
+            
+            downloaded += metadata.zone_refs[z].size;
+            setDownloadedBytes(static_cast<uint32_t>(downloaded));
+            
+            std::lock_guard<std::mutex> lock(ready_mutex);
+            ready[z] = 1;
+            ready_cv.notify_all();
+        }
+        
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        download_finished = true;
+        download_ok = ok;
+        download_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        ready_cv.notify_all();
+    });
+    
+    size_t zones_to_send = order.size();
+    uint32_t zones_completed = 0;
+    bool sent = scheduler.run(zgw_max_concurrent_, [&](size_t z) {
+        {
+            std::unique_lock<std::mutex> lock(ready_mutex);
+            ready_cv.wait(lock, [&]() { return ready[z] || download_finished; });
+            if (!ready[z]) {
+                return false;           // Download failed or was cancelled
+            }
+        }
+        
+        if (!cancel_.waitWhilePaused()) {
+            return false;
+        }
+        if (!sendScheduledZone(z, zones_to_send, zones_completed)) {
+            send_failed = true;         // Zones after it would not be sent; stop downloading them
+            return false;
+        }
+        return true;
+    });
+    
+    downloader.join();
+    ::close(fd);
+    
+    if (send_failed) {
+        reportError("Failed to send Zone Package to ZGW");
+        return false;
+    }
+    if (!download_ok) {
+        reportError("Zone Package download or integrity check failed");
+        return false;
+    }
+    if (!sent) {
+        reportError("Failed to send Zone Package to ZGW");
+        return false;
+    }
+    
+    double total_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "[VehicleOTA] ✓ Zones downloaded after " << static_cast<uint64_t>(download_ms) << " ms, sent after "
+              << static_cast<uint64_t>(total_ms) << " ms (overlapped)\n";
+    return true;
+}
+
+bool OTAManager::downloadZoneHeaders(int fd, const VehiclePackageMetadata& metadata, const UpdatePlan& plan) {
+    std::cout << "[VehicleOTA] Fetching Zone Package headers and ECU metadata...\n";
+    
+    size_t ranges = 0;
+    std::string body;
+    auto fetch = [&](uint64_t start, size_t size) {
+        if (!cancel_.waitWhilePaused() || !downloadChunk(package_info_.package_url, start, start + size - 1, body)) {
+            return false;
+        }
+        
+        PipelineBlock block = {reinterpret_cast<uint8_t*>(&body[0]), body.size(), start};
+        if (!writePipelineBlock(fd, block)) {
+            std::cerr << "[VehicleOTA] ✗ Failed to write header range: " << std::strerror(errno) << "\n";
+            return false;
+        }
+        ranges++;
+        return true;
+    };
+    
+    for (size_t z = 0; z < metadata.zone_count; z++) {
+        if (!plan.zoneSelected(z)) {
+            continue;
+        }
+        
+        const ZoneReference& ref = metadata.zone_refs[z];
+        if (ref.size < sizeof(ZonePackageHeader) || !fetch(ref.offset, sizeof(ZonePackageHeader))) {
+            std::cerr << "[VehicleOTA] ✗ Failed to fetch Zone " << (int)ref.zone_number << " header\n";
+            return false;
+        }
+        
+        // ECU metadata holds the dependencies; bounds are checked again once parsed
+        ZonePackageHeader header;
+        std::memcpy(&header, body.data(), sizeof(header));
+        uint8_t count = std::min<uint8_t>(header.package_count, MAX_ECUS_IN_ZONE);
+        for (uint8_t i = 0; i < count; i++) {
+            const ZoneECUEntry& entry = header.ecu_table[i];
+            if (uint64_t(entry.offset) + sizeof(ECUMetadata) > ref.size ||
+                plan.ecuSkipped(fixedStringView(entry.ecu_id, sizeof(entry.ecu_id)))) {
+                continue;
+            }
+            if (!fetch(ref.offset + entry.offset, sizeof(ECUMetadata))) {
+                std::cerr << "[VehicleOTA] ✗ Failed to fetch " << fixedStringView(entry.ecu_id, sizeof(entry.ecu_id))
+                          << " metadata\n";
+                return false;
+            }
+        }
+    }
+    
+    std::cout << "[VehicleOTA] ✓ " << ranges << " header ranges fetched\n";
+    return true;
+}
+
+bool OTAManager::downloadZonePackage(int fd, OTAPipeline& pipeline, size_t z, const UpdatePlan& plan,
+                                     const std::atomic<bool>& abort) {
+    const ZoneReference& ref = vehicle_parser_->getView().zones()[z];
+    uint64_t next = ref.offset;
+    uint64_t end = next + ref.size;
+    
+    std::cout << "[VehicleOTA] Downloading Zone " << (int)ref.zone_number << " (" << ref.size << " bytes)...\n";
+    bool completed = pipeline.run(
+        [&](PipelineBlock& block, size_t capacity) {
+            return !abort.load(std::memory_order_acquire) && receiveChunk(block, capacity, next, end);
+        },
+        PipelineStage(),
+        [&](const PipelineBlock& block) {
+            if (!writePipelineBlock(fd, block)) {
+                std::cerr << "[VehicleOTA] ✗ Failed to write Zone " << (int)ref.zone_number << ": "
+                          << std::strerror(errno) << "\n";
+                return false;
+            }
+            return true;
+        });
+    
+    if (!completed) {
+        std::cerr << "[VehicleOTA] ✗ Zone " << (int)ref.zone_number << " download failed: " << pipeline.getError() << "\n";
+        return false;
+    }
+    
+    // Zone and ECU CRCs of this zone only
+    std::vector<bool> selection(vehicle_parser_->getView().zoneCount(), false);
+    selection[z] = true;
+    
+    PackageIntegrityVerifier verifier(download_path_ + "/" + package_info_.campaign_id + ".bin");
+    verifier.setThreadCount(verify_threads_);
+    verifier.setZoneSelection(selection);
+    if (!verifier.verify()) {
+        verifier.printReport();
+        const PackageIntegrityReport& report = verifier.getReport();
+        std::cerr << "[VehicleOTA] ✗ Zone " << (int)ref.zone_number << " integrity check failed ("
+                  << integrityLevelToString(report.failed_level) << "): " << report.message << "\n";
+        return false;
+    }
+    
+    // Step 7: Extract (up-to-date ECUs dropped)
+    return extractZonePackage(z, plan);
+}
+
 // ==================== Verify Vehicle Target ====================
 
-bool OTAManager::verifyVehiclePackageTarget() {
+bool OTAManager::verifyVehiclePackageTarget(const VehiclePackageMetadata& metadata) {
     std::cout << "[VehicleOTA] Verifying Vehicle Package target...\n";
     
     // Get vehicle info from config
@@ -148,8 +608,7 @@ bool OTAManager::verifyVehiclePackageTarget() {
     std::cout << "[VehicleOTA]   Expected VIN: " << expected_vin << "\n";
     std::cout << "[VehicleOTA]   Expected Model: " << expected_model << " (" << expected_year << ")\n";
     
-    // Verify using parser
-    if (!vehicle_parser_->verifyVehicleTarget(expected_vin, expected_model, expected_year)) {
+    if (!VehiclePackageParser::verifyVehicleTarget(metadata, expected_vin, expected_model, expected_year)) {
         std::cerr << "[VehicleOTA] ✗ Vehicle target mismatch\n";
         return false;
     }
@@ -160,24 +619,82 @@ bool OTAManager::verifyVehiclePackageTarget() {
 
 // ==================== Extract Zone Packages ====================
 
-bool OTAManager::extractZonePackages() {
+bool OTAManager::extractZonePackages(const UpdatePlan& plan) {
     std::cout << "[VehicleOTA] Extracting Zone Packages...\n";
     
+    zone_packages_ = vehicle_parser_->getZonePackages();
+    
+    for (size_t z = 0; z < zone_packages_.size(); z++) {
+        if (plan.zoneSelected(z) && !extractZonePackage(z, plan)) {
+            return false;
+        }
+    }
+    
+    std::cout << "[VehicleOTA] ✓ Zone Packages extracted\n";
+    return true;
+}
+
+bool OTAManager::extractZonePackage(size_t z, const UpdatePlan& plan) {
     // Create extraction directory
     std::string extract_dir = download_path_ + "/zones";
-    
-    // Extract all Zone Packages
-    if (!vehicle_parser_->extractAllZonePackages(extract_dir)) {
-        std::cerr << "[VehicleOTA] ✗ Failed to extract Zone Packages\n";
-        return false;
+    mkdir(extract_dir.c_str(), 0755);
+    
+    const VehiclePackageView& view = vehicle_parser_->getView();
+    ZonePackageInfo& zone_info = zone_packages_[z];
+    std::string output_path = extract_dir + "/zone_" + std::to_string((int)zone_info.zone_number) + ".bin";
+    
+    // ECUs already at the target version are not sent to the ZGW
+    ZonePackageView zone = view.zonePackage(view.zones()[z]);
+    uint32_t kept_count = 0;
+    uint64_t kept_size = sizeof(ZonePackageHeader);
+    for (size_t i = 0; i < zone.ecuCount(); i++) {
+        if (!plan.ecuSkipped(zone.ecuId(i))) {
+            kept_count++;
+            kept_size += zone.ecus()[i].size;
+        }
     }
     
-    std::cout << "[VehicleOTA] ✓ All Zone Packages extracted\n";
+    if (kept_count == zone.ecuCount()) {
+        if (!vehicle_parser_->extractZonePackage(zone_info.zone_number, output_path)) {
+            std::cerr << "[VehicleOTA] ✗ Failed to extract Zone " << (int)zone_info.zone_number << "\n";
+            return false;
+        }
+    } else {
+        if (!writeZonePackageSubset(zone, plan, output_path)) {
+            std::cerr << "[VehicleOTA] ✗ Failed to extract Zone " << (int)zone_info.zone_number << "\n";
+            return false;
+        }
+        zone_info.ecu_count = static_cast<uint8_t>(kept_count);
+        zone_info.size = static_cast<uint32_t>(kept_size);
+    }
+    zone_info.extracted_path = output_path;
     return true;
 }
 
 // ==================== Send Zone Package to ZGW ====================
 
+bool OTAManager::sendScheduledZone(size_t z, size_t zones_to_send, uint32_t& zones_completed) {
+    const ZonePackageInfo& zone = zone_packages_[z];
+    
+    std::cout << "\n[VehicleOTA] Sending Zone " << (int)zone.zone_number << " (" << zone.zone_id << ")...\n";
+    std::cout << "[VehicleOTA]   Target: " << zone.target_zgw_ip << ":" << zone.target_zgw_port << "\n";
+    std::cout << "[VehicleOTA]   ECUs: " << (int)zone.ecu_count << "\n";
+    std::cout << "[VehicleOTA]   Size: " << zone.size << " bytes\n";
+    
+    if (!sendZonePackageToZGW(zone)) {
+        std::cerr << "[VehicleOTA] ✗ Failed to send Zone " << (int)zone.zone_number << "\n";
+        return false;
+    }
+    
+    std::cout << "[VehicleOTA] ✓ Zone " << (int)zone.zone_number << " sent successfully\n";
+    
+    // Report progress
+    std::lock_guard<std::mutex> lock(zone_mutex_);
+    zones_completed++;
+    setProgressPercentage(static_cast<uint8_t>((zones_completed * 100) / zones_to_send));
+    return true;
+}
+
 bool OTAManager::sendZonePackageToZGW(const ZonePackageInfo& zone_info) {
     std::cout << "[ZoneTransfer] Sending Zone Package to ZGW...\n";
     std::cout << "[ZoneTransfer]   Zone: " << zone_info.zone_id 
@@ -186,8 +703,8 @@ bool OTAManager::sendZonePackageToZGW(const ZonePackageInfo& zone_info) {
               << ":" << zone_info.target_zgw_port << "\n";
     
     // Get DoIP client for this ZGW
-    DoIPClient* doip_client = getDoIPClientForZGW(zone_info.target_zgw_ip, 
-                                                    zone_info.target_zgw_port);
+    std::shared_ptr<DoIPClient> doip_client = getDoIPClientForZGW(zone_info.target_zgw_ip,
+                                                                    zone_info.target_zgw_port);
     if (!doip_client) {
         std::cerr << "[ZoneTransfer] ✗ Failed to get DoIP client\n";
         return false;
@@ -204,22 +721,44 @@ bool OTAManager::sendZonePackageToZGW(const ZonePackageInfo& zone_info) {
     }
     
     // Parse Zone Package before sending
+    // (zone and ECU CRCs were already checked by PackageIntegrityVerifier)
     ZonePackageParser zone_parser(zone_info.extracted_path);
     if (!zone_parser.parse()) {
         std::cerr << "[ZoneTransfer] ✗ Failed to parse Zone Package\n";
         return false;
     }
     
-    if (!zone_parser.verify()) {
-        std::cerr << "[ZoneTransfer] ✗ Zone Package integrity check failed\n";
-        return false;
-    }
-    
     // Print Zone Package summary
     zone_parser.printSummary();
     
+    // Compressed ECU payloads: the ZGW decompresses if it accepts the zstd format,
+    // otherwise the Zone Package is expanded here (bounded decoder window)
+    std::string transfer_path = zone_info.extracted_path;
+    if (zoneHasCompressedECUs(zone_parser.getView())) {
+        bool rejected = false;
+        if (transferZonePackageViaUDS(doip_client.get(), zone_info, transfer_path, UDS_DFI_ZSTD, &rejected)) {
+            std::cout << "[ZoneTransfer] ✓ Zone Package sent successfully (zstd payloads)\n";
+            return true;
+        }
+        if (!rejected) {
+            std::cerr << "[ZoneTransfer] ✗ Failed to transfer Zone Package\n";
+            return false;
+        }
+        
+        std::cout << "[ZoneTransfer] ZGW does not accept zstd payloads, decompressing on VMG...\n";
+        transfer_path = zone_info.extracted_path + ".raw";
+        if (!expandZonePackage(zone_parser.getView(), transfer_path, zstd_window_log_max_)) {
+            std::cerr << "[ZoneTransfer] ✗ Failed to decompress Zone Package\n";
+            return false;
+        }
+    }
+    
     // Transfer Zone Package via DoIP/UDS (0x34/0x36/0x37)
-    if (!transferZonePackageViaUDS(doip_client, zone_info.extracted_path)) {
+    bool transferred = transferZonePackageViaUDS(doip_client.get(), zone_info, transfer_path);
+    if (transfer_path != zone_info.extracted_path) {
+        std::remove(transfer_path.c_str());
+    }
+    if (!transferred) {
         std::cerr << "[ZoneTransfer] ✗ Failed to transfer Zone Package\n";
         return false;
     }
@@ -231,123 +770,68 @@ bool OTAManager::sendZonePackageToZGW(const ZonePackageInfo& zone_info) {
 // ==================== Transfer Zone Package via UDS ====================
 
 bool OTAManager::transferZonePackageViaUDS(DoIPClient* doip_client,
-                                            const std::string& zone_package_path) {
-    std::cout << "[UDS] Transferring Zone Package via UDS (0x34/0x36/0x37)...\n";
-    
-    // Open Zone Package file
-    std::ifstream file(zone_package_path, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        std::cerr << "[UDS] ✗ Failed to open Zone Package file\n";
-        return false;
+                                            const ZonePackageInfo& zone_info,
+                                            const std::string& zone_package_path,
+                                            uint8_t data_format,
+                                            bool* format_rejected) {
+    std::cout << "[UDS] Transferring Zone Package via UDS ("
+              << (uds_file_transfer_ ? "0x38" : "0x34") << "/0x36/0x37)...\n";
+    
+    // Blocks are streamed from the file; a lost link is resumed, not restarted
+    UdsZoneTransfer transfer(*doip_client, zone_info.target_zgw_ip + ":" + std::to_string(zone_info.target_zgw_port));
+    transfer.setDataFormat(data_format);
+    transfer.setFileTransfer(uds_file_transfer_);
+    transfer.setMaxBlockSize(uds_max_block_bytes_);
+    transfer.setCheckpointStore(uds_checkpoints_.get());
+    transfer.setCancelToken(&cancel_);
+    
+    bool transferred = transfer.run(zone_package_path);
+    if (format_rejected) {
+        *format_rejected = transfer.formatRejected();
     }
     
-    // Get file size
-    size_t file_size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    
-    std::cout << "[UDS] Zone Package size: " << file_size << " bytes\n";
-    
-    // Read entire file
-    std::vector<uint8_t> zone_data(file_size);
-    file.read(reinterpret_cast<char*>(zone_data.data()), file_size);
-    file.close();
-    
-    // Step 1: Request Download (0x34)
-    std::cout << "[UDS] Step 1: Request Download (0x34)...\n";
-    
-    // Build UDS 0x34 payload: [0x34] [total_size: 4 bytes]
-    std::vector<uint8_t> request_download_payload;
-    request_download_payload.push_back(0x34);  // Service ID
-    
-    // Add total size (big-endian)
-    uint32_t total_size = static_cast<uint32_t>(file_size);
-    request_download_payload.push_back((total_size >> 24) & 0xFF);
-    request_download_payload.push_back((total_size >> 16) & 0xFF);
-    request_download_payload.push_back((total_size >> 8) & 0xFF);
-    request_download_payload.push_back(total_size & 0xFF);
-    
-    auto response = doip_client->sendDiagnosticMessage(0x34, request_download_payload);
-    
-    if (response.empty() || response[0] != 0x74) {  // 0x74 = positive response to 0x34
-        std::cerr << "[UDS] ✗ Request Download failed\n";
-        return false;
+    const UdsTransferStats& stats = transfer.getStats();
+    if (stats.reconnects || stats.resumes || stats.restarts || stats.block_retries) {
+        std::cout << "[UDS] Link recovery: " << stats.reconnects << " reconnect(s), " << stats.resumes
+                  << " resume(s), " << stats.restarts << " restart(s), " << stats.block_retries
+                  << " block resend(s)\n";
     }
-    
-    std::cout << "[UDS] ✓ Request Download accepted\n";
-    
-    // Step 2: Transfer Data (0x36) - Chunked
-    std::cout << "[UDS] Step 2: Transfer Data (0x36) in chunks...\n";
-    
-    const size_t chunk_size = 1024;  // 1KB chunks
-    uint8_t block_sequence = 1;
-    size_t total_sent = 0;
-    
-    while (total_sent < file_size) {
-        size_t remaining = file_size - total_sent;
-        size_t current_chunk_size = std::min(chunk_size, remaining);
-        
-        // Build UDS 0x36 payload: [0x36] [block_sequence: 1 byte] [data: N bytes]
-        std::vector<uint8_t> transfer_payload;
-        transfer_payload.push_back(0x36);  // Service ID
-        transfer_payload.push_back(block_sequence);
-        
-        // Append chunk data
-        transfer_payload.insert(transfer_payload.end(),
-                                zone_data.begin() + total_sent,
-                                zone_data.begin() + total_sent + current_chunk_size);
-        
-        // Send chunk
-        auto chunk_response = doip_client->sendDiagnosticMessage(0x36, transfer_payload);
-        
-        if (chunk_response.empty() || chunk_response[0] != 0x76) {  // 0x76 = positive response to 0x36
-            std::cerr << "[UDS] ✗ Transfer Data failed at block " << (int)block_sequence << "\n";
-            return false;
-        }
-        
-        total_sent += current_chunk_size;
-        block_sequence = (block_sequence + 1) % 256;
-        
-        // Print progress
-        uint8_t progress = (total_sent * 100) / file_size;
-        std::cout << "[UDS] Progress: " << (int)progress << "% (" 
-                  << total_sent << "/" << file_size << " bytes)\r" << std::flush;
-    }
-    
-    std::cout << "\n[UDS] ✓ All data blocks transferred\n";
-    
-    // Step 3: Request Transfer Exit (0x37)
-    std::cout << "[UDS] Step 3: Request Transfer Exit (0x37)...\n";
-    
-    std::vector<uint8_t> exit_payload;
-    exit_payload.push_back(0x37);  // Service ID
-    
-    auto exit_response = doip_client->sendDiagnosticMessage(0x37, exit_payload);
-    
-    if (exit_response.empty() || exit_response[0] != 0x77) {  // 0x77 = positive response to 0x37
-        std::cerr << "[UDS] ✗ Transfer Exit failed\n";
+    if (!transferred) {
         return false;
     }
     
-    std::cout << "[UDS] ✓ Transfer Exit accepted\n";
-    std::cout << "[UDS] ✓ Zone Package transfer completed\n";
-    
+    std::cout << "[UDS] ✓ Zone Package transfer completed (" << stats.bytes << " bytes"
+              << (stats.resumed_from ? ", resumed at byte " + std::to_string(stats.resumed_from) : std::string())
+              << ", block " << stats.block_size << "/" << stats.block_limit << " bytes, "
+              << static_cast<uint64_t>(stats.elapsed_ms) << " ms)\n";
     return true;
 }
 
 // ==================== Get DoIP Client for ZGW ====================
 
-DoIPClient* OTAManager::getDoIPClientForZGW(const std::string& zgw_ip, uint16_t zgw_port) {
-    // Search for existing client
-    for (auto& client : doip_clients_) {
-        // TODO: Add method to get IP/Port from DoIPClient
-        // For now, create new client if not found
+std::shared_ptr<DoIPClient> OTAManager::getDoIPClientForZGW(const std::string& zgw_ip, uint16_t zgw_port) {
+    std::shared_ptr<DoIPClient> client;
+    {
+        // Zone transfers run concurrently: take an idle client off the list
+        std::lock_guard<std::mutex> lock(zone_mutex_);
+        for (auto it = doip_clients_.begin(); it != doip_clients_.end(); ++it) {
+            if ((*it)->getZgwIp() == zgw_ip && (*it)->getZgwPort() == zgw_port) {
+                client = *it;
+                doip_clients_.erase(it);
+                break;
+            }
+        }
     }
     
-    // Create new DoIP client
-    std::cout << "[DoIP] Creating new DoIP client for " << zgw_ip << ":" << zgw_port << "\n";
-    auto new_client = std::make_shared<DoIPClient>(zgw_ip, zgw_port);
-    doip_clients_.push_back(new_client);
+    if (!client) {
+        std::cout << "[DoIP] Creating new DoIP client for " << zgw_ip << ":" << zgw_port << "\n";
+        client = std::make_shared<DoIPClient>(zgw_ip, zgw_port);
+    }
     
-    return new_client.get();
+    // Back on the idle list once the transfer drops it
+    return std::shared_ptr<DoIPClient>(client.get(), [this, client](DoIPClient*) {
+        std::lock_guard<std::mutex> lock(zone_mutex_);
+        doip_clients_.push_back(client);
+    });
 }
 
@@ -0,0 +1,201 @@
+/**
+ * @file ota_pipeline.cpp
+ * @brief Threaded receive → hash → write pipeline Implementation
+ */
+
+#include "ota_pipeline.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <unistd.h>
+
+// ==================== Helpers ====================
+
+using PipelineClock = std::chrono::steady_clock;
+
+static double elapsedMs(PipelineClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(PipelineClock::now() - start).count();
+}
+
+/**
+ * @brief Poll until ready() succeeds: spin, then yield, then sleep (backing off)
+ * @return false if another stage failed first
+ *
+ * The sleep doubles up to OTA_PIPELINE_MAX_SLEEP_US, so stages idling
+ * behind a paused receive stage barely wake up.
+ */
+template <typename Ready>
+static bool waitFor(const Ready& ready, const std::atomic<bool>& failed) {
+    unsigned sleep_us = OTA_PIPELINE_SLEEP_US;
+    for (unsigned polls = 0; ; polls++) {
+        if (ready()) {
+            return true;
+        }
+        if (failed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (polls < OTA_PIPELINE_SPIN_COUNT) {
+            continue;
+        }
+        if (polls < 2 * OTA_PIPELINE_SPIN_COUNT) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+            sleep_us = std::min<unsigned>(sleep_us * 2, OTA_PIPELINE_MAX_SLEEP_US);
+        }
+    }
+}
+
+// ==================== Functions ====================
+
+bool writePipelineBlock(int fd, const PipelineBlock& block) {
+    size_t done = 0;
+    while (done < block.size) {
+        ssize_t n = ::pwrite(fd, block.data + done, block.size - done, block.offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// ==================== Constructor ====================
+
+OTAPipeline::OTAPipeline(size_t buffer_size, unsigned buffer_count)
+    : buffer_size_(buffer_size), stats_{} {
+    buffer_count = std::clamp(buffer_count, 2u, static_cast<unsigned>(OTA_PIPELINE_MAX_BUFFERS));
+    for (unsigned i = 0; i < buffer_count; i++) {
+        AsyncIOBuffer buffer = allocateAsyncIOBuffer(buffer_size_);
+        if (!buffer) {
+            buffers_.clear();
+            break;
+        }
+        buffers_.push_back(std::move(buffer));
+    }
+}
+
+// ==================== Run ====================
+
+bool OTAPipeline::run(const PipelineReceive& receive, const PipelineStage& hash, const PipelineStage& write) {
+    stats_ = PipelineStats{};
+    error_.clear();
+    
+    if (buffers_.empty() || buffer_size_ == 0) {
+        error_ = "Failed to allocate pipeline buffers";
+        return false;
+    }
+    
+    // Every queue can hold the whole pool, so push() never has to wait
+    size_t count = buffers_.size();
+    std::vector<PipelineBlock> blocks(count);
+    SPSCQueue<uint32_t> free_queue(count);
+    SPSCQueue<uint32_t> hash_queue(count);
+    SPSCQueue<uint32_t> write_queue(count);
+    
+    for (uint32_t i = 0; i < count; i++) {
+        blocks[i].data = buffers_[i].get();
+        blocks[i].size = 0;
+        blocks[i].offset = 0;
+        free_queue.push(i);
+    }
+    
+    // First failure wins; the other stages see the flag and stop
+    std::atomic<bool> failed(false);
+    auto fail = [&](const char* message) {
+        bool expected = false;
+        if (failed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            error_ = message;
+        }
+    };
+    
+    PipelineClock::time_point start = PipelineClock::now();
+    SPSCQueue<uint32_t>& received_queue = hash ? hash_queue : write_queue;
+    
+    // Receive: free buffer → received_queue (an empty block marks the end)
+    std::thread receiver([&]() {
+        uint32_t index = 0;
+        while (waitFor([&]() { return free_queue.pop(index); }, failed)) {
+            PipelineBlock& block = blocks[index];
+            block.size = 0;
+            block.offset = 0;
+            
+            PipelineClock::time_point busy = PipelineClock::now();
+            bool received = receive(block, buffer_size_);
+            stats_.receive_ms += elapsedMs(busy);
+            
+            if (!received || block.size > buffer_size_) {
+                fail(received ? "Receive stage overran its buffer" : "Receive stage failed");
+                return;
+            }
+            
+            // The block belongs to the next stage once pushed
+            bool end = block.size == 0;
+            received_queue.push(index);
+            if (end) {
+                return;
+            }
+        }
+    });
+    
+    // Hash: hash_queue → write_queue
+    std::thread hasher;
+    if (hash) {
+        hasher = std::thread([&]() {
+            uint32_t index = 0;
+            while (waitFor([&]() { return hash_queue.pop(index); }, failed)) {
+                const PipelineBlock& block = blocks[index];
+                if (block.size != 0) {
+                    PipelineClock::time_point busy = PipelineClock::now();
+                    bool hashed = hash(block);
+                    stats_.hash_ms += elapsedMs(busy);
+                    if (!hashed) {
+                        fail("Hash stage failed");
+                        return;
+                    }
+                }
+                
+                bool end = block.size == 0;
+                write_queue.push(index);
+                if (end) {
+                    return;
+                }
+            }
+        });
+    }
+    
+    // Write (calling thread): write_queue → free_queue
+    bool finished = false;
+    uint32_t index = 0;
+    while (waitFor([&]() { return write_queue.pop(index); }, failed)) {
+        const PipelineBlock& block = blocks[index];
+        if (block.size == 0) {
+            finished = true;
+            break;
+        }
+        
+        PipelineClock::time_point busy = PipelineClock::now();
+        bool written = write(block);
+        stats_.write_ms += elapsedMs(busy);
+        if (!written) {
+            fail("Write stage failed");
+            break;
+        }
+        
+        stats_.bytes += block.size;
+        stats_.blocks++;
+        free_queue.push(index);
+    }
+    
+    receiver.join();
+    if (hasher.joinable()) {
+        hasher.join();
+    }
+    stats_.elapsed_ms = elapsedMs(start);
+    
+    return finished && !failed.load(std::memory_order_acquire);
+}
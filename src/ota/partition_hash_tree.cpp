@@ -0,0 +1,340 @@
+/**
+ * @file partition_hash_tree.cpp
+ * @brief Block Hash Tree Implementation
+ */
+
+#include "partition_hash_tree.hpp"
+#include "package_crc.hpp"
+#include "async_io.hpp"
+#include <iostream>
+#include <thread>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <openssl/sha.h>
+
+// ==================== Helpers ====================
+
+static uint64_t hashBlockCount(uint64_t hash_count) {
+    return std::max<uint64_t>(1, (hash_count + HASH_TREE_HASHES_PER_BLOCK - 1) / HASH_TREE_HASHES_PER_BLOCK);
+}
+
+// ==================== Constructor ====================
+
+PartitionHashTree::PartitionHashTree()
+    : data_size_(0), bad_block_(UINT64_MAX), next_block_(0), received_(0) {
+    layout(0);
+}
+
+// ==================== Layout ====================
+
+void PartitionHashTree::layout(uint64_t data_size) {
+    data_size_ = data_size;
+    level_offsets_.clear();
+    
+    // Each level is the hash blocks of the level below; stop at a single hash block
+    uint64_t hashes = blockCount();
+    uint64_t size = 0;
+    for (;;) {
+        level_offsets_.push_back(size);
+        uint64_t blocks = hashBlockCount(hashes);
+        size += blocks * HASH_TREE_BLOCK_SIZE;
+        if (blocks == 1) {
+            break;
+        }
+        hashes = blocks;
+    }
+    
+    tree_.assign(size, 0);
+    std::memset(root_, 0, sizeof(root_));
+    bad_block_ = UINT64_MAX;
+}
+
+void PartitionHashTree::computeUpperLevels() {
+    for (size_t level = 0; level + 1 < level_offsets_.size(); level++) {
+        const uint8_t* blocks = tree_.data() + level_offsets_[level];
+        uint8_t* hashes = tree_.data() + level_offsets_[level + 1];
+        uint64_t count = (level_offsets_[level + 1] - level_offsets_[level]) / HASH_TREE_BLOCK_SIZE;
+        
+        for (uint64_t i = 0; i < count; i++) {
+            SHA256(blocks + i * HASH_TREE_BLOCK_SIZE, HASH_TREE_BLOCK_SIZE, hashes + i * HASH_TREE_DIGEST_SIZE);
+        }
+    }
+    
+    SHA256(tree_.data() + level_offsets_.back(), HASH_TREE_BLOCK_SIZE, root_);
+}
+
+// ==================== Build ====================
+
+bool PartitionHashTree::build(const std::string& path, uint64_t data_offset, uint64_t data_size,
+                              unsigned thread_count) {
+    layout(data_size);
+    error_.clear();
+    
+    if (!hashBlocksParallel(path, data_offset, 0, blockCount(), false, thread_count)) {
+        return false;
+    }
+    
+    computeUpperLevels();
+    return true;
+}
+
+void PartitionHashTree::begin(uint64_t data_size) {
+    layout(data_size);
+    error_.clear();
+    pending_.clear();
+    pending_.reserve(HASH_TREE_BLOCK_SIZE);
+    next_block_ = 0;
+    received_ = 0;
+}
+
+void PartitionHashTree::update(const uint8_t* data, size_t size) {
+    received_ += size;
+    
+    while (size > 0) {
+        // Whole blocks straight from the caller's buffer
+        if (pending_.empty() && size >= HASH_TREE_BLOCK_SIZE) {
+            if (next_block_ < blockCount()) {
+                SHA256(data, HASH_TREE_BLOCK_SIZE, tree_.data() + next_block_ * HASH_TREE_DIGEST_SIZE);
+            }
+            next_block_++;
+            data += HASH_TREE_BLOCK_SIZE;
+            size -= HASH_TREE_BLOCK_SIZE;
+            continue;
+        }
+        
+        size_t n = std::min(size, HASH_TREE_BLOCK_SIZE - pending_.size());
+        pending_.insert(pending_.end(), data, data + n);
+        data += n;
+        size -= n;
+        
+        if (pending_.size() == HASH_TREE_BLOCK_SIZE) {
+            if (next_block_ < blockCount()) {
+                SHA256(pending_.data(), HASH_TREE_BLOCK_SIZE, tree_.data() + next_block_ * HASH_TREE_DIGEST_SIZE);
+            }
+            next_block_++;
+            pending_.clear();
+        }
+    }
+}
+
+bool PartitionHashTree::finish() {
+    if (received_ != data_size_) {
+        error_ = "Hash tree received " + std::to_string(received_) + " of " + std::to_string(data_size_) + " bytes";
+        return false;
+    }
+    
+    // Final partial block, zero padded
+    if (!pending_.empty()) {
+        pending_.resize(HASH_TREE_BLOCK_SIZE, 0);
+        SHA256(pending_.data(), HASH_TREE_BLOCK_SIZE, tree_.data() + next_block_ * HASH_TREE_DIGEST_SIZE);
+        next_block_++;
+        pending_.clear();
+    }
+    
+    computeUpperLevels();
+    return true;
+}
+
+// ==================== Storage ====================
+
+bool PartitionHashTree::store(const std::string& path, uint64_t tree_offset) const {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[HashTree] ✗ Failed to open " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    
+    const uint8_t* data = tree_.data();
+    size_t remaining = tree_.size();
+    uint64_t offset = tree_offset;
+    bool ok = true;
+    while (ok && remaining > 0) {
+        ssize_t n = ::pwrite(fd, data, remaining, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        ok = n > 0;
+        if (ok) {
+            data += n;
+            remaining -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+    }
+    
+    if (!ok || ::fdatasync(fd) != 0) {
+        std::cerr << "[HashTree] ✗ Failed to write hash tree to " << path << ": " << strerror(errno) << "\n";
+        ::close(fd);
+        return false;
+    }
+    
+    ::close(fd);
+    return true;
+}
+
+bool PartitionHashTree::load(const std::string& path, uint64_t tree_offset, uint64_t tree_size,
+                             uint64_t data_size) {
+    layout(data_size);
+    error_.clear();
+    
+    if (tree_size != tree_.size()) {
+        error_ = "Stored hash tree size " + std::to_string(tree_size) + " does not match image size " +
+                 std::to_string(data_size);
+        return false;
+    }
+    
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_ = "Failed to open " + path + ": " + strerror(errno);
+        return false;
+    }
+    
+    uint8_t* data = tree_.data();
+    size_t remaining = tree_.size();
+    uint64_t offset = tree_offset;
+    while (remaining > 0) {
+        ssize_t n = ::pread(fd, data, remaining, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error_ = "Failed to read hash tree at offset " + std::to_string(offset);
+            ::close(fd);
+            return false;
+        }
+        data += n;
+        remaining -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    
+    ::close(fd);
+    return true;
+}
+
+// ==================== Verification ====================
+
+bool PartitionHashTree::matchesRoot(const uint8_t* root) const {
+    // Rebuild the upper levels from the stored leaves; every stored level must agree
+    PartitionHashTree rebuilt(*this);
+    rebuilt.computeUpperLevels();
+    return rebuilt.tree_ == tree_ && std::memcmp(rebuilt.root_, root, HASH_TREE_DIGEST_SIZE) == 0;
+}
+
+bool PartitionHashTree::verifyBlocks(const std::string& path, uint64_t data_offset, uint64_t first_block,
+                                     uint64_t block_count, unsigned thread_count) {
+    error_.clear();
+    bad_block_ = UINT64_MAX;
+    
+    if (first_block > blockCount()) {
+        error_ = "Block " + std::to_string(first_block) + " beyond image";
+        return false;
+    }
+    block_count = std::min(block_count, blockCount() - first_block);
+    
+    return hashBlocksParallel(path, data_offset, first_block, block_count, true, thread_count);
+}
+
+bool PartitionHashTree::hashBlocksParallel(const std::string& path, uint64_t data_offset, uint64_t first,
+                                           uint64_t count, bool compare, unsigned thread_count) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_ = "Failed to open " + path + ": " + strerror(errno);
+        return false;
+    }
+    posix_fadvise(fd, static_cast<off_t>(data_offset + first * HASH_TREE_BLOCK_SIZE),
+                  static_cast<off_t>(count * HASH_TREE_BLOCK_SIZE), POSIX_FADV_SEQUENTIAL);
+    
+    // Same split rule as the CRC workers: no thread for less than PACKAGE_CRC_PARALLEL_MIN_SIZE
+    unsigned workers = resolveCRCThreadCount(thread_count);
+    uint64_t min_blocks = PACKAGE_CRC_PARALLEL_MIN_SIZE / HASH_TREE_BLOCK_SIZE;
+    workers = static_cast<unsigned>(std::min<uint64_t>(workers, std::max<uint64_t>(1, count / min_blocks)));
+    
+    std::vector<char> results(workers, 0);        // Not vector<bool>: workers write neighbouring entries
+    std::vector<uint64_t> bad(workers, UINT64_MAX);
+    std::vector<std::string> errors(workers);
+    std::vector<std::thread> threads;
+    uint64_t per_worker = (count + workers - 1) / std::max(1u, workers);
+    
+    for (unsigned w = 0; w < workers; w++) {
+        uint64_t start = first + w * per_worker;
+        uint64_t end = std::min(first + count, start + per_worker);
+        if (start >= end) {
+            results[w] = 1;
+            continue;
+        }
+        uint8_t* out = tree_.data() + start * HASH_TREE_DIGEST_SIZE;
+        auto run = [&, w, start, end, out]() {
+            uint64_t bad_block = UINT64_MAX;
+            results[w] = hashBlocks(fd, data_offset, start, end - start, out, compare, bad_block, errors[w]) ? 1 : 0;
+            bad[w] = bad_block;
+        };
+        if (w + 1 == workers) {
+            run();          // Last range on the calling thread
+        } else {
+            threads.emplace_back(run);
+        }
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    ::close(fd);
+    
+    bool ok = true;
+    for (unsigned w = 0; w < workers; w++) {
+        if (!results[w]) {
+            ok = false;
+            if (error_.empty()) {
+                error_ = errors[w];
+            }
+        }
+        bad_block_ = std::min(bad_block_, bad[w]);
+    }
+    if (bad_block_ != UINT64_MAX) {
+        error_ = "Block " + std::to_string(bad_block_) + " does not match the hash tree";
+    }
+    return ok;
+}
+
+bool PartitionHashTree::hashBlocks(int fd, uint64_t data_offset, uint64_t first, uint64_t count,
+                                   uint8_t* out, bool compare, uint64_t& bad, std::string& error) const {
+    uint64_t start = first * HASH_TREE_BLOCK_SIZE;
+    uint64_t length = std::min(count * HASH_TREE_BLOCK_SIZE, data_size_ - start);
+    uint8_t digest[HASH_TREE_DIGEST_SIZE];
+    uint8_t last[HASH_TREE_BLOCK_SIZE];
+    uint64_t block = 0;
+    uint64_t consumed = 0;
+    bool matched = true;
+    
+    // Next reads are queued while this worker hashes
+    AsyncFileReader reader(HASH_TREE_READ_BLOCKS * HASH_TREE_BLOCK_SIZE);
+    bool read = reader.read(fd, data_offset + start, length, [&](const uint8_t* data, size_t size) {
+        for (size_t position = 0; position < size; position += HASH_TREE_BLOCK_SIZE, block++) {
+            const uint8_t* input = data + position;
+            if (size - position < HASH_TREE_BLOCK_SIZE) {
+                // Final partial block is hashed zero padded
+                std::memset(last, 0, sizeof(last));
+                std::memcpy(last, input, size - position);
+                input = last;
+            }
+            
+            uint8_t* leaf = out + block * HASH_TREE_DIGEST_SIZE;
+            SHA256(input, HASH_TREE_BLOCK_SIZE, compare ? digest : leaf);
+            if (compare && std::memcmp(digest, leaf, HASH_TREE_DIGEST_SIZE) != 0) {
+                bad = std::min(bad, first + block);
+                matched = false;
+            }
+        }
+        posix_fadvise(fd, static_cast<off_t>(data_offset + start + consumed), static_cast<off_t>(size),
+                      POSIX_FADV_DONTNEED);
+        consumed += size;
+        return true;
+    });
+    
+    if (!read) {
+        error = reader.getError();
+        return false;
+    }
+    return matched;
+}
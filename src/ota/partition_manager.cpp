@@ -10,10 +10,17 @@
  */
 
 #include "partition_manager.hpp"
+#include "crc32.hpp"
+#include "async_io.hpp"
 #include <iostream>
 #include <fstream>
 #include <cstring>
 #include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include <openssl/sha.h>
 
@@ -31,11 +38,78 @@ PartitionManager::PartitionManager(
     boot_status_path_(boot_status_path),
     simulation_mode_(simulation_mode),
     active_partition_(PartitionId::PARTITION_UNKNOWN),
-    data_mounted_(false)
+    data_mounted_(false),
+    verify_threads_(0),
+    sim_image_size_(DEFAULT_SIM_PARTITION_SIZE),
+    boot_status_fd_(-1),
+    batch_depth_(0),
+    boot_status_dirty_(false)
 {
     std::memset(&boot_status_, 0, sizeof(BootStatus));
 }
 
+PartitionManager::~PartitionManager() {
+    if (boot_status_fd_ >= 0) {
+        ::close(boot_status_fd_);
+    }
+}
+
+// ==================== Boot Status Batch ====================
+
+PartitionManager::BootStatusBatch::BootStatusBatch(PartitionManager& manager)
+    : manager_(manager), committed_(false), result_(true) {
+    manager_.batch_depth_++;
+}
+
+PartitionManager::BootStatusBatch::~BootStatusBatch() {
+    commit();
+}
+
+bool PartitionManager::BootStatusBatch::commit() {
+    if (committed_) {
+        return result_;
+    }
+    committed_ = true;
+    
+    // Outermost batch writes everything deferred since it was opened
+    if (--manager_.batch_depth_ == 0 && manager_.boot_status_dirty_) {
+        result_ = manager_.writeBootStatus();
+    }
+    return result_;
+}
+
+// ==================== Helpers ====================
+
+static const char* partitionName(PartitionId partition) {
+    return partition == PartitionId::PARTITION_A ? "A" : "B";
+}
+
+/**
+ * @brief Create a directory and its parents (logs on failure)
+ */
+static bool createDirectories(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec) {
+        std::cerr << "[PARTITION] Failed to create directory " << path << ": " << ec.message() << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read metadata without logging (partitions may legitimately have none)
+ */
+static bool readMetadataFile(const std::string& path, PartitionMetadata& metadata) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t n = ::pread(fd, &metadata, sizeof(PartitionMetadata), 0);
+    ::close(fd);
+    return n == static_cast<ssize_t>(sizeof(PartitionMetadata)) && metadata.magic_number == PARTITION_MAGIC_NUMBER;
+}
+
 // ==================== Initialization ====================
 
 bool PartitionManager::initialize() {
@@ -88,6 +162,8 @@ bool PartitionManager::initialize() {
     std::cout << "[PARTITION] ✓ Partition B State: " 
               << static_cast<int>(boot_status_.state_b) << "\n";
     
+    checkBootPartitions();
+    
     return true;
 }
 
@@ -151,20 +227,22 @@ bool PartitionManager::readMetadata(PartitionId partition, PartitionMetadata& me
 bool PartitionManager::writeMetadata(PartitionId partition, const PartitionMetadata& metadata) {
     std::string path = getPartitionPath(partition);
     
-    std::ofstream file(path, std::ios::binary | std::ios::in | std::ios::out);
-    if (!file.is_open()) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
         std::cerr << "[PARTITION] Failed to open partition for writing: " << path << "\n";
         return false;
     }
     
-    file.write(reinterpret_cast<const char*>(&metadata), sizeof(PartitionMetadata));
-    if (!file.good()) {
-        std::cerr << "[PARTITION] Failed to write metadata to: " << path << "\n";
+    // Metadata is written after the image and marks it complete: make it durable
+    ssize_t n = ::pwrite(fd, &metadata, sizeof(PartitionMetadata), 0);
+    bool ok = n == static_cast<ssize_t>(sizeof(PartitionMetadata)) && ::fdatasync(fd) == 0;
+    int error = errno;
+    ::close(fd);
+    if (!ok) {
+        std::cerr << "[PARTITION] Failed to write metadata to: " << path << " (" << strerror(error) << ")\n";
         return false;
     }
     
-    file.close();
-    
     std::cout << "[PARTITION] ✓ Metadata written to partition " 
               << (partition == PartitionId::PARTITION_A ? "A" : "B") << "\n";
     return true;
@@ -183,30 +261,42 @@ bool PartitionManager::verifyPartition(PartitionId partition) {
         return false;
     }
     
-    // Read partition data (excluding metadata)
     std::string path = getPartitionPath(partition);
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "[PARTITION] Failed to open partition: " << path << "\n";
-        return false;
-    }
     
-    // Skip metadata
-    file.seekg(sizeof(PartitionMetadata));
+    // Hash tree: every block on verify threads, against a tree checked against the root
+    if (metadata.hash_tree_offset != 0) {
+        PartitionHashTree tree;
+        if (!loadHashTree(partition, metadata, tree)) {
+            return false;
+        }
+        if (!tree.matchesRoot(metadata.hash_tree_root)) {
+            std::cerr << "[PARTITION] ✗ Hash tree does not match root! Partition corrupted\n";
+            return false;
+        }
+        if (!tree.verifyBlocks(path, sizeof(PartitionMetadata), 0, tree.blockCount(), verify_threads_)) {
+            std::cerr << "[PARTITION] ✗ " << tree.getError() << "! Partition corrupted\n";
+            return false;
+        }
+        
+        std::cout << "[PARTITION] ✓ Partition verified successfully (" << tree.blockCount() << " blocks)\n";
+        return true;
+    }
     
-    // Calculate SHA256
+    // No tree: SHA256 of the image only, not the unused rest of the partition
     unsigned char hash[SHA256_DIGEST_LENGTH];
     SHA256_CTX sha256;
     SHA256_Init(&sha256);
     
-    char buffer[4096];
-    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
-        SHA256_Update(&sha256, buffer, file.gcount());
+    AsyncFileReader reader;
+    if (!reader.read(path, sizeof(PartitionMetadata), metadata.total_size, [&](const uint8_t* data, size_t size) {
+        SHA256_Update(&sha256, data, size);
+        return true;
+    })) {
+        std::cerr << "[PARTITION] ✗ " << reader.getError() << "\n";
+        return false;
     }
     SHA256_Final(hash, &sha256);
     
-    file.close();
-    
     // Compare hashes
     if (std::memcmp(hash, metadata.sha256_hash, SHA256_DIGEST_LENGTH) != 0) {
         std::cerr << "[PARTITION] ✗ Hash mismatch! Partition corrupted\n";
@@ -217,6 +307,106 @@ bool PartitionManager::verifyPartition(PartitionId partition) {
     return true;
 }
 
+bool PartitionManager::verifyPartitionRange(PartitionId partition, uint64_t offset, uint64_t length) {
+    PartitionMetadata metadata;
+    if (!readMetadata(partition, metadata)) {
+        return false;
+    }
+    if (metadata.hash_tree_offset == 0) {
+        std::cerr << "[PARTITION] ✗ Partition " << partitionName(partition) << " has no hash tree\n";
+        return false;
+    }
+    
+    PartitionHashTree tree;
+    if (!loadHashTree(partition, metadata, tree) || !tree.matchesRoot(metadata.hash_tree_root)) {
+        std::cerr << "[PARTITION] ✗ Hash tree of partition " << partitionName(partition) << " is invalid\n";
+        return false;
+    }
+    
+    uint64_t first = offset / HASH_TREE_BLOCK_SIZE;
+    uint64_t end = (offset + length + HASH_TREE_BLOCK_SIZE - 1) / HASH_TREE_BLOCK_SIZE;
+    if (!tree.verifyBlocks(getPartitionPath(partition), sizeof(PartitionMetadata), first, end - first,
+                           verify_threads_)) {
+        std::cerr << "[PARTITION] ✗ " << tree.getError() << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PartitionManager::checkPartitionRoot(PartitionId partition) {
+    PartitionMetadata metadata;
+    if (!readMetadataFile(getPartitionPath(partition), metadata) || metadata.hash_tree_offset == 0) {
+        return false;
+    }
+    
+    PartitionHashTree tree;
+    return loadHashTree(partition, metadata, tree) && tree.matchesRoot(metadata.hash_tree_root);
+}
+
+bool PartitionManager::writeHashTree(PartitionId partition, const PartitionHashTree& tree,
+                                     PartitionMetadata& metadata) {
+    // First block boundary after the image, so the tree never shares a block with it
+    uint64_t offset = (sizeof(PartitionMetadata) + tree.dataSize() + HASH_TREE_BLOCK_SIZE - 1) /
+                      HASH_TREE_BLOCK_SIZE * HASH_TREE_BLOCK_SIZE;
+    
+    if (!tree.store(getPartitionPath(partition), offset)) {
+        return false;
+    }
+    
+    std::memcpy(metadata.hash_tree_root, tree.root(), HASH_TREE_DIGEST_SIZE);
+    metadata.hash_tree_offset = offset;
+    metadata.hash_tree_size = static_cast<uint32_t>(tree.treeSize());
+    metadata.hash_block_size = HASH_TREE_BLOCK_SIZE;
+    
+    std::cout << "[PARTITION] ✓ Hash tree written to partition " << partitionName(partition)
+              << " (" << tree.treeSize() << " bytes at offset " << offset << ")\n";
+    return true;
+}
+
+bool PartitionManager::loadHashTree(PartitionId partition, const PartitionMetadata& metadata,
+                                    PartitionHashTree& tree) {
+    if (metadata.hash_block_size != HASH_TREE_BLOCK_SIZE) {
+        std::cerr << "[PARTITION] ✗ Unsupported hash block size: " << metadata.hash_block_size << "\n";
+        return false;
+    }
+    
+    if (!tree.load(getPartitionPath(partition), metadata.hash_tree_offset, metadata.hash_tree_size,
+                   metadata.total_size)) {
+        std::cerr << "[PARTITION] ✗ " << tree.getError() << "\n";
+        return false;
+    }
+    return true;
+}
+
+void PartitionManager::checkBootPartitions() {
+    for (PartitionId partition : {PartitionId::PARTITION_A, PartitionId::PARTITION_B}) {
+        PartitionState state = getPartitionState(partition);
+        if (state != PartitionState::STATE_READY && state != PartitionState::STATE_ACTIVE) {
+            continue;
+        }
+        
+        PartitionMetadata metadata;
+        if (!readMetadataFile(getPartitionPath(partition), metadata) || metadata.hash_tree_offset == 0) {
+            continue;       // Factory image, no tree to check
+        }
+        
+        if (checkPartitionRoot(partition)) {
+            std::cout << "[PARTITION] ✓ Partition " << partitionName(partition) << " hash tree root verified\n";
+            continue;
+        }
+        
+        // Running from it either way; a standby copy must not be booted or rolled back to
+        if (partition == active_partition_) {
+            std::cerr << "[PARTITION] ⚠️ Active partition " << partitionName(partition)
+                      << " hash tree does not match its root\n";
+        } else {
+            std::cerr << "[PARTITION] ✗ Partition " << partitionName(partition)
+                      << " hash tree does not match its root, marking as error\n";
+            setPartitionState(partition, PartitionState::STATE_ERROR);
+        }
+    }
+}
+
 // ==================== Boot Target Management ====================
 
 bool PartitionManager::switchBootTarget(PartitionId target) {
@@ -255,6 +445,19 @@ bool PartitionManager::performRollback() {
                           ? PartitionId::PARTITION_B 
                           : PartitionId::PARTITION_A;
     
+    // Do not fall back onto a corrupted image
+    PartitionMetadata metadata;
+    if (readMetadataFile(getPartitionPath(previous), metadata) && metadata.hash_tree_offset != 0 &&
+        !verifyPartition(previous)) {
+        std::cerr << "[PARTITION] ✗ Previous partition " << partitionName(previous)
+                  << " failed verification, rollback aborted\n";
+        setPartitionState(previous, PartitionState::STATE_ERROR);
+        return false;
+    }
+    
+    // State and boot target change in one journal record
+    BootStatusBatch batch(*this);
+    
     // Mark current partition as error
     setPartitionState(current, PartitionState::STATE_ROLLBACK);
     
@@ -262,7 +465,7 @@ bool PartitionManager::performRollback() {
     boot_status_.boot_target = previous;
     boot_status_.boot_count = 0;
     
-    if (!writeBootStatus()) {
+    if (!batch.commit()) {
         std::cerr << "[PARTITION] Failed to write boot status during rollback\n";
         return false;
     }
@@ -284,37 +487,113 @@ std::string PartitionManager::getPartitionPath(PartitionId partition) const {
     return "";
 }
 
+bool PartitionManager::openBootStatus() {
+    if (boot_status_fd_ >= 0) {
+        return true;
+    }
+    
+    boot_status_fd_ = ::open(boot_status_path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    if (boot_status_fd_ < 0 || fstat(boot_status_fd_, &st) != 0) {
+        std::cerr << "[PARTITION] Failed to open boot status file: " << boot_status_path_ << "\n";
+        if (boot_status_fd_ >= 0) {
+            ::close(boot_status_fd_);
+            boot_status_fd_ = -1;
+        }
+        return false;
+    }
+    
+    // Both slots allocated once: later writes never change the file size,
+    // so fdatasync has no inode update to flush
+    if (static_cast<size_t>(st.st_size) < BOOT_STATUS_FILE_SIZE) {
+        int error = posix_fallocate(boot_status_fd_, 0, BOOT_STATUS_FILE_SIZE);
+        if (error != 0 || ::fsync(boot_status_fd_) != 0) {
+            std::cerr << "[PARTITION] Failed to allocate boot status file: "
+                      << strerror(error ? error : errno) << "\n";
+            ::close(boot_status_fd_);
+            boot_status_fd_ = -1;
+            return false;
+        }
+        
+        // New file: make its directory entry durable too
+        int dir_fd = ::open(std::filesystem::path(boot_status_path_).parent_path().string().c_str(),
+                            O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd >= 0) {
+            ::fsync(dir_fd);
+            ::close(dir_fd);
+        }
+    }
+    
+    return true;
+}
+
+uint32_t PartitionManager::bootStatusCRC32(const BootStatus& status) {
+    return crc32Update(0, reinterpret_cast<const uint8_t*>(&status), offsetof(BootStatus, crc32));
+}
+
 bool PartitionManager::readBootStatus() {
-    std::ifstream file(boot_status_path_, std::ios::binary);
-    if (!file.is_open()) {
+    if (!openBootStatus()) {
         return false;
     }
     
-    file.read(reinterpret_cast<char*>(&boot_status_), sizeof(BootStatus));
-    file.close();
+    BootStatus slots[BOOT_STATUS_SLOTS];
+    std::memset(slots, 0, sizeof(slots));
+    if (::pread(boot_status_fd_, slots, sizeof(slots), 0) < 0) {
+        std::cerr << "[PARTITION] Failed to read boot status: " << strerror(errno) << "\n";
+        return false;
+    }
     
-    // Verify magic number
-    if (boot_status_.magic_number != PARTITION_MAGIC_NUMBER) {
+    // Newest valid slot (sequence compared modulo 2^32)
+    const BootStatus* newest = nullptr;
+    for (const BootStatus& slot : slots) {
+        if (slot.magic_number != PARTITION_MAGIC_NUMBER || slot.crc32 != bootStatusCRC32(slot)) {
+            continue;
+        }
+        if (!newest || static_cast<int32_t>(slot.sequence - newest->sequence) > 0) {
+            newest = &slot;
+        }
+    }
+    
+    // Pre-journal file: a single record without sequence or CRC (journal records never have sequence 0)
+    if (!newest && slots[0].magic_number == PARTITION_MAGIC_NUMBER && slots[0].sequence == 0 &&
+        slots[0].crc32 == 0) {
+        std::cout << "[PARTITION] Converting boot status to journal format\n";
+        newest = &slots[0];
+    }
+    
+    if (!newest) {
         return false;
     }
     
+    boot_status_ = *newest;
     return true;
 }
 
 bool PartitionManager::writeBootStatus() {
-    std::ofstream file(boot_status_path_, std::ios::binary | std::ios::trunc);
-    if (!file.is_open()) {
-        std::cerr << "[PARTITION] Failed to open boot status file: " << boot_status_path_ << "\n";
+    if (batch_depth_ > 0) {
+        boot_status_dirty_ = true;
+        return true;
+    }
+    
+    if (!openBootStatus()) {
         return false;
     }
     
-    file.write(reinterpret_cast<const char*>(&boot_status_), sizeof(BootStatus));
-    if (!file.good()) {
-        std::cerr << "[PARTITION] Failed to write boot status\n";
+    // Other slot than the newest record: a torn write leaves that record intact
+    BootStatus record = boot_status_;
+    record.sequence = boot_status_.sequence + 1;
+    record.crc32 = bootStatusCRC32(record);
+    off_t offset = static_cast<off_t>((record.sequence % BOOT_STATUS_SLOTS) * sizeof(BootStatus));
+    
+    ssize_t n = ::pwrite(boot_status_fd_, &record, sizeof(BootStatus), offset);
+    if (n != static_cast<ssize_t>(sizeof(BootStatus)) || ::fdatasync(boot_status_fd_) != 0) {
+        std::cerr << "[PARTITION] Failed to write boot status: " << strerror(errno) << "\n";
         return false;
     }
     
-    file.close();
+    boot_status_.sequence = record.sequence;
+    boot_status_.crc32 = record.crc32;
+    boot_status_dirty_ = false;
     return true;
 }
 
@@ -323,10 +602,8 @@ bool PartitionManager::writeBootStatus() {
 bool PartitionManager::mountDataPartition() {
     if (simulation_mode_) {
         // Simulation mode: just create directory
-        std::string cmd = "mkdir -p " + data_mount_point_;
-        system(cmd.c_str());
-        data_mounted_ = true;
-        return true;
+        data_mounted_ = createDirectories(data_mount_point_);
+        return data_mounted_;
     }
     
     // Check if already mounted
@@ -337,8 +614,9 @@ bool PartitionManager::mountDataPartition() {
     }
     
     // Create mount point
-    std::string mkdir_cmd = "mkdir -p " + data_mount_point_;
-    system(mkdir_cmd.c_str());
+    if (!createDirectories(data_mount_point_)) {
+        return false;
+    }
     
     // Mount data partition
     std::string mount_cmd = "mount " + data_partition_path_ + " " + data_mount_point_;
@@ -371,34 +649,55 @@ bool PartitionManager::isDataPartitionMounted() const {
 }
 
 bool PartitionManager::createSimulationEnvironment() {
-    std::cout << "[PARTITION] Creating simulation environment (3-sector)...\n";
+    std::cout << "[PARTITION] Preparing simulation environment (3-sector)...\n";
     
     // Create partition directories
-    system("mkdir -p /tmp/vmg_partitions");
-    system("mkdir -p /tmp/vmg_partitions/data");
-    system("mkdir -p /tmp/vmg_partitions/data/ota/downloads");
-    system("mkdir -p /tmp/vmg_partitions/data/ota/zones");
-    system("mkdir -p /tmp/vmg_partitions/data/log");
+    std::filesystem::path boot_status_dir = std::filesystem::path(boot_status_path_).parent_path();
+    for (const std::string& dir : {std::filesystem::path(partition_a_path_).parent_path().string(),
+                                   std::filesystem::path(partition_b_path_).parent_path().string(),
+                                   boot_status_dir.string(),
+                                   data_mount_point_ + "/ota/downloads",
+                                   data_mount_point_ + "/ota/zones",
+                                   data_mount_point_ + "/log"}) {
+        if (!dir.empty() && !createDirectories(dir)) {
+            return false;
+        }
+    }
+    
+    // Partition images: sparse, and kept across restarts
+    if (!prepareSimulationImage(partition_a_path_) || !prepareSimulationImage(partition_b_path_)) {
+        return false;
+    }
     
-    // Create empty partition files (100MB each for simulation)
-    const size_t partition_size = 100 * 1024 * 1024;  // 100MB
+    std::cout << "[PARTITION] ✓ Simulation environment ready\n";
+    return true;
+}
+
+bool PartitionManager::prepareSimulationImage(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "[PARTITION] Failed to open simulation image " << path << ": " << strerror(errno) << "\n";
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
     
-    // Create Partition A
-    std::ofstream part_a(DEFAULT_SIM_PARTITION_A, std::ios::binary | std::ios::trunc);
-    if (part_a.is_open()) {
-        std::vector<uint8_t> zeros(partition_size, 0);
-        part_a.write(reinterpret_cast<const char*>(zeros.data()), partition_size);
-        part_a.close();
+    if (static_cast<uint64_t>(st.st_size) >= sim_image_size_) {
+        ::close(fd);
+        std::cout << "[PARTITION]   Reusing " << path << " (" << st.st_size / (1024 * 1024) << " MB)\n";
+        return true;
     }
     
-    // Create Partition B
-    std::ofstream part_b(DEFAULT_SIM_PARTITION_B, std::ios::binary | std::ios::trunc);
-    if (part_b.is_open()) {
-        std::vector<uint8_t> zeros(partition_size, 0);
-        part_b.write(reinterpret_cast<const char*>(zeros.data()), partition_size);
-        part_b.close();
+    // Extending allocates no blocks: unwritten ranges read back as zeros
+    if (::ftruncate(fd, static_cast<off_t>(sim_image_size_)) != 0) {
+        std::cerr << "[PARTITION] Failed to size simulation image " << path << ": " << strerror(errno) << "\n";
+        ::close(fd);
+        return false;
     }
     
-    std::cout << "[PARTITION] ✓ Simulation environment created\n";
+    ::close(fd);
+    std::cout << "[PARTITION]   Created " << path << " (" << sim_image_size_ / (1024 * 1024) << " MB, sparse)\n";
     return true;
 }
@@ -0,0 +1,431 @@
+/**
+ * @file partition_writer.cpp
+ * @brief Large-block Partition Image Writer Implementation
+ */
+
+#include "partition_writer.hpp"
+#include "async_io.hpp"
+#include <iostream>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+
+// ==================== Helpers ====================
+
+static bool pwriteAll(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+/**
+ * @brief errno values meaning "this file pair does not support the call"
+ */
+static bool isUnsupported(int error) {
+    return error == EINVAL || error == EXDEV || error == ENOSYS || error == EOPNOTSUPP || error == EBADF;
+}
+
+const char* partitionWriteMethodName(PartitionWriteMethod method) {
+    switch (method) {
+        case PartitionWriteMethod::COPY_FILE_RANGE: return "copy_file_range";
+        case PartitionWriteMethod::SENDFILE:        return "sendfile";
+        case PartitionWriteMethod::DIRECT_IO:       return "O_DIRECT";
+        case PartitionWriteMethod::BUFFERED:        return "buffered";
+        default:                                    return "UNKNOWN";
+    }
+}
+
+// ==================== Constructor ====================
+
+PartitionWriter::PartitionWriter(const std::string& target_path, size_t block_size)
+    : target_path_(target_path),
+      block_size_((std::max<size_t>(block_size, 1) + PARTITION_WRITE_ALIGNMENT - 1) /
+                  PARTITION_WRITE_ALIGNMENT * PARTITION_WRITE_ALIGNMENT),
+      stats_{PartitionWriteMethod::BUFFERED, 0, 0.0, 0, 0},
+      target_fd_(-1),
+      direct_fd_(-1),
+      buffer_(nullptr, &std::free),
+      compare_buffer_(nullptr, &std::free),
+      skip_unchanged_(false),
+      cancel_(nullptr),
+      buffered_(0),
+      stream_offset_(0)
+{
+}
+
+PartitionWriter::~PartitionWriter() {
+    closeTarget(false);
+}
+
+// ==================== Copy ====================
+
+bool PartitionWriter::copy(const std::string& source_path, uint64_t source_offset, uint64_t length,
+                           uint64_t target_offset, const PartitionWriteProgress& progress) {
+    int source_fd = ::open(source_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (source_fd < 0) {
+        stats_ = PartitionWriteStats{PartitionWriteMethod::BUFFERED, 0, 0.0, 0, 0};
+        error_ = "Failed to open " + source_path + ": " + strerror(errno);
+        return false;
+    }
+    
+    if (!openTarget(target_offset, true)) {
+        ::close(source_fd);
+        return false;
+    }
+    
+    posix_fadvise(source_fd, static_cast<off_t>(source_offset), static_cast<off_t>(length), POSIX_FADV_SEQUENTIAL);
+    
+    bool ok = true;
+    uint64_t written = 0;
+    
+    // In-kernel copy while the kernel accepts it
+    while (written < length && (stats_.method == PartitionWriteMethod::COPY_FILE_RANGE ||
+                                stats_.method == PartitionWriteMethod::SENDFILE)) {
+        if (cancelled()) {
+            ok = false;
+            break;
+        }
+        
+        size_t size = static_cast<size_t>(std::min<uint64_t>(block_size_, length - written));
+        size_t n = copyBlock(source_fd, source_offset + written, target_offset + written, size);
+        if (n == 0) {
+            ok = error_.empty();        // No error: refused, continue in user space
+            break;
+        }
+        written += n;
+        stats_.bytes = written;
+        
+        if (progress) {
+            progress(written, length, throughputKBps());
+        }
+    }
+    
+    // User space: source reads queued ahead while the current block is written
+    if (ok && written < length) {
+        AsyncFileReader reader(block_size_);
+        ok = reader.read(source_fd, source_offset + written, length - written, [&](const uint8_t* data, size_t size) {
+            if (cancelled() || !writeBuffer(data, size, target_offset + written)) {
+                return false;
+            }
+            posix_fadvise(source_fd, static_cast<off_t>(source_offset + written), static_cast<off_t>(size),
+                          POSIX_FADV_DONTNEED);
+            written += size;
+            stats_.bytes = written;
+            
+            if (progress) {
+                progress(written, length, throughputKBps());
+            }
+            return true;
+        });
+        if (!ok && error_.empty()) {
+            error_ = reader.getError();
+        }
+    }
+    
+    ::close(source_fd);
+    return closeTarget(ok);
+}
+
+bool PartitionWriter::cancelled() {
+    if (cancel_ == nullptr || cancel_->waitWhilePaused()) {
+        return false;
+    }
+    error_ = "Cancelled";
+    return true;
+}
+
+// ==================== Streaming ====================
+
+bool PartitionWriter::begin(uint64_t target_offset) {
+    return openTarget(target_offset, false);
+}
+
+bool PartitionWriter::append(const uint8_t* data, size_t size) {
+    if (target_fd_ < 0) {
+        if (error_.empty()) {
+            error_ = "Partition not open";
+        }
+        return false;
+    }
+    
+    // Gather into whole blocks so O_DIRECT and eMMC see large sequential writes
+    while (size > 0) {
+        size_t n = std::min(size, block_size_ - buffered_);
+        std::memcpy(buffer_.get() + buffered_, data, n);
+        buffered_ += n;
+        data += n;
+        size -= n;
+        stats_.bytes += n;
+        
+        if (buffered_ == block_size_) {
+            if (cancelled() || !writeBuffer(buffer_.get(), buffered_, stream_offset_)) {
+                closeTarget(false);
+                return false;
+            }
+            stream_offset_ += buffered_;
+            buffered_ = 0;
+        }
+    }
+    return true;
+}
+
+bool PartitionWriter::finish() {
+    if (target_fd_ < 0) {
+        if (error_.empty()) {
+            error_ = "Partition not open";
+        }
+        return false;
+    }
+    
+    bool ok = buffered_ == 0 || writeBuffer(buffer_.get(), buffered_, stream_offset_);
+    buffered_ = 0;
+    return closeTarget(ok);
+}
+
+uint32_t PartitionWriter::throughputKBps() const {
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    return elapsed > 0 ? static_cast<uint32_t>(stats_.bytes / 1024.0 / elapsed) : 0;
+}
+
+// ==================== Target ====================
+
+bool PartitionWriter::openTarget(uint64_t target_offset, bool from_file) {
+    closeTarget(false);
+    stats_ = PartitionWriteStats{PartitionWriteMethod::BUFFERED, 0, 0.0, 0, 0};
+    error_.clear();
+    buffered_ = 0;
+    stream_offset_ = target_offset;
+    start_ = std::chrono::steady_clock::now();
+    
+    // Skip-unchanged reads the partition back through the same descriptors
+    int access = skip_unchanged_ ? O_RDWR : O_WRONLY;
+    target_fd_ = ::open(target_path_.c_str(), access | O_CLOEXEC);
+    struct stat st;
+    if (target_fd_ < 0 || fstat(target_fd_, &st) != 0) {
+        error_ = "Failed to open " + target_path_ + ": " + strerror(errno);
+        closeTarget(false);
+        return false;
+    }
+    
+    // Block device: bypass the page cache if the offset is sector aligned
+    if (S_ISBLK(st.st_mode)) {
+        size_t sector = logicalBlockSize(target_fd_);
+        if (PARTITION_WRITE_ALIGNMENT % sector == 0 && target_offset % sector == 0) {
+            direct_fd_ = ::open(target_path_.c_str(), access | O_DIRECT | O_CLOEXEC);
+        }
+        if (direct_fd_ >= 0) {
+            stats_.method = PartitionWriteMethod::DIRECT_IO;
+        }
+    } else if (S_ISREG(st.st_mode) && from_file && !skip_unchanged_) {
+        stats_.method = PartitionWriteMethod::COPY_FILE_RANGE;
+    }
+    
+    void* raw = nullptr;
+    if (posix_memalign(&raw, PARTITION_WRITE_ALIGNMENT, block_size_) != 0) {
+        error_ = "Failed to allocate write buffer";
+        closeTarget(false);
+        return false;
+    }
+    buffer_.reset(static_cast<uint8_t*>(raw));
+    
+    if (skip_unchanged_) {
+        raw = nullptr;
+        if (posix_memalign(&raw, PARTITION_WRITE_ALIGNMENT, block_size_) != 0) {
+            error_ = "Failed to allocate compare buffer";
+            closeTarget(false);
+            return false;
+        }
+        compare_buffer_.reset(static_cast<uint8_t*>(raw));
+    }
+    return true;
+}
+
+bool PartitionWriter::closeTarget(bool ok) {
+    if (target_fd_ < 0) {
+        return ok;
+    }
+    
+    // O_DIRECT skips the page cache, not the device write cache: sync either way
+    if (ok && ::fdatasync(target_fd_) != 0) {
+        error_ = "fdatasync failed on " + target_path_ + ": " + strerror(errno);
+        ok = false;
+    }
+    
+    if (direct_fd_ >= 0) {
+        ::close(direct_fd_);
+        direct_fd_ = -1;
+    }
+    if (::close(target_fd_) != 0 && ok) {
+        error_ = "Failed to close " + target_path_ + ": " + strerror(errno);
+        ok = false;
+    }
+    target_fd_ = -1;
+    buffer_.reset();
+    compare_buffer_.reset();
+    
+    stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    return ok;
+}
+
+// ==================== Block Writes ====================
+
+size_t PartitionWriter::copyBlock(int source_fd, uint64_t source_offset, uint64_t target_offset, size_t size) {
+    for (;;) {
+        ssize_t n = -1;
+        
+        switch (stats_.method) {
+            case PartitionWriteMethod::COPY_FILE_RANGE: {
+                loff_t in = static_cast<loff_t>(source_offset);
+                loff_t out = static_cast<loff_t>(target_offset);
+                n = ::copy_file_range(source_fd, &in, target_fd_, &out, size, 0);
+                break;
+            }
+            
+            case PartitionWriteMethod::SENDFILE: {
+                off_t in = static_cast<off_t>(source_offset);
+                if (::lseek(target_fd_, static_cast<off_t>(target_offset), SEEK_SET) < 0) {
+                    break;
+                }
+                n = ::sendfile(target_fd_, source_fd, &in, size);
+                break;
+            }
+            
+            default:
+                return 0;
+        }
+        
+        if (n > 0) {
+            return static_cast<size_t>(n);
+        }
+        if (n == 0) {
+            error_ = "Unexpected end of source at offset " + std::to_string(source_offset);
+            return 0;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        
+        // In-kernel copy refused for this file pair: next method, same block
+        if (stats_.method == PartitionWriteMethod::COPY_FILE_RANGE && isUnsupported(errno)) {
+            stats_.method = PartitionWriteMethod::SENDFILE;
+            continue;
+        }
+        if (stats_.method == PartitionWriteMethod::SENDFILE && isUnsupported(errno)) {
+            stats_.method = PartitionWriteMethod::BUFFERED;
+            return 0;
+        }
+        
+        error_ = "Write to " + target_path_ + " failed at offset " + std::to_string(target_offset) + ": " +
+                 strerror(errno);
+        return 0;
+    }
+}
+
+bool PartitionWriter::writeBuffer(const uint8_t* data, size_t size, uint64_t target_offset) {
+    if (!skip_unchanged_) {
+        return writeRange(data, size, target_offset);
+    }
+    
+    // Write runs of differing compare blocks; a short read (end of partition) counts as different
+    size_t current = readTarget(size, target_offset);
+    size_t run_start = 0;
+    bool in_run = false;
+    
+    for (size_t position = 0; position < size; position += PARTITION_COMPARE_BLOCK_SIZE) {
+        size_t n = std::min<size_t>(PARTITION_COMPARE_BLOCK_SIZE, size - position);
+        bool unchanged = position + n <= current &&
+                         std::memcmp(data + position, compare_buffer_.get() + position, n) == 0;
+        
+        if (unchanged) {
+            stats_.blocks_skipped++;
+            if (in_run && !writeRange(data + run_start, position - run_start, target_offset + run_start)) {
+                return false;
+            }
+            in_run = false;
+        } else {
+            stats_.blocks_written++;
+            if (!in_run) {
+                run_start = position;
+                in_run = true;
+            }
+        }
+    }
+    
+    return !in_run || writeRange(data + run_start, size - run_start, target_offset + run_start);
+}
+
+size_t PartitionWriter::readTarget(size_t size, uint64_t target_offset) {
+    // Same split as writes: aligned part via O_DIRECT (no page cache), tail buffered
+    size_t direct = stats_.method == PartitionWriteMethod::DIRECT_IO
+                    ? size / PARTITION_WRITE_ALIGNMENT * PARTITION_WRITE_ALIGNMENT : 0;
+    size_t done = 0;
+    
+    while (done < size) {
+        int fd = done < direct ? direct_fd_ : target_fd_;
+        size_t n_max = done < direct ? direct - done : size - done;
+        ssize_t n = ::pread(fd, compare_buffer_.get() + done, n_max, static_cast<off_t>(target_offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    
+    if (done > direct) {
+        posix_fadvise(target_fd_, static_cast<off_t>(target_offset + direct), static_cast<off_t>(done - direct),
+                      POSIX_FADV_DONTNEED);
+    }
+    return done;
+}
+
+bool PartitionWriter::writeRange(const uint8_t* data, size_t size, uint64_t target_offset) {
+    // Whole aligned blocks via O_DIRECT; the unaligned tail of the image is buffered
+    size_t direct = stats_.method == PartitionWriteMethod::DIRECT_IO
+                    ? size / PARTITION_WRITE_ALIGNMENT * PARTITION_WRITE_ALIGNMENT : 0;
+    if (direct > 0 && !pwriteAll(direct_fd_, data, direct, target_offset)) {
+        if (errno != EINVAL) {
+            error_ = "Write to " + target_path_ + " failed at offset " + std::to_string(target_offset) + ": " +
+                     strerror(errno);
+            return false;
+        }
+        std::cout << "[PartitionWriter] ⚠ O_DIRECT rejected, using buffered writes\n";
+        stats_.method = PartitionWriteMethod::BUFFERED;
+        direct = 0;
+    }
+    
+    if (!pwriteAll(target_fd_, data + direct, size - direct, target_offset + direct)) {
+        error_ = "Write to " + target_path_ + " failed at offset " + std::to_string(target_offset + direct) + ": " +
+                 strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+size_t PartitionWriter::logicalBlockSize(int fd) {
+    int sector = 0;
+    if (::ioctl(fd, BLKSSZGET, &sector) == 0 && sector > 0) {
+        return static_cast<size_t>(sector);
+    }
+    return 512;
+}
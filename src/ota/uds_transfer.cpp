@@ -0,0 +1,646 @@
+/**
+ * @file uds_transfer.cpp
+ * @brief Resumable UDS Zone Transfer Implementation
+ */
+
+#include "uds_transfer.hpp"
+#include "zone_package.hpp"
+#include "atomic_file.hpp"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ==================== Helpers ====================
+
+static std::string checkpointKey(const std::string& zgw, const std::string& zone_id) {
+    return zgw + "/" + zone_id;
+}
+
+static bool isNegative(const std::vector<uint8_t>& response, uint8_t service_id) {
+    return response.size() >= 3 && response[0] == UDS_NEGATIVE_RESPONSE && response[1] == service_id;
+}
+
+static uint64_t readBigEndian(const std::vector<uint8_t>& data, size_t index, size_t length) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < length; i++) {
+        value = (value << 8) | data[index + i];
+    }
+    return value;
+}
+
+static void appendBigEndian(std::vector<uint8_t>& data, uint64_t value, size_t length) {
+    for (size_t i = length; i > 0; i--) {
+        data.push_back(static_cast<uint8_t>((value >> (8 * (i - 1))) & 0xFF));
+    }
+}
+
+static bool preadFull(int fd, uint8_t* buffer, size_t length, uint64_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pread(fd, buffer + done, length - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// ==================== UDS Checkpoint Store ====================
+
+UdsCheckpointStore::UdsCheckpointStore(const std::string& path)
+    : path_(path) {
+}
+
+bool UdsCheckpointStore::load() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    
+    std::ifstream file(path_);
+    if (!file.is_open()) {
+        return true;    // No checkpoints yet
+    }
+    
+    try {
+        nlohmann::json store;
+        file >> store;
+        
+        if (store.value("version", 0) != UDS_CHECKPOINT_VERSION) {
+            std::cout << "[UDS] ⚠ Checkpoint version mismatch, starting empty\n";
+            return true;
+        }
+        
+        for (const auto& j : store.at("checkpoints")) {
+            UdsTransferCheckpoint checkpoint;
+            checkpoint.zgw = j.at("zgw").get<std::string>();
+            checkpoint.zone_id = j.at("zone_id").get<std::string>();
+            checkpoint.ecu_id = j.value("ecu_id", "");
+            checkpoint.file_size = j.at("file_size").get<uint64_t>();
+            checkpoint.zone_crc32 = j.at("zone_crc32").get<uint32_t>();
+            checkpoint.data_format = j.at("data_format").get<uint8_t>();
+            checkpoint.offset = j.at("offset").get<uint64_t>();
+            checkpoint.block_sequence = j.value("block_sequence", 0);
+            checkpoint.updated_at = j.value("updated_at", 0);
+            entries_[checkpointKey(checkpoint.zgw, checkpoint.zone_id)] = checkpoint;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[UDS] ✗ Failed to read " << path_ << ": " << e.what() << "\n";
+        entries_.clear();
+        return false;
+    }
+    
+    std::cout << "[UDS] ✓ Loaded " << entries_.size() << " transfer checkpoint(s)\n";
+    return true;
+}
+
+bool UdsCheckpointStore::lookup(const std::string& zgw, const std::string& zone_id, uint64_t file_size,
+                                uint32_t zone_crc32, uint8_t data_format,
+                                UdsTransferCheckpoint& checkpoint) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(checkpointKey(zgw, zone_id));
+    if (it == entries_.end()) {
+        return false;
+    }
+    
+    // Same zone ID but a different package: the partial file on the ZGW is stale
+    const UdsTransferCheckpoint& entry = it->second;
+    if (entry.file_size != file_size || entry.zone_crc32 != zone_crc32 || entry.data_format != data_format ||
+        entry.offset > file_size) {
+        return false;
+    }
+    
+    checkpoint = entry;
+    return true;
+}
+
+bool UdsCheckpointStore::record(const UdsTransferCheckpoint& checkpoint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[checkpointKey(checkpoint.zgw, checkpoint.zone_id)] = checkpoint;
+    
+    while (entries_.size() > UDS_CHECKPOINT_MAX_ENTRIES) {
+        auto oldest = entries_.begin();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->second.updated_at < oldest->second.updated_at) {
+                oldest = it;
+            }
+        }
+        entries_.erase(oldest);
+    }
+    
+    return save();
+}
+
+void UdsCheckpointStore::clear(const std::string& zgw, const std::string& zone_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.erase(checkpointKey(zgw, zone_id)) > 0) {
+        save();
+    }
+}
+
+size_t UdsCheckpointStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+bool UdsCheckpointStore::save() const {
+    nlohmann::json checkpoints = nlohmann::json::array();
+    for (const auto& entry : entries_) {
+        const UdsTransferCheckpoint& checkpoint = entry.second;
+        nlohmann::json j;
+        j["zgw"] = checkpoint.zgw;
+        j["zone_id"] = checkpoint.zone_id;
+        j["ecu_id"] = checkpoint.ecu_id;
+        j["file_size"] = checkpoint.file_size;
+        j["zone_crc32"] = checkpoint.zone_crc32;
+        j["data_format"] = checkpoint.data_format;
+        j["offset"] = checkpoint.offset;
+        j["block_sequence"] = checkpoint.block_sequence;
+        j["updated_at"] = checkpoint.updated_at;
+        checkpoints.push_back(j);
+    }
+    
+    nlohmann::json store;
+    store["version"] = UDS_CHECKPOINT_VERSION;
+    store["checkpoints"] = checkpoints;
+    std::string content = store.dump(2);
+    
+    std::string error;
+    if (!writeFileAtomic(path_, content, error)) {
+        std::cerr << "[UDS] ✗ " << error << "\n";
+        return false;
+    }
+    return true;
+}
+
+// ==================== UDS Zone Transfer ====================
+
+UdsZoneTransfer::UdsZoneTransfer(DoIPClient& client, const std::string& zgw)
+    : client_(client),
+      zgw_(zgw),
+      data_format_(UDS_DFI_UNCOMPRESSED),
+      file_transfer_(true),
+      max_block_size_(0),
+      checkpoints_(nullptr),
+      cancel_(nullptr),
+      fd_(-1),
+      file_size_(0),
+      zone_crc32_(0),
+      using_file_transfer_(false),
+      offset_(0),
+      sequence_(1),
+      block_size_(0),
+      block_limit_(0),
+      persisted_offset_(0),
+      file_transfer_unsupported_(false),
+      format_rejected_(false),
+      stats_() {
+}
+
+bool UdsZoneTransfer::run(const std::string& path) {
+    auto start_time = std::chrono::steady_clock::now();
+    
+    stats_ = UdsTransferStats();
+    error_.clear();
+    zone_id_.clear();
+    zone_crc32_ = 0;
+    ecu_ranges_.clear();
+    using_file_transfer_ = false;
+    offset_ = 0;
+    sequence_ = 1;
+    block_size_ = 0;
+    block_limit_ = 0;
+    persisted_offset_ = 0;
+    file_transfer_unsupported_ = !file_transfer_;
+    format_rejected_ = false;
+    
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        error_ = "Failed to open " + path + ": " + strerror(errno);
+        std::cerr << "[UDS] ✗ " << error_ << "\n";
+        return false;
+    }
+    
+    struct stat st;
+    if (::fstat(fd_, &st) != 0 || st.st_size <= 0 || static_cast<uint64_t>(st.st_size) > UINT32_MAX) {
+        error_ = "Zone Package is empty or too large for a 4-byte memorySize";
+        std::cerr << "[UDS] ✗ " << error_ << "\n";
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    file_size_ = static_cast<uint64_t>(st.st_size);
+    readHeader();
+    
+    std::cout << "[UDS] Transferring " << zone_id_ << " (" << file_size_ << " bytes) to ZGW " << zgw_ << "\n";
+    
+    UdsTransferCheckpoint checkpoint;
+    bool resume = !file_transfer_unsupported_ && checkpoints_ &&
+                  checkpoints_->lookup(zgw_, zone_id_, file_size_, zone_crc32_, data_format_, checkpoint);
+    if (resume) {
+        std::cout << "[UDS] Checkpoint at byte " << checkpoint.offset << "/" << file_size_
+                  << (checkpoint.ecu_id.empty() ? std::string() : " (" + checkpoint.ecu_id + ")")
+                  << ", asking ZGW to resume\n";
+        persisted_offset_ = checkpoint.offset;
+    }
+    
+    bool success = false;
+    if (start(resume) == RequestResult::ACCEPTED) {
+        stats_.resumed_from = offset_;
+        success = sendBlocks() && exitTransfer();
+    }
+    
+    if (checkpoints_) {
+        if (success) {
+            checkpoints_->clear(zgw_, zone_id_);
+        } else {
+            saveCheckpoint();
+        }
+    }
+    
+    ::close(fd_);
+    fd_ = -1;
+    
+    stats_.block_size = block_size_;
+    stats_.block_limit = block_limit_;
+    stats_.file_transfer = using_file_transfer_;
+    stats_.elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time).count();
+    return success;
+}
+
+void UdsZoneTransfer::readHeader() {
+    ZonePackageHeader header;
+    if (file_size_ < sizeof(header) ||
+        !preadFull(fd_, reinterpret_cast<uint8_t*>(&header), sizeof(header), 0) ||
+        header.magic_number != ZONE_PACKAGE_MAGIC) {
+        zone_id_ = "zone";      // Not a Zone Package: still transferable, keyed by ZGW only
+        return;
+    }
+    
+    zone_id_.assign(header.zone_id, strnlen(header.zone_id, sizeof(header.zone_id)));
+    if (zone_id_.empty()) {
+        zone_id_ = "zone";
+    }
+    zone_crc32_ = header.zone_crc32;
+    
+    size_t count = std::min<size_t>(header.package_count, MAX_ECUS_IN_ZONE);
+    for (size_t i = 0; i < count; i++) {
+        const ZoneECUEntry& entry = header.ecu_table[i];
+        EcuRange range;
+        range.ecu_id.assign(entry.ecu_id, strnlen(entry.ecu_id, sizeof(entry.ecu_id)));
+        range.offset = entry.offset;
+        range.size = entry.size;
+        ecu_ranges_.push_back(range);
+    }
+}
+
+// ==================== Transfer Setup ====================
+
+UdsZoneTransfer::RequestResult UdsZoneTransfer::start(bool resume) {
+    uint64_t previous_offset = std::max(offset_, persisted_offset_);
+    
+    if (!file_transfer_unsupported_) {
+        RequestResult result = RequestResult::UNSUPPORTED;
+        if (resume) {
+            result = requestFileTransfer(UDS_MOOP_RESUME_FILE);
+            if (result == RequestResult::ACCEPTED) {
+                stats_.resumes++;
+                std::cout << "[UDS] ✓ ZGW resumes " << zone_id_ << " at byte " << offset_ << "/" << file_size_
+                          << "\n";
+                return result;
+            }
+            if (result == RequestResult::NO_RESPONSE) {
+                return result;
+            }
+            std::cout << "[UDS] ⚠ ZGW cannot resume " << zone_id_ << ", starting from byte 0\n";
+        }
+        
+        result = requestFileTransfer(UDS_MOOP_REPLACE_FILE);
+        if (result != RequestResult::UNSUPPORTED) {
+            if (result == RequestResult::ACCEPTED && previous_offset > 0) {
+                stats_.restarts++;
+            }
+            return result;
+        }
+        
+        std::cout << "[UDS] ZGW does not support RequestFileTransfer (0x38), using RequestDownload (0x34)\n";
+        file_transfer_unsupported_ = true;
+    }
+    
+    RequestResult result = requestDownload();
+    if (result == RequestResult::ACCEPTED && previous_offset > 0) {
+        stats_.restarts++;
+    }
+    return result;
+}
+
+UdsZoneTransfer::RequestResult UdsZoneTransfer::requestFileTransfer(uint8_t mode) {
+    // 0x38 payload: [0x38] [modeOfOperation] [filePathAndNameLength: 2] [filePathAndName]
+    //               [dataFormatIdentifier] [fileSizeParameterLength = 4] [fileSizeUncompressed: 4]
+    //               [fileSizeCompressed: 4]
+    std::vector<uint8_t> payload;
+    payload.push_back(static_cast<uint8_t>(UDSService::REQUEST_FILE_TRANSFER));
+    payload.push_back(mode);
+    appendBigEndian(payload, zone_id_.size(), 2);
+    payload.insert(payload.end(), zone_id_.begin(), zone_id_.end());
+    payload.push_back(data_format_);
+    payload.push_back(4);
+    appendBigEndian(payload, file_size_, 4);
+    appendBigEndian(payload, file_size_, 4);
+    
+    auto response = client_.sendDiagnosticMessage(payload[0], payload);
+    if (response.empty()) {
+        std::cerr << "[UDS] ✗ No response to RequestFileTransfer (0x38)\n";
+        return RequestResult::NO_RESPONSE;
+    }
+    
+    if (isNegative(response, payload[0])) {
+        uint8_t nrc = response[2];
+        if (nrc == UDS_NRC_SERVICE_NOT_SUPPORTED || nrc == UDS_NRC_SERVICE_NOT_SUPPORTED_IN_SESSION ||
+            (mode == UDS_MOOP_REPLACE_FILE &&
+             (nrc == UDS_NRC_SUB_FUNCTION_NOT_SUPPORTED || nrc == UDS_NRC_REQUEST_OUT_OF_RANGE))) {
+            return RequestResult::UNSUPPORTED;
+        }
+        std::cerr << "[UDS] ✗ RequestFileTransfer (0x38) mode 0x" << std::hex << (int)mode << " rejected (NRC 0x"
+                  << (int)nrc << ")" << std::dec << "\n";
+        return RequestResult::REJECTED;
+    }
+    
+    // Positive response: [0x78] [modeOfOperation] [lengthFormatIdentifier] [maxNumberOfBlockLength]
+    //                    [dataFormatIdentifier] ([filePosition: 8] for ResumeFile)
+    size_t length = response.size() >= 3 ? response[2] : 0;
+    size_t position_index = 3 + length + 1;
+    if (response[0] != 0x78 || length == 0 || length > 8 || response.size() < position_index ||
+        (mode == UDS_MOOP_RESUME_FILE && response.size() < position_index + 8)) {
+        std::cerr << "[UDS] ✗ Malformed RequestFileTransfer (0x38) response\n";
+        return RequestResult::REJECTED;
+    }
+    
+    uint64_t position = 0;
+    if (mode == UDS_MOOP_RESUME_FILE) {
+        position = readBigEndian(response, position_index, 8);
+        if (position > file_size_) {
+            std::cerr << "[UDS] ✗ ZGW resume position " << position << " beyond file size " << file_size_ << "\n";
+            return RequestResult::REJECTED;
+        }
+    }
+    
+    setBlockLimit(response, 3, length);
+    using_file_transfer_ = true;
+    offset_ = position;
+    persisted_offset_ = position;   // A stale, higher checkpoint is harmless: the ZGW reports its position
+    sequence_ = 1;
+    return RequestResult::ACCEPTED;
+}
+
+UdsZoneTransfer::RequestResult UdsZoneTransfer::requestDownload() {
+    // 0x34 payload: [0x34] [total_size: 4 bytes] [dataFormatIdentifier, if not uncompressed]
+    std::vector<uint8_t> payload;
+    payload.push_back(static_cast<uint8_t>(UDSService::REQUEST_DOWNLOAD));
+    appendBigEndian(payload, file_size_, 4);
+    if (data_format_ != UDS_DFI_UNCOMPRESSED) {
+        payload.push_back(data_format_);
+    }
+    
+    auto response = client_.sendDiagnosticMessage(payload[0], payload);
+    if (response.empty()) {
+        std::cerr << "[UDS] ✗ No response to RequestDownload (0x34)\n";
+        return RequestResult::NO_RESPONSE;
+    }
+    
+    if (isNegative(response, payload[0])) {
+        if (data_format_ != UDS_DFI_UNCOMPRESSED && response[2] == UDS_NRC_REQUEST_OUT_OF_RANGE) {
+            std::cout << "[UDS] ZGW rejected dataFormatIdentifier 0x" << std::hex << (int)data_format_
+                      << std::dec << " (NRC 0x31)\n";
+            format_rejected_ = true;
+        } else {
+            std::cerr << "[UDS] ✗ RequestDownload (0x34) rejected (NRC 0x" << std::hex << (int)response[2]
+                      << std::dec << ")\n";
+        }
+        return RequestResult::REJECTED;
+    }
+    
+    if (response[0] != 0x74) {  // 0x74 = positive response to 0x34
+        std::cerr << "[UDS] ✗ Request Download failed\n";
+        return RequestResult::REJECTED;
+    }
+    
+    // [0x74] [lengthFormatIdentifier: high nibble = byte count] [maxNumberOfBlockLength]
+    size_t length = response.size() >= 2 ? (response[1] >> 4) : 0;
+    if (length > 0 && length <= 8 && response.size() >= 2 + length) {
+        setBlockLimit(response, 2, length);
+    } else {
+        setBlockLimit(response, 0, 0);
+    }
+    
+    using_file_transfer_ = false;
+    offset_ = 0;
+    persisted_offset_ = 0;
+    sequence_ = 1;
+    return RequestResult::ACCEPTED;
+}
+
+void UdsZoneTransfer::setBlockLimit(const std::vector<uint8_t>& response, size_t index, size_t length) {
+    // maxNumberOfBlockLength counts the whole 0x36 request (SID + counter + data)
+    uint64_t max_block_length = length ? readBigEndian(response, index, length) : 0;
+    size_t limit = max_block_length > 2 ? static_cast<size_t>(std::min<uint64_t>(max_block_length - 2,
+                                                                                  UDS_TRANSFER_MAX_BLOCK))
+                                        : UDS_TRANSFER_DEFAULT_BLOCK;
+    if (max_block_size_ > 0) {
+        limit = std::min(limit, max_block_size_);
+    }
+    
+    block_limit_ = limit;
+    block_size_ = block_size_ ? std::min(block_size_, limit) : limit;
+}
+
+// ==================== Data Transfer ====================
+
+bool UdsZoneTransfer::sendBlocks() {
+    std::vector<uint8_t> payload;
+    uint32_t good_blocks = 0;
+    
+    while (offset_ < file_size_) {
+        if (cancelled()) {
+            error_ = "Transfer cancelled at byte " + std::to_string(offset_);
+            std::cerr << "\n[UDS] ⚠️  " << error_ << "\n";
+            return false;
+        }
+        
+        // Build UDS 0x36 payload: [0x36] [block_sequence: 1 byte] [data: N bytes]
+        size_t length = static_cast<size_t>(std::min<uint64_t>(block_size_, file_size_ - offset_));
+        payload.resize(2 + length);
+        payload[0] = static_cast<uint8_t>(UDSService::TRANSFER_DATA);
+        payload[1] = sequence_;
+        if (!preadFull(fd_, payload.data() + 2, length, offset_)) {
+            error_ = std::string("Failed to read Zone Package: ") + strerror(errno);
+            std::cerr << "\n[UDS] ✗ " << error_ << "\n";
+            return false;
+        }
+        
+        auto response = client_.sendDiagnosticMessage(payload[0], payload);
+        
+        // Lost block: resend the same bytes with the same counter (the ZGW
+        // acknowledges a repeated counter without writing twice)
+        for (int retry = 0; response.empty() && retry < UDS_TRANSFER_BLOCK_RETRIES; retry++) {
+            stats_.block_retries++;
+            response = client_.sendDiagnosticMessage(payload[0], payload);
+        }
+        
+        if (response.empty()) {
+            // Smaller blocks after a loss; the next good run grows them back
+            block_size_ = std::max(block_size_ / 2, std::min<size_t>(UDS_TRANSFER_MIN_BLOCK, block_limit_));
+            good_blocks = 0;
+            std::cerr << "\n[UDS] ⚠️  No response to block " << (int)sequence_ << " at byte " << offset_
+                      << ", reconnecting\n";
+            if (!recover()) {
+                return false;
+            }
+            continue;
+        }
+        
+        if (response[0] != 0x76) {  // 0x76 = positive response to 0x36
+            error_ = "Transfer Data failed at block " + std::to_string(sequence_);
+            if (isNegative(response, payload[0])) {
+                char nrc[8];
+                snprintf(nrc, sizeof(nrc), "0x%02X", response[2]);
+                error_ += std::string(" (NRC ") + nrc + ")";
+            }
+            std::cerr << "\n[UDS] ✗ " << error_ << "\n";
+            return false;
+        }
+        
+        offset_ += length;
+        sequence_++;            // Wraps 0xFF → 0x00
+        stats_.bytes += length;
+        stats_.blocks++;
+        
+        if (++good_blocks >= UDS_TRANSFER_GROW_AFTER && block_size_ < block_limit_) {
+            block_size_ = std::min(block_size_ * 2, block_limit_);
+            good_blocks = 0;
+        }
+        
+        if (offset_ - persisted_offset_ >= UDS_CHECKPOINT_INTERVAL_BYTES) {
+            saveCheckpoint();
+        }
+        
+        uint8_t progress = static_cast<uint8_t>((offset_ * 100) / file_size_);
+        std::cout << "[UDS] Progress: " << (int)progress << "% (" << offset_ << "/" << file_size_
+                  << " bytes)\r" << std::flush;
+    }
+    
+    std::cout << "\n[UDS] ✓ All data blocks transferred\n";
+    return true;
+}
+
+bool UdsZoneTransfer::recover() {
+    saveCheckpoint();
+    
+    uint32_t delay_ms = UDS_TRANSFER_RECONNECT_DELAY_MS;
+    for (int attempt = 1; attempt <= UDS_TRANSFER_RECONNECT_ATTEMPTS; attempt++, delay_ms *= 2) {
+        if (cancelled()) {
+            error_ = "Transfer cancelled at byte " + std::to_string(offset_);
+            std::cerr << "[UDS] ⚠️  " << error_ << "\n";
+            return false;
+        }
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        stats_.reconnects++;
+        client_.disconnect();
+        if (!client_.connect()) {
+            std::cerr << "[UDS] ⚠️  Reconnect " << attempt << "/" << UDS_TRANSFER_RECONNECT_ATTEMPTS
+                      << " to ZGW " << zgw_ << " failed\n";
+            continue;
+        }
+        
+        // A 0x38 transfer asks the ZGW where it stands; 0x34 starts over
+        RequestResult result = start(using_file_transfer_);
+        if (result == RequestResult::ACCEPTED) {
+            return true;
+        }
+        if (result != RequestResult::NO_RESPONSE) {
+            error_ = "ZGW refused to continue the transfer";
+            return false;
+        }
+    }
+    
+    error_ = "ZGW " + zgw_ + " unreachable after " + std::to_string(UDS_TRANSFER_RECONNECT_ATTEMPTS) +
+             " reconnect attempts";
+    std::cerr << "[UDS] ✗ " << error_ << "\n";
+    return false;
+}
+
+bool UdsZoneTransfer::exitTransfer() {
+    std::vector<uint8_t> payload;
+    payload.push_back(static_cast<uint8_t>(UDSService::REQUEST_TRANSFER_EXIT));
+    
+    auto response = client_.sendDiagnosticMessage(payload[0], payload);
+    if (response.empty()) {
+        // Exit lost with the link: re-open (a resumed file has nothing left to send)
+        std::cerr << "[UDS] ⚠️  No response to Request Transfer Exit, reconnecting\n";
+        if (!recover() || !sendBlocks()) {
+            return false;
+        }
+        response = client_.sendDiagnosticMessage(payload[0], payload);
+    }
+    
+    if (response.empty() || response[0] != 0x77) {  // 0x77 = positive response to 0x37
+        error_ = "Transfer Exit failed";
+        std::cerr << "[UDS] ✗ " << error_ << "\n";
+        return false;
+    }
+    
+    std::cout << "[UDS] ✓ Transfer Exit accepted\n";
+    return true;
+}
+
+// ==================== Checkpoints ====================
+
+void UdsZoneTransfer::saveCheckpoint() {
+    if (!using_file_transfer_ || !checkpoints_ || offset_ == 0 || offset_ == persisted_offset_) {
+        return;
+    }
+    
+    UdsTransferCheckpoint checkpoint;
+    checkpoint.zgw = zgw_;
+    checkpoint.zone_id = zone_id_;
+    checkpoint.ecu_id = ecuAt(offset_);
+    checkpoint.file_size = file_size_;
+    checkpoint.zone_crc32 = zone_crc32_;
+    checkpoint.data_format = data_format_;
+    checkpoint.offset = offset_;
+    checkpoint.block_sequence = static_cast<uint8_t>(sequence_ - 1);
+    checkpoint.updated_at = static_cast<uint64_t>(std::time(nullptr));
+    
+    if (checkpoints_->record(checkpoint)) {
+        persisted_offset_ = offset_;
+    }
+}
+
+const std::string& UdsZoneTransfer::ecuAt(uint64_t offset) const {
+    static const std::string none;
+    for (const auto& range : ecu_ranges_) {
+        if (offset >= range.offset && offset < range.offset + range.size) {
+            return range.ecu_id;
+        }
+    }
+    return none;
+}
+
+bool UdsZoneTransfer::cancelled() {
+    return cancel_ && !cancel_->waitWhilePaused();
+}
@@ -0,0 +1,306 @@
+/**
+ * @file update_planner.cpp
+ * @brief VCI-driven Selective Vehicle OTA Planning Implementation
+ */
+
+#include "update_planner.hpp"
+#include "crc32.hpp"
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ==================== Helpers ====================
+
+static std::string versionToString(uint32_t version) {
+    return "v" + std::to_string((version >> 16) & 0xFF) + "." +
+           std::to_string((version >> 8) & 0xFF) + "." +
+           std::to_string(version & 0xFF);
+}
+
+static bool writeAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool parseVersionString(const std::string& text, uint32_t& version) {
+    size_t pos = 0;
+    if (pos < text.size() && (text[pos] == 'v' || text[pos] == 'V')) {
+        pos++;
+    }
+    
+    // Up to three numeric parts; anything after them ("-20241117") is ignored
+    uint32_t parts[3] = {0, 0, 0};
+    size_t count = 0;
+    while (count < 3) {
+        size_t start = pos;
+        uint32_t value = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            value = value * 10 + static_cast<uint32_t>(text[pos] - '0');
+            if (value > 0xFF) {
+                return false;
+            }
+            pos++;
+        }
+        if (pos == start) {
+            return false;
+        }
+        parts[count++] = value;
+        
+        if (pos >= text.size() || text[pos] != '.') {
+            break;
+        }
+        pos++;
+    }
+    
+    version = (parts[0] << 16) | (parts[1] << 8) | parts[2];
+    return true;
+}
+
+// ==================== Update Plan ====================
+
+const ECUUpdateDecision* UpdatePlan::findECU(std::string_view ecu_id) const {
+    for (const ECUUpdateDecision& ecu : ecus) {
+        if (ecu.ecu_id == ecu_id) {
+            return &ecu;
+        }
+    }
+    return nullptr;
+}
+
+bool UpdatePlan::ecuSkipped(std::string_view ecu_id) const {
+    const ECUUpdateDecision* ecu = selective ? findECU(ecu_id) : nullptr;
+    return ecu && !ecu->update;     // Not referenced in the metadata: update
+}
+
+size_t UpdatePlan::selectedZoneCount() const {
+    return static_cast<size_t>(std::count(zones.begin(), zones.end(), true));
+}
+
+size_t UpdatePlan::updatedECUCount() const {
+    return static_cast<size_t>(std::count_if(ecus.begin(), ecus.end(),
+        [](const ECUUpdateDecision& ecu) { return ecu.update; }));
+}
+
+// ==================== Zone Package Subset ====================
+
+bool writeZonePackageSubset(const ZonePackageView& zone, const UpdatePlan& plan,
+                            const std::string& output_path) {
+    if (!zone.isValid()) {
+        std::cerr << "[UpdatePlan] ✗ Cannot write subset: " << zone.getError() << "\n";
+        return false;
+    }
+    
+    std::vector<size_t> order;
+    for (size_t i = 0; i < zone.ecuCount(); i++) {
+        if (!plan.ecuSkipped(zone.ecuId(i))) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return zone.ecus()[a].offset < zone.ecus()[b].offset;
+    });
+    
+    int fd = ::open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[UpdatePlan] ✗ Failed to create " << output_path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    
+    // Header is written last, once offsets and CRCs are known
+    ZonePackageHeader header = zone.header();
+    std::memset(header.ecu_table, 0, sizeof(header.ecu_table));
+    header.package_count = static_cast<uint8_t>(order.size());
+    bool ok = ::lseek(fd, sizeof(ZonePackageHeader), SEEK_SET) == static_cast<off_t>(sizeof(ZonePackageHeader));
+    
+    uint64_t offset = sizeof(ZonePackageHeader);
+    uint32_t zone_crc = 0;
+    for (size_t slot = 0; ok && slot < order.size(); slot++) {
+        const ZoneECUEntry& entry = zone.ecus()[order[slot]];
+        ok = writeAll(fd, zone.data() + entry.offset, entry.size);
+        
+        // ECU Package bytes are unchanged, so the verified ECU CRC carries over
+        ZoneECUEntry& out = header.ecu_table[slot];
+        out = entry;
+        out.offset = static_cast<uint32_t>(offset);
+        zone_crc = crc32Combine(zone_crc, entry.crc32, entry.size);
+        offset += entry.size;
+    }
+    
+    if (ok) {
+        header.total_size = static_cast<uint32_t>(offset);
+        header.zone_crc32 = zone_crc;
+        ok = ::pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    }
+    
+    if (::close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        std::cerr << "[UpdatePlan] ✗ Failed to write " << output_path << ": " << strerror(errno) << "\n";
+        ::unlink(output_path.c_str());
+        return false;
+    }
+    
+    std::cout << "[UpdatePlan] ✓ " << zone.zoneId() << ": " << order.size() << "/" << zone.ecuCount()
+              << " ECUs kept (" << zone.totalSize() << " -> " << offset << " bytes)\n";
+    return true;
+}
+
+// ==================== Constructor ====================
+
+UpdatePlanner::UpdatePlanner() {
+    plan_.selective = false;
+    plan_.package_bytes = 0;
+    plan_.download_bytes = 0;
+}
+
+// ==================== Planning ====================
+
+void UpdatePlanner::selectAll(const VehiclePackageMetadata& metadata, const std::string& reason) {
+    plan_.selective = false;
+    plan_.reason = reason;
+    plan_.zones.assign(metadata.zone_count, true);
+    plan_.download_bytes = metadata.total_size;
+    for (ECUUpdateDecision& ecu : plan_.ecus) {
+        ecu.update = true;
+    }
+}
+
+bool UpdatePlanner::build(const VehiclePackageMetadata& metadata, const nlohmann::json& vci) {
+    plan_ = UpdatePlan();
+    plan_.selective = false;
+    plan_.package_bytes = metadata.total_size;
+    plan_.download_bytes = metadata.total_size;
+    zone_ids_.clear();
+    zone_numbers_.clear();
+    
+    if (metadata.magic_number != VEHICLE_PACKAGE_MAGIC || metadata.zone_count > MAX_ZONES_IN_VEHICLE ||
+        metadata.total_size < sizeof(VehiclePackageMetadata)) {
+        std::cerr << "[UpdatePlan] ✗ Invalid Vehicle Package metadata\n";
+        return false;
+    }
+    
+    for (uint8_t z = 0; z < metadata.zone_count; z++) {
+        const ZoneReference& ref = metadata.zone_refs[z];
+        zone_ids_.push_back(std::string(fixedStringView(ref.zone_id, sizeof(ref.zone_id))));
+        zone_numbers_.push_back(ref.zone_number);
+    }
+    
+    // Installed versions from the VCI snapshot
+    std::map<std::string, uint32_t> installed;
+    if (vci.is_object() && vci.contains("ecus") && vci["ecus"].is_array()) {
+        for (const auto& ecu : vci["ecus"]) {
+            uint32_t version = 0;
+            if (ecu.contains("ecu_id") && ecu["ecu_id"].is_string() &&
+                ecu.contains("sw_version") && ecu["sw_version"].is_string() &&
+                parseVersionString(ecu["sw_version"].get<std::string>(), version)) {
+                installed[ecu["ecu_id"].get<std::string>()] = version;
+            }
+        }
+    }
+    
+    // ECU references; a zone is needed if one of its ECUs is
+    std::vector<bool> needed(metadata.zone_count, false);
+    std::vector<unsigned> referenced(metadata.zone_count, 0);
+    bool references_valid = metadata.total_ecu_count > 0;
+    
+    for (unsigned i = 0; i < metadata.total_ecu_count; i++) {
+        const ECUReference& ref = metadata.ecu_refs[i];
+        
+        ECUUpdateDecision ecu;
+        ecu.ecu_id = std::string(fixedStringView(ref.ecu_id, sizeof(ref.ecu_id)));
+        ecu.zone_number = ref.zone_number;
+        ecu.target_version = ref.firmware_version;
+        auto it = installed.find(ecu.ecu_id);
+        ecu.installed_known = it != installed.end();
+        ecu.installed_version = ecu.installed_known ? it->second : 0;
+        ecu.update = !ecu.installed_known || ecu.installed_version != ecu.target_version;
+        plan_.ecus.push_back(ecu);
+        
+        auto zone = std::find(zone_numbers_.begin(), zone_numbers_.end(), ref.zone_number);
+        if (ecu.ecu_id.empty() || zone == zone_numbers_.end()) {
+            references_valid = false;
+            continue;
+        }
+        size_t z = static_cast<size_t>(zone - zone_numbers_.begin());
+        referenced[z]++;
+        if (ecu.update) {
+            needed[z] = true;
+        }
+    }
+    
+    if (installed.empty()) {
+        selectAll(metadata, "no VCI snapshot");
+        return true;
+    }
+    if (!references_valid) {
+        selectAll(metadata, "package has no valid ECU references");
+        return true;
+    }
+    
+    plan_.selective = true;
+    plan_.zones = needed;
+    plan_.download_bytes = sizeof(VehiclePackageMetadata);
+    for (uint8_t z = 0; z < metadata.zone_count; z++) {
+        // ECUs missing from the reference table cannot be compared: send the zone
+        if (referenced[z] != metadata.zone_refs[z].ecu_count) {
+            std::cout << "[UpdatePlan] ⚠ " << zone_ids_[z] << ": " << referenced[z] << " of "
+                      << (int)metadata.zone_refs[z].ecu_count << " ECUs referenced, sending whole zone\n";
+            plan_.zones[z] = true;
+        }
+        if (plan_.zones[z]) {
+            plan_.download_bytes += metadata.zone_refs[z].size;
+        }
+    }
+    
+    return true;
+}
+
+// ==================== Plan ====================
+
+void UpdatePlanner::printPlan() const {
+    std::cout << "\n";
+    std::cout << "========================================\n";
+    std::cout << "  Update Plan (package vs VCI)\n";
+    std::cout << "========================================\n";
+    
+    if (!plan_.selective) {
+        std::cout << "Full update: " << plan_.reason << "\n";
+        std::cout << "========================================\n\n";
+        return;
+    }
+    
+    for (size_t z = 0; z < zone_ids_.size(); z++) {
+        std::cout << "  Zone " << (int)zone_numbers_[z] << " (" << zone_ids_[z] << "): "
+                  << (plan_.zones[z] ? "download" : "skip (up to date)") << "\n";
+        
+        for (const ECUUpdateDecision& ecu : plan_.ecus) {
+            if (ecu.zone_number != zone_numbers_[z]) {
+                continue;
+            }
+            std::cout << "    " << ecu.ecu_id << ": "
+                      << (ecu.installed_known ? versionToString(ecu.installed_version) : std::string("unknown"))
+                      << " -> " << versionToString(ecu.target_version)
+                      << (ecu.update ? " (update)" : " (skip)") << "\n";
+        }
+    }
+    
+    std::cout << "ECUs to update: " << plan_.updatedECUCount() << "/" << plan_.ecus.size()
+              << ", zones: " << plan_.selectedZoneCount() << "/" << zone_ids_.size() << "\n";
+    std::cout << "Download: " << plan_.download_bytes << " of " << plan_.package_bytes << " bytes\n";
+    std::cout << "========================================\n\n";
+}
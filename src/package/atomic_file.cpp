@@ -0,0 +1,55 @@
+/**
+ * @file atomic_file.cpp
+ * @brief Crash-safe File Replacement Implementation
+ */
+
+#include "atomic_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool writeFileAtomic(const std::string& path, const std::string& content, std::string& error) {
+    std::string temp_path = path + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = "Failed to create " + temp_path + ": " + strerror(errno);
+        return false;
+    }
+    
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t n = ::write(fd, content.data() + written, content.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error = "Failed to write " + temp_path + ": " + strerror(errno);
+            ::close(fd);
+            ::unlink(temp_path.c_str());
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    
+    if (::fsync(fd) != 0 || ::close(fd) != 0) {
+        error = "Failed to sync " + temp_path + ": " + strerror(errno);
+        ::unlink(temp_path.c_str());
+        return false;
+    }
+    
+    if (::rename(temp_path.c_str(), path.c_str()) != 0) {
+        error = "Failed to replace " + path + ": " + strerror(errno);
+        ::unlink(temp_path.c_str());
+        return false;
+    }
+    
+    // The rename lives in the directory; best effort, the new content is already synced
+    std::string dir = path.substr(0, path.find_last_of('/') + 1);
+    int dir_fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file crc32.cpp
+ * @brief CRC32 Kernels and Runtime Dispatch
+ *
+ * PCLMUL folding follows Intel "Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction" (bit-reflected constants for 0x04C11DB7).
+ */
+
+#include "crc32.hpp"
+#include <cstring>
+#include <zlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC32_HAVE_X86_PCLMUL 1
+#endif
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CRC32_HAVE_ARMV8_CRC 1
+#endif
+
+// ==================== Portable Kernel ====================
+
+static uint32_t crc32Portable(uint32_t crc, const uint8_t* data, size_t size) {
+    // zlib takes uInt lengths; feed very large buffers in pieces
+    while (size > 0) {
+        uInt n = static_cast<uInt>(size > 0x40000000 ? 0x40000000 : size);
+        crc = crc32(crc, data, n);
+        data += n;
+        size -= n;
+    }
+    return crc;
+}
+
+// ==================== x86-64 PCLMULQDQ Kernel ====================
+
+#ifdef CRC32_HAVE_X86_PCLMUL
+
+/**
+ * @brief Fold 16-byte blocks with carry-less multiply
+ * @param state Inverted CRC state (~crc)
+ * @param data Input (size >= 64, multiple of 16)
+ * @return Inverted CRC state
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32FoldPclmul(uint32_t state, const uint8_t* data, size_t size) {
+    alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+    
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+    
+    // Load first 64 bytes and inject the CRC state
+    x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+    x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+    x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(state)));
+    
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    data += 64;
+    size -= 64;
+    
+    // Fold 4 x 128 bits in parallel
+    while (size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        
+        y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+        y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+        y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+        y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+        
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+        
+        data += 64;
+        size -= 64;
+    }
+    
+    // Fold 512 bits into 128 bits
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+    
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+    
+    // Fold remaining 16-byte blocks
+    while (size >= 16) {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        
+        data += 16;
+        size -= 16;
+    }
+    
+    // Fold 128 bits to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+    
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+static uint32_t crc32X86(uint32_t crc, const uint8_t* data, size_t size) {
+    if (size >= 64) {
+        size_t folded = size & ~static_cast<size_t>(15);
+        crc = ~crc32FoldPclmul(~crc, data, folded);
+        data += folded;
+        size -= folded;
+    }
+    return size > 0 ? crc32Portable(crc, data, size) : crc;
+}
+
+#endif // CRC32_HAVE_X86_PCLMUL
+
+// ==================== AArch64 CRC32 Kernel ====================
+
+#ifdef CRC32_HAVE_ARMV8_CRC
+
+__attribute__((target("+crc")))
+static uint32_t crc32Arm(uint32_t crc, const uint8_t* data, size_t size) {
+    crc = ~crc;
+    
+    // Align to 8 bytes
+    while (size > 0 && (reinterpret_cast<uintptr_t>(data) & 7) != 0) {
+        crc = __crc32b(crc, *data++);
+        size--;
+    }
+    
+    while (size >= 32) {
+        uint64_t v0, v1, v2, v3;
+        std::memcpy(&v0, data, 8);
+        std::memcpy(&v1, data + 8, 8);
+        std::memcpy(&v2, data + 16, 8);
+        std::memcpy(&v3, data + 24, 8);
+        crc = __crc32d(crc, v0);
+        crc = __crc32d(crc, v1);
+        crc = __crc32d(crc, v2);
+        crc = __crc32d(crc, v3);
+        data += 32;
+        size -= 32;
+    }
+    
+    while (size >= 8) {
+        uint64_t v;
+        std::memcpy(&v, data, 8);
+        crc = __crc32d(crc, v);
+        data += 8;
+        size -= 8;
+    }
+    
+    while (size > 0) {
+        crc = __crc32b(crc, *data++);
+        size--;
+    }
+    
+    return ~crc;
+}
+
+#endif // CRC32_HAVE_ARMV8_CRC
+
+// ==================== Runtime Dispatch ====================
+
+using CRC32Function = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+
+static CRC32Function kernelFunction(CRC32Kernel kernel) {
+    switch (kernel) {
+#ifdef CRC32_HAVE_X86_PCLMUL
+        case CRC32Kernel::X86_PCLMUL:
+            return crc32X86;
+#endif
+#ifdef CRC32_HAVE_ARMV8_CRC
+        case CRC32Kernel::ARMV8_CRC:
+            return crc32Arm;
+#endif
+        default:
+            return crc32Portable;
+    }
+}
+
+bool crc32KernelSupported(CRC32Kernel kernel) {
+    switch (kernel) {
+        case CRC32Kernel::PORTABLE:
+            return true;
+#ifdef CRC32_HAVE_X86_PCLMUL
+        case CRC32Kernel::X86_PCLMUL:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+#ifdef CRC32_HAVE_ARMV8_CRC
+        case CRC32Kernel::ARMV8_CRC:
+            return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif
+        default:
+            return false;
+    }
+}
+
+CRC32Kernel crc32SelectedKernel() {
+    static const CRC32Kernel selected = []() {
+        if (crc32KernelSupported(CRC32Kernel::X86_PCLMUL)) {
+            return CRC32Kernel::X86_PCLMUL;
+        }
+        if (crc32KernelSupported(CRC32Kernel::ARMV8_CRC)) {
+            return CRC32Kernel::ARMV8_CRC;
+        }
+        return CRC32Kernel::PORTABLE;
+    }();
+    return selected;
+}
+
+const char* crc32KernelName(CRC32Kernel kernel) {
+    switch (kernel) {
+        case CRC32Kernel::X86_PCLMUL:
+            return "x86-pclmul";
+        case CRC32Kernel::ARMV8_CRC:
+            return "armv8-crc";
+        default:
+            return "portable";
+    }
+}
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size) {
+    static const CRC32Function function = kernelFunction(crc32SelectedKernel());
+    return function(crc, data, size);
+}
+
+uint32_t crc32UpdateWith(CRC32Kernel kernel, uint32_t crc, const uint8_t* data, size_t size) {
+    if (!crc32KernelSupported(kernel)) {
+        kernel = CRC32Kernel::PORTABLE;
+    }
+    return kernelFunction(kernel)(crc, data, size);
+}
+
+uint32_t crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t length2) {
+    return crc32_combine(crc1, crc2, static_cast<z_off_t>(length2));
+}
@@ -0,0 +1,374 @@
+/**
+ * @file ecu_compression.cpp
+ * @brief zstd ECU Payload Codec and Zone Package Expansion
+ */
+
+#include "ecu_compression.hpp"
+#include "crc32.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef VMG_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// ==================== Helpers ====================
+
+static bool writeAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool ecuCompressionAvailable(uint8_t compression) {
+    switch (compression) {
+        case ECU_COMPRESSION_NONE:
+            return true;
+        case ECU_COMPRESSION_ZSTD:
+#ifdef VMG_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* ecuCompressionName(uint8_t compression) {
+    switch (compression) {
+        case ECU_COMPRESSION_NONE: return "none";
+        case ECU_COMPRESSION_ZSTD: return "zstd";
+        default:                   return "unknown";
+    }
+}
+
+bool zoneHasCompressedECUs(const ZonePackageView& zone) {
+    for (const ZoneECUEntry& entry : zone.ecus()) {
+        if (entry.compression != ECU_COMPRESSION_NONE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ==================== Decoder ====================
+
+#ifdef VMG_HAVE_ZSTD
+
+ZstdStreamDecoder::ZstdStreamDecoder(unsigned window_log_max)
+    : dctx_(ZSTD_createDCtx()), buffer_(ZSTD_DStreamOutSize()) {
+    if (dctx_) {
+        ZSTD_DCtx_setParameter(static_cast<ZSTD_DCtx*>(dctx_), ZSTD_d_windowLogMax,
+                               static_cast<int>(std::clamp<unsigned>(window_log_max, ECU_ZSTD_WINDOW_LOG_MIN,
+                                                                     ECU_ZSTD_WINDOW_LOG_MAX)));
+    }
+}
+
+ZstdStreamDecoder::~ZstdStreamDecoder() {
+    ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(dctx_));
+}
+
+bool ZstdStreamDecoder::decompress(const uint8_t* data, size_t size, uint64_t expected_size,
+                                   const ZstdSink& sink) {
+    ZSTD_DCtx* dctx = static_cast<ZSTD_DCtx*>(dctx_);
+    if (!dctx) {
+        error_ = "Failed to create zstd decoder";
+        return false;
+    }
+    ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+    
+    ZSTD_inBuffer input = {data, size, 0};
+    uint64_t produced = 0;
+    
+    while (true) {
+        ZSTD_outBuffer output = {buffer_.data(), buffer_.size(), 0};
+        size_t result = ZSTD_decompressStream(dctx, &output, &input);
+        if (ZSTD_isError(result)) {
+            error_ = ZSTD_getErrorName(result);
+            return false;
+        }
+        
+        if (output.pos > 0) {
+            produced += output.pos;
+            if (produced > expected_size) {
+                error_ = "Decoded firmware larger than expected";
+                return false;
+            }
+            if (!sink(buffer_.data(), output.pos)) {
+                error_ = "Output rejected";
+                return false;
+            }
+        }
+        
+        if (result == 0) {
+            break;      // Frame complete
+        }
+        if (input.pos == input.size && output.pos < output.size) {
+            error_ = "Truncated zstd frame";
+            return false;
+        }
+    }
+    
+    if (input.pos != input.size) {
+        error_ = "Trailing data after zstd frame";
+        return false;
+    }
+    if (produced != expected_size) {
+        error_ = "Decoded firmware smaller than expected";
+        return false;
+    }
+    
+    error_.clear();
+    return true;
+}
+
+#else
+
+ZstdStreamDecoder::ZstdStreamDecoder(unsigned) : dctx_(nullptr) {
+}
+
+ZstdStreamDecoder::~ZstdStreamDecoder() {
+}
+
+bool ZstdStreamDecoder::decompress(const uint8_t*, size_t, uint64_t, const ZstdSink&) {
+    error_ = "Built without zstd support";
+    return false;
+}
+
+#endif
+
+// ==================== Encoder ====================
+
+#ifdef VMG_HAVE_ZSTD
+
+ZstdStreamEncoder::ZstdStreamEncoder(int level, unsigned window_log)
+    : cctx_(ZSTD_createCCtx()), level_(level),
+      window_log_(std::clamp<unsigned>(window_log, ECU_ZSTD_WINDOW_LOG_MIN, ECU_ZSTD_WINDOW_LOG_MAX)),
+      frame_window_log_(0), buffer_(ZSTD_CStreamOutSize()) {
+}
+
+ZstdStreamEncoder::~ZstdStreamEncoder() {
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(cctx_));
+}
+
+uint64_t ZstdStreamEncoder::compressBound(uint64_t size) {
+    return ZSTD_compressBound(static_cast<size_t>(size));
+}
+
+bool ZstdStreamEncoder::begin(uint64_t content_size) {
+    ZSTD_CCtx* cctx = static_cast<ZSTD_CCtx*>(cctx_);
+    if (!cctx) {
+        error_ = "Failed to create zstd encoder";
+        return false;
+    }
+    
+    // Smallest window covering the content keeps the decoder's memory down
+    unsigned log = ECU_ZSTD_WINDOW_LOG_MIN;
+    while (log < window_log_ && (uint64_t(1) << log) < content_size) {
+        log++;
+    }
+    frame_window_log_ = static_cast<uint8_t>(log);
+    
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+    size_t result = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level_);
+    if (!ZSTD_isError(result)) {
+        result = ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, static_cast<int>(log));
+    }
+    if (!ZSTD_isError(result)) {
+        result = ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+    }
+    if (!ZSTD_isError(result)) {
+        result = ZSTD_CCtx_setPledgedSrcSize(cctx, content_size);
+    }
+    if (ZSTD_isError(result)) {
+        error_ = ZSTD_getErrorName(result);
+        return false;
+    }
+    return true;
+}
+
+bool ZstdStreamEncoder::compress(const uint8_t* data, size_t size, bool last, const ZstdSink& sink) {
+    ZSTD_CCtx* cctx = static_cast<ZSTD_CCtx*>(cctx_);
+    ZSTD_inBuffer input = {data, size, 0};
+    ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+    
+    while (true) {
+        ZSTD_outBuffer output = {buffer_.data(), buffer_.size(), 0};
+        size_t remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
+        if (ZSTD_isError(remaining)) {
+            error_ = ZSTD_getErrorName(remaining);
+            return false;
+        }
+        if (output.pos > 0 && !sink(buffer_.data(), output.pos)) {
+            error_ = "Output rejected";
+            return false;
+        }
+        
+        // continue: done once the input is consumed; end: once the frame is flushed
+        if (last ? remaining == 0 : input.pos == input.size) {
+            return true;
+        }
+    }
+}
+
+#else
+
+ZstdStreamEncoder::ZstdStreamEncoder(int level, unsigned window_log)
+    : cctx_(nullptr), level_(level), window_log_(window_log), frame_window_log_(0) {
+}
+
+ZstdStreamEncoder::~ZstdStreamEncoder() {
+}
+
+uint64_t ZstdStreamEncoder::compressBound(uint64_t size) {
+    return size + (size >> 8) + 1024;
+}
+
+bool ZstdStreamEncoder::begin(uint64_t) {
+    error_ = "Built without zstd support";
+    return false;
+}
+
+bool ZstdStreamEncoder::compress(const uint8_t*, size_t, bool, const ZstdSink&) {
+    error_ = "Built without zstd support";
+    return false;
+}
+
+#endif
+
+// ==================== Zone Package Expansion ====================
+
+bool expandZonePackage(const ZonePackageView& zone, const std::string& output_path,
+                       unsigned window_log_max) {
+    if (!zone.isValid()) {
+        std::cerr << "[ZonePackage] ✗ Cannot expand: " << zone.getError() << "\n";
+        return false;
+    }
+    
+    for (const ZoneECUEntry& entry : zone.ecus()) {
+        if (!ecuCompressionAvailable(entry.compression)) {
+            std::cerr << "[ZonePackage] ✗ " << fixedStringView(entry.ecu_id, sizeof(entry.ecu_id))
+                      << ": " << ecuCompressionName(entry.compression) << " firmware not supported by this build\n";
+            return false;
+        }
+        if (entry.compression != ECU_COMPRESSION_NONE && entry.window_log > window_log_max) {
+            std::cerr << "[ZonePackage] ✗ " << fixedStringView(entry.ecu_id, sizeof(entry.ecu_id))
+                      << ": zstd window 2^" << (int)entry.window_log << " exceeds limit 2^"
+                      << window_log_max << "\n";
+            return false;
+        }
+    }
+    
+    int fd = ::open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[ZonePackage] ✗ Failed to create " << output_path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    
+    // Header is rewritten last, once offsets and CRCs are known
+    ZonePackageHeader header = zone.header();
+    bool ok = ::lseek(fd, sizeof(ZonePackageHeader), SEEK_SET) == static_cast<off_t>(sizeof(ZonePackageHeader));
+    
+    std::vector<size_t> order(zone.ecuCount());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return zone.ecus()[a].offset < zone.ecus()[b].offset;
+    });
+    
+    ZstdStreamDecoder decoder(window_log_max);
+    uint64_t offset = sizeof(ZonePackageHeader);
+    uint32_t zone_crc = 0;
+    
+    for (size_t i : order) {
+        if (!ok) {
+            break;
+        }
+        
+        ECUPackageView ecu = zone.ecuPackage(i);
+        const ZoneECUEntry& entry = *ecu.entry;
+        ZoneECUEntry& out = header.ecu_table[i];
+        
+        // Metadata block is copied as is
+        const uint8_t* metadata = reinterpret_cast<const uint8_t*>(ecu.metadata);
+        uint32_t package_crc = crc32Update(0, metadata, entry.metadata_size);
+        uint32_t image_crc = 0;
+        uint64_t image_size = 0;
+        ok = writeAll(fd, metadata, entry.metadata_size);
+        
+        auto sink = [&](const uint8_t* data, size_t size) {
+            image_crc = crc32Update(image_crc, data, size);
+            image_size += size;
+            return writeAll(fd, data, size);
+        };
+        
+        if (ok && entry.compression == ECU_COMPRESSION_NONE) {
+            ok = sink(ecu.firmware, ecu.firmware_size);
+        } else if (ok && !decoder.decompress(ecu.firmware, ecu.firmware_size, entry.uncompressed_size, sink)) {
+            std::cerr << "[ZonePackage] ✗ " << ecu.ecuId() << ": zstd decode failed: " << decoder.getError() << "\n";
+            ok = false;
+        }
+        if (!ok) {
+            break;
+        }
+        
+        if (image_size != ecu.metadata->firmware_size || image_crc != ecu.metadata->firmware_crc32) {
+            std::cerr << "[ZonePackage] ✗ " << ecu.ecuId() << ": firmware image CRC32 mismatch after decompression\n";
+            ok = false;
+            break;
+        }
+        
+        uint64_t size = uint64_t(entry.metadata_size) + image_size;
+        package_crc = crc32Combine(package_crc, image_crc, image_size);
+        
+        out.offset = static_cast<uint32_t>(offset);
+        out.size = static_cast<uint32_t>(size);
+        out.firmware_size = static_cast<uint32_t>(image_size);
+        out.crc32 = package_crc;
+        out.compression = ECU_COMPRESSION_NONE;
+        out.window_log = 0;
+        out.uncompressed_size = 0;
+        
+        zone_crc = crc32Combine(zone_crc, package_crc, size);
+        offset += size;
+        
+        if (offset > UINT32_MAX) {
+            std::cerr << "[ZonePackage] ✗ Expanded Zone Package exceeds 4GB\n";
+            ok = false;
+        }
+    }
+    
+    if (ok) {
+        header.total_size = static_cast<uint32_t>(offset);
+        header.zone_crc32 = zone_crc;
+        ok = ::pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    }
+    
+    if (::close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        std::cerr << "[ZonePackage] ✗ Failed to expand " << zone.zoneId() << " into " << output_path << "\n";
+        ::unlink(output_path.c_str());
+        return false;
+    }
+    
+    std::cout << "[ZonePackage] ✓ Expanded " << zone.zoneId() << ": " << zone.totalSize()
+              << " -> " << offset << " bytes\n";
+    return true;
+}
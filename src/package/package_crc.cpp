@@ -0,0 +1,128 @@
+/**
+ * @file package_crc.cpp
+ * @brief Streaming CRC32 Implementation
+ */
+
+#include "package_crc.hpp"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ==================== Helpers ====================
+
+/**
+ * @brief CRC32 of [offset, offset + length) of an open file
+ *
+ * pread() does not move the file offset, so several workers can share fd.
+ */
+static bool crcFileRange(int fd, uint64_t offset, uint64_t length, uint32_t& crc) {
+    std::vector<uint8_t> buffer(PACKAGE_CRC_BUFFER_SIZE);
+    uint32_t running = 0;
+    uint64_t position = offset;
+    uint64_t remaining = length;
+    
+    while (remaining > 0) {
+        size_t to_read = static_cast<size_t>(std::min<uint64_t>(remaining, buffer.size()));
+        ssize_t n = pread(fd, buffer.data(), to_read, position);
+        
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[CRC] ✗ Read error at offset " << position << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        
+        if (n == 0) {
+            std::cerr << "[CRC] ✗ Unexpected end of file at offset " << position
+                      << " (" << remaining << " bytes missing)\n";
+            return false;
+        }
+        
+        running = crc32Update(running, buffer.data(), static_cast<size_t>(n));
+        
+        // Already-hashed pages are not needed again; keep page cache small
+        posix_fadvise(fd, position, n, POSIX_FADV_DONTNEED);
+        
+        position += n;
+        remaining -= n;
+    }
+    
+    crc = running;
+    return true;
+}
+
+// ==================== Public API ====================
+
+unsigned resolveCRCThreadCount(unsigned requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+bool calculateFileCRC32(const std::string& file_path,
+                        uint64_t offset,
+                        uint64_t length,
+                        uint32_t& crc,
+                        unsigned thread_count) {
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[CRC] ✗ Failed to open " << file_path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    
+    // Sequential scan: let the kernel read ahead aggressively
+    posix_fadvise(fd, offset, length, POSIX_FADV_SEQUENTIAL);
+    
+    // Each worker needs a meaningful share of the range, otherwise thread
+    // start-up costs more than it saves
+    unsigned workers = resolveCRCThreadCount(thread_count);
+    uint64_t max_workers = std::max<uint64_t>(1, length / PACKAGE_CRC_PARALLEL_MIN_SIZE);
+    workers = static_cast<unsigned>(std::min<uint64_t>(workers, max_workers));
+    
+    if (workers <= 1) {
+        bool ok = crcFileRange(fd, offset, length, crc);
+        close(fd);
+        return ok;
+    }
+    
+    // Split into equal segments; the last one takes the remainder
+    uint64_t segment = length / workers;
+    std::vector<uint32_t> partial(workers, 0);
+    std::vector<uint64_t> sizes(workers, segment);
+    sizes[workers - 1] = length - segment * (workers - 1);
+    std::vector<char> results(workers, 0);
+    
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (unsigned i = 0; i < workers; i++) {
+        threads.emplace_back([&, i]() {
+            results[i] = crcFileRange(fd, offset + segment * i, sizes[i], partial[i]) ? 1 : 0;
+        });
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    close(fd);
+    
+    // Merge partial CRCs in file order
+    uint32_t combined = 0;
+    for (unsigned i = 0; i < workers; i++) {
+        if (!results[i]) {
+            return false;
+        }
+        combined = (i == 0) ? partial[0] : crc32Combine(combined, partial[i], sizes[i]);
+    }
+    
+    crc = combined;
+    return true;
+}
@@ -0,0 +1,237 @@
+/**
+ * @file package_index.cpp
+ * @brief Verified Package Index Implementation
+ */
+
+#include "package_index.hpp"
+#include "atomic_file.hpp"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <ctime>
+#include <sys/stat.h>
+
+// ==================== JSON Helpers ====================
+
+static nlohmann::json rangeToJson(const VerifiedRange& range) {
+    return {
+        {"id", range.id},
+        {"offset", range.offset},
+        {"size", range.size},
+        {"crc32", range.crc32},
+        {"firmware_crc32", range.firmware_crc32}
+    };
+}
+
+static VerifiedRange rangeFromJson(const nlohmann::json& j) {
+    VerifiedRange range;
+    range.id = j.at("id").get<std::string>();
+    range.offset = j.at("offset").get<uint64_t>();
+    range.size = j.at("size").get<uint64_t>();
+    range.crc32 = j.at("crc32").get<uint32_t>();
+    range.firmware_crc32 = j.value("firmware_crc32", 0u);
+    return range;
+}
+
+// ==================== Constructor ====================
+
+VerifiedPackageIndex::VerifiedPackageIndex(const std::string& index_path)
+    : index_path_(index_path) {
+}
+
+// ==================== Load / Save ====================
+
+bool VerifiedPackageIndex::load() {
+    entries_.clear();
+    
+    std::ifstream file(index_path_);
+    if (!file.is_open()) {
+        return true;    // No index yet
+    }
+    
+    try {
+        nlohmann::json index;
+        file >> index;
+        
+        if (index.value("version", 0) != PACKAGE_INDEX_VERSION) {
+            std::cout << "[PackageIndex] ⚠ Index version mismatch, starting empty\n";
+            return true;
+        }
+        
+        for (const auto& j : index.at("packages")) {
+            VerifiedPackageEntry entry;
+            entry.key.path = j.at("path").get<std::string>();
+            entry.key.size = j.at("size").get<uint64_t>();
+            entry.key.mtime_ns = j.at("mtime_ns").get<int64_t>();
+            entry.key.inode = j.at("inode").get<uint64_t>();
+            entry.key.expected_hash = j.at("expected_hash").get<std::string>();
+            entry.vehicle_crc32 = j.at("vehicle_crc32").get<uint32_t>();
+            entry.verified_at = j.value("verified_at", uint64_t(0));
+            
+            for (const auto& zone : j.at("zones")) {
+                entry.zones.push_back(rangeFromJson(zone));
+            }
+            for (const auto& ecu : j.at("ecus")) {
+                entry.ecus.push_back(rangeFromJson(ecu));
+            }
+            
+            entries_[entry.key.path] = entry;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[PackageIndex] ✗ Failed to read " << index_path_ << ": " << e.what() << "\n";
+        entries_.clear();
+        return false;
+    }
+    
+    return true;
+}
+
+bool VerifiedPackageIndex::save() const {
+    nlohmann::json packages = nlohmann::json::array();
+    for (const auto& [path, entry] : entries_) {
+        nlohmann::json zones = nlohmann::json::array();
+        nlohmann::json ecus = nlohmann::json::array();
+        for (const auto& zone : entry.zones) {
+            zones.push_back(rangeToJson(zone));
+        }
+        for (const auto& ecu : entry.ecus) {
+            ecus.push_back(rangeToJson(ecu));
+        }
+        
+        packages.push_back({
+            {"path", entry.key.path},
+            {"size", entry.key.size},
+            {"mtime_ns", entry.key.mtime_ns},
+            {"inode", entry.key.inode},
+            {"expected_hash", entry.key.expected_hash},
+            {"vehicle_crc32", entry.vehicle_crc32},
+            {"verified_at", entry.verified_at},
+            {"zones", zones},
+            {"ecus", ecus}
+        });
+    }
+    
+    nlohmann::json index;
+    index["version"] = PACKAGE_INDEX_VERSION;
+    index["packages"] = packages;
+    std::string content = index.dump(2);
+    
+    std::string error;
+    if (!writeFileAtomic(index_path_, content, error)) {
+        std::cerr << "[PackageIndex] ✗ " << error << "\n";
+        return false;
+    }
+    return true;
+}
+
+// ==================== Lookup / Record ====================
+
+bool VerifiedPackageIndex::statFile(const std::string& path, PackageFileKey& key) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    
+    key.path = path;
+    key.size = static_cast<uint64_t>(st.st_size);
+    key.mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    key.inode = static_cast<uint64_t>(st.st_ino);
+    return true;
+}
+
+const VerifiedPackageEntry* VerifiedPackageIndex::lookup(const std::string& package_path,
+                                                         const std::string& expected_hash,
+                                                         uint32_t vehicle_crc32) const {
+    auto it = entries_.find(package_path);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    
+    PackageFileKey current;
+    if (!statFile(package_path, current)) {
+        return nullptr;
+    }
+    
+    const VerifiedPackageEntry& entry = it->second;
+    if (current.size != entry.key.size ||
+        current.mtime_ns != entry.key.mtime_ns ||
+        current.inode != entry.key.inode ||
+        expected_hash != entry.key.expected_hash) {
+        return nullptr;
+    }
+    
+    if (vehicle_crc32 != 0 && vehicle_crc32 != entry.vehicle_crc32) {
+        return nullptr;
+    }
+    
+    return &entry;
+}
+
+bool VerifiedPackageIndex::record(const std::string& package_path, const std::string& expected_hash,
+                                  const VehiclePackageView& package, const PackageIntegrityReport& report) {
+    // A partial verification did not check vehicle_crc32 or the missing zones
+    if (!report.valid || report.partial || !package.isValid() || report.zones.size() != package.zoneCount()) {
+        std::cerr << "[PackageIndex] ✗ Refusing to record unverified package\n";
+        return false;
+    }
+    
+    VerifiedPackageEntry entry;
+    if (!statFile(package_path, entry.key)) {
+        std::cerr << "[PackageIndex] ✗ Cannot stat " << package_path << "\n";
+        return false;
+    }
+    entry.key.expected_hash = expected_hash;
+    entry.vehicle_crc32 = report.calculated_vehicle_crc;
+    entry.verified_at = static_cast<uint64_t>(std::time(nullptr));
+    
+    for (size_t z = 0; z < package.zoneCount(); z++) {
+        const ZoneReference& ref = package.zones()[z];
+        const ZoneIntegrityResult& zone_result = report.zones[z];
+        ZonePackageView zone = package.zonePackage(ref);
+        if (!zone.isValid() || zone_result.ecus.size() != zone.ecuCount()) {
+            std::cerr << "[PackageIndex] ✗ Report does not match zone " << zone_result.zone_id << "\n";
+            return false;
+        }
+        
+        entry.zones.push_back({zone_result.zone_id, ref.offset, ref.size, zone_result.calculated_crc, 0});
+        
+        for (size_t e = 0; e < zone.ecuCount(); e++) {
+            const ZoneECUEntry& ecu_entry = zone.ecus()[e];
+            const ECUIntegrityResult& ecu_result = zone_result.ecus[e];
+            entry.ecus.push_back({ecu_result.ecu_id,
+                                  uint64_t(ref.offset) + ecu_entry.offset,
+                                  ecu_entry.size,
+                                  ecu_result.calculated_package_crc,
+                                  ecu_result.calculated_firmware_crc});
+        }
+    }
+    
+    entries_[package_path] = entry;
+    
+    // Keep the index small: drop the oldest verifications (never the new one)
+    while (entries_.size() > PACKAGE_INDEX_MAX_ENTRIES) {
+        auto oldest = std::min_element(entries_.begin(), entries_.end(),
+            [&](const auto& a, const auto& b) {
+                if (a.first == package_path || b.first == package_path) {
+                    return b.first == package_path;
+                }
+                return a.second.verified_at < b.second.verified_at;
+            });
+        entries_.erase(oldest);
+    }
+    
+    if (!save()) {
+        return false;
+    }
+    
+    std::cout << "[PackageIndex] ✓ Recorded " << package_path << " ("
+              << entry.zones.size() << " zones, " << entry.ecus.size() << " ECUs)\n";
+    return true;
+}
+
+void VerifiedPackageIndex::invalidate(const std::string& package_path) {
+    if (entries_.erase(package_path) > 0) {
+        save();
+    }
+}
@@ -0,0 +1,686 @@
+/**
+ * @file package_verifier.cpp
+ * @brief Single-pass Hierarchical Integrity Verification Implementation
+ */
+
+#include "package_verifier.hpp"
+#include "package_crc.hpp"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ==================== Walk State ====================
+
+/**
+ * @brief Kind of byte range visited during the walk
+ */
+enum class SpanKind : uint8_t {
+    RANGE,              // Part of the Vehicle Package body (root of a walk)
+    ZONE_HEADER,        // 1KB Zone Package header (captured)
+    ZONE_BODY,          // Zone Package data covered by zone_crc32
+    ECU_PACKAGE,        // ECU metadata + firmware covered by ZoneECUEntry::crc32
+    ECU_METADATA,       // ECU metadata (captured)
+    FIRMWARE            // Firmware covered by ECUMetadata::firmware_crc32 (raw firmware only)
+};
+
+/**
+ * @brief Byte range [start, end) in the Vehicle Package file
+ */
+struct Span {
+    SpanKind kind;
+    uint64_t start;
+    uint64_t end;
+    size_t zone;        // Index into report zones
+    size_t ecu;         // Index into zone ECUs
+};
+
+/**
+ * @brief Open range on the walk stack
+ *
+ * crc covers every byte from span.start to the current position: bytes
+ * outside children are hashed directly, closed children are merged with
+ * crc32Combine.
+ */
+struct WalkNode {
+    Span span;
+    uint32_t crc;
+    std::vector<Span> children;     // Sorted, non-overlapping, inside span
+    size_t next_child;
+    std::vector<uint8_t> captured;
+    size_t capture_limit;
+};
+
+// ==================== Helpers ====================
+
+static bool readAt(int fd, uint8_t* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, data, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+/**
+ * @brief ECU table indices sorted by offset
+ */
+static std::vector<size_t> sortedECUs(const ZonePackageHeader& header) {
+    std::vector<size_t> order(header.package_count);
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return header.ecu_table[a].offset < header.ecu_table[b].offset;
+    });
+    return order;
+}
+
+const char* integrityLevelToString(IntegrityLevel level) {
+    switch (level) {
+        case IntegrityLevel::NONE: return "NONE";
+        case IntegrityLevel::STRUCTURE: return "STRUCTURE";
+        case IntegrityLevel::VEHICLE: return "VEHICLE";
+        case IntegrityLevel::ZONE: return "ZONE";
+        case IntegrityLevel::ECU_PACKAGE: return "ECU_PACKAGE";
+        case IntegrityLevel::FIRMWARE: return "FIRMWARE";
+        default: return "UNKNOWN";
+    }
+}
+
+// ==================== Constructor ====================
+
+PackageIntegrityVerifier::PackageIntegrityVerifier(const std::string& package_path)
+    : package_path_(package_path), thread_count_(1) {
+    std::memset(&metadata_, 0, sizeof(VehiclePackageMetadata));
+    report_.valid = false;
+    report_.partial = false;
+    report_.failed_level = IntegrityLevel::NONE;
+    report_.expected_vehicle_crc = 0;
+    report_.calculated_vehicle_crc = 0;
+    report_.bytes_read = 0;
+}
+
+// ==================== Verification ====================
+
+bool PackageIntegrityVerifier::verify() {
+    std::cout << "[Integrity] Verifying Vehicle Package (single pass): " << package_path_ << "\n";
+    
+    report_ = PackageIntegrityReport();
+    report_.valid = false;
+    report_.partial = !zone_selection_.empty();
+    report_.failed_level = IntegrityLevel::STRUCTURE;
+    report_.expected_vehicle_crc = 0;
+    report_.calculated_vehicle_crc = 0;
+    report_.bytes_read = 0;
+    
+    int fd = open(package_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        report_.message = std::string("Failed to open package: ") + strerror(errno);
+        std::cerr << "[Integrity] ✗ " << report_.message << "\n";
+        return false;
+    }
+    
+    // The metadata is the first part of the stream; the body follows it
+    if (!readAt(fd, reinterpret_cast<uint8_t*>(&metadata_), sizeof(VehiclePackageMetadata), 0)) {
+        close(fd);
+        report_.message = "Failed to read metadata";
+        std::cerr << "[Integrity] ✗ " << report_.message << "\n";
+        return false;
+    }
+    report_.bytes_read = sizeof(VehiclePackageMetadata);
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        st.st_size = 0;
+    }
+    if (static_cast<uint64_t>(st.st_size) < metadata_.total_size) {
+        close(fd);
+        report_.message = "Package file truncated (" + std::to_string(st.st_size) + " < " +
+                          std::to_string(metadata_.total_size) + " bytes)";
+        std::cerr << "[Integrity] ✗ " << report_.message << "\n";
+        return false;
+    }
+    
+    if (!validateMetadata()) {
+        close(fd);
+        std::cerr << "[Integrity] ✗ " << report_.message << "\n";
+        return false;
+    }
+    
+    posix_fadvise(fd, 0, metadata_.total_size, POSIX_FADV_SEQUENTIAL);
+    
+    // Selected zones in file order
+    std::vector<size_t> order;
+    for (size_t i = 0; i < report_.zones.size(); i++) {
+        if (report_.zones[i].checked) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return metadata_.zone_refs[a].offset < metadata_.zone_refs[b].offset;
+    });
+    
+    uint64_t body_start = sizeof(VehiclePackageMetadata);
+    uint64_t body_length = metadata_.total_size - body_start;
+    if (report_.partial) {
+        body_length = 0;
+        for (size_t zone : order) {
+            body_length += metadata_.zone_refs[zone].size;
+        }
+    }
+    unsigned workers = resolveCRCThreadCount(thread_count_);
+    uint64_t max_workers = std::max<uint64_t>(1, body_length / PACKAGE_CRC_PARALLEL_MIN_SIZE);
+    workers = static_cast<unsigned>(std::min<uint64_t>(workers, max_workers));
+    
+    std::vector<std::vector<size_t>> groups;
+    std::vector<uint64_t> starts;
+    std::vector<uint64_t> ends;
+    if (report_.partial) {
+        // Bytes between selected zones were not downloaded: one range per zone
+        for (size_t zone : order) {
+            const ZoneReference& ref = metadata_.zone_refs[zone];
+            groups.push_back({zone});
+            starts.push_back(ref.offset);
+            ends.push_back(uint64_t(ref.offset) + ref.size);
+        }
+    } else {
+        // Split the body at zone boundaries into roughly equal ranges, one per worker
+        uint64_t target = body_length / workers;
+        groups.emplace_back();
+        starts.push_back(body_start);
+        for (size_t zone : order) {
+            uint64_t offset = metadata_.zone_refs[zone].offset;
+            if (!groups.back().empty() && groups.size() < workers &&
+                offset - body_start >= target * groups.size()) {
+                groups.emplace_back();
+                starts.push_back(offset);
+            }
+            groups.back().push_back(zone);
+        }
+        ends.assign(starts.begin() + 1, starts.end());
+        ends.push_back(metadata_.total_size);
+    }
+    
+    size_t range_count = groups.size();
+    std::vector<uint32_t> crcs(range_count, 0);
+    std::vector<uint64_t> bytes(range_count, 0);
+    std::vector<std::string> errors(range_count);
+    std::vector<char> results(range_count, 0);
+    
+    auto walk = [&](size_t i) {
+        results[i] = walkRange(fd, starts[i], ends[i], groups[i], crcs[i], bytes[i], errors[i]) ? 1 : 0;
+    };
+    
+    size_t thread_count = std::min<size_t>(workers, range_count);
+    if (thread_count <= 1) {
+        for (size_t i = 0; i < range_count; i++) {
+            walk(i);
+        }
+    } else {
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+        for (size_t t = 0; t < thread_count; t++) {
+            threads.emplace_back([&]() {
+                for (size_t i = next++; i < range_count; i = next++) {
+                    walk(i);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+    close(fd);
+    
+    // Merge range CRCs in file order (whole package only)
+    uint32_t vehicle_crc = 0;
+    for (size_t i = 0; i < range_count; i++) {
+        report_.bytes_read += bytes[i];
+        if (!results[i]) {
+            report_.message = errors[i];
+            std::cerr << "[Integrity] ✗ " << report_.message << "\n";
+            return false;
+        }
+        if (!report_.partial) {
+            vehicle_crc = (i == 0) ? crcs[0] : crc32Combine(vehicle_crc, crcs[i], ends[i] - starts[i]);
+        }
+    }
+    
+    report_.expected_vehicle_crc = metadata_.vehicle_crc32;
+    report_.calculated_vehicle_crc = vehicle_crc;
+    summarize();
+    
+    if (!report_.valid) {
+        std::cerr << "[Integrity] ✗ Failed at " << integrityLevelToString(report_.failed_level)
+                  << " level: " << report_.message << "\n";
+        return false;
+    }
+    
+    size_t ecu_count = 0;
+    for (const auto& zone : report_.zones) {
+        ecu_count += zone.ecus.size();
+    }
+    
+    if (report_.partial) {
+        std::cout << "[Integrity] ✓ " << order.size() << " of " << report_.zones.size() << " zones, " << ecu_count
+                  << " ECU packages and firmware verified (partial package, vehicle CRC32 not checked)\n";
+        return true;
+    }
+    
+    std::cout << "[Integrity] ✓ Vehicle CRC32 valid: 0x" << std::hex << vehicle_crc << std::dec << "\n";
+    std::cout << "[Integrity] ✓ " << report_.zones.size() << " zones, " << ecu_count
+              << " ECU packages and firmware verified (" << report_.bytes_read << " bytes read once)\n";
+    return true;
+}
+
+bool PackageIntegrityVerifier::validateMetadata() {
+    if (metadata_.magic_number != VEHICLE_PACKAGE_MAGIC) {
+        report_.message = "Invalid Vehicle Package magic number";
+        return false;
+    }
+    
+    if (metadata_.metadata_crc32 != 0 && metadata_.metadata_crc32 != calculateMetadataCRC32(metadata_)) {
+        report_.message = "Metadata CRC32 mismatch";
+        return false;
+    }
+    
+    if (metadata_.total_size < sizeof(VehiclePackageMetadata)) {
+        report_.message = "Invalid total size: " + std::to_string(metadata_.total_size);
+        return false;
+    }
+    
+    if (metadata_.zone_count > MAX_ZONES_IN_VEHICLE) {
+        report_.message = "Invalid zone count: " + std::to_string(metadata_.zone_count);
+        return false;
+    }
+    
+    report_.zones.resize(metadata_.zone_count);
+    zone_headers_.assign(metadata_.zone_count, ZonePackageHeader());
+    
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (uint8_t i = 0; i < metadata_.zone_count; i++) {
+        const ZoneReference& ref = metadata_.zone_refs[i];
+        ZoneIntegrityResult& zone = report_.zones[i];
+        zone.zone_id = std::string(fixedStringView(ref.zone_id, sizeof(ref.zone_id)));
+        zone.zone_number = ref.zone_number;
+        zone.expected_crc = 0;
+        zone.calculated_crc = 0;
+        zone.checked = zone_selection_.empty() || (i < zone_selection_.size() && zone_selection_[i]);
+        zone.header_valid = false;
+        zone.crc_valid = false;
+        
+        uint64_t start = ref.offset;
+        uint64_t end = start + ref.size;
+        if (start < sizeof(VehiclePackageMetadata) || ref.size < sizeof(ZonePackageHeader) ||
+            end > metadata_.total_size) {
+            report_.message = "Zone " + zone.zone_id + " out of bounds (offset=" +
+                              std::to_string(ref.offset) + ", size=" + std::to_string(ref.size) + ")";
+            return false;
+        }
+        ranges.push_back({start, end});
+    }
+    
+    std::sort(ranges.begin(), ranges.end());
+    for (size_t i = 1; i < ranges.size(); i++) {
+        if (ranges[i].first < ranges[i - 1].second) {
+            report_.message = "Zone Packages overlap at offset " + std::to_string(ranges[i].first);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PackageIntegrityVerifier::walkRange(int fd, uint64_t start, uint64_t end,
+                                         const std::vector<size_t>& zones,
+                                         uint32_t& crc, uint64_t& bytes_read, std::string& error) {
+    // Child ranges are only known once the enclosing header has been captured
+    auto makeNode = [&](const Span& span) {
+        WalkNode node;
+        node.span = span;
+        node.crc = 0;
+        node.next_child = 0;
+        node.capture_limit = 0;
+        
+        switch (span.kind) {
+            case SpanKind::RANGE:
+                for (size_t zone : zones) {
+                    const ZoneReference& ref = metadata_.zone_refs[zone];
+                    uint64_t body = ref.offset + sizeof(ZonePackageHeader);
+                    node.children.push_back({SpanKind::ZONE_HEADER, ref.offset, body, zone, 0});
+                    node.children.push_back({SpanKind::ZONE_BODY, body, uint64_t(ref.offset) + ref.size, zone, 0});
+                }
+                break;
+            
+            case SpanKind::ZONE_HEADER:
+                node.capture_limit = sizeof(ZonePackageHeader);
+                break;
+            
+            case SpanKind::ZONE_BODY:
+                if (report_.zones[span.zone].header_valid) {
+                    const ZonePackageHeader& header = zone_headers_[span.zone];
+                    uint64_t zone_offset = metadata_.zone_refs[span.zone].offset;
+                    for (size_t ecu : sortedECUs(header)) {
+                        const ZoneECUEntry& entry = header.ecu_table[ecu];
+                        uint64_t ecu_start = zone_offset + entry.offset;
+                        node.children.push_back({SpanKind::ECU_PACKAGE, ecu_start, ecu_start + entry.size,
+                                                 span.zone, ecu});
+                    }
+                }
+                break;
+            
+            case SpanKind::ECU_PACKAGE: {
+                const ZoneECUEntry& entry = zone_headers_[span.zone].ecu_table[span.ecu];
+                uint64_t firmware = span.start + entry.metadata_size;
+                node.children.push_back({SpanKind::ECU_METADATA, span.start, firmware, span.zone, span.ecu});
+                node.children.push_back({SpanKind::FIRMWARE, firmware, firmware + entry.firmware_size,
+                                         span.zone, span.ecu});
+                break;
+            }
+            
+            case SpanKind::ECU_METADATA:
+                node.capture_limit = sizeof(ECUMetadata);
+                break;
+            
+            case SpanKind::FIRMWARE:
+                break;
+        }
+        
+        node.captured.reserve(node.capture_limit);
+        return node;
+    };
+    
+    std::vector<uint8_t> buffer(PACKAGE_CRC_BUFFER_SIZE);
+    uint64_t buffer_start = start;
+    uint64_t buffer_length = 0;
+    uint64_t position = start;
+    bytes_read = 0;
+    
+    std::vector<WalkNode> stack;
+    stack.push_back(makeNode({SpanKind::RANGE, start, end, 0, 0}));
+    
+    while (true) {
+        WalkNode& top = stack.back();
+        
+        // Close finished range and merge it into its parent
+        if (position == top.span.end) {
+            const Span span = top.span;
+            uint32_t node_crc = top.crc;
+            
+            switch (span.kind) {
+                case SpanKind::ZONE_HEADER:
+                    checkZoneHeader(span.zone, top.captured);
+                    break;
+                
+                case SpanKind::ZONE_BODY: {
+                    ZoneIntegrityResult& zone = report_.zones[span.zone];
+                    zone.calculated_crc = node_crc;
+                    zone.crc_valid = zone.header_valid && node_crc == zone.expected_crc;
+                    break;
+                }
+                
+                case SpanKind::ECU_PACKAGE: {
+                    ECUIntegrityResult& ecu = report_.zones[span.zone].ecus[span.ecu];
+                    ecu.calculated_package_crc = node_crc;
+                    ecu.package_valid = node_crc == ecu.expected_package_crc;
+                    break;
+                }
+                
+                case SpanKind::ECU_METADATA:
+                    checkECUMetadata(span.zone, span.ecu, top.captured);
+                    break;
+                
+                case SpanKind::FIRMWARE: {
+                    ECUIntegrityResult& ecu = report_.zones[span.zone].ecus[span.ecu];
+                    ecu.calculated_firmware_crc = node_crc;
+                    ecu.firmware_valid = ecu.metadata_valid &&
+                                         (ecu.compressed || node_crc == ecu.expected_firmware_crc);
+                    break;
+                }
+                
+                case SpanKind::RANGE:
+                    break;
+            }
+            
+            stack.pop_back();
+            if (stack.empty()) {
+                crc = node_crc;
+                break;
+            }
+            
+            WalkNode& parent = stack.back();
+            parent.crc = crc32Combine(parent.crc, node_crc, span.end - span.start);
+            parent.next_child++;
+            continue;
+        }
+        
+        // Descend into the next child range
+        bool has_child = top.next_child < top.children.size();
+        if (has_child && top.children[top.next_child].start == position) {
+            Span child = top.children[top.next_child];
+            stack.push_back(makeNode(child));
+            continue;
+        }
+        
+        uint64_t limit = has_child ? top.children[top.next_child].start : top.span.end;
+        
+        // Refill buffer
+        if (position >= buffer_start + buffer_length) {
+            size_t to_read = static_cast<size_t>(std::min<uint64_t>(buffer.size(), end - position));
+            ssize_t n = pread(fd, buffer.data(), to_read, position);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                error = "Read error at offset " + std::to_string(position) + ": " + strerror(errno);
+                return false;
+            }
+            if (n == 0) {
+                error = "Unexpected end of file at offset " + std::to_string(position);
+                return false;
+            }
+            
+            posix_fadvise(fd, buffer_start, buffer_length, POSIX_FADV_DONTNEED);
+            buffer_start = position;
+            buffer_length = static_cast<uint64_t>(n);
+            bytes_read += buffer_length;
+        }
+        
+        // Hash bytes up to the next boundary into the innermost range only
+        size_t n = static_cast<size_t>(std::min(limit, buffer_start + buffer_length) - position);
+        const uint8_t* data = buffer.data() + (position - buffer_start);
+        top.crc = crc32Update(top.crc, data, n);
+        
+        if (top.captured.size() < top.capture_limit) {
+            size_t take = std::min(n, top.capture_limit - top.captured.size());
+            top.captured.insert(top.captured.end(), data, data + take);
+        }
+        
+        position += n;
+    }
+    
+    posix_fadvise(fd, buffer_start, buffer_length, POSIX_FADV_DONTNEED);
+    return true;
+}
+
+void PackageIntegrityVerifier::checkZoneHeader(size_t zone, const std::vector<uint8_t>& captured) {
+    ZoneIntegrityResult& result = report_.zones[zone];
+    ZonePackageHeader& header = zone_headers_[zone];
+    const ZoneReference& ref = metadata_.zone_refs[zone];
+    std::memcpy(&header, captured.data(), sizeof(ZonePackageHeader));
+    
+    result.expected_crc = header.zone_crc32;
+    result.header_valid = false;
+    
+    if (header.magic_number != ZONE_PACKAGE_MAGIC) {
+        std::cerr << "[Integrity] ✗ Zone " << result.zone_id << ": invalid magic number\n";
+        return;
+    }
+    
+    if (header.total_size != ref.size) {
+        std::cerr << "[Integrity] ✗ Zone " << result.zone_id << ": size mismatch (header="
+                  << header.total_size << ", reference=" << ref.size << ")\n";
+        return;
+    }
+    
+    if (header.package_count > MAX_ECUS_IN_ZONE) {
+        std::cerr << "[Integrity] ✗ Zone " << result.zone_id << ": invalid ECU count "
+                  << (int)header.package_count << "\n";
+        return;
+    }
+    
+    // ECU Packages must lie inside the zone body without overlapping
+    uint64_t previous_end = sizeof(ZonePackageHeader);
+    for (size_t ecu : sortedECUs(header)) {
+        const ZoneECUEntry& entry = header.ecu_table[ecu];
+        uint64_t ecu_end = uint64_t(entry.offset) + entry.size;
+        
+        if (entry.offset < previous_end || ecu_end > header.total_size ||
+            entry.metadata_size < sizeof(ECUMetadata) ||
+            uint64_t(entry.metadata_size) + entry.firmware_size > entry.size ||
+            entry.compression > ECU_COMPRESSION_ZSTD) {
+            std::cerr << "[Integrity] ✗ Zone " << result.zone_id << ": invalid ECU table entry "
+                      << fixedStringView(entry.ecu_id, sizeof(entry.ecu_id)) << "\n";
+            return;
+        }
+        previous_end = ecu_end;
+    }
+    
+    result.ecus.resize(header.package_count);
+    for (uint8_t i = 0; i < header.package_count; i++) {
+        ECUIntegrityResult& ecu = result.ecus[i];
+        ecu.ecu_id = std::string(fixedStringView(header.ecu_table[i].ecu_id, sizeof(header.ecu_table[i].ecu_id)));
+        ecu.expected_package_crc = header.ecu_table[i].crc32;
+        ecu.calculated_package_crc = 0;
+        ecu.expected_firmware_crc = 0;
+        ecu.calculated_firmware_crc = 0;
+        ecu.metadata_valid = false;
+        ecu.package_valid = false;
+        ecu.firmware_valid = false;
+        ecu.compressed = header.ecu_table[i].compression != ECU_COMPRESSION_NONE;
+    }
+    
+    result.header_valid = true;
+}
+
+void PackageIntegrityVerifier::checkECUMetadata(size_t zone, size_t ecu,
+                                                const std::vector<uint8_t>& captured) {
+    ECUIntegrityResult& result = report_.zones[zone].ecus[ecu];
+    const ZoneECUEntry& entry = zone_headers_[zone].ecu_table[ecu];
+    
+    ECUMetadata metadata;
+    std::memcpy(&metadata, captured.data(), sizeof(ECUMetadata));
+    
+    result.expected_firmware_crc = metadata.firmware_crc32;
+    result.metadata_valid = metadata.magic_number == ECU_METADATA_MAGIC &&
+                            metadata.firmware_size == ecuImageSize(entry);
+}
+
+void PackageIntegrityVerifier::summarize() {
+    report_.valid = true;
+    report_.failed_level = IntegrityLevel::NONE;
+    report_.message.clear();
+    
+    // Keep the most specific failure; the first one found wins on ties
+    auto fail = [&](IntegrityLevel level, const std::string& zone_id,
+                    const std::string& ecu_id, const std::string& message) {
+        report_.valid = false;
+        if (level > report_.failed_level) {
+            report_.failed_level = level;
+            report_.failed_zone_id = zone_id;
+            report_.failed_ecu_id = ecu_id;
+            report_.message = message;
+        }
+    };
+    
+    if (!report_.partial && report_.calculated_vehicle_crc != report_.expected_vehicle_crc) {
+        fail(IntegrityLevel::VEHICLE, "", "", "Vehicle CRC32 mismatch");
+    }
+    
+    for (const auto& zone : report_.zones) {
+        if (!zone.checked) {
+            continue;
+        }
+        
+        if (!zone.header_valid) {
+            fail(IntegrityLevel::ZONE, zone.zone_id, "", "Zone " + zone.zone_id + " header invalid");
+            continue;
+        }
+        
+        if (!zone.crc_valid) {
+            fail(IntegrityLevel::ZONE, zone.zone_id, "", "Zone " + zone.zone_id + " CRC32 mismatch");
+        }
+        
+        for (const auto& ecu : zone.ecus) {
+            if (!ecu.metadata_valid) {
+                fail(IntegrityLevel::ECU_PACKAGE, zone.zone_id, ecu.ecu_id,
+                     "ECU " + ecu.ecu_id + " metadata invalid");
+            } else if (!ecu.firmware_valid) {
+                fail(IntegrityLevel::FIRMWARE, zone.zone_id, ecu.ecu_id,
+                     "ECU " + ecu.ecu_id + " firmware CRC32 mismatch");
+            }
+            
+            if (!ecu.package_valid) {
+                fail(IntegrityLevel::ECU_PACKAGE, zone.zone_id, ecu.ecu_id,
+                     "ECU " + ecu.ecu_id + " package CRC32 mismatch");
+            }
+        }
+    }
+}
+
+// ==================== Report ====================
+
+void PackageIntegrityVerifier::printReport() const {
+    auto mark = [](bool ok) { return ok ? "✓" : "✗"; };
+    
+    std::cout << "\n";
+    std::cout << "========================================\n";
+    std::cout << "  Package Integrity Report\n";
+    std::cout << "========================================\n";
+    if (report_.partial) {
+        std::cout << "Vehicle CRC32: - not checked (partial package)\n";
+    } else {
+        std::cout << "Vehicle CRC32: " << mark(report_.calculated_vehicle_crc == report_.expected_vehicle_crc)
+                  << " expected 0x" << std::hex << report_.expected_vehicle_crc
+                  << ", calculated 0x" << report_.calculated_vehicle_crc << std::dec << "\n";
+    }
+    
+    for (const auto& zone : report_.zones) {
+        if (!zone.checked) {
+            std::cout << "  Zone " << (int)zone.zone_number << " (" << zone.zone_id << "): - not downloaded\n";
+            continue;
+        }
+        std::cout << "  Zone " << (int)zone.zone_number << " (" << zone.zone_id << "): "
+                  << "header " << mark(zone.header_valid) << ", CRC32 " << mark(zone.crc_valid) << "\n";
+        
+        for (const auto& ecu : zone.ecus) {
+            std::cout << "    " << ecu.ecu_id
+                      << ": metadata " << mark(ecu.metadata_valid)
+                      << ", package " << mark(ecu.package_valid)
+                      << ", firmware " << mark(ecu.firmware_valid)
+                      << (ecu.compressed ? " (zstd, image CRC checked on decompression)" : "") << "\n";
+        }
+    }
+    
+    if (report_.valid) {
+        std::cout << "Result: ✓ Valid\n";
+    } else {
+        std::cout << "Result: ✗ " << integrityLevelToString(report_.failed_level)
+                  << " - " << report_.message << "\n";
+    }
+    std::cout << "========================================\n\n";
+}
@@ -0,0 +1,261 @@
+/**
+ * @file package_view.cpp
+ * @brief Zero-copy Package View Implementation
+ */
+
+#include "vehicle_package.hpp"
+#include "crc32.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Package fields are little-endian; overlaying them needs a little-endian host
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static const bool HOST_LITTLE_ENDIAN = false;
+#else
+static const bool HOST_LITTLE_ENDIAN = true;
+#endif
+
+// ==================== Mapped File ====================
+
+MappedFile::MappedFile() : data_(nullptr), size_(0) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);     // Mapping stays valid after close
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    
+    data_ = static_cast<const uint8_t*>(mapped);
+    size_ = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+// ==================== Zone Package View ====================
+
+ZonePackageView::ZonePackageView() : data_(nullptr), header_(nullptr), error_("Not opened") {
+}
+
+const ZonePackageHeader& ZonePackageView::header() const {
+    static const ZonePackageHeader empty = {};
+    return header_ ? *header_ : empty;
+}
+
+bool ZonePackageView::open(const uint8_t* data, uint64_t size) {
+    data_ = nullptr;
+    header_ = nullptr;
+    
+    if (!HOST_LITTLE_ENDIAN) {
+        error_ = "Big-endian host not supported";
+        return false;
+    }
+    
+    if (!data || size < sizeof(ZonePackageHeader)) {
+        error_ = "Zone Package smaller than header";
+        return false;
+    }
+    
+    const ZonePackageHeader* header = reinterpret_cast<const ZonePackageHeader*>(data);
+    if (header->magic_number != ZONE_PACKAGE_MAGIC) {
+        error_ = "Invalid Zone Package magic number";
+        return false;
+    }
+    
+    if (header->total_size < sizeof(ZonePackageHeader) || header->total_size > size) {
+        error_ = "Zone Package total size out of bounds";
+        return false;
+    }
+    
+    if (header->package_count > MAX_ECUS_IN_ZONE) {
+        error_ = "Invalid ECU count";
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < header->package_count; i++) {
+        const ZoneECUEntry& entry = header->ecu_table[i];
+        uint64_t end = uint64_t(entry.offset) + entry.size;
+        
+        if (entry.offset < sizeof(ZonePackageHeader) || end > header->total_size ||
+            entry.metadata_size < sizeof(ECUMetadata) ||
+            uint64_t(entry.metadata_size) + entry.firmware_size > entry.size) {
+            error_ = "ECU table entry out of bounds";
+            return false;
+        }
+        
+        if (entry.compression > ECU_COMPRESSION_ZSTD ||
+            (entry.compression != ECU_COMPRESSION_NONE && entry.uncompressed_size == 0)) {
+            error_ = "Unknown ECU firmware compression";
+            return false;
+        }
+    }
+    
+    data_ = data;
+    header_ = header;
+    error_ = "";
+    return true;
+}
+
+ECUPackageView ZonePackageView::ecuPackage(size_t index) const {
+    const ZoneECUEntry& entry = header().ecu_table[index];
+    const uint8_t* start = data_ + entry.offset;
+    
+    ECUPackageView view;
+    view.entry = &entry;
+    view.metadata = reinterpret_cast<const ECUMetadata*>(start);
+    view.firmware = start + entry.metadata_size;
+    view.firmware_size = entry.firmware_size;
+    return view;
+}
+
+// ==================== Vehicle Package View ====================
+
+uint32_t calculateMetadataCRC32(const VehiclePackageMetadata& metadata) {
+    static const uint8_t zero[sizeof(metadata.metadata_crc32)] = {};
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&metadata);
+    const size_t field = offsetof(VehiclePackageMetadata, metadata_crc32);
+    const size_t rest = field + sizeof(zero);
+    
+    uint32_t crc = crc32Update(0, bytes, field);
+    crc = crc32Update(crc, zero, sizeof(zero));
+    return crc32Update(crc, bytes + rest, sizeof(VehiclePackageMetadata) - rest);
+}
+
+VehiclePackageView::VehiclePackageView() : data_(nullptr), metadata_(nullptr), error_("Not opened") {
+}
+
+const VehiclePackageMetadata& VehiclePackageView::metadata() const {
+    static const VehiclePackageMetadata empty = {};
+    return metadata_ ? *metadata_ : empty;
+}
+
+bool VehiclePackageView::open(const uint8_t* data, uint64_t size) {
+    data_ = nullptr;
+    metadata_ = nullptr;
+    
+    if (!HOST_LITTLE_ENDIAN) {
+        error_ = "Big-endian host not supported";
+        return false;
+    }
+    
+    if (!data || size < sizeof(VehiclePackageMetadata)) {
+        error_ = "Vehicle Package smaller than metadata";
+        return false;
+    }
+    
+    const VehiclePackageMetadata* metadata = reinterpret_cast<const VehiclePackageMetadata*>(data);
+    const char* error = checkMetadata(*metadata);
+    if (error) {
+        error_ = error;
+        return false;
+    }
+    
+    if (metadata->total_size > size) {
+        error_ = "Vehicle Package total size out of bounds";
+        return false;
+    }
+    
+    data_ = data;
+    metadata_ = metadata;
+    error_ = "";
+    return true;
+}
+
+const char* VehiclePackageView::checkMetadata(const VehiclePackageMetadata& metadata) {
+    if (metadata.magic_number != VEHICLE_PACKAGE_MAGIC) {
+        return "Invalid Vehicle Package magic number";
+    }
+    
+    if (metadata.metadata_crc32 != 0 && metadata.metadata_crc32 != calculateMetadataCRC32(metadata)) {
+        return "Vehicle Package metadata CRC32 mismatch";
+    }
+    
+    if (metadata.total_size < sizeof(VehiclePackageMetadata)) {
+        return "Vehicle Package total size out of bounds";
+    }
+    
+    if (metadata.zone_count > MAX_ZONES_IN_VEHICLE) {
+        return "Invalid zone count";
+    }
+    
+    for (uint8_t i = 0; i < metadata.zone_count; i++) {
+        const ZoneReference& ref = metadata.zone_refs[i];
+        uint64_t end = uint64_t(ref.offset) + ref.size;
+        
+        if (ref.offset < sizeof(VehiclePackageMetadata) || ref.size < sizeof(ZonePackageHeader) ||
+            end > metadata.total_size) {
+            return "Zone reference out of bounds";
+        }
+        
+        // At most 16 zones: pairwise is cheaper than sorting
+        for (uint8_t j = 0; j < i; j++) {
+            const ZoneReference& other = metadata.zone_refs[j];
+            if (ref.offset < uint64_t(other.offset) + other.size && other.offset < end) {
+                return "Zone references overlap";
+            }
+        }
+    }
+    
+    return nullptr;
+}
+
+const ZoneReference* VehiclePackageView::findZone(uint8_t zone_number) const {
+    for (const ZoneReference& ref : zones()) {
+        if (ref.zone_number == zone_number) {
+            return &ref;
+        }
+    }
+    return nullptr;
+}
+
+ZonePackageView VehiclePackageView::zonePackage(const ZoneReference& ref) const {
+    ZonePackageView view;
+    if (isValid()) {
+        view.open(data_ + ref.offset, ref.size);
+    }
+    return view;
+}
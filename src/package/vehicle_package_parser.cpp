@@ -9,10 +9,10 @@
  */
 
 #include "vehicle_package.hpp"
+#include "package_crc.hpp"
 #include <iostream>
 #include <fstream>
 #include <cstring>
-#include <zlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -22,44 +22,36 @@
 #endif
 
 VehiclePackageParser::VehiclePackageParser(const std::string& package_path)
-    : package_path_(package_path), parsed_(false) {
-    std::memset(&metadata_, 0, sizeof(VehiclePackageMetadata));
+    : package_path_(package_path), parsed_(false), verify_threads_(1) {
 }
 
 bool VehiclePackageParser::parse() {
     std::cout << "[VehiclePackage] Parsing Vehicle Package: " << package_path_ << "\n";
     
-    // Open package file
-    std::ifstream file(package_path_, std::ios::binary);
-    if (!file.is_open()) {
+    // Map package file (metadata is overlaid, not copied)
+    if (!file_.open(package_path_)) {
         std::cerr << "[VehiclePackage] ✗ Failed to open package file\n";
         return false;
     }
     
-    // Read metadata (first 12KB)
-    file.read(reinterpret_cast<char*>(&metadata_), sizeof(VehiclePackageMetadata));
-    if (!file.good()) {
-        std::cerr << "[VehiclePackage] ✗ Failed to read metadata\n";
-        return false;
-    }
-    
-    // Verify magic number
-    if (metadata_.magic_number != VEHICLE_PACKAGE_MAGIC) {
-        std::cerr << "[VehiclePackage] ✗ Invalid magic number: 0x" 
-                  << std::hex << metadata_.magic_number << std::dec << "\n";
+    // Validate magic, sizes and zone references once
+    if (!view_.open(file_.data(), file_.size())) {
+        std::cerr << "[VehiclePackage] ✗ " << view_.getError() << "\n";
         return false;
     }
     
     std::cout << "[VehiclePackage] ✓ Magic number valid: 0x5650504B (\"VPPK\")\n";
     
+    const VehiclePackageMetadata& metadata = view_.metadata();
+    
     // Parse Zone References
     zone_packages_.clear();
-    for (uint8_t i = 0; i < metadata_.zone_count; i++) {
-        const ZoneReference& zone_ref = metadata_.zone_refs[i];
+    zone_packages_.reserve(view_.zoneCount());
+    for (size_t i = 0; i < view_.zoneCount(); i++) {
+        const ZoneReference& zone_ref = view_.zones()[i];
         
         ZonePackageInfo zone_info;
-        zone_info.zone_id = std::string(zone_ref.zone_id, 16);
-        zone_info.zone_id.erase(zone_info.zone_id.find('\0')); // Remove null padding
+        zone_info.zone_id = std::string(view_.zoneId(i));
         zone_info.zone_number = zone_ref.zone_number;
         zone_info.offset = zone_ref.offset;
         zone_info.size = zone_ref.size;
@@ -74,20 +66,19 @@ bool VehiclePackageParser::parse() {
         
         std::cout << "[VehiclePackage]   Zone " << (int)zone_ref.zone_number 
                   << ": " << zone_info.zone_id 
-                  << " (" << zone_ref.ecu_count << " ECUs, " 
+                  << " (" << (int)zone_ref.ecu_count << " ECUs, " 
                   << zone_ref.size << " bytes)\n";
         std::cout << "[VehiclePackage]      Target: " << zgw_ip << ":" << zgw_port << "\n";
     }
     
-    file.close();
     parsed_ = true;
     
     std::cout << "[VehiclePackage] ✓ Vehicle Package parsed successfully\n";
-    std::cout << "[VehiclePackage]   VIN: " << metadata_.vin << "\n";
-    std::cout << "[VehiclePackage]   Model: " << metadata_.model << " (" << metadata_.model_year << ")\n";
-    std::cout << "[VehiclePackage]   Master SW: " << metadata_.master_sw_string << "\n";
-    std::cout << "[VehiclePackage]   Zones: " << (int)metadata_.zone_count << "\n";
-    std::cout << "[VehiclePackage]   Total ECUs: " << (int)metadata_.total_ecu_count << "\n";
+    std::cout << "[VehiclePackage]   VIN: " << view_.vin() << "\n";
+    std::cout << "[VehiclePackage]   Model: " << view_.model() << " (" << metadata.model_year << ")\n";
+    std::cout << "[VehiclePackage]   Master SW: " << view_.masterSWString() << "\n";
+    std::cout << "[VehiclePackage]   Zones: " << (int)metadata.zone_count << "\n";
+    std::cout << "[VehiclePackage]   Total ECUs: " << (int)metadata.total_ecu_count << "\n";
     
     return true;
 }
@@ -100,45 +91,44 @@ bool VehiclePackageParser::verify() {
     
     std::cout << "[VehiclePackage] Verifying package integrity...\n";
     
-    // Open file
-    std::ifstream file(package_path_, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "[VehiclePackage] ✗ Failed to open file for verification\n";
+    // total_size was bounds-checked by VehiclePackageView::open()
+    const VehiclePackageMetadata& metadata = view_.metadata();
+    
+    // Calculate CRC32 of package body (everything after metadata), streamed
+    uint32_t calculated_crc = 0;
+    if (!calculateFileCRC32(package_path_, sizeof(VehiclePackageMetadata),
+                            metadata.total_size - sizeof(VehiclePackageMetadata),
+                            calculated_crc, verify_threads_)) {
+        std::cerr << "[VehiclePackage] ✗ Failed to read package for verification\n";
         return false;
     }
     
-    // Calculate CRC32 of entire package (excluding metadata CRC32 fields)
-    file.seekg(sizeof(VehiclePackageMetadata), std::ios::beg);
-    
-    std::vector<uint8_t> package_data;
-    package_data.resize(metadata_.total_size - sizeof(VehiclePackageMetadata));
-    file.read(reinterpret_cast<char*>(package_data.data()), package_data.size());
-    
-    uint32_t calculated_crc = calculateCRC32(package_data.data(), package_data.size());
-    
-    if (calculated_crc != metadata_.vehicle_crc32) {
+    if (calculated_crc != metadata.vehicle_crc32) {
         std::cerr << "[VehiclePackage] ✗ CRC32 mismatch\n";
-        std::cerr << "  Expected: 0x" << std::hex << metadata_.vehicle_crc32 << "\n";
+        std::cerr << "  Expected: 0x" << std::hex << metadata.vehicle_crc32 << "\n";
         std::cerr << "  Calculated: 0x" << calculated_crc << std::dec << "\n";
         return false;
     }
     
     std::cout << "[VehiclePackage] ✓ CRC32 valid: 0x" << std::hex << calculated_crc << std::dec << "\n";
-    
-    file.close();
     return true;
 }
 
 bool VehiclePackageParser::verifyVehicleTarget(const std::string& vin,
                                                 const std::string& model,
                                                 uint16_t model_year) {
+    return verifyVehicleTarget(view_.metadata(), vin, model, model_year);
+}
+
+bool VehiclePackageParser::verifyVehicleTarget(const VehiclePackageMetadata& metadata,
+                                                const std::string& vin,
+                                                const std::string& model,
+                                                uint16_t model_year) {
     std::cout << "[VehiclePackage] Verifying vehicle target...\n";
     
-    std::string package_vin = std::string(metadata_.vin, 17);
-    package_vin.erase(package_vin.find('\0'));
-    
-    std::string package_model = std::string(metadata_.model, 32);
-    package_model.erase(package_model.find('\0'));
+    std::string_view package_vin = fixedStringView(metadata.vin, sizeof(metadata.vin));
+    std::string_view package_model = fixedStringView(metadata.model, sizeof(metadata.model));
+    uint16_t package_year = metadata.model_year;
     
     if (package_vin != vin) {
         std::cerr << "[VehiclePackage] ✗ VIN mismatch\n";
@@ -154,10 +144,10 @@ bool VehiclePackageParser::verifyVehicleTarget(const std::string& vin,
         return false;
     }
     
-    if (metadata_.model_year != model_year) {
+    if (package_year != model_year) {
         std::cerr << "[VehiclePackage] ✗ Model year mismatch\n";
         std::cerr << "  Expected: " << model_year << "\n";
-        std::cerr << "  Package: " << metadata_.model_year << "\n";
+        std::cerr << "  Package: " << package_year << "\n";
         return false;
     }
     
@@ -173,13 +163,7 @@ bool VehiclePackageParser::extractZonePackage(uint8_t zone_number,
     }
     
     // Find zone
-    const ZoneReference* zone_ref = nullptr;
-    for (uint8_t i = 0; i < metadata_.zone_count; i++) {
-        if (metadata_.zone_refs[i].zone_number == zone_number) {
-            zone_ref = &metadata_.zone_refs[i];
-            break;
-        }
-    }
+    const ZoneReference* zone_ref = view_.findZone(zone_number);
     
     if (!zone_ref) {
         std::cerr << "[VehiclePackage] ✗ Zone " << (int)zone_number << " not found\n";
@@ -189,13 +173,6 @@ bool VehiclePackageParser::extractZonePackage(uint8_t zone_number,
     std::cout << "[VehiclePackage] Extracting Zone " << (int)zone_number 
               << " to " << output_path << "...\n";
     
-    // Open source file
-    std::ifstream src_file(package_path_, std::ios::binary);
-    if (!src_file.is_open()) {
-        std::cerr << "[VehiclePackage] ✗ Failed to open source file\n";
-        return false;
-    }
-    
     // Open output file
     std::ofstream dst_file(output_path, std::ios::binary);
     if (!dst_file.is_open()) {
@@ -203,16 +180,13 @@ bool VehiclePackageParser::extractZonePackage(uint8_t zone_number,
         return false;
     }
     
-    // Seek to zone offset
-    src_file.seekg(zone_ref->offset, std::ios::beg);
-    
-    // Copy zone data
-    std::vector<uint8_t> zone_data(zone_ref->size);
-    src_file.read(reinterpret_cast<char*>(zone_data.data()), zone_ref->size);
-    dst_file.write(reinterpret_cast<const char*>(zone_data.data()), zone_ref->size);
-    
-    src_file.close();
+    // Write zone bytes straight from the mapping (bounds checked in parse())
+    dst_file.write(reinterpret_cast<const char*>(view_.data() + zone_ref->offset), zone_ref->size);
     dst_file.close();
+    if (!dst_file.good()) {
+        std::cerr << "[VehiclePackage] ✗ Failed to write output file\n";
+        return false;
+    }
     
     std::cout << "[VehiclePackage] ✓ Zone " << (int)zone_number 
               << " extracted (" << zone_ref->size << " bytes)\n";
@@ -240,11 +214,8 @@ bool VehiclePackageParser::extractAllZonePackages(const std::string& output_dir)
     mkdir(output_dir.c_str(), 0755);
     
     // Extract each zone
-    for (uint8_t i = 0; i < metadata_.zone_count; i++) {
-        uint8_t zone_num = metadata_.zone_refs[i].zone_number;
-        std::string zone_id = std::string(metadata_.zone_refs[i].zone_id, 16);
-        zone_id.erase(zone_id.find('\0'));
-        
+    for (const ZoneReference& zone_ref : view_.zones()) {
+        uint8_t zone_num = zone_ref.zone_number;
         std::string output_path = output_dir + "/zone_" + std::to_string((int)zone_num) + ".bin";
         
         if (!extractZonePackage(zone_num, output_path)) {
@@ -275,13 +246,14 @@ void VehiclePackageParser::printSummary() const {
     std::cout << "========================================\n";
     std::cout << "  Vehicle Package Summary\n";
     std::cout << "========================================\n";
-    std::cout << "VIN:           " << metadata_.vin << "\n";
-    std::cout << "Model:         " << metadata_.model << " (" << metadata_.model_year << ")\n";
-    std::cout << "Region:        " << (int)metadata_.region << "\n";
-    std::cout << "Master SW:     " << metadata_.master_sw_string << "\n";
-    std::cout << "Total Size:    " << metadata_.total_size << " bytes\n";
-    std::cout << "Zone Count:    " << (int)metadata_.zone_count << "\n";
-    std::cout << "Total ECUs:    " << (int)metadata_.total_ecu_count << "\n";
+    const VehiclePackageMetadata& metadata = view_.metadata();
+    std::cout << "VIN:           " << view_.vin() << "\n";
+    std::cout << "Model:         " << view_.model() << " (" << metadata.model_year << ")\n";
+    std::cout << "Region:        " << (int)metadata.region << "\n";
+    std::cout << "Master SW:     " << view_.masterSWString() << "\n";
+    std::cout << "Total Size:    " << metadata.total_size << " bytes\n";
+    std::cout << "Zone Count:    " << (int)metadata.zone_count << "\n";
+    std::cout << "Total ECUs:    " << (int)metadata.total_ecu_count << "\n";
     std::cout << "\nZone Packages:\n";
     
     for (size_t i = 0; i < zone_packages_.size(); i++) {
@@ -296,10 +268,6 @@ void VehiclePackageParser::printSummary() const {
     std::cout << "========================================\n\n";
 }
 
-uint32_t VehiclePackageParser::calculateCRC32(const uint8_t* data, size_t size) const {
-    return crc32(0L, data, size);
-}
-
 std::pair<std::string, uint16_t> VehiclePackageParser::determineZoneTarget(uint8_t zone_number) const {
     // TODO: This should be configurable via routing table
     // For now, use default ZGW configuration
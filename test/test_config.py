@@ -91,6 +91,13 @@ def test_3_sector_layout(config):
         print(f"Data Partition: {dual_partition['data_partition']}")
         print(f"Data Mount: {dual_partition['data_mount_point']}")
         
+        # Simulation images (optional)
+        simulation = dual_partition.get('simulation', {})
+        if simulation.get('enabled', False):
+            assert simulation.get('image_size_mb', 100) > 0, "simulation.image_size_mb must be positive"
+            print(f"Simulation Images: {simulation.get('image_dir', '/tmp/vmg_partitions')} "
+                  f"({simulation.get('image_size_mb', 100)} MB, sparse)")
+        
         # Check paths use data mount point
         assert ota['download_path'].startswith('/mnt/data'), "download_path should use /mnt/data"
         assert ota['install_path'].startswith('/mnt/data'), "install_path should use /mnt/data"
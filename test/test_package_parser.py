@@ -92,6 +92,19 @@ def test_vehicle_package_structure(package_path):
             print(f"Zone Count: {zone_count}")
             assert zone_count == 3, f"Zone count mismatch: {zone_count}"
             
+            # ECU Quick Reference (VCI 비교용): ecu_id, zone_number, firmware_version
+            total_ecu_count = struct.unpack('B', f.read(1))[0]
+            f.seek(704)
+            refs = []
+            for _ in range(total_ecu_count):
+                entry = f.read(32)
+                ecu_id = entry[:16].decode('ascii').rstrip('\x00')
+                refs.append((ecu_id, entry[16], struct.unpack('<I', entry[17:21])[0]))
+            print(f"ECU References: {refs}")
+            assert len(refs) == 5, f"ECU reference count mismatch: {len(refs)}"
+            assert refs[0] == ('ECU_011', 1, 0x00020001), f"ECU reference mismatch: {refs[0]}"
+            assert refs[-1] == ('ECU_091', 9, 0x00020000), f"ECU reference mismatch: {refs[-1]}"
+            
             print("\n✓ Test 2 PASSED")
             
     except Exception as e:
@@ -167,6 +180,106 @@ def test_zone_package_extraction(package_path):
         print(f"✗ Test 4 FAILED: {e}")
         raise
 
+def test_hierarchical_crc(package_path):
+    """Vehicle → Zone → ECU CRC 계층 검증"""
+    print("\n" + "="*60)
+    print("Test 5: Hierarchical CRC (Vehicle / Zone / ECU / Firmware)")
+    print("="*60)
+    
+    import struct
+    import zlib
+    
+    try:
+        with open(package_path, 'rb') as f:
+            data = f.read()
+        
+        # Vehicle CRC (body after 12KB metadata)
+        vehicle_crc = struct.unpack_from('<I', data, 144)[0]
+        assert zlib.crc32(data[12288:]) == vehicle_crc, "Vehicle CRC32 mismatch"
+        print(f"✓ Vehicle CRC32: 0x{vehicle_crc:08X}")
+        
+        # Metadata CRC (12KB metadata with the field itself as 0)
+        metadata_crc = struct.unpack_from('<I', data, 148)[0]
+        metadata = bytearray(data[:12288])
+        struct.pack_into('<I', metadata, 148, 0)
+        assert zlib.crc32(metadata) == metadata_crc, "Metadata CRC32 mismatch"
+        print(f"✓ Metadata CRC32: 0x{metadata_crc:08X}")
+        
+        zone_count = data[128]
+        for i in range(zone_count):
+            entry_offset = 192 + (i * 32)
+            zone_offset, zone_size = struct.unpack_from('<II', data, entry_offset + 16)
+            zone = data[zone_offset:zone_offset + zone_size]
+            
+            # Zone CRC (body after 1KB header)
+            zone_crc = struct.unpack_from('<I', zone, 32)[0]
+            assert zlib.crc32(zone[1024:]) == zone_crc, f"Zone {i} CRC32 mismatch"
+            
+            package_count = zone[29]
+            assert package_count <= 12, f"Zone {i} ECU count {package_count} > 12"
+            
+            for j in range(package_count):
+                ecu_entry = 256 + (j * 64)
+                ecu_id = zone[ecu_entry:ecu_entry + 16].decode('ascii').rstrip('\x00')
+                offset, size, metadata_size, firmware_size, _, ecu_crc = \
+                    struct.unpack_from('<IIIIII', zone, ecu_entry + 16)
+                ecu_package = zone[offset:offset + size]
+                
+                # ECU Package CRC (metadata + firmware)
+                assert zlib.crc32(ecu_package) == ecu_crc, f"{ecu_id} package CRC32 mismatch"
+                
+                # Firmware CRC (ECUMetadata::firmware_crc32)
+                firmware_crc = struct.unpack_from('<I', ecu_package, 32)[0]
+                firmware = ecu_package[metadata_size:metadata_size + firmware_size]
+                assert zlib.crc32(firmware) == firmware_crc, f"{ecu_id} firmware CRC32 mismatch"
+                
+                print(f"  ✓ {ecu_id}: package 0x{ecu_crc:08X}, firmware 0x{firmware_crc:08X}")
+        
+        print("\n✓ Test 5 PASSED")
+        
+    except Exception as e:
+        print(f"✗ Test 5 FAILED: {e}")
+        raise
+
+def test_reproducible_build():
+    """--seed 재현 빌드 (Python ↔ vmg-pack 바이트 동일)"""
+    print("\n" + "="*60)
+    print("Test 6: Reproducible Build (--seed)")
+    print("="*60)
+    
+    import filecmp
+    from vehicle_package_simulator import make_synthetic_config
+    
+    paths = [tempfile.mktemp(suffix='.bin') for _ in range(3)]
+    try:
+        config = make_synthetic_config(3, 4, 8)
+        for path in paths[:2]:
+            create_vehicle_package(path, 'KMHXX00XXXX000001', 'Genesis GV80', 2024,
+                                   ecu_config=config, seed=1234)
+        assert filecmp.cmp(paths[0], paths[1], shallow=False), "Seeded builds differ"
+        print("✓ Python seeded builds identical")
+        
+        vmg_pack_path = '../build/vmg-pack'
+        if not os.path.exists(vmg_pack_path):
+            print("⚠ vmg-pack executable not found, skipping C++ comparison")
+            print("  Run: cd ../build && cmake .. && make vmg-pack")
+        else:
+            subprocess.run([vmg_pack_path, '-o', paths[2], '--zones', '3', '--ecus-per-zone', '4',
+                            '--firmware-kb', '8', '--seed', '1234'], check=True)
+            assert filecmp.cmp(paths[0], paths[2], shallow=False), "vmg-pack output differs"
+            print("✓ vmg-pack output byte-identical")
+        
+        print("\n✓ Test 6 PASSED")
+        
+    except Exception as e:
+        print(f"✗ Test 6 FAILED: {e}")
+        raise
+    
+    finally:
+        for path in paths:
+            if os.path.exists(path):
+                os.unlink(path)
+
 def test_cleanup(package_path):
     """테스트 정리"""
     if os.path.exists(package_path):
@@ -199,6 +312,14 @@ def main():
         test_zone_package_extraction(package_path)
         tests_passed += 1
         
+        # Test 5: 계층 CRC 검증
+        test_hierarchical_crc(package_path)
+        tests_passed += 1
+        
+        # Test 6: 재현 빌드 (Python ↔ vmg-pack)
+        test_reproducible_build()
+        tests_passed += 1
+        
     except Exception as e:
         tests_failed += 1
         print(f"\n✗ Test suite failed: {e}")
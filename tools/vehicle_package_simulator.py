@@ -10,6 +10,10 @@ ECU Configuration:
 - ECU_012: Zone 1, ECU #2 (DCM - Door Control Module)
 - ECU_021: Zone 2, ECU #1 (Camera Module)
 - ECU_022: Zone 2, ECU #2 (Radar Module)
+
+--zones / --ecus-per-zone / --firmware-kb replace this with a synthetic
+layout. --seed makes the output reproducible (seeded firmware, fixed
+timestamps) and byte-identical to `vmg-pack` with the same options.
 """
 
 import struct
@@ -26,7 +30,7 @@ ZONE_PACKAGE_MAGIC = 0x5A4F4E45     # "ZONE"
 ECU_METADATA_MAGIC = 0x4543554D     # "ECUM"
 
 MAX_ZONES_IN_VEHICLE = 16
-MAX_ECUS_IN_ZONE = 16
+MAX_ECUS_IN_ZONE = 12  # ECU table entries that fit in the 1KB zone header
 
 # ==================== ECU Configuration ====================
 
@@ -38,7 +42,8 @@ ECU_CONFIG = {
         'zone_number': 1,
         'ecus': [
             {'ecu_id': 'ECU_011', 'name': 'BCM', 'version': 'v2.0.1', 'hw_ver': 'v1.0.0', 'priority': 0, 'size_kb': 256},
-            {'ecu_id': 'ECU_012', 'name': 'DCM', 'version': 'v1.5.0', 'hw_ver': 'v1.0.0', 'priority': 1, 'size_kb': 128},
+            {'ecu_id': 'ECU_012', 'name': 'DCM', 'version': 'v1.5.0', 'hw_ver': 'v1.0.0', 'priority': 1, 'size_kb': 128,
+             'depends': [('ECU_011', 'v2.0.0')]},
         ]
     },
     # Zone 2 ECUs (Rear)
@@ -47,7 +52,8 @@ ECU_CONFIG = {
         'zone_name': 'Zone_Rear_Left',
         'zone_number': 2,
         'ecus': [
-            {'ecu_id': 'ECU_021', 'name': 'Camera', 'version': 'v1.0.0', 'hw_ver': 'v1.0.0', 'priority': 0, 'size_kb': 512},
+            {'ecu_id': 'ECU_021', 'name': 'Camera', 'version': 'v1.0.0', 'hw_ver': 'v1.0.0', 'priority': 0, 'size_kb': 512,
+             'depends': [('ECU_091', 'v2.0.0')]},
             {'ecu_id': 'ECU_022', 'name': 'Radar', 'version': 'v1.0.0', 'hw_ver': 'v1.0.0', 'priority': 1, 'size_kb': 384},
         ]
     },
@@ -76,7 +82,50 @@ def crc32_calculate(data):
     """CRC32 계산"""
     return zlib.crc32(data) & 0xFFFFFFFF
 
-def generate_dummy_firmware(ecu_id, size_kb):
+def make_synthetic_config(zone_count, ecus_per_zone, firmware_kb):
+    """합성 ECU 구성 생성 (부하 테스트용, vmg-pack과 동일)"""
+    if not 1 <= zone_count <= MAX_ZONES_IN_VEHICLE:
+        raise ValueError(f"zone count {zone_count} (1~{MAX_ZONES_IN_VEHICLE})")
+    if not 1 <= ecus_per_zone <= MAX_ECUS_IN_ZONE:
+        raise ValueError(f"ECUs per zone {ecus_per_zone} (1~{MAX_ECUS_IN_ZONE})")
+    if firmware_kb < 1:
+        raise ValueError(f"firmware size {firmware_kb} KB (min 1)")
+    
+    config = {}
+    for z in range(1, zone_count + 1):
+        config[f'zone_{z}'] = {
+            'zone_id': f'Zone_{z:02d}',
+            'zone_name': f'Zone_{z:02d}_Synthetic',
+            'zone_number': z,
+            'ecus': [
+                {'ecu_id': f'ECU_{z:02d}{e:02d}', 'name': f'ECU{e}', 'version': 'v1.0.0',
+                 'hw_ver': 'v1.0.0', 'priority': e - 1, 'size_kb': firmware_kb}
+                for e in range(1, ecus_per_zone + 1)
+            ]
+        }
+    return config
+
+def fnv1a64(text):
+    """FNV-1a 64-bit hash (per-ECU seed)"""
+    h = 0xCBF29CE484222325
+    for b in text.encode('ascii'):
+        h = ((h ^ b) * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+def seeded_bytes(seed, ecu_id, size):
+    """splitmix64 바이트 스트림 (vmg-pack과 동일)"""
+    mask = 0xFFFFFFFFFFFFFFFF
+    state = (seed + fnv1a64(ecu_id)) & mask
+    words = []
+    for _ in range((size + 7) // 8):
+        state = (state + 0x9E3779B97F4A7C15) & mask
+        z = state
+        z = ((z ^ (z >> 30)) * 0xBF58476D1CE4E5B9) & mask
+        z = ((z ^ (z >> 27)) * 0x94D049BB133111EB) & mask
+        words.append(z ^ (z >> 31))
+    return struct.pack(f'<{len(words)}Q', *words)[:size]
+
+def generate_dummy_firmware(ecu_id, size_kb, seed=None):
     """더미 펌웨어 생성 (테스트용)"""
     firmware = bytearray()
     
@@ -84,6 +133,11 @@ def generate_dummy_firmware(ecu_id, size_kb):
     header = f"FIRMWARE_{ecu_id}".ljust(64, '\0').encode('ascii')
     firmware.extend(header)
     
+    # Seeded 데이터 (재현 가능한 빌드)
+    if seed is not None:
+        firmware.extend(seeded_bytes(seed, ecu_id, (size_kb * 1024) - len(firmware)))
+        return bytes(firmware)
+    
     # 패턴 데이터
     pattern = bytes([i % 256 for i in range(1024)])
     remaining = (size_kb * 1024) - len(firmware)
@@ -97,7 +151,7 @@ def generate_dummy_firmware(ecu_id, size_kb):
 
 # ==================== ECU Package ====================
 
-def create_ecu_package(ecu_config):
+def create_ecu_package(ecu_config, seed=None, timestamp=None):
     """
     ECU Package 생성
     
@@ -112,7 +166,7 @@ def create_ecu_package(ecu_config):
     print(f"  [ECU] Creating {ecu_id} package...")
     
     # Generate firmware
-    firmware = generate_dummy_firmware(ecu_id, ecu_config['size_kb'])
+    firmware = generate_dummy_firmware(ecu_id, ecu_config['size_kb'], seed)
     firmware_size = len(firmware)
     firmware_crc32 = crc32_calculate(firmware)
     
@@ -131,19 +185,24 @@ def create_ecu_package(ecu_config):
     struct.pack_into('<I', metadata, 24, hw_version)
     struct.pack_into('<I', metadata, 28, firmware_size)
     struct.pack_into('<I', metadata, 32, firmware_crc32)
-    struct.pack_into('<I', metadata, 36, int(time.time()))
+    struct.pack_into('<I', metadata, 36, timestamp)
     
     # Version string
     version_str = ecu_config['version'].ljust(32, '\0').encode('ascii')
     metadata[40:72] = version_str
     
-    # Dependency count (0 for now)
-    metadata[72] = 0
+    # Dependencies (8 × 20 bytes, offset 76): ECU that must be flashed first + min version
+    depends = ecu_config.get('depends', [])
+    if len(depends) > 8:
+        raise ValueError(f"{ecu_id}: {len(depends)} dependencies (max 8)")
+    metadata[72] = len(depends)
     
-    # Dependencies (8 × 32 bytes)
-    # (reserved for now)
+    for i, (dep_id, min_version) in enumerate(depends):
+        dep_offset = 76 + (i * 20)
+        metadata[dep_offset:dep_offset+16] = dep_id.encode('ascii').ljust(16, b'\x00')
+        struct.pack_into('<I', metadata, dep_offset+16, version_to_int(min_version))
     
-    # Reserved2 (144 bytes)
+    # Reserved2 (20 bytes)
     # (already zeroed)
     
     # Combine metadata + firmware
@@ -157,7 +216,7 @@ def create_ecu_package(ecu_config):
 
 # ==================== Zone Package ====================
 
-def create_zone_package(zone_config):
+def create_zone_package(zone_config, seed=None, timestamp=None):
     """
     Zone Package 생성
     
@@ -173,12 +232,15 @@ def create_zone_package(zone_config):
     
     print(f"\n[Zone] Creating Zone {zone_number} ({zone_name})...")
     
+    if len(zone_config['ecus']) > MAX_ECUS_IN_ZONE:
+        raise ValueError(f"Zone {zone_number}: {len(zone_config['ecus'])} ECUs (max {MAX_ECUS_IN_ZONE})")
+    
     # Create ECU packages
     ecu_packages = []
     current_offset = 1024  # Zone header size
     
     for ecu_cfg in zone_config['ecus']:
-        ecu_pkg, fw_size, fw_crc, version = create_ecu_package(ecu_cfg)
+        ecu_pkg, fw_size, fw_crc, version = create_ecu_package(ecu_cfg, seed, timestamp)
         ecu_pkg_crc = crc32_calculate(ecu_pkg)
         
         ecu_packages.append({
@@ -222,7 +284,7 @@ def create_zone_package(zone_config):
     # struct.pack_into('<I', header, 32, zone_crc32)
     
     # Timestamp
-    struct.pack_into('<I', header, 36, int(time.time()))
+    struct.pack_into('<I', header, 36, timestamp)
     
     # Zone name
     zone_name_bytes = zone_name.encode('ascii').ljust(32, b'\x00')
@@ -263,7 +325,8 @@ def create_zone_package(zone_config):
 
 # ==================== Vehicle Package ====================
 
-def create_vehicle_package(output_path, vin, model, model_year):
+def create_vehicle_package(output_path, vin, model, model_year,
+                           ecu_config=None, seed=None, timestamp=None):
     """
     Vehicle Package 생성 (최상위)
     
@@ -272,7 +335,14 @@ def create_vehicle_package(output_path, vin, model, model_year):
         - Zone Package #1
         - Zone Package #2
         - ...
+    
+    seed: 지정 시 펌웨어를 seeded 데이터로 채우고 timestamp 기본값은 0
     """
+    if ecu_config is None:
+        ecu_config = ECU_CONFIG
+    if timestamp is None:
+        timestamp = 0 if seed is not None else int(time.time())
+    
     print("\n" + "="*60)
     print("  Vehicle Package Creator")
     print("="*60)
@@ -284,8 +354,8 @@ def create_vehicle_package(output_path, vin, model, model_year):
     zone_packages = []
     current_offset = 12288  # Vehicle metadata size (12KB)
     
-    for zone_key, zone_cfg in ECU_CONFIG.items():
-        zone_pkg, zone_id, zone_num, ecu_count = create_zone_package(zone_cfg)
+    for zone_key, zone_cfg in ecu_config.items():
+        zone_pkg, zone_id, zone_num, ecu_count = create_zone_package(zone_cfg, seed, timestamp)
         
         zone_packages.append({
             'zone_id': zone_id,
@@ -360,7 +430,16 @@ def create_vehicle_package(output_path, vin, model, model_year):
         metadata[entry_offset+25] = zone['ecu_count']
     
     # ECU Quick Reference (starts at offset 704)
-    # (optional, skipping for now)
+    # VMG는 이 테이블과 VCI를 비교해 업데이트가 필요한 Zone만 다운로드
+    ecu_ref_offset = 704
+    ecu_index = 0
+    for zone_cfg in ecu_config.values():
+        for ecu_cfg in zone_cfg['ecus']:
+            entry_offset = ecu_ref_offset + (ecu_index * 32)
+            metadata[entry_offset:entry_offset+16] = ecu_cfg['ecu_id'].encode('ascii')[:16].ljust(16, b'\x00')
+            metadata[entry_offset+16] = zone_cfg['zone_number']
+            struct.pack_into('<I', metadata, entry_offset+17, version_to_int(ecu_cfg['version']))
+            ecu_index += 1
     
     # Vehicle CRC32 (will calculate after assembly)
     # struct.pack_into('<I', metadata, 144, vehicle_crc32)
@@ -374,6 +453,10 @@ def create_vehicle_package(output_path, vin, model, model_year):
     vehicle_crc32 = crc32_calculate(vehicle_package[12288:])
     struct.pack_into('<I', vehicle_package, 144, vehicle_crc32)
     
+    # Metadata CRC32 (metadata with this field still 0)
+    metadata_crc32 = crc32_calculate(vehicle_package[:12288])
+    struct.pack_into('<I', vehicle_package, 148, metadata_crc32)
+    
     # Write to file
     output_file = Path(output_path)
     output_file.parent.mkdir(parents=True, exist_ok=True)
@@ -389,6 +472,7 @@ def create_vehicle_package(output_path, vin, model, model_year):
     print(f"Zone Packages: {len(zone_packages)}")
     print(f"Total ECUs: {total_ecu_count}")
     print(f"Vehicle CRC32: 0x{vehicle_crc32:08X}")
+    print(f"Metadata CRC32: 0x{metadata_crc32:08X}")
     print("="*60)
     
     return output_path
@@ -405,10 +489,25 @@ def main():
                         help='Vehicle model (default: Genesis GV80)')
     parser.add_argument('--year', type=int, default=2024,
                         help='Model year (default: 2024)')
+    parser.add_argument('--zones', type=int, default=0,
+                        help='Synthetic layout: number of zones (default: built-in ECU config)')
+    parser.add_argument('--ecus-per-zone', type=int, default=2,
+                        help='Synthetic layout: ECUs per zone (default: 2)')
+    parser.add_argument('--firmware-kb', type=int, default=256,
+                        help='Synthetic layout: firmware size per ECU in KB (default: 256)')
+    parser.add_argument('--seed', type=int, default=None,
+                        help='Reproducible build: seeded firmware, fixed timestamps')
+    parser.add_argument('--timestamp', type=int, default=None,
+                        help='Build timestamp (default: now, or 0 with --seed)')
     
     args = parser.parse_args()
     
-    create_vehicle_package(args.output, args.vin, args.model, args.year)
+    ecu_config = None
+    if args.zones > 0:
+        ecu_config = make_synthetic_config(args.zones, args.ecus_per_zone, args.firmware_kb)
+    
+    create_vehicle_package(args.output, args.vin, args.model, args.year,
+                           ecu_config, args.seed, args.timestamp)
 
 if __name__ == '__main__':
     main()
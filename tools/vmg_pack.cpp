@@ -0,0 +1,826 @@
+/**
+ * @file vmg_pack.cpp
+ * @brief High-speed Vehicle Package builder (vmg-pack)
+ *
+ * Native counterpart of tools/vehicle_package_simulator.py for load tests
+ * with multi-GB packages. Uses the packed structs from vehicle_package.hpp /
+ * zone_package.hpp, so the layout cannot drift from the parser.
+ *
+ * The layout is fixed before any byte is written, so every ECU Package is
+ * generated, CRC'd and written (pwrite) at its final offset by a pool of
+ * worker threads with a fixed-size buffer each. Zone and vehicle CRCs are
+ * assembled with crc32Combine; nothing is read back.
+ *
+ * Output is byte-identical to the Python tool with the same options and
+ * --seed (without --seed both use the pattern firmware and the current time).
+ *
+ * With --compress zstd each firmware is stored as one zstd frame
+ * (ecu_compression.hpp). Compressed sizes are unknown up front, so ECU
+ * Packages are first written into worst-case slots, then moved down to their
+ * final offsets in one sequential pass before the headers are written.
+ *
+ * Usage:
+ *   vmg-pack -o <file> [--zones N --ecus-per-zone M --firmware-kb K]
+ *            [--seed S] [--timestamp T] [--threads N]
+ *            [--compress zstd[:LEVEL]] [--window-log N]
+ *            [--vin VIN] [--model MODEL] [--year YEAR]
+ *            [--corrupt TARGET]...
+ *
+ * Corruption targets (applied after the package is complete):
+ *   vehicle-crc            Flip VehiclePackageMetadata::vehicle_crc32 (metadata resealed)
+ *   metadata-crc           Flip VehiclePackageMetadata::metadata_crc32
+ *   zone-crc:<zone>        Flip ZonePackageHeader::zone_crc32
+ *   zone-magic:<zone>      Flip ZonePackageHeader::magic_number
+ *   ecu-crc:<ECU_ID>       Flip ZoneECUEntry::crc32
+ *   firmware:<ECU_ID>      Flip one byte in the middle of the firmware
+ *   truncate:<bytes>       Cut bytes off the end of the file
+ */
+
+#include "vehicle_package.hpp"
+#include "zone_package.hpp"
+#include "package_crc.hpp"
+#include "ecu_compression.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ==================== Constants ====================
+
+#define PACK_BUFFER_SIZE        (1024 * 1024)   // Per-worker firmware buffer (multiple of 8)
+#define PACK_FIRMWARE_HEADER    64              // "FIRMWARE_<ecu_id>" + NUL padding
+
+// ==================== Package Layout ====================
+
+struct EcuSpec {
+    std::string ecu_id;
+    std::string version;                // "v2.0.1"
+    std::string hw_version;
+    uint8_t priority;
+    uint32_t firmware_size;
+    std::vector<std::pair<std::string, std::string>> depends;   // (ECU ID, min version)
+    
+    // Filled by layout / workers
+    uint64_t offset;                    // Absolute file offset of the ECU Package
+    uint64_t stored_size;               // Firmware bytes in the package (worst case until compressed)
+    uint8_t window_log;                 // zstd window (compressed only)
+    uint32_t firmware_crc32;            // Firmware image
+    uint32_t package_crc32;             // metadata + firmware as stored
+};
+
+struct ZoneSpec {
+    std::string zone_id;
+    std::string zone_name;
+    uint8_t zone_number;
+    std::vector<EcuSpec> ecus;
+    
+    uint64_t offset;
+    uint64_t size;
+    uint32_t zone_crc32;                // Body after the 1KB header
+    uint32_t header_crc32;
+};
+
+struct PackOptions {
+    std::string output;
+    std::string vin = "KMHXX00XXXX000001";
+    std::string model = "Genesis GV80";
+    uint16_t year = 2024;
+    unsigned zones = 0;                 // 0 = built-in ECU config
+    unsigned ecus_per_zone = 2;
+    unsigned firmware_kb = 256;
+    bool seeded = false;
+    uint64_t seed = 0;
+    bool has_timestamp = false;
+    uint32_t timestamp = 0;
+    unsigned threads = 0;
+    bool compress = false;
+    int level = ECU_ZSTD_LEVEL_DEFAULT;
+    unsigned window_log = ECU_ZSTD_WINDOW_LOG_DEFAULT;
+    std::vector<std::string> corruptions;
+    bool help = false;
+};
+
+// ==================== Helpers ====================
+
+/**
+ * @brief v1.2.3 → 0x00010203 (same as version_to_int in the Python tool)
+ */
+static uint32_t versionToInt(const std::string& version) {
+    uint32_t parts[3] = {0, 0, 0};
+    size_t pos = (!version.empty() && version[0] == 'v') ? 1 : 0;
+    for (int i = 0; i < 3 && pos <= version.size(); i++) {
+        size_t dot = version.find('.', pos);
+        parts[i] = static_cast<uint32_t>(std::strtoul(version.substr(pos, dot - pos).c_str(), nullptr, 10));
+        if (dot == std::string::npos) {
+            break;
+        }
+        pos = dot + 1;
+    }
+    return (parts[0] << 16) | (parts[1] << 8) | parts[2];
+}
+
+/**
+ * @brief Copy string into a fixed-width field (NUL padded, truncated)
+ */
+static void copyField(char* field, size_t width, const std::string& value) {
+    std::memset(field, 0, width);
+    std::memcpy(field, value.data(), std::min(width, value.size()));
+}
+
+static uint64_t fnv1a64(const std::string& text) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static bool writeAt(int fd, const void* data, size_t size, uint64_t offset) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+// ==================== Firmware Generator ====================
+
+/**
+ * @brief Dummy firmware byte stream (generate_dummy_firmware in the Python tool)
+ *
+ * 64-byte "FIRMWARE_<ecu_id>" header, then either the 0..255 pattern or,
+ * with a seed, a splitmix64 stream seeded with seed + FNV-1a(ecu_id) and
+ * emitted as little-endian 64-bit words.
+ */
+class FirmwareStream {
+public:
+    FirmwareStream(const std::string& ecu_id, bool seeded, uint64_t seed)
+        : ecu_id_(ecu_id), seeded_(seeded), state_(seed + fnv1a64(ecu_id)), position_(0) {}
+    
+    /**
+     * @brief Produce the next size bytes (size must be a multiple of 8 except at the end)
+     */
+    void fill(uint8_t* out, size_t size) {
+        size_t i = 0;
+        
+        // Header
+        while (i < size && position_ < PACK_FIRMWARE_HEADER) {
+            std::string header = "FIRMWARE_" + ecu_id_;
+            out[i++] = position_ < header.size() ? static_cast<uint8_t>(header[position_]) : 0;
+            position_++;
+        }
+        
+        // Body
+        uint64_t body = position_ - PACK_FIRMWARE_HEADER;
+        if (!seeded_) {
+            for (; i < size; i++, body++) {
+                out[i] = static_cast<uint8_t>(body);
+            }
+        } else {
+            for (; i < size; i += 8, body += 8) {
+                uint64_t word = next();
+                for (size_t b = 0; b < 8 && i + b < size; b++) {
+                    out[i + b] = static_cast<uint8_t>(word >> (8 * b));
+                }
+            }
+        }
+        position_ = PACK_FIRMWARE_HEADER + body;
+    }
+
+private:
+    std::string ecu_id_;
+    bool seeded_;
+    uint64_t state_;
+    uint64_t position_;
+    
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+// ==================== Configuration ====================
+
+/**
+ * @brief Built-in ECU config (ECU_CONFIG in the Python tool)
+ */
+static std::vector<ZoneSpec> defaultConfig() {
+    auto ecu = [](const char* id, const char* version, uint8_t priority, uint32_t size_kb,
+                  std::vector<std::pair<std::string, std::string>> depends = {}) {
+        EcuSpec spec = {};
+        spec.ecu_id = id;
+        spec.version = version;
+        spec.hw_version = "v1.0.0";
+        spec.priority = priority;
+        spec.firmware_size = size_kb * 1024;
+        spec.depends = depends;
+        return spec;
+    };
+    
+    std::vector<ZoneSpec> zones(3);
+    zones[0].zone_id = "Zone_Front";
+    zones[0].zone_name = "Zone_Front_Left";
+    zones[0].zone_number = 1;
+    zones[0].ecus = { ecu("ECU_011", "v2.0.1", 0, 256),
+                      ecu("ECU_012", "v1.5.0", 1, 128, {{"ECU_011", "v2.0.0"}}) };
+    
+    zones[1].zone_id = "Zone_Rear";
+    zones[1].zone_name = "Zone_Rear_Left";
+    zones[1].zone_number = 2;
+    zones[1].ecus = { ecu("ECU_021", "v1.0.0", 0, 512, {{"ECU_091", "v2.0.0"}}),
+                      ecu("ECU_022", "v1.0.0", 1, 384) };
+    
+    zones[2].zone_id = "Zone_Gateway";
+    zones[2].zone_name = "Zone_Central_Gateway";
+    zones[2].zone_number = 9;
+    zones[2].ecus = { ecu("ECU_091", "v2.0.0", 10, 1024) };
+    
+    return zones;
+}
+
+/**
+ * @brief Synthetic layout (make_synthetic_config in the Python tool)
+ */
+static std::vector<ZoneSpec> syntheticConfig(unsigned zone_count, unsigned ecus_per_zone, unsigned firmware_kb) {
+    std::vector<ZoneSpec> zones;
+    for (unsigned z = 1; z <= zone_count; z++) {
+        char zone_id[16];
+        std::snprintf(zone_id, sizeof(zone_id), "Zone_%02u", z);
+        
+        ZoneSpec zone = {};
+        zone.zone_id = zone_id;
+        zone.zone_name = std::string(zone_id) + "_Synthetic";
+        zone.zone_number = static_cast<uint8_t>(z);
+        
+        for (unsigned e = 1; e <= ecus_per_zone; e++) {
+            char ecu_id[16];
+            std::snprintf(ecu_id, sizeof(ecu_id), "ECU_%02u%02u", z, e);
+            
+            EcuSpec ecu = {};
+            ecu.ecu_id = ecu_id;
+            ecu.version = "v1.0.0";
+            ecu.hw_version = "v1.0.0";
+            ecu.priority = static_cast<uint8_t>(e - 1);
+            ecu.firmware_size = firmware_kb * 1024;
+            zone.ecus.push_back(ecu);
+        }
+        zones.push_back(zone);
+    }
+    return zones;
+}
+
+/**
+ * @brief Assign offsets from stored sizes; fails if a final layout exceeds the 32-bit fields
+ */
+static bool layoutPackage(std::vector<ZoneSpec>& zones, uint64_t& total_size, bool final_layout = true) {
+    uint64_t offset = sizeof(VehiclePackageMetadata);
+    
+    for (ZoneSpec& zone : zones) {
+        zone.offset = offset;
+        uint64_t ecu_offset = offset + sizeof(ZonePackageHeader);
+        for (EcuSpec& ecu : zone.ecus) {
+            ecu.offset = ecu_offset;
+            ecu_offset += sizeof(ECUMetadata) + ecu.stored_size;
+        }
+        zone.size = ecu_offset - offset;
+        offset = ecu_offset;
+    }
+    
+    total_size = offset;
+    if (final_layout && total_size > UINT32_MAX) {
+        std::cerr << "[Pack] ✗ Package size " << total_size << " exceeds 4GB (32-bit size fields)\n";
+        return false;
+    }
+    return true;
+}
+
+// ==================== Package Writer ====================
+
+/**
+ * @brief Generate, CRC and write one ECU Package (metadata + firmware)
+ */
+static bool writeECUPackage(int fd, EcuSpec& ecu, const PackOptions& options, uint8_t* buffer) {
+    FirmwareStream stream(ecu.ecu_id, options.seeded, options.seed);
+    uint64_t firmware_offset = ecu.offset + sizeof(ECUMetadata);
+    uint32_t crc = 0;
+    uint32_t stored_crc = 0;
+    uint64_t stored = 0;
+    
+    // Compressed frames go into the worst-case slot reserved by the layout
+    ZstdStreamEncoder encoder(options.level, options.window_log);
+    auto store = [&](const uint8_t* data, size_t size) {
+        if (stored + size > ecu.stored_size || !writeAt(fd, data, size, firmware_offset + stored)) {
+            return false;
+        }
+        stored_crc = crc32Update(stored_crc, data, size);
+        stored += size;
+        return true;
+    };
+    if (options.compress && !encoder.begin(ecu.firmware_size)) {
+        std::cerr << "[Pack] ✗ " << ecu.ecu_id << ": " << encoder.getError() << "\n";
+        return false;
+    }
+    
+    for (uint64_t done = 0; done < ecu.firmware_size; ) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(PACK_BUFFER_SIZE, ecu.firmware_size - done));
+        stream.fill(buffer, chunk);
+        crc = crc32Update(crc, buffer, chunk);
+        done += chunk;
+        
+        bool ok = options.compress ? encoder.compress(buffer, chunk, done == ecu.firmware_size, store)
+                                   : store(buffer, chunk);
+        if (!ok) {
+            return false;
+        }
+    }
+    ecu.firmware_crc32 = crc;
+    ecu.stored_size = stored;
+    ecu.window_log = options.compress ? encoder.windowLog() : 0;
+    
+    ECUMetadata metadata;
+    std::memset(&metadata, 0, sizeof(metadata));
+    metadata.magic_number = ECU_METADATA_MAGIC;
+    copyField(metadata.ecu_id, sizeof(metadata.ecu_id), ecu.ecu_id);
+    metadata.sw_version = versionToInt(ecu.version);
+    metadata.hw_version = versionToInt(ecu.hw_version);
+    metadata.firmware_size = ecu.firmware_size;
+    metadata.firmware_crc32 = ecu.firmware_crc32;
+    metadata.build_timestamp = options.timestamp;
+    copyField(metadata.version_string, sizeof(metadata.version_string), ecu.version);
+    metadata.dependency_count = static_cast<uint8_t>(ecu.depends.size());
+    for (size_t d = 0; d < ecu.depends.size(); d++) {
+        copyField(metadata.dependencies[d].ecu_id, sizeof(metadata.dependencies[d].ecu_id), ecu.depends[d].first);
+        metadata.dependencies[d].min_version = versionToInt(ecu.depends[d].second);
+    }
+    
+    uint32_t metadata_crc = crc32Update(0, reinterpret_cast<const uint8_t*>(&metadata), sizeof(metadata));
+    ecu.package_crc32 = crc32Combine(metadata_crc, stored_crc, stored);
+    
+    return writeAt(fd, &metadata, sizeof(metadata), ecu.offset);
+}
+
+/**
+ * @brief Move ECU Packages from their worst-case slots to the final layout
+ *
+ * Final offsets never exceed the reserved ones, so packages are moved down
+ * in file order with a forward copy (safe for overlapping ranges).
+ */
+static bool compactPackage(int fd, std::vector<ZoneSpec>& zones, uint64_t& total_size, uint8_t* buffer) {
+    std::vector<uint64_t> reserved;
+    for (const ZoneSpec& zone : zones) {
+        for (const EcuSpec& ecu : zone.ecus) {
+            reserved.push_back(ecu.offset);
+        }
+    }
+    
+    if (!layoutPackage(zones, total_size)) {
+        return false;
+    }
+    
+    size_t index = 0;
+    for (const ZoneSpec& zone : zones) {
+        for (const EcuSpec& ecu : zone.ecus) {
+            uint64_t from = reserved[index++];
+            uint64_t size = sizeof(ECUMetadata) + ecu.stored_size;
+            for (uint64_t done = 0; from != ecu.offset && done < size; ) {
+                size_t chunk = static_cast<size_t>(std::min<uint64_t>(PACK_BUFFER_SIZE, size - done));
+                if (::pread(fd, buffer, chunk, static_cast<off_t>(from + done)) != static_cast<ssize_t>(chunk) ||
+                    !writeAt(fd, buffer, chunk, ecu.offset + done)) {
+                    return false;
+                }
+                done += chunk;
+            }
+        }
+    }
+    
+    return ::ftruncate(fd, static_cast<off_t>(total_size)) == 0;
+}
+
+/**
+ * @brief Build the zone header from finished ECU Packages and write it
+ */
+static bool writeZoneHeader(int fd, ZoneSpec& zone, const PackOptions& options) {
+    ZonePackageHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic_number = ZONE_PACKAGE_MAGIC;
+    header.version = 0x00010000;
+    header.total_size = static_cast<uint32_t>(zone.size);
+    copyField(header.zone_id, sizeof(header.zone_id), zone.zone_id);
+    header.zone_number = zone.zone_number;
+    header.package_count = static_cast<uint8_t>(zone.ecus.size());
+    header.timestamp = options.timestamp;
+    copyField(header.zone_name, sizeof(header.zone_name), zone.zone_name);
+    
+    uint32_t crc = 0;
+    for (size_t i = 0; i < zone.ecus.size(); i++) {
+        const EcuSpec& ecu = zone.ecus[i];
+        ZoneECUEntry& entry = header.ecu_table[i];
+        uint32_t size = static_cast<uint32_t>(sizeof(ECUMetadata) + ecu.stored_size);
+        
+        copyField(entry.ecu_id, sizeof(entry.ecu_id), ecu.ecu_id);
+        entry.offset = static_cast<uint32_t>(ecu.offset - zone.offset);
+        entry.size = size;
+        entry.metadata_size = sizeof(ECUMetadata);
+        entry.firmware_size = static_cast<uint32_t>(ecu.stored_size);
+        entry.firmware_version = versionToInt(ecu.version);
+        entry.crc32 = ecu.package_crc32;
+        entry.priority = ecu.priority;
+        if (options.compress) {
+            entry.compression = ECU_COMPRESSION_ZSTD;
+            entry.window_log = ecu.window_log;
+            entry.uncompressed_size = ecu.firmware_size;
+        }
+        
+        crc = crc32Combine(crc, ecu.package_crc32, size);
+    }
+    zone.zone_crc32 = crc;
+    header.zone_crc32 = crc;
+    
+    zone.header_crc32 = crc32Update(0, reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    return writeAt(fd, &header, sizeof(header), zone.offset);
+}
+
+/**
+ * @brief Build the vehicle metadata from finished zones and write it
+ */
+static bool writeVehicleMetadata(int fd, const std::vector<ZoneSpec>& zones, uint64_t total_size,
+                                 const PackOptions& options, uint32_t& vehicle_crc) {
+    // VehiclePackageMetadata is 12KB; keep it off the stack
+    std::vector<uint8_t> buffer(sizeof(VehiclePackageMetadata), 0);
+    VehiclePackageMetadata& metadata = *reinterpret_cast<VehiclePackageMetadata*>(buffer.data());
+    
+    metadata.magic_number = VEHICLE_PACKAGE_MAGIC;
+    metadata.version = 0x00010000;
+    metadata.total_size = static_cast<uint32_t>(total_size);
+    copyField(metadata.vin, sizeof(metadata.vin), options.vin);
+    copyField(metadata.model, sizeof(metadata.model), options.model);
+    metadata.model_year = options.year;
+    metadata.region = 3;    // Korea
+    metadata.master_sw_version = versionToInt("v2.0.0");
+    copyField(metadata.master_sw_string, sizeof(metadata.master_sw_string), "v2.0.0");
+    metadata.zone_count = static_cast<uint8_t>(zones.size());
+    
+    unsigned total_ecus = 0;
+    vehicle_crc = 0;
+    for (size_t i = 0; i < zones.size(); i++) {
+        const ZoneSpec& zone = zones[i];
+        ZoneReference& ref = metadata.zone_refs[i];
+        
+        copyField(ref.zone_id, sizeof(ref.zone_id), zone.zone_id);
+        ref.offset = static_cast<uint32_t>(zone.offset);
+        ref.size = static_cast<uint32_t>(zone.size);
+        ref.zone_number = zone.zone_number;
+        ref.ecu_count = static_cast<uint8_t>(zone.ecus.size());
+        
+        // ECU Quick Reference: lets the VMG plan a selective download from the metadata alone
+        for (const EcuSpec& ecu : zone.ecus) {
+            ECUReference& ecu_ref = metadata.ecu_refs[total_ecus++];
+            copyField(ecu_ref.ecu_id, sizeof(ecu_ref.ecu_id), ecu.ecu_id);
+            ecu_ref.zone_number = zone.zone_number;
+            ecu_ref.firmware_version = versionToInt(ecu.version);
+        }
+        
+        vehicle_crc = crc32Combine(vehicle_crc, zone.header_crc32, sizeof(ZonePackageHeader));
+        vehicle_crc = crc32Combine(vehicle_crc, zone.zone_crc32, zone.size - sizeof(ZonePackageHeader));
+    }
+    metadata.total_ecu_count = static_cast<uint8_t>(total_ecus);
+    metadata.vehicle_crc32 = vehicle_crc;
+    metadata.metadata_crc32 = calculateMetadataCRC32(metadata);
+    
+    return writeAt(fd, buffer.data(), buffer.size(), 0);
+}
+
+// ==================== Corruption Injection ====================
+
+static bool flipBytes(int fd, uint64_t offset, size_t count) {
+    uint8_t bytes[8];
+    if (count > sizeof(bytes) || ::pread(fd, bytes, count, static_cast<off_t>(offset)) != static_cast<ssize_t>(count)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        bytes[i] ^= 0xFF;
+    }
+    return writeAt(fd, bytes, count, offset);
+}
+
+static bool resealMetadata(int fd) {
+    std::vector<uint8_t> buffer(sizeof(VehiclePackageMetadata));
+    if (::pread(fd, buffer.data(), buffer.size(), 0) != static_cast<ssize_t>(buffer.size())) {
+        return false;
+    }
+    VehiclePackageMetadata& metadata = *reinterpret_cast<VehiclePackageMetadata*>(buffer.data());
+    metadata.metadata_crc32 = calculateMetadataCRC32(metadata);
+    return writeAt(fd, &metadata.metadata_crc32, sizeof(metadata.metadata_crc32),
+                   offsetof(VehiclePackageMetadata, metadata_crc32));
+}
+
+static const ZoneSpec* findZone(const std::vector<ZoneSpec>& zones, const std::string& number) {
+    for (const ZoneSpec& zone : zones) {
+        if (std::to_string(zone.zone_number) == number) {
+            return &zone;
+        }
+    }
+    return nullptr;
+}
+
+static bool applyCorruption(int fd, const std::vector<ZoneSpec>& zones, uint64_t total_size,
+                            const std::string& spec) {
+    size_t colon = spec.find(':');
+    std::string target = spec.substr(0, colon);
+    std::string arg = colon == std::string::npos ? "" : spec.substr(colon + 1);
+    
+    // Resealed so the package fails the body CRC, not the metadata check
+    if (target == "vehicle-crc") {
+        return flipBytes(fd, offsetof(VehiclePackageMetadata, vehicle_crc32), 4) && resealMetadata(fd);
+    }
+    
+    if (target == "metadata-crc") {
+        return flipBytes(fd, offsetof(VehiclePackageMetadata, metadata_crc32), 4);
+    }
+    
+    if (target == "zone-crc" || target == "zone-magic") {
+        const ZoneSpec* zone = findZone(zones, arg);
+        if (!zone) {
+            std::cerr << "[Pack] ✗ No zone " << arg << "\n";
+            return false;
+        }
+        size_t field = target == "zone-crc" ? offsetof(ZonePackageHeader, zone_crc32)
+                                            : offsetof(ZonePackageHeader, magic_number);
+        return flipBytes(fd, zone->offset + field, 4);
+    }
+    
+    if (target == "ecu-crc" || target == "firmware") {
+        for (const ZoneSpec& zone : zones) {
+            for (size_t i = 0; i < zone.ecus.size(); i++) {
+                const EcuSpec& ecu = zone.ecus[i];
+                if (ecu.ecu_id != arg) {
+                    continue;
+                }
+                if (target == "firmware") {
+                    return flipBytes(fd, ecu.offset + sizeof(ECUMetadata) + ecu.stored_size / 2, 1);
+                }
+                return flipBytes(fd, zone.offset + offsetof(ZonePackageHeader, ecu_table) +
+                                     i * sizeof(ZoneECUEntry) + offsetof(ZoneECUEntry, crc32), 4);
+            }
+        }
+        std::cerr << "[Pack] ✗ No ECU " << arg << "\n";
+        return false;
+    }
+    
+    if (target == "truncate") {
+        uint64_t cut = std::strtoull(arg.c_str(), nullptr, 10);
+        if (cut == 0 || cut >= total_size) {
+            std::cerr << "[Pack] ✗ Invalid truncate size: " << arg << "\n";
+            return false;
+        }
+        return ::ftruncate(fd, static_cast<off_t>(total_size - cut)) == 0;
+    }
+    
+    std::cerr << "[Pack] ✗ Unknown corruption target: " << spec << "\n";
+    return false;
+}
+
+// ==================== Main ====================
+
+static void printUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " -o <file> [options]\n"
+        << "  --zones N            Synthetic layout: number of zones (default: built-in ECU config)\n"
+        << "  --ecus-per-zone M    Synthetic layout: ECUs per zone (default: 2)\n"
+        << "  --firmware-kb K      Synthetic layout: firmware size per ECU in KB (default: 256)\n"
+        << "  --seed S             Reproducible build: seeded firmware, fixed timestamps\n"
+        << "  --timestamp T        Build timestamp (default: now, or 0 with --seed)\n"
+        << "  --threads N          Worker threads (default: 0 = one per CPU core)\n"
+        << "  --compress zstd[:L]  Store firmware zstd-compressed (level L, default "
+        << ECU_ZSTD_LEVEL_DEFAULT << ")\n"
+        << "  --window-log N       Max zstd window 2^N bytes (default " << ECU_ZSTD_WINDOW_LOG_DEFAULT << ")\n"
+        << "  --vin / --model / --year   Vehicle target\n"
+        << "  --corrupt TARGET     vehicle-crc | metadata-crc | zone-crc:<zone> | zone-magic:<zone> |\n"
+        << "                       ecu-crc:<ECU_ID> | firmware:<ECU_ID> | truncate:<bytes>\n"
+        << "  -h, --help           Show this help\n";
+}
+
+static bool parseOptions(int argc, char* argv[], PackOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            options.help = true;
+            return true;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "[Pack] ✗ Missing value for " << arg << "\n";
+            return false;
+        }
+        std::string value = argv[++i];
+        
+        if (arg == "-o" || arg == "--output") {
+            options.output = value;
+        } else if (arg == "--vin") {
+            options.vin = value;
+        } else if (arg == "--model") {
+            options.model = value;
+        } else if (arg == "--year") {
+            options.year = static_cast<uint16_t>(std::atoi(value.c_str()));
+        } else if (arg == "--zones") {
+            options.zones = static_cast<unsigned>(std::atoi(value.c_str()));
+        } else if (arg == "--ecus-per-zone") {
+            options.ecus_per_zone = static_cast<unsigned>(std::atoi(value.c_str()));
+        } else if (arg == "--firmware-kb") {
+            options.firmware_kb = static_cast<unsigned>(std::atoi(value.c_str()));
+        } else if (arg == "--seed") {
+            options.seeded = true;
+            options.seed = std::strtoull(value.c_str(), nullptr, 0);
+        } else if (arg == "--timestamp") {
+            options.has_timestamp = true;
+            options.timestamp = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--threads") {
+            options.threads = static_cast<unsigned>(std::atoi(value.c_str()));
+        } else if (arg == "--compress") {
+            if (value.compare(0, 4, "zstd") != 0 || (value.size() > 4 && value[4] != ':')) {
+                std::cerr << "[Pack] ✗ Unknown compression: " << value << "\n";
+                return false;
+            }
+            options.compress = true;
+            if (value.size() > 5) {
+                options.level = std::atoi(value.c_str() + 5);
+            }
+        } else if (arg == "--window-log") {
+            options.window_log = static_cast<unsigned>(std::atoi(value.c_str()));
+        } else if (arg == "--corrupt") {
+            options.corruptions.push_back(value);
+        } else {
+            std::cerr << "[Pack] ✗ Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    
+    if (options.output.empty()) {
+        return false;
+    }
+    
+    if (options.zones > 0 &&
+        (options.zones > MAX_ZONES_IN_VEHICLE || options.ecus_per_zone < 1 ||
+         options.ecus_per_zone > MAX_ECUS_IN_ZONE || options.firmware_kb < 1)) {
+        std::cerr << "[Pack] ✗ Layout out of range (zones 1~" << MAX_ZONES_IN_VEHICLE
+                  << ", ECUs per zone 1~" << MAX_ECUS_IN_ZONE << ", firmware >= 1 KB)\n";
+        return false;
+    }
+    
+    if (options.compress && !ecuCompressionAvailable(ECU_COMPRESSION_ZSTD)) {
+        std::cerr << "[Pack] ✗ --compress zstd: vmg-pack was built without zstd\n";
+        return false;
+    }
+    
+    if (options.window_log < ECU_ZSTD_WINDOW_LOG_MIN || options.window_log > ECU_ZSTD_WINDOW_LOG_MAX) {
+        std::cerr << "[Pack] ✗ --window-log out of range (" << ECU_ZSTD_WINDOW_LOG_MIN << "~"
+                  << ECU_ZSTD_WINDOW_LOG_MAX << ")\n";
+        return false;
+    }
+    
+    if (!options.has_timestamp) {
+        options.timestamp = options.seeded ? 0 : static_cast<uint32_t>(std::time(nullptr));
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    PackOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(std::cerr, argv[0]);
+        return 1;
+    }
+    if (options.help) {
+        printUsage(std::cout, argv[0]);
+        return 0;
+    }
+    
+    std::vector<ZoneSpec> zones = options.zones > 0
+        ? syntheticConfig(options.zones, options.ecus_per_zone, options.firmware_kb)
+        : defaultConfig();
+    
+    for (ZoneSpec& zone : zones) {
+        for (EcuSpec& ecu : zone.ecus) {
+            ecu.stored_size = options.compress ? ZstdStreamEncoder::compressBound(ecu.firmware_size)
+                                               : ecu.firmware_size;
+        }
+    }
+    
+    uint64_t total_size = 0;
+    uint64_t image_size = 0;
+    if (!layoutPackage(zones, total_size, !options.compress)) {
+        return 1;
+    }
+    
+    int fd = ::open(options.output.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(total_size)) != 0) {
+        std::cerr << "[Pack] ✗ Failed to create " << options.output << ": " << strerror(errno) << "\n";
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return 1;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    // ECU Packages: independent, written in parallel at their final offsets
+    std::vector<EcuSpec*> jobs;
+    for (ZoneSpec& zone : zones) {
+        for (EcuSpec& ecu : zone.ecus) {
+            jobs.push_back(&ecu);
+        }
+    }
+    
+    unsigned thread_count = std::min<unsigned>(resolveCRCThreadCount(options.threads),
+                                               static_cast<unsigned>(jobs.size()));
+    std::atomic<size_t> next_job(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < thread_count; t++) {
+        workers.emplace_back([&]() {
+            std::vector<uint8_t> buffer(PACK_BUFFER_SIZE);
+            for (size_t j = next_job++; j < jobs.size() && !failed; j = next_job++) {
+                if (!writeECUPackage(fd, *jobs[j], options, buffer.data())) {
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    bool ok = !failed;
+    for (const EcuSpec* ecu : jobs) {
+        image_size += sizeof(ECUMetadata) + uint64_t(ecu->firmware_size);
+    }
+    if (ok && options.compress) {
+        std::vector<uint8_t> buffer(PACK_BUFFER_SIZE);
+        ok = compactPackage(fd, zones, total_size, buffer.data());
+    }
+    for (size_t i = 0; ok && i < zones.size(); i++) {
+        ok = writeZoneHeader(fd, zones[i], options);
+    }
+    
+    uint32_t vehicle_crc = 0;
+    ok = ok && writeVehicleMetadata(fd, zones, total_size, options, vehicle_crc);
+    if (!ok) {
+        std::cerr << "[Pack] ✗ Failed to write " << options.output << ": " << strerror(errno) << "\n";
+        ::close(fd);
+        return 1;
+    }
+    
+    for (const std::string& spec : options.corruptions) {
+        if (!applyCorruption(fd, zones, total_size, spec)) {
+            std::cerr << "[Pack] ✗ Failed to apply corruption: " << spec << "\n";
+            ::close(fd);
+            return 1;
+        }
+        std::cout << "[Pack] ⚠ Corrupted: " << spec << "\n";
+    }
+    
+    if (::close(fd) != 0) {
+        std::cerr << "[Pack] ✗ Failed to close " << options.output << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double mb = static_cast<double>(total_size) / (1024.0 * 1024.0);
+    double generated_mb = options.compress ? static_cast<double>(image_size) / (1024.0 * 1024.0) : mb;
+    
+    std::cout << "[Pack] ✓ Vehicle Package created: " << options.output << "\n";
+    std::cout << "[Pack]   Total Size: " << total_size << " bytes ("
+              << std::fixed << std::setprecision(2) << mb << " MB)\n";
+    std::cout << "[Pack]   Zones: " << zones.size() << ", ECUs: " << jobs.size() << "\n";
+    if (options.compress) {
+        std::cout << "[Pack]   Compression: zstd level " << options.level << ", ECU Packages "
+                  << image_size << " -> " << (total_size - sizeof(VehiclePackageMetadata)
+                                                          - zones.size() * sizeof(ZonePackageHeader))
+                  << " bytes\n";
+    }
+    std::cout << "[Pack]   Vehicle CRC32: 0x" << std::hex << std::uppercase << std::setw(8)
+              << std::setfill('0') << vehicle_crc << std::dec << "\n";
+    std::cout << "[Pack]   " << std::setprecision(1) << generated_mb / seconds << " MB/s ("
+              << thread_count << " threads, " << crc32KernelName(crc32SelectedKernel()) << ")\n";
+    return 0;
+}